@@ -67,6 +67,27 @@ async function apiSaveGeofence(obj) {
   return payload || {};
 }
 
+async function apiGetGeofenceStats() {
+  const r = await fetch("/api/geofence/stats", { cache: "no-store" });
+  if (!r.ok) throw new Error(`GET /api/geofence/stats failed: ${r.status}`);
+  return await r.json();
+}
+
+// SUA areas near a point from the device's catalog index, with geometry.
+async function apiSuaNear(lat, lon, radiusKm) {
+  const q = `lat=${lat}&lon=${lon}&radius_km=${radiusKm}&limit=${SUA_NEAR_LIMIT}`;
+  const r = await fetch(`/api/sua/near?${q}`, { cache: "no-store" });
+  if (!r.ok) throw new Error(`GET /api/sua/near failed: ${r.status}`);
+  return await r.json();
+}
+
+// One SUA area by exact name (any case); an empty list when unknown.
+async function apiSuaArea(name) {
+  const r = await fetch(`/api/sua/area?name=${encodeURIComponent(name)}`, { cache: "no-store" });
+  if (!r.ok) throw new Error(`GET /api/sua/area failed: ${r.status}`);
+  return await r.json();
+}
+
 async function apiGetConfig() {
   const r = await fetch("/api/config", { cache: "no-store" });
   if (!r.ok) throw new Error(`GET /api/config failed: ${r.status}`);
@@ -240,6 +261,8 @@ const MAX_POINTS = 10;
 let createPolyDraft = [];
 let keepOutPolygons = [];
 let remainInPolygon = [];
+// Further rings of the contained area; combined even-odd with the outline.
+let remainInHoles = [];
 let remainInLabel = "";
 let currentGeofenceDoc = { keep_out: [], stay_in: [], lines: [] };
 let lastStatus = null;
@@ -248,12 +271,20 @@ let suaCatalog = [];
 const suaById = new Map();
 const suaNameById = new Map();
 const keepOutFromSua = new Map();
+// Type codes in the catalog ({ code, count }) and the ones saved as
+// category keep-outs ({ sua_type } rules the firmware expands).
+let suaTypes = [];
+const keepOutTypes = new Set();
 let remainInFromSua = null;
+let remainInBand = null;
 let suaBin = null;
 let suaStringOffset = 0;
 let suaGeomOffset = 0;
+let suaGeomV2 = false;
 let selectedSuaId = "";
 let suaAsOf = "";
+// " within N km" while the list holds a proximity query's areas.
+let suaScope = "";
 let containedEnabled = true;
 let exclusionEnabled = true;
 
@@ -263,6 +294,15 @@ const keepOutFromPrebuilt = new Map();
 
 const MAX_KEEP_OUT = 6;
 const ARC_STEP_M = 1000;
+const ARC_MAX_RADIUS_M = 500000;
+// Firmware simplifies saved rings to this tolerance (keep-outs only grow,
+// stay-ins only shrink); 0 keeps every vertex.
+const GEOFENCE_SIMPLIFY_M = 25;
+// SIA1 index entries of 40+ bytes carry an altitude band (metres MSL).
+const SUA_BAND_ENTRY_SIZE = 40;
+const SUA_NEAR_LIMIT = 100;
+const SUA_NO_FLOOR = -2147483648;
+const SUA_NO_CEILING = 2147483647;
 
 let lastAutoSaveConfig = "";
 let lastAutoSaveGeofence = "";
@@ -378,6 +418,11 @@ function readCString(buf, offset) {
   return new TextDecoder().decode(bytes.slice(0, end));
 }
 
+// The builder stores angles as (cd & 0xFFFF), so negatives wrap.
+function centiDeg(raw) {
+  return raw > 36000 ? raw - 65536 : raw;
+}
+
 function metersToDegLat(m) {
   return m / 111320;
 }
@@ -387,40 +432,46 @@ function metersToDegLon(m, latDeg) {
   return m / (denom || 1);
 }
 
+// Mirrors GeoMath::makeArc in the firmware: angles and radius come from
+// the endpoints (the stored centi-degrees are approximate), start == end is
+// a full circle, and oversized "arcs" (parallels of latitude around a
+// near-polar centre) are drawn as their chord.
 function arcToPoints(seg) {
-  const startDeg = seg.start_cd / 100;
-  const endDeg = seg.end_cd / 100;
-  const direction = seg.direction;
-  let start = ((startDeg % 360) + 360) % 360;
-  let end = ((endDeg % 360) + 360) % 360;
-
-  let delta;
-  let stepSign;
-  if (direction === 1) {
-    if (end < start) end += 360;
-    delta = end - start;
-    stepSign = 1;
+  const cosLat = Math.cos((seg.center[0] * Math.PI) / 180);
+  const toLocal = (pt) => [
+    (pt[1] - seg.center[1]) * 111320 * cosLat,
+    (pt[0] - seg.center[0]) * 111320,
+  ];
+  const [sx, sy] = toLocal(seg.start);
+  const [ex, ey] = toLocal(seg.end);
+  const ds = Math.hypot(sx, sy);
+  const de = Math.hypot(ex, ey);
+  const radius = ds > 0 || de > 0 ? (ds + de) / 2 : seg.radius_m;
+  if (!(radius > 0) || radius > ARC_MAX_RADIUS_M) return [seg.start, seg.end];
+
+  const ccw = seg.direction === 1;
+  const start = Math.atan2(sy, sx);
+  let sweep;
+  if (seg.start[0] === seg.end[0] && seg.start[1] === seg.end[1]) {
+    sweep = ccw ? 2 * Math.PI : -2 * Math.PI;
   } else {
-    if (start < end) start += 360;
-    delta = start - end;
-    stepSign = -1;
-  }
-
-  const arcLen = (delta * Math.PI / 180) * seg.radius_m;
-  const steps = Math.max(2, Math.ceil(arcLen / ARC_STEP_M));
-  const pts = [];
-
-  for (let i = 0; i <= steps; i++) {
-    const t = i / steps;
-    const ang = start + stepSign * (delta * t);
-    const angRad = (ang * Math.PI) / 180;
-    const dx = Math.cos(angRad) * seg.radius_m;
-    const dy = Math.sin(angRad) * seg.radius_m;
-    const lat = seg.center[0] + metersToDegLat(dy);
-    const lon = seg.center[1] + metersToDegLon(dx, seg.center[0]);
-    pts.push([lat, lon]);
+    sweep = Math.atan2(ey, ex) - start;
+    if (ccw) {
+      while (sweep <= 0) sweep += 2 * Math.PI;
+    } else {
+      while (sweep >= 0) sweep -= 2 * Math.PI;
+    }
   }
 
+  const steps = Math.max(2, Math.ceil((Math.abs(sweep) * radius) / ARC_STEP_M));
+  const pts = [seg.start];
+  for (let i = 1; i < steps; i++) {
+    const ang = start + (sweep * i) / steps;
+    const lat = seg.center[0] + metersToDegLat(Math.sin(ang) * radius);
+    const lon = seg.center[1] + metersToDegLon(Math.cos(ang) * radius, seg.center[0]);
+    pts.push([lat, lon]);
+  }
+  pts.push(seg.end);
   return pts;
 }
 
@@ -449,6 +500,13 @@ function segmentsToRing(segments) {
 }
 
 function parseAreaGeometry(area) {
+  // Areas from /api/sua/near arrive decoded.
+  if (area?.rings) {
+    return {
+      type_code: area.type_code || "",
+      rings: area.rings.map((segments) => ({ segments, polygon: segmentsToRing(segments) })),
+    };
+  }
   if (!suaBin) return null;
   const view = new DataView(suaBin);
   let offset = suaGeomOffset + area.geom_offset;
@@ -464,6 +522,17 @@ function parseAreaGeometry(area) {
   const typeCode = typeLen > 0 ? readCString(suaBin, suaStringOffset + typeOffset) : "";
   const rings = [];
 
+  if (suaGeomV2) {
+    const bytes = new Uint8Array(suaBin);
+    for (let r = 0; r < ringCount; r++) {
+      const ring = readSuaRingV2(bytes, offset);
+      if (!ring) return null;
+      offset = ring.offset;
+      rings.push({ segments: ring.segments, polygon: segmentsToRing(ring.segments) });
+    }
+    return { type_code: typeCode, rings };
+  }
+
   for (let r = 0; r < ringCount; r++) {
     const segCount = view.getUint16(offset, true);
     offset += 2;
@@ -491,8 +560,8 @@ function parseAreaGeometry(area) {
         const cLat = view.getInt32(offset, true); offset += 4;
         const cLon = view.getInt32(offset, true); offset += 4;
         const radius = view.getUint32(offset, true); offset += 4;
-        const startCd = view.getUint16(offset, true); offset += 2;
-        const endCd = view.getUint16(offset, true); offset += 2;
+        const startCd = centiDeg(view.getUint16(offset, true)); offset += 2;
+        const endCd = centiDeg(view.getUint16(offset, true)); offset += 2;
         const direction = view.getUint8(offset); offset += 1;
         segments.push({
           type: "ARC",
@@ -518,6 +587,88 @@ function parseAreaGeometry(area) {
   return { type_code: typeCode, rings };
 }
 
+// SIA2 ring: varint segment count, then per segment varint(zigzag(dLat) << 3
+// | flags), start deltas after a jump, zigzag(dLon), and for arcs the centre
+// deltas, radius and both angles. Each segment starts where the last ended;
+// the first jumps from 0,0. Plain numbers: every value fits in 53 bits.
+function readSuaRingV2(bytes, offset) {
+  const varint = () => {
+    let value = 0;
+    let scale = 1;
+    while (offset < bytes.length) {
+      const b = bytes[offset++];
+      value += (b & 0x7f) * scale;
+      if (!(b & 0x80)) return value;
+      scale *= 128;
+    }
+    throw new Error("Truncated SUA geometry");
+  };
+  const zigzag = (u) => (u % 2 ? -(u + 1) / 2 : u / 2);
+  try {
+    const segCount = varint();
+    const segments = [];
+    let lat = 0;
+    let lon = 0;
+    for (let s = 0; s < segCount; s++) {
+      const head = varint();
+      const flags = head % 8;
+      if (flags & 0x02) {
+        lat += zigzag(varint());
+        lon += zigzag(varint());
+      }
+      const eLat = lat + zigzag(Math.floor(head / 8));
+      const eLon = lon + zigzag(varint());
+      const seg = {
+        type: flags & 0x01 ? "ARC" : "LINE",
+        start: [lat / 1e6, lon / 1e6],
+        end: [eLat / 1e6, eLon / 1e6],
+      };
+      if (flags & 0x01) {
+        const cLat = lat + zigzag(varint());
+        const cLon = lon + zigzag(varint());
+        seg.center = [cLat / 1e6, cLon / 1e6];
+        seg.radius_m = varint();
+        seg.start_cd = centiDeg(varint());
+        seg.end_cd = centiDeg(varint());
+        seg.direction = flags & 0x04 ? 1 : 0;
+      }
+      segments.push(seg);
+      lat = eLat;
+      lon = eLon;
+    }
+    return { segments, offset };
+  } catch (e) {
+    return null;
+  }
+}
+
+// Type section of the index (offset in the header's last word): "TYP1",
+// type count, then per type code[8], area count, bitset and list offsets.
+// Returns each record's type code from the bitsets.
+function readSuaTypes(idxBuf, entryCount) {
+  const view = new DataView(idxBuf);
+  const codes = new Array(entryCount).fill("");
+  suaTypes = [];
+  const base = view.getUint32(12, true);
+  if (!base || base + 8 > idxBuf.byteLength) return codes;
+  if (readCString(idxBuf.slice(base, base + 4), 0) !== "TYP1") return codes;
+  const count = view.getUint16(base + 4, true);
+  const bitsetLen = Math.ceil(entryCount / 8);
+  for (let t = 0; t < count; t++) {
+    const rec = base + 8 + t * 20;
+    if (rec + 20 > idxBuf.byteLength) break;
+    const code = readCString(idxBuf.slice(rec, rec + 8), 0);
+    const bitsetOff = base + view.getUint32(rec + 12, true);
+    if (bitsetOff + bitsetLen > idxBuf.byteLength) break;
+    const bits = new Uint8Array(idxBuf, bitsetOff, bitsetLen);
+    for (let i = 0; i < entryCount; i++) {
+      if (bits[i >> 3] & (1 << (i & 7))) codes[i] = code;
+    }
+    suaTypes.push({ code, count: view.getUint32(rec + 8, true) });
+  }
+  return codes;
+}
+
 function previewPolygonPoints(poly, limit = 20) {
   if (poly.length <= limit) return poly;
   const headCount = Math.ceil(limit / 2);
@@ -619,18 +770,51 @@ function areLineRowsValid(count) {
   return true;
 }
 
+// Inner rings of a parsed SUA area (holes, or islands inside holes). The
+// firmware combines them even-odd with the outline.
+function areaHoles(parsed) {
+  return (parsed?.rings || []).slice(1).map((r) => r.polygon).filter((ring) => ring.length >= 3);
+}
+
+// "holes" field for a geofence rule; omitted when there are none.
+function ruleHoles(holes) {
+  return holes?.length ? { holes } : {};
+}
+
+// floor_m / ceil_m fields for a geofence rule; unbounded sides are omitted.
+function altitudeBand(src) {
+  const band = {};
+  if (Number.isFinite(src?.floor_m)) band.floor_m = src.floor_m;
+  if (Number.isFinite(src?.ceil_m)) band.ceil_m = src.ceil_m;
+  return band;
+}
+
 function buildGeofenceDoc() {
   const keepOutRule = keepOutPolygons.map((entry, idx) => ({
     id: `KeepOut-${idx + 1}`,
     label: entry.label || "",
     polygon: entry.polygon,
+    ...ruleHoles(entry.holes),
+    ...(entry.sua ? { sua: entry.sua } : {}),
+    ...altitudeBand(entry),
   }));
+  keepOutTypes.forEach((code) => {
+    keepOutRule.push({ id: `SUA-${code}`, label: `All ${code} areas`, sua_type: code });
+  });
 
   const stayInRule = remainInPolygon.length
-    ? [{ id: "StayIn", label: remainInLabel || "", polygon: remainInPolygon }]
+    ? [{
+      id: "StayIn",
+      label: remainInLabel || "",
+      polygon: remainInPolygon,
+      ...ruleHoles(remainInHoles),
+      ...(remainInFromSua ? { sua: remainInFromSua } : {}),
+      ...altitudeBand(remainInBand),
+    }]
     : [];
 
   currentGeofenceDoc = {
+    simplify_m: GEOFENCE_SIMPLIFY_M,
     keep_out: keepOutRule,
     stay_in: stayInRule,
     lines: collectLines(4),
@@ -735,11 +919,35 @@ function validateLineRows(count) {
 
 function updateCounters() {
   setText("countTimed", getTimedTotalSeconds() > 0 ? 1 : 0);
-  setText("countKeepOut", keepOutPolygons.length);
+  setText("countKeepOut", keepOutPolygons.length + keepOutTypes.size);
   setText("countRemainIn", remainInPolygon.length ? 1 : 0);
   setText("countLines", collectLines(4).length);
 }
 
+// What the device made of the saved rules: how many category areas it
+// loaded, or that the load failed (then no geofence is in force).
+async function refreshGeofenceLoad() {
+  const el = document.getElementById("suaTypeLoad");
+  if (!el) return;
+  const st = await apiGetGeofenceStats();
+  let msg = "";
+  let bad = false;
+  if (st.reload_pending) {
+    msg = "Loading saved geofence…";
+  } else if (st.sua_type_refused > 0) {
+    bad = true;
+    msg = `Geofence NOT loaded: ${st.sua_type_refused} category areas do not fit in memory. ` +
+      "Set a Contained boundary to narrow them, or exclude fewer types.";
+  } else if (!st.loaded) {
+    bad = true;
+    msg = "Geofence NOT loaded: the saved rules could not be read.";
+  } else if (st.sua_type_areas > 0) {
+    msg = `${st.sua_type_areas} category areas loaded as exclusion boundaries.`;
+  }
+  el.textContent = msg;
+  el.classList.toggle("sua-load-bad", bad);
+}
+
 // Callsign is read directly from /api/config (single source of truth).
 
 async function refreshActiveMission() {
@@ -762,6 +970,7 @@ async function refreshActiveMission() {
   } catch (e) {
     showSaveFlag(e?.message || "Config fetch failed", true);
   }
+  refreshGeofenceLoad().catch(() => {});
 }
 
 function applyConfigPayload(cfg) {
@@ -834,15 +1043,28 @@ async function loadGeofence() {
   try {
     const doc = await apiGetGeofence();
     currentGeofenceDoc = doc || currentGeofenceDoc;
-    keepOutPolygons = (currentGeofenceDoc.keep_out || []).map((rule) => ({
+    const keepOut = currentGeofenceDoc.keep_out || [];
+    keepOutTypes.clear();
+    keepOut.forEach((rule) => {
+      if (rule.sua_type) keepOutTypes.add(rule.sua_type);
+    });
+    keepOutPolygons = keepOut.filter((rule) => !rule.sua_type).map((rule) => ({
       polygon: rule.polygon || [],
+      ...ruleHoles(rule.holes),
       label: rule.label || rule.id || "",
+      ...(rule.sua ? { sua: rule.sua } : {}),
+      ...altitudeBand(rule),
     }));
     const stayIn = (currentGeofenceDoc.stay_in || [])[0];
     remainInPolygon = stayIn?.polygon || [];
+    remainInHoles = stayIn?.holes || [];
     remainInLabel = stayIn?.label || stayIn?.id || "";
     keepOutFromSua.clear();
-    remainInFromSua = null;
+    keepOutPolygons.forEach((entry) => {
+      if (entry.sua) keepOutFromSua.set(entry.sua, entry);
+    });
+    remainInFromSua = stayIn?.sua || null;
+    remainInBand = altitudeBand(stayIn);
     keepOutFromPrebuilt.clear();
     fillLineInputs(currentGeofenceDoc.lines || [], 4);
     for (let i = 1; i <= 4; i++) {
@@ -852,7 +1074,10 @@ async function loadGeofence() {
   } catch (e) {
     currentGeofenceDoc = { keep_out: [], stay_in: [], lines: [] };
     keepOutPolygons = [];
+    keepOutTypes.clear();
     remainInPolygon = [];
+    remainInHoles = [];
+    remainInBand = null;
     remainInLabel = "";
     fillLineInputs([], 4);
   }
@@ -861,6 +1086,7 @@ async function loadGeofence() {
   updateCounters();
   setRemainButtonsState();
   renderSuaList();
+  renderSuaTypes();
 }
 
 async function fetchFirstOk(urls, type = "arrayBuffer") {
@@ -882,6 +1108,98 @@ async function fetchFirstOk(urls, type = "arrayBuffer") {
   throw lastErr || new Error("Fetch failed");
 }
 
+function suaAreaFromApi(a) {
+  return {
+    id: a.name,
+    name: a.name,
+    type_code: a.type || "",
+    distance_m: a.distance_m,
+    rings: a.rings || [],
+    ...altitudeBand(a),
+  };
+}
+
+// A search that matches nothing nearby is tried as an exact area name on
+// the device (hash lookup), and a hit joins the list.
+let suaLookupTimer = null;
+let suaLookupLast = "";
+function lookupSuaName(query) {
+  if (query === suaLookupLast) return;
+  suaLookupLast = query;
+  if (suaLookupTimer) clearTimeout(suaLookupTimer);
+  suaLookupTimer = setTimeout(async () => {
+    try {
+      const res = await apiSuaArea(query);
+      const found = res.areas?.[0];
+      if (!found || suaById.has(found.name)) return;
+      const area = suaAreaFromApi(found);
+      suaCatalog.push(area);
+      suaById.set(area.id, area);
+      suaNameById.set(area.id, area.name);
+      renderSuaList();
+    } catch {}
+  }, 400);
+}
+
+// Position the SUA list is centred on: the GPS fix, else the launch site.
+async function defaultSuaCenter() {
+  try {
+    const r = await fetch("/api/status", { cache: "no-store" });
+    const st = r.ok ? await r.json() : null;
+    if (st?.gpsFix) return [st.lat, st.lon];
+    if (st?.launch_set) return [st.launch_lat, st.launch_lon];
+  } catch {}
+  return null;
+}
+
+// Lists the areas near the entered position from the device's index; the
+// whole-catalog download below is only the fallback when that API is not
+// there.
+async function loadSuaAreas() {
+  const latEl = document.getElementById("suaNearLat");
+  const lonEl = document.getElementById("suaNearLon");
+  const radiusEl = document.getElementById("suaNearRadius");
+  if (latEl && lonEl && latEl.value === "" && lonEl.value === "") {
+    const center = await defaultSuaCenter();
+    if (center) {
+      latEl.value = Number(center[0]).toFixed(4);
+      lonEl.value = Number(center[1]).toFixed(4);
+    }
+  }
+  const lat = Number(latEl?.value);
+  const lon = Number(lonEl?.value);
+  const radiusKm = Math.min(Math.max(Number(radiusEl?.value) || 100, 1), 300);
+  if (latEl?.value === "" || lonEl?.value === "" || !Number.isFinite(lat) || !Number.isFinite(lon)) {
+    suaCatalog = [];
+    suaScope = "";
+    renderSuaList();
+    setText("suaStatus", "Enter a position to list nearby areas.");
+    return;
+  }
+
+  let res;
+  try {
+    res = await apiSuaNear(lat, lon, radiusKm);
+  } catch (e) {
+    suaScope = "";
+    await loadSuaCatalog();
+    return;
+  }
+  suaTypes = res.types || [];
+  suaCatalog = (res.areas || []).map(suaAreaFromApi);
+  suaById.clear();
+  suaCatalog.forEach((area) => {
+    suaById.set(area.id, area);
+    suaNameById.set(area.id, area.name);
+  });
+  suaScope = res.truncated
+    ? ` within ${radiusKm} km (nearest ${res.count} of ${res.matched})`
+    : ` within ${radiusKm} km`;
+  setText("suaStatus", "");
+  renderSuaTypes();
+  renderSuaList();
+}
+
 async function loadSuaCatalog() {
   const tbody = document.getElementById("suaSelect");
   const statusEl = document.getElementById("suaStatus");
@@ -903,19 +1221,21 @@ async function loadSuaCatalog() {
     const binMagic = String.fromCharCode(
       binView.getUint8(0), binView.getUint8(1), binView.getUint8(2), binView.getUint8(3)
     );
-    if (idxMagic !== "SIA1" || binMagic !== "SIA1") {
+    if (idxMagic !== "SIA1" || (binMagic !== "SIA1" && binMagic !== "SIA2")) {
       throw new Error("Invalid SUA catalog format");
     }
 
     const entrySize = idxView.getUint16(6, true);
     const entryCount = idxView.getUint32(8, true);
 
+    suaGeomV2 = binMagic === "SIA2";
     suaStringOffset = binView.getUint32(8, true);
     suaGeomOffset = binView.getUint32(12, true);
 
     suaCatalog = [];
     suaById.clear();
     suaNameById.clear();
+    const typeCodes = readSuaTypes(idxBuf, entryCount);
 
     let offset = 16;
     for (let i = 0; i < entryCount; i++) {
@@ -924,7 +1244,13 @@ async function loadSuaCatalog() {
       const geomLength = idxView.getUint32(offset + 12, true);
       const name = readCString(suaBin, suaStringOffset + nameOffset);
       if (name) {
-        const area = { id: name, name, geom_offset: geomOffset, geom_length: geomLength };
+        const area = { id: name, name, geom_offset: geomOffset, geom_length: geomLength, type_code: typeCodes[i] };
+        if (entrySize >= SUA_BAND_ENTRY_SIZE) {
+          const floorM = idxView.getInt32(offset + 32, true);
+          const ceilM = idxView.getInt32(offset + 36, true);
+          if (floorM !== SUA_NO_FLOOR) area.floor_m = floorM;
+          if (ceilM !== SUA_NO_CEILING) area.ceil_m = ceilM;
+        }
         suaCatalog.push(area);
         suaById.set(name, area);
         suaNameById.set(name, name);
@@ -933,6 +1259,7 @@ async function loadSuaCatalog() {
     }
 
     suaCatalog.sort((a, b) => a.name.localeCompare(b.name));
+    renderSuaTypes();
     renderSuaList();
     if (statusEl) statusEl.textContent = "";
   } catch (e) {
@@ -947,7 +1274,9 @@ function renderSuaList() {
   if (!list) return;
   list.innerHTML = "";
 
+  const query = (document.getElementById("suaSearch")?.value || "").trim().toLowerCase();
   if (!suaCatalog.length) {
+    if (query && !suaBin) lookupSuaName(query);
     const opt = document.createElement("option");
     opt.textContent = "No areas available.";
     opt.disabled = true;
@@ -958,9 +1287,10 @@ function renderSuaList() {
     return;
   }
 
-  const query = (document.getElementById("suaSearch")?.value || "").trim().toLowerCase();
-  const filtered = query
+  const type = document.getElementById("suaType")?.value || "";
+  const filtered = query || type
     ? suaCatalog.filter((area) => {
+        if (type && area.type_code !== type) return false;
         const haystack = `${area.name} ${area.id}`.toLowerCase();
         return haystack.includes(query);
       })
@@ -969,12 +1299,13 @@ function renderSuaList() {
   if (countEl) {
     const total = suaCatalog.length;
     const asOf = suaAsOf ? ` as of ${suaAsOf}` : "";
-    countEl.textContent = query
-      ? `Showing ${filtered.length} of ${total}${asOf}`
-      : `${total} areas${asOf}`;
+    countEl.textContent = query || type
+      ? `Showing ${filtered.length} of ${total}${suaScope}${asOf}`
+      : `${total} areas${suaScope}${asOf}`;
   }
 
   if (!filtered.length) {
+    if (query && !suaBin) lookupSuaName(query);
     const opt = document.createElement("option");
     opt.textContent = "No matches found.";
     opt.disabled = true;
@@ -995,7 +1326,9 @@ function renderSuaList() {
     const name = area.name;
     const opt = document.createElement("option");
     opt.value = id;
-    opt.textContent = name;
+    opt.textContent = Number.isFinite(area.distance_m)
+      ? `${name} (${(area.distance_m / 1000).toFixed(0)} km)`
+      : name;
     if (id === selectedSuaId) opt.selected = true;
     list.appendChild(opt);
   });
@@ -1003,6 +1336,48 @@ function renderSuaList() {
   updateSuaActionButtons();
 }
 
+// Type filter options and one "exclude every area of this type" checkbox
+// per catalog type; checked types are saved as { sua_type } keep-outs.
+function renderSuaTypes() {
+  const select = document.getElementById("suaType");
+  if (select) {
+    const current = select.value;
+    select.innerHTML = "";
+    const all = document.createElement("option");
+    all.value = "";
+    all.textContent = "All types";
+    select.appendChild(all);
+    suaTypes.forEach((t) => {
+      const opt = document.createElement("option");
+      opt.value = t.code;
+      opt.textContent = `${t.code} (${t.count})`;
+      select.appendChild(opt);
+    });
+    select.value = suaTypes.some((t) => t.code === current) ? current : "";
+  }
+
+  const box = document.getElementById("suaTypeKeepOut");
+  if (!box) return;
+  box.innerHTML = "";
+  suaTypes.forEach((t) => {
+    const label = document.createElement("label");
+    label.className = "sua-type-option";
+    const input = document.createElement("input");
+    input.type = "checkbox";
+    input.checked = keepOutTypes.has(t.code);
+    input.disabled = !exclusionEnabled;
+    input.addEventListener("change", () => {
+      if (input.checked) keepOutTypes.add(t.code);
+      else keepOutTypes.delete(t.code);
+      updateCounters();
+      updateSelectedAreas();
+    });
+    label.appendChild(input);
+    label.appendChild(document.createTextNode(` Exclude all ${t.code}`));
+    box.appendChild(label);
+  });
+}
+
 function updateSuaActionButtons() {
   const remainBtn = document.getElementById("suaSetRemain");
   const keepBtn = document.getElementById("suaAddKeepOut");
@@ -1143,12 +1518,16 @@ function applyRemainSelection(areaId, checked) {
     const ring = parsed?.rings?.[0]?.polygon || [];
     if (ring.length >= 3) {
       remainInFromSua = areaId;
+      remainInBand = altitudeBand(area);
       remainInPolygon = ring;
+      remainInHoles = areaHoles(parsed);
       remainInLabel = suaNameById.get(areaId) || areaId;
     }
   } else if (remainInFromSua === areaId) {
     remainInFromSua = null;
+    remainInBand = null;
     remainInPolygon = [];
+    remainInHoles = [];
     remainInLabel = "";
   }
 
@@ -1171,7 +1550,15 @@ function applyKeepSelection(areaId, checked) {
     const parsed = parseAreaGeometry(area);
     const ring = parsed?.rings?.[0]?.polygon || [];
     if (ring.length >= 3) {
-      const entry = { polygon: ring, label: suaNameById.get(areaId) || areaId };
+      // The firmware streams the area from its own catalog copy when "sua"
+      // resolves; the polygon stays as the map preview and fallback.
+      const entry = {
+        polygon: ring,
+        ...ruleHoles(areaHoles(parsed)),
+        label: suaNameById.get(areaId) || areaId,
+        sua: areaId,
+        ...altitudeBand(area),
+      };
       keepOutFromSua.set(areaId, entry);
       keepOutPolygons.push(entry);
     }
@@ -1202,7 +1589,9 @@ function applyPrebuiltRemain(areaId) {
     return;
   }
   remainInPolygon = area.polygon;
+  remainInHoles = [];
   remainInLabel = area.name;
+  remainInBand = null;
   remainInFromSua = null;
   renderSavedPolygons();
   updateCounters();
@@ -1298,6 +1687,8 @@ function wireEvents() {
     }
     closePolygon(poly);
     remainInPolygon = poly;
+    remainInHoles = [];
+    remainInBand = null;
     remainInLabel = label;
     createPolyDraft.length = 0;
     renderPointList("createPolyPoints", createPolyDraft);
@@ -1394,6 +1785,7 @@ function wireEvents() {
       if (createBtn) createBtn.disabled = !exclusionEnabled;
       updateSuaActionButtons();
       updatePrebuiltButtons();
+      renderSuaTypes();
     };
     exclusionToggle.addEventListener("change", apply);
     const prevApplying = isApplyingConfig;
@@ -1448,7 +1840,7 @@ function wireEvents() {
 
 function calculateTriggerCount(ttTotalSec) {
   const timerTrigger = ttTotalSec > 60 ? 1 : 0;
-  const keepOutCount = keepOutPolygons.length;
+  const keepOutCount = keepOutPolygons.length + keepOutTypes.size;
   const remainInCount = remainInPolygon.length ? 1 : 0;
   const lineCount = collectLines(4).length;
   return timerTrigger + keepOutCount + remainInCount + lineCount;
@@ -1473,7 +1865,7 @@ document.addEventListener("DOMContentLoaded", () => {
     loadGeofence().catch(() => {}),
   ]).catch(showConfigLoadError);
 
-  loadSuaCatalog();
+  loadSuaAreas();
   loadPrebuiltAreas();
 
   refreshActiveMission();
@@ -1484,6 +1876,11 @@ document.addEventListener("DOMContentLoaded", () => {
 
   const search = document.getElementById("suaSearch");
   if (search) search.addEventListener("input", renderSuaList);
+  const nearFind = document.getElementById("suaNearFind");
+  if (nearFind) nearFind.addEventListener("click", loadSuaAreas);
+
+  const typeFilter = document.getElementById("suaType");
+  if (typeFilter) typeFilter.addEventListener("change", renderSuaList);
 
   const select = document.getElementById("suaSelect");
   if (select) {
@@ -461,6 +461,15 @@ function wireTerminationToggles() {
   }
 }
 
+// Same rounding as the OLED: metres under 1 km, then km.
+function formatGeoMargin(m) {
+  if (!Number.isFinite(m)) return "";
+  const abs = Math.abs(m);
+  if (abs < 1000) return `${Math.trunc(m)}m`;
+  if (abs < 10000) return `${(m / 1000).toFixed(1)}k`;
+  return `${Math.min(999, Math.trunc(m / 1000))}k`;
+}
+
 function updateOledMirror(status) {
   const callsign = (status?.callsign || "").toString() || "NONE";
   const balloon = (status?.balloonType || "").toString();
@@ -482,6 +491,7 @@ function updateOledMirror(status) {
   setText("oledHold", hold || "");
   setText("oledSatcom", satcom || "");
   setText("oledLora", lora || "");
+  setText("oledGeoMargin", formatGeoMargin(Number(status?.geoMarginM)));
 
   const gpsLabel = gpsGood ? "Good" : (gpsFair ? "Fair" : "No Fix");
   const gpsText = `${gpsLabel} ${Number.isFinite(sats) ? sats : 0}`;
@@ -572,28 +582,21 @@ async function renderMap(launchPoint) {
     return;
   }
 
-  const keepOut = (geofence.keep_out || []).map((rule) => ({
-    label: rule.label || rule.id || "",
-    points: (rule.polygon || [])
-      .map((pair) => {
-        const lat = Number(pair?.[0]);
-        const lon = Number(pair?.[1]);
-        if (!Number.isFinite(lat) || !Number.isFinite(lon)) return null;
-        return latLonToPx(lat, lon);
-      })
-      .filter(Boolean),
-  }));
-  const stayIn = (geofence.stay_in || []).map((rule) => ({
+  const ringToPx = (ring) => (ring || [])
+    .map((pair) => {
+      const lat = Number(pair?.[0]);
+      const lon = Number(pair?.[1]);
+      if (!Number.isFinite(lat) || !Number.isFinite(lon)) return null;
+      return latLonToPx(lat, lon);
+    })
+    .filter(Boolean);
+  const toShape = (rule) => ({
     label: rule.label || rule.id || "",
-    points: (rule.polygon || [])
-      .map((pair) => {
-        const lat = Number(pair?.[0]);
-        const lon = Number(pair?.[1]);
-        if (!Number.isFinite(lat) || !Number.isFinite(lon)) return null;
-        return latLonToPx(lat, lon);
-      })
-      .filter(Boolean),
-  }));
+    points: ringToPx(rule.polygon),
+    holes: (rule.holes || []).map(ringToPx),
+  });
+  const keepOut = (geofence.keep_out || []).map(toShape);
+  const stayIn = (geofence.stay_in || []).map(toShape);
   const lines = (geofence.lines || [])
     .map((line) => {
       const axis = (line?.axis || "N/S").toUpperCase() === "E/W" ? "E/W" : "N/S";
@@ -608,21 +611,21 @@ async function renderMap(launchPoint) {
     .filter(Boolean);
   keepOut.forEach((poly) => {
     if (poly.points.length < 3) return;
-    drawPolygon(ctx, poly.points, {
+    [poly.points, ...poly.holes].forEach((ring) => drawPolygon(ctx, ring, {
       color: COLORS.keepOut,
       drawVertices: DRAW_VERTICES,
       vertexColor: COLORS.keepOut,
-    });
+    }));
     if (DRAW_LABELS) drawLabel(ctx, poly.points, poly.label);
   });
 
   stayIn.forEach((poly) => {
     if (poly.points.length < 3) return;
-    drawPolygon(ctx, poly.points, {
+    [poly.points, ...poly.holes].forEach((ring) => drawPolygon(ctx, ring, {
       color: COLORS.stayIn,
       drawVertices: DRAW_VERTICES,
       vertexColor: COLORS.stayIn,
-    });
+    }));
     if (DRAW_LABELS) drawLabel(ctx, poly.points, poly.label);
   });
 
@@ -81,6 +81,15 @@ function updateGpsMode(status) {
   setText("gpsFlight", flightText);
 }
 
+// Same rounding as the OLED: metres under 1 km, then km.
+function formatGeoMargin(m) {
+  if (!Number.isFinite(m)) return "";
+  const abs = Math.abs(m);
+  if (abs < 1000) return `${Math.trunc(m)}m`;
+  if (abs < 10000) return `${(m / 1000).toFixed(1)}k`;
+  return `${Math.min(999, Math.trunc(m / 1000))}k`;
+}
+
 function updateOledMirror(status) {
   const callsign = (status?.callsign || "").toString() || "NONE";
   const balloon = (status?.balloonType || "").toString();
@@ -102,6 +111,7 @@ function updateOledMirror(status) {
   setText("oledHold", hold || "");
   setText("oledSatcom", satcom || "");
   setText("oledLora", lora || "");
+  setText("oledGeoMargin", formatGeoMargin(Number(status?.geoMarginM)));
 
   const gpsLabel = gpsGood ? "Good" : (gpsFair ? "Fair" : "No Fix");
   const gpsText = `${gpsLabel} ${Number.isFinite(sats) ? sats : 0}`;
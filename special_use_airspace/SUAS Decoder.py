@@ -56,7 +56,7 @@ if gdf.crs is not None and gdf.crs.to_string() != "EPSG:4326":
 # Select only the columns we care about + keep geometry for coord extraction
 columns_to_keep = [
     'OBJECTID', 'NAME', 'TYPE_CODE',
-    'UPPER_VAL', 'UPPER_UOM', 'LOWER_VAL', 'LOWER_UOM',
+    'UPPER_VAL', 'UPPER_UOM', 'UPPER_CODE', 'LOWER_VAL', 'LOWER_UOM', 'LOWER_CODE',
     'geometry'
 ]
 gdf = gdf[columns_to_keep]
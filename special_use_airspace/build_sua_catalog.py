@@ -1,4 +1,6 @@
+import argparse
 import json
+import math
 import struct
 from datetime import datetime
 from pathlib import Path
@@ -9,7 +11,24 @@ BIN = Path("data/sua_catalog.bin")
 META = Path("data/sua_catalog_meta.json")
 
 MAGIC = b"SIA1"
+# Geometry file with delta/varint-coded rings; the index keeps SIA1.
+MAGIC_V2 = b"SIA2"
 VERSION = 1
+TYPE_MAGIC = b"TYP1"
+HASH_MAGIC = b"HSH1"
+TYPE_CODE_LEN = 8
+PART_MAGIC = b"SUAP"
+PART_VERSION = 1
+PART_HEADER_LEN = 32
+ENTRY_SIZE = 40  # 32-byte entries (no altitude band) are still accepted by readers
+
+# Altitude band sentinels (metres MSL)
+NO_FLOOR = -(2**31)
+NO_CEILING = 2**31 - 1
+FT_TO_M = 0.3048
+# SFC-referenced ceilings are widened by the highest CONUS terrain so the
+# band stays conservative without a terrain model.
+TERRAIN_MAX_M = 4500
 
 
 def fnv1a_32(text):
@@ -28,6 +47,261 @@ def to_cd(value):
     return int(round(float(value) * 100)) & 0xFFFF
 
 
+def altitude_m(val, uom):
+    try:
+        v = float(val)
+    except (TypeError, ValueError):
+        return None
+    if v <= -9998:  # FAA "unlimited" marker
+        return None
+    if str(uom).strip().upper() == "FL":
+        v *= 100
+    return v * FT_TO_M
+
+
+def altitude_band(props):
+    """(floor_m, ceil_m) MSL, widened where the source is surface referenced."""
+    lower = altitude_m(props.get("LOWER_VAL"), props.get("LOWER_UOM"))
+    if lower is None or lower <= 0:
+        floor_m = NO_FLOOR
+    else:
+        # An AGL floor is taken as MSL, i.e. as if over sea-level terrain.
+        floor_m = int(math.floor(lower))
+
+    upper = altitude_m(props.get("UPPER_VAL"), props.get("UPPER_UOM"))
+    upper_code = str(props.get("UPPER_CODE") or "").strip().upper()
+    if upper is None or upper <= 0 or upper_code == "UNLTD":
+        ceil_m = NO_CEILING
+    elif upper_code == "SFC":
+        ceil_m = int(math.ceil(upper)) + TERRAIN_MAX_M
+    else:
+        ceil_m = int(math.ceil(upper))
+
+    if floor_m > ceil_m:
+        floor_m, ceil_m = NO_FLOOR, NO_CEILING
+    return floor_m, ceil_m
+
+
+# --- Conservative ring simplification ---------------------------------------
+# Python copy of src/geofence/GeoSimplify.cpp; keep the two in step. With
+# grow=True the ring only gains area, with grow=False it only loses area, and
+# no point of either boundary moves more than tolerance_m from the other.
+
+M_PER_DEG_LAT = 111320.0
+
+
+def _orient(a, b, c):
+    return (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0])
+
+
+def _side_of(o, side):
+    return 0 if o == 0 else (1 if (o > 0) == (side > 0) else -1)
+
+
+def _seg_dist_m(a, b, p):
+    m_lat = M_PER_DEG_LAT / 1e6
+    m_lon = m_lat * max(math.cos(math.radians(p[0] / 1e6)), 1e-6)
+    ax, ay = (a[1] - p[1]) * m_lon, (a[0] - p[0]) * m_lat
+    dx, dy = (b[1] - a[1]) * m_lon, (b[0] - a[0]) * m_lat
+    len2 = dx * dx + dy * dy
+    t = min(max(-(ax * dx + ay * dy) / len2, 0.0), 1.0) if len2 > 0 else 0.0
+    return math.hypot(ax + t * dx, ay + t * dy)
+
+
+def _on_segment(a, b, p):
+    return (_orient(a, b, p) == 0 and min(a[0], b[0]) <= p[0] <= max(a[0], b[0])
+            and min(a[1], b[1]) <= p[1] <= max(a[1], b[1]))
+
+
+def _sign(v):
+    return (v > 0) - (v < 0)
+
+
+def _segments_intersect(a, b, c, d):
+    o1, o2 = _sign(_orient(a, b, c)), _sign(_orient(a, b, d))
+    o3, o4 = _sign(_orient(c, d, a)), _sign(_orient(c, d, b))
+    if o1 != o2 and o3 != o4:
+        return True
+    return ((o1 == 0 and _on_segment(a, b, c)) or (o2 == 0 and _on_segment(a, b, d))
+            or (o3 == 0 and _on_segment(c, d, a)) or (o4 == 0 and _on_segment(c, d, b)))
+
+
+def _crosses_ray(a, b, p):
+    if (p[1] < b[1]) == (p[1] < a[1]):
+        return False
+    return (_orient(a, b, p) > 0) == (b[1] > a[1])
+
+
+def _meet_beyond(side, a, b, c, d):
+    rx, ry = b[1] - a[1], b[0] - a[0]
+    qx, qy = c[1] - d[1], c[0] - d[0]
+    den = rx * qy - ry * qx
+    if den == 0:
+        return None
+    ax, ay = d[1] - a[1], d[0] - a[0]
+    t = (ax * qy - ay * qx) / den
+    u = (ax * ry - ay * rx) / den
+    if not (t > 1.0 and u > 1.0):
+        return None
+    x_lon, x_lat = a[1] + t * rx, a[0] + t * ry
+    if abs(x_lon) > 1.8e8 or abs(x_lat) > 0.9e8:
+        return None
+    best = None
+    for k in range(4):
+        p = (math.ceil(x_lat) if k & 1 else math.floor(x_lat),
+             math.ceil(x_lon) if k & 2 else math.floor(x_lon))
+        if (_side_of(_orient(a, p, b), side) < 0 or _side_of(_orient(p, d, c), side) < 0
+                or _side_of(_orient(b, c, p), side) >= 0):
+            continue
+        e = _seg_dist_m(b, c, p)
+        if best is None or e < best[0]:
+            best = (e, p)
+    return best[1] if best else None
+
+
+def _clear(pts, nxt, head, live, chain, x):
+    path = [pts[chain[0]]] + ([x] if x else []) + [pts[chain[-1]]]
+    region = [pts[i] for i in chain] + ([x] if x else [])
+    min_lat, max_lat = min(p[0] for p in region), max(p[0] for p in region)
+    min_lon, max_lon = min(p[1] for p in region), max(p[1] for p in region)
+    k = head
+    for _ in range(live):
+        k1 = nxt[k]
+        e0, e1 = pts[k], pts[k1]
+        if (max(e0[0], e1[0]) < min_lat or min(e0[0], e1[0]) > max_lat
+                or max(e0[1], e1[1]) < min_lon or min(e0[1], e1[1]) > max_lon):
+            k = k1
+            continue
+        if k not in chain[:-1]:
+            for p0, p1 in zip(path, path[1:]):
+                share0 = e0 == p0 or e0 == p1
+                share1 = e1 == p0 or e1 == p1
+                if share0 and share1:
+                    return False
+                if share0 or share1:
+                    other, shared = (e1, e0) if share0 else (e0, e1)
+                    far = p1 if shared == p0 else p0
+                    if _on_segment(p0, p1, other) or _on_segment(e0, e1, far):
+                        return False
+                    continue
+                if _segments_intersect(e0, e1, p0, p1):
+                    return False
+        if k not in chain:
+            inside = False
+            for i, a in enumerate(region):
+                if _crosses_ray(a, region[(i + 1) % len(region)], e0):
+                    inside = not inside
+            if inside:
+                return False
+        k = k1
+    return True
+
+
+def simplify_ring(points, tolerance_m, grow):
+    """Simplify an open ring of (lat_e6, lon_e6) tuples; see GeoSimplify.h."""
+    n = len(points)
+    if n <= 3 or tolerance_m <= 0:
+        return list(points)
+    pts = [tuple(p) for p in points]
+    area = sum(_orient(pts[0], pts[i], pts[i + 1]) for i in range(1, n - 1))
+    if area == 0:
+        return list(points)
+    side = 1 if (area > 0) == grow else -1
+    dev = [0.0] * n
+    nxt = [(i + 1) % n for i in range(n)]
+    prv = [(i - 1) % n for i in range(n)]
+    touched = [0] * n
+    head, live = 0, n
+
+    def unlink(v):
+        nonlocal head, live
+        nxt[prv[v]] = nxt[v]
+        prv[nxt[v]] = prv[v]
+        if head == v:
+            head = nxt[v]
+        live -= 1
+
+    pass_no = 0
+    while True:
+        pass_no += 1
+        steps = []
+        b = head
+        for _ in range(live):
+            a, c = prv[b], nxt[b]
+            if _side_of(_orient(pts[a], pts[b], pts[c]), side) <= 0:
+                cost = _seg_dist_m(pts[a], pts[c], pts[b]) + max(dev[a], dev[b])
+                if cost <= tolerance_m:
+                    steps.append((cost, a, b, c, c, None))
+            elif live >= 4:
+                d = nxt[c]
+                if _side_of(_orient(pts[b], pts[c], pts[d]), side) > 0:
+                    x = _meet_beyond(side, pts[a], pts[b], pts[c], pts[d])
+                    if x:
+                        e = max(_seg_dist_m(pts[b], pts[c], x), _seg_dist_m(pts[a], x, pts[b]),
+                                _seg_dist_m(x, pts[d], pts[c]))
+                        cost = e + max(dev[a], dev[b], dev[c])
+                        if cost <= tolerance_m:
+                            steps.append((cost, a, b, c, d, x))
+            b = nxt[b]
+        steps.sort(key=lambda s: s[0])
+
+        applied = False
+        for cost, a, b, c, d, x in steps:
+            if live <= 3 or (x and live < 4):
+                break
+            if pass_no in (touched[a], touched[b], touched[c], touched[d]):
+                continue
+            chain = [a, b, c, d] if x else [a, b, c]
+            if not _clear(pts, nxt, head, live, chain, x):
+                continue
+            if x:
+                pts[b] = x
+                unlink(c)
+                dev[a] = dev[b] = cost
+            else:
+                unlink(b)
+                dev[a] = cost
+            touched[a] = touched[b] = touched[c] = touched[d] = pass_no
+            applied = True
+        if not applied:
+            break
+
+    out, v = [], head
+    for _ in range(live):
+        out.append(pts[v])
+        v = nxt[v]
+    return out
+
+
+def simplify_feature(feat, tolerance_m):
+    """Grow the feature's all-LINE rings in place; returns True if any changed.
+
+    Rings with arcs are left alone: the ring checks above only know about
+    straight edges.
+    """
+    changed = False
+    for ring in feat.get("rings", []):
+        segments = ring.get("segments", [])
+        if len(segments) <= 3 or any(seg.get("type") != "LINE" for seg in segments):
+            continue
+        pts = [(to_e6(seg["start"][0]), to_e6(seg["start"][1])) for seg in segments]
+        linked = all((to_e6(a["end"][0]), to_e6(a["end"][1])) == pts[(i + 1) % len(pts)]
+                     for i, a in enumerate(segments))
+        if not linked:
+            continue
+        out = simplify_ring(pts, tolerance_m, grow=True)
+        if len(out) == len(pts):
+            continue
+        ring["segments"] = [
+            {"type": "LINE",
+             "start": [p[0] / 1e6, p[1] / 1e6],
+             "end": [q[0] / 1e6, q[1] / 1e6]}
+            for p, q in zip(out, out[1:] + out[:1])
+        ]
+        changed = True
+    return changed
+
+
 def pack_string_table(strings):
     table = bytearray()
     offsets = {}
@@ -40,79 +314,447 @@ def pack_string_table(strings):
     return offsets, bytes(table)
 
 
-def build_geometry(feat, string_offsets):
-    props = feat.get("properties", {})
-    type_code = (props.get("TYPE_CODE") or "").strip()
-    type_off = string_offsets.get(type_code, 0)
-    type_len = len(type_code.encode("utf-8"))
+# SIA2 segment flags, in the low bits of each segment's first varint.
+SEG2_ARC = 0x01
+SEG2_JUMP = 0x02  # start differs from the previous end (always for a ring's first)
+SEG2_CCW = 0x04
 
+
+def feature_rings(feat):
+    """Rings of a feature as segment tuples in micro-degrees:
+    ("LINE", s_lat, s_lon, e_lat, e_lon) or ("ARC", s_lat, s_lon, e_lat,
+    e_lon, c_lat, c_lon, radius_m, start_cd, end_cd, direction)."""
     rings = []
     for ring in feat.get("rings", []):
-        segments = ring.get("segments", [])
-        if segments:
-            rings.append(segments)
+        out = []
+        for seg in ring.get("segments", []):
+            s_lat, s_lon = seg["start"]
+            e_lat, e_lon = seg["end"]
+            if seg.get("type") == "LINE":
+                out.append(("LINE", to_e6(s_lat), to_e6(s_lon), to_e6(e_lat), to_e6(e_lon)))
+            elif seg.get("type") == "ARC":
+                c_lat, c_lon = seg["center"]
+                out.append((
+                    "ARC",
+                    to_e6(s_lat), to_e6(s_lon), to_e6(e_lat), to_e6(e_lon),
+                    to_e6(c_lat), to_e6(c_lon),
+                    int(round(float(seg.get("radius_m", 0)))),
+                    to_cd(seg.get("start_angle_deg", 0)),
+                    to_cd(seg.get("end_angle_deg", 0)),
+                    1 if str(seg.get("direction", "CCW")).upper() == "CCW" else 0,
+                ))
+        if out:
+            rings.append(out)
+    return rings
 
-    geom = bytearray()
-    geom.extend(struct.pack("<HHHHI", len(rings), 0, type_len, 0, type_off))
 
-    min_lat = min_lon = 2**31 - 1
-    max_lat = max_lon = -(2**31)
+def zigzag(v):
+    return v * 2 if v >= 0 else -v * 2 - 1
+
+
+def varint(u):
+    out = bytearray()
+    while u >= 0x80:
+        out.append((u & 0x7F) | 0x80)
+        u >>= 7
+    out.append(u)
+    return bytes(out)
 
+
+def pack_ring_v2(segments):
+    """SIA2 ring: varint segment count, then per segment
+    varint(zigzag(d_lat) << 3 | flags) with d_lat = end - start, for a JUMP
+    zigzag varints of start - previous end, then zigzag(d_lon), and for an
+    ARC zigzag(center - start) twice, varint radius_m, start_cd, end_cd.
+    The previous end starts at (0, 0), so each ring's first vertex is
+    absolute and every shared vertex is written once."""
+    out = bytearray(varint(len(segments)))
+    cur = (0, 0)
+    for seg in segments:
+        s_lat, s_lon, e_lat, e_lon = seg[1:5]
+        flags = 0
+        if seg[0] == "ARC":
+            flags |= SEG2_ARC | (SEG2_CCW if seg[10] else 0)
+        if (s_lat, s_lon) != cur:
+            flags |= SEG2_JUMP
+        out += varint(zigzag(e_lat - s_lat) << 3 | flags)
+        if flags & SEG2_JUMP:
+            out += varint(zigzag(s_lat - cur[0])) + varint(zigzag(s_lon - cur[1]))
+        out += varint(zigzag(e_lon - s_lon))
+        if seg[0] == "ARC":
+            c_lat, c_lon, radius_m, start_cd, end_cd = seg[5:10]
+            out += varint(zigzag(c_lat - s_lat)) + varint(zigzag(c_lon - s_lon))
+            out += varint(radius_m) + varint(start_cd) + varint(end_cd)
+        cur = (e_lat, e_lon)
+    return bytes(out)
+
+
+def pack_geometry(rings, grown_m, type_len, type_off, v2):
+    """One area's geometry block: the 12-byte header (shared by SIA1 and
+    SIA2) and its rings, fixed-width in SIA1, delta-coded in SIA2."""
+    geom = bytearray(struct.pack("<HHHHI", len(rings), grown_m, type_len, 0, type_off))
     for segments in rings:
-        geom.extend(struct.pack("<HH", len(segments), 0))
+        if v2:
+            geom += pack_ring_v2(segments)
+            continue
+        geom += struct.pack("<HH", len(segments), 0)
         for seg in segments:
-            seg_type = seg.get("type")
-            if seg_type == "LINE":
-                s_lat, s_lon = seg["start"]
-                e_lat, e_lon = seg["end"]
-                geom.extend(struct.pack(
-                    "<Biiii",
-                    0x01,
-                    to_e6(s_lat),
-                    to_e6(s_lon),
-                    to_e6(e_lat),
-                    to_e6(e_lon),
-                ))
-                for lat, lon in (seg["start"], seg["end"]):
-                    min_lat = min(min_lat, to_e6(lat))
-                    min_lon = min(min_lon, to_e6(lon))
-                    max_lat = max(max_lat, to_e6(lat))
-                    max_lon = max(max_lon, to_e6(lon))
-            elif seg_type == "ARC":
-                s_lat, s_lon = seg["start"]
-                e_lat, e_lon = seg["end"]
-                c_lat, c_lon = seg["center"]
-                radius_m = int(round(float(seg.get("radius_m", 0))))
-                start_cd = to_cd(seg.get("start_angle_deg", 0))
-                end_cd = to_cd(seg.get("end_angle_deg", 0))
-                direction = 1 if str(seg.get("direction", "CCW")).upper() == "CCW" else 0
-                geom.extend(struct.pack(
-                    "<BiiiiiiIHHB",
-                    0x02,
-                    to_e6(s_lat),
-                    to_e6(s_lon),
-                    to_e6(e_lat),
-                    to_e6(e_lon),
-                    to_e6(c_lat),
-                    to_e6(c_lon),
-                    radius_m,
-                    start_cd,
-                    end_cd,
-                    direction,
-                ))
-                for lat, lon in (seg["start"], seg["end"], seg["center"]):
-                    min_lat = min(min_lat, to_e6(lat))
-                    min_lon = min(min_lon, to_e6(lon))
-                    max_lat = max(max_lat, to_e6(lat))
-                    max_lon = max(max_lon, to_e6(lon))
+            if seg[0] == "LINE":
+                geom += struct.pack("<Biiii", 0x01, *seg[1:5])
+            else:
+                geom += struct.pack("<BiiiiiiIHHB", 0x02, *seg[1:])
+    return bytes(geom)
+
 
+def rings_bbox(rings):
+    min_lat = min_lon = 2**31 - 1
+    max_lat = max_lon = -(2**31)
+    for segments in rings:
+        for seg in segments:
+            points = [seg[1:3], seg[3:5]] + ([seg[5:7]] if seg[0] == "ARC" else [])
+            for lat, lon in points:
+                min_lat, min_lon = min(min_lat, lat), min(min_lon, lon)
+                max_lat, max_lon = max(max_lat, lat), max(max_lon, lon)
     if min_lat == 2**31 - 1:
         min_lat = min_lon = max_lat = max_lon = 0
+    return min_lat, min_lon, max_lat, max_lon
 
-    return bytes(geom), min_lat, min_lon, max_lat, max_lon
+
+def build_geometry(feat, string_offsets, grown_m=0, v2=True):
+    type_code = ((feat.get("properties", {}).get("TYPE_CODE")) or "").strip()
+    rings = feature_rings(feat)
+    geom = pack_geometry(rings, grown_m, len(type_code.encode("utf-8")),
+                         string_offsets.get(type_code, 0), v2)
+    return (geom, *rings_bbox(rings))
+
+
+def read_sia1_rings(blob, off):
+    """Header fields and rings of one SIA1 geometry block, as feature_rings()."""
+    ring_count, grown_m, type_len, _, type_off = struct.unpack_from("<HHHHI", blob, off)
+    pos = off + 12
+    rings = []
+    for _ in range(ring_count):
+        seg_count = struct.unpack_from("<H", blob, pos)[0]
+        pos += 4
+        segments = []
+        for _ in range(seg_count):
+            if blob[pos] == 0x01:
+                segments.append(("LINE", *struct.unpack_from("<iiii", blob, pos + 1)))
+                pos += 17
+            elif blob[pos] == 0x02:
+                segments.append(("ARC", *struct.unpack_from("<iiiiiiIHHB", blob, pos + 1)))
+                pos += 34
+            else:
+                raise SystemExit(f"bad segment type {blob[pos]} at {pos}")
+        rings.append(segments)
+    return grown_m, type_len, type_off, rings
+
+
+def read_varint(blob, pos):
+    u = shift = 0
+    while True:
+        b = blob[pos]
+        pos += 1
+        u |= (b & 0x7F) << shift
+        shift += 7
+        if b < 0x80:
+            return u, pos
+
+
+def unzigzag(u):
+    return (u >> 1) ^ -(u & 1)
+
+
+def read_sia2_rings(blob, off):
+    """Header fields and rings of one SIA2 geometry block, as feature_rings()."""
+    ring_count, grown_m, type_len, _, type_off = struct.unpack_from("<HHHHI", blob, off)
+    pos = off + 12
+    rings = []
+    for _ in range(ring_count):
+        seg_count, pos = read_varint(blob, pos)
+        segments = []
+        cur = (0, 0)
+        for _ in range(seg_count):
+            head, pos = read_varint(blob, pos)
+            flags = head & 0x07
+            s_lat, s_lon = cur
+            if flags & SEG2_JUMP:
+                d, pos = read_varint(blob, pos)
+                s_lat += unzigzag(d)
+                d, pos = read_varint(blob, pos)
+                s_lon += unzigzag(d)
+            d, pos = read_varint(blob, pos)
+            e_lat, e_lon = s_lat + unzigzag(head >> 3), s_lon + unzigzag(d)
+            if flags & SEG2_ARC:
+                vals = []
+                for _ in range(5):
+                    v, pos = read_varint(blob, pos)
+                    vals.append(v)
+                segments.append(("ARC", s_lat, s_lon, e_lat, e_lon, s_lat + unzigzag(vals[0]),
+                                 s_lon + unzigzag(vals[1]), vals[2], vals[3], vals[4],
+                                 1 if flags & SEG2_CCW else 0))
+            else:
+                segments.append(("LINE", s_lat, s_lon, e_lat, e_lon))
+            cur = (e_lat, e_lon)
+        rings.append(segments)
+    return grown_m, type_len, type_off, rings
+
+
+def recode_catalog(idx_path, bin_path, v2):
+    """Rewrite a catalog's geometry in place as SIA2 (v2) or SIA1, with the
+    index's geometry offsets updated. Strings, bboxes, bands and types carry
+    over. SIA1 is what readers before SIA2 and the geofence bench's SIA1/SIA2
+    comparison load."""
+    idx = Path(idx_path).read_bytes()
+    blob = Path(bin_path).read_bytes()
+    if idx[:4] != MAGIC or blob[:4] != (MAGIC if v2 else MAGIC_V2):
+        raise SystemExit(f"{idx_path} / {bin_path}: not an {'SIA1' if v2 else 'SIA2'} catalog")
+    _, _, entry_size, count, _ = struct.unpack_from("<4sHHII", idx, 0)
+    string_off, geom_off = struct.unpack_from("<II", blob, 8)
+    read_rings = read_sia1_rings if v2 else read_sia2_rings
+
+    def cstring(off):
+        return blob[off:blob.index(b"\0", off)].decode("utf-8")
+
+    entries = []
+    blocks = []
+    geom_offset = 0
+    for i in range(count):
+        rec = 16 + i * entry_size
+        fields = struct.unpack_from("<IIIIiiii", idx, rec)
+        band = struct.unpack_from("<ii", idx, rec + 32) if entry_size >= 40 else (NO_FLOOR, NO_CEILING)
+        grown_m, type_len, type_off, rings = read_rings(blob, geom_off + fields[2])
+        geom = pack_geometry(rings, grown_m, type_len, type_off, v2)
+        blocks.append(geom)
+        entries.append({
+            "name": cstring(string_off + fields[1]),
+            "type_code": cstring(string_off + type_off) if type_len else "",
+            "name_offset": fields[1],
+            "geom_offset": geom_offset,
+            "geom_length": len(geom),
+            "min_lat": fields[4],
+            "min_lon": fields[5],
+            "max_lat": fields[6],
+            "max_lon": fields[7],
+            "band": band,
+        })
+        geom_offset += len(geom)
+
+    strings = blob[string_off:geom_off]
+    new_geom = b"".join(blocks)
+    header = struct.pack("<4sHHIII", MAGIC_V2 if v2 else MAGIC, VERSION, 0, 20, 20 + len(strings),
+                         20 + len(strings) + len(new_geom))
+    Path(bin_path).write_bytes(header + strings + new_geom)
+    Path(idx_path).write_bytes(pack_index(entries))
+    old = len(blob) - geom_off
+    print(f"{'Compacted' if v2 else 'Expanded'} {bin_path}: geometry {old} -> {len(new_geom)} bytes, "
+          f"file {len(blob)} -> {len(header) + len(strings) + len(new_geom)} bytes")
+
+
+def pack_type_section(idx_entries):
+    """Per-type lookup tables, appended after the index records.
+
+    Section: "TYP1", u16 type count, u16 reserved, then per type
+    char code[8] (NUL-padded), u32 area count, u32 bitset offset,
+    u32 list offset (offsets from the section start). The bitset has bit i
+    set when record i is of that type; the list holds the type's records as
+    (u32 record, i32 min_lat, min_lon, max_lat, max_lon) sorted by min_lat,
+    so "areas of type T near P" is a binary search plus a short scan.
+    """
+    codes = sorted({e["type_code"] for e in idx_entries if e.get("type_code")})
+    if not codes:
+        return b""
+    bitset_len = (len(idx_entries) + 7) // 8
+    table_len = 8 + len(codes) * (TYPE_CODE_LEN + 12)
+    records = bytearray()
+    data = bytearray()
+    for code in codes:
+        members = [i for i, e in enumerate(idx_entries) if e.get("type_code") == code]
+        bits = bytearray(bitset_len)
+        for i in members:
+            bits[i >> 3] |= 1 << (i & 7)
+        bitset_off = table_len + len(data)
+        data.extend(bits)
+        data.extend(bytes(-len(data) % 4))
+        list_off = table_len + len(data)
+        for i in sorted(members, key=lambda i: (idx_entries[i]["min_lat"], i)):
+            e = idx_entries[i]
+            data.extend(struct.pack("<Iiiii", i, e["min_lat"], e["min_lon"], e["max_lat"], e["max_lon"]))
+        records.extend(struct.pack(f"<{TYPE_CODE_LEN}sIII", code.encode("utf-8")[:TYPE_CODE_LEN - 1],
+                                   len(members), bitset_off, list_off))
+    return TYPE_MAGIC + struct.pack("<HH", len(codes), 0) + bytes(records) + bytes(data)
+
+
+def pack_hash_section(idx_entries):
+    """Name lookup table, placed right after the index records.
+
+    Section: "HSH1", u32 count, then (u32 id_hash, u32 record) pairs sorted
+    by hash then record, so a name resolves with a binary search and a name
+    check on the few records sharing its hash. Records keep their order.
+    """
+    pairs = sorted((fnv1a_32(e["name"].upper()), i) for i, e in enumerate(idx_entries))
+    return HASH_MAGIC + struct.pack("<I", len(pairs)) + b"".join(struct.pack("<II", h, i) for h, i in pairs)
+
+
+def pack_index(idx_entries):
+    # The records are followed by the hash section and then the type
+    # section. The header's last word (reserved in older catalogs) is the
+    # offset of the type section, 0 when there is none.
+    hashes = pack_hash_section(idx_entries)
+    types = pack_type_section(idx_entries)
+    types_off = 16 + len(idx_entries) * ENTRY_SIZE + len(hashes) if types else 0
+    idx = bytearray(struct.pack("<4sHHII", MAGIC, VERSION, ENTRY_SIZE, len(idx_entries), types_off))
+    for entry in idx_entries:
+        id_hash = fnv1a_32(entry["name"].upper())
+        floor_m, ceil_m = entry["band"]
+        idx.extend(struct.pack(
+            "<IIIIiiiiii",
+            id_hash,
+            entry["name_offset"],
+            entry["geom_offset"],
+            entry["geom_length"],
+            entry["min_lat"],
+            entry["min_lon"],
+            entry["max_lat"],
+            entry["max_lon"],
+            floor_m,
+            ceil_m,
+        ))
+    return bytes(idx) + hashes + types
+
+
+def read_dbf(path):
+    data = Path(path).read_bytes()
+    count = struct.unpack_from("<I", data, 4)[0]
+    header_len, record_len = struct.unpack_from("<HH", data, 8)
+    fields = []
+    off = 32
+    while data[off] != 0x0D:
+        name = data[off:off + 11].split(b"\0")[0].decode("ascii")
+        fields.append((name, data[off + 16]))
+        off += 32
+    records = []
+    for i in range(count):
+        rec = data[header_len + i * record_len:header_len + (i + 1) * record_len]
+        pos = 1
+        row = {}
+        for name, length in fields:
+            row[name] = rec[pos:pos + length].decode("latin-1").strip()
+            pos += length
+        records.append(row)
+    return records
+
+
+def restamp_index(idx_path, bin_path, dbf_path):
+    """Rewrite an existing index with altitude bands from the FAA DBF.
+
+    Geometry is left untouched, so this works without sua_primitives.json.
+    The type section is rebuilt from the type codes in the geometry.
+    Records are matched by position when the DBF lines up with the index
+    (the decoder keeps DBF order), otherwise by name, taking the union of
+    the bands of same-named records.
+    """
+    idx = Path(idx_path).read_bytes()
+    blob = Path(bin_path).read_bytes()
+    magic, _, entry_size, count, _ = struct.unpack_from("<4sHHII", idx, 0)
+    if magic != MAGIC or entry_size < 32:
+        raise SystemExit(f"{idx_path}: not an SIA1 index")
+    string_off, geom_off = struct.unpack_from("<II", blob, 8)
+
+    def cstring(off):
+        return blob[off:blob.index(b"\0", off)].decode("utf-8")
+
+    entries = []
+    for i in range(count):
+        fields = struct.unpack_from("<IIIIiiii", idx, 16 + i * entry_size)
+        type_len, type_off = struct.unpack_from("<HxxI", blob, geom_off + fields[2] + 4)
+        entries.append({
+            "name": cstring(string_off + fields[1]),
+            "type_code": cstring(string_off + type_off) if type_len else "",
+            "name_offset": fields[1],
+            "geom_offset": fields[2],
+            "geom_length": fields[3],
+            "min_lat": fields[4],
+            "min_lon": fields[5],
+            "max_lat": fields[6],
+            "max_lon": fields[7],
+        })
+
+    rows = read_dbf(dbf_path)
+    row_names = [(r.get("NAME") or f"OBJECTID-{r.get('OBJECTID', '')}") for r in rows]
+    unmatched = 0
+    if row_names == [e["name"] for e in entries]:
+        for entry, row in zip(entries, rows):
+            entry["band"] = altitude_band(row)
+    else:
+        bands = {}
+        for name, row in zip(row_names, rows):
+            floor_m, ceil_m = altitude_band(row)
+            prev = bands.get(name.upper())
+            if prev:
+                floor_m, ceil_m = min(prev[0], floor_m), max(prev[1], ceil_m)
+            bands[name.upper()] = (floor_m, ceil_m)
+        for entry in entries:
+            band = bands.get(entry["name"].upper())
+            if band is None:
+                unmatched += 1
+                band = (NO_FLOOR, NO_CEILING)
+            entry["band"] = band
+    Path(idx_path).write_bytes(pack_index(entries))
+    print(f"Restamped {idx_path} ({count} areas, {unmatched} without altitude data)")
+
+
+def pack_partition(idx_path, bin_path, out_path):
+    """Pack an index and geometry file into a raw "sua" partition image.
+
+    Header (little-endian): "SUAP", u16 version, u16 header length, then
+    u32 offset/length of the .idx and of the .bin, 8 reserved bytes. Both
+    files follow verbatim, 16-byte aligned, so the firmware maps the
+    partition and reads them in place.
+    """
+    idx = Path(idx_path).read_bytes()
+    blob = Path(bin_path).read_bytes()
+    if idx[:4] != MAGIC or blob[:4] not in (MAGIC, MAGIC_V2):
+        raise SystemExit(f"{idx_path} / {bin_path}: not an SIA catalog")
+    idx_off = PART_HEADER_LEN
+    bin_off = (idx_off + len(idx) + 15) & ~15
+    header = struct.pack("<4sHHIIIIII", PART_MAGIC, PART_VERSION, PART_HEADER_LEN,
+                         idx_off, len(idx), bin_off, len(blob), 0, 0)
+    image = header + idx + bytes(bin_off - idx_off - len(idx)) + blob
+    Path(out_path).write_bytes(image)
+    print(f"Wrote {out_path} ({len(image)} bytes); flash it to the sua partition, e.g.")
+    print(f"  python -m esptool --chip esp32s3 write_flash 0x710000 {out_path}")
 
 
 def main():
+    parser = argparse.ArgumentParser(description="Build the SUA catalog (SIA1 index, SIA2 geometry)")
+    parser.add_argument("--restamp", metavar="IDX",
+                        help="only rewrite IDX with altitude bands from --dbf")
+    parser.add_argument("--partition", metavar="IMAGE",
+                        help="only pack --idx and --bin into a flashable sua partition image")
+    parser.add_argument("--compact", action="store_true",
+                        help="only rewrite an SIA1 --idx/--bin pair in place with SIA2 geometry")
+    parser.add_argument("--expand", action="store_true",
+                        help="only rewrite an SIA2 --idx/--bin pair in place with SIA1 geometry")
+    parser.add_argument("--sia1", action="store_true",
+                        help="write fixed-width SIA1 geometry (readers before SIA2)")
+    parser.add_argument("--idx", default=str(IDX), help="catalog .idx paired with --partition, --compact or --expand")
+    parser.add_argument("--bin", default=str(BIN),
+                        help="catalog .bin paired with --restamp, --partition, --compact or --expand")
+    parser.add_argument("--dbf", default="special_use_airspace/Special_Use_Airspace/Special_Use_Airspace.dbf")
+    parser.add_argument("--simplify-m", type=float, default=0.0,
+                        help="grow LINE-only rings by at most this many metres to drop vertices")
+    args = parser.parse_args()
+    if args.restamp:
+        restamp_index(args.restamp, args.bin, args.dbf)
+        return
+    if args.partition:
+        pack_partition(args.idx, args.bin, args.partition)
+        return
+    if args.compact or args.expand:
+        recode_catalog(args.idx, args.bin, args.compact)
+        return
+
     data = json.loads(SRC.read_text())
     features = data.get("features", [])
     as_of = data.get("generated_at", "")
@@ -137,6 +779,7 @@ def main():
     idx_entries = []
     geom_blocks = []
     geom_offset = 0
+    simplified = dropped = 0
 
     for feat in features:
         props = feat.get("properties", {})
@@ -144,10 +787,18 @@ def main():
         if not name:
             name = f"OBJECTID-{props.get('OBJECTID', '')}"
         name_off = string_offsets.get(name, 0)
-        geom, min_lat, min_lon, max_lat, max_lon = build_geometry(feat, string_offsets)
+        grown_m = 0
+        if args.simplify_m > 0:
+            before = sum(len(r.get("segments", [])) for r in feat.get("rings", []))
+            if simplify_feature(feat, args.simplify_m):
+                grown_m = min(int(math.ceil(args.simplify_m)), 0xFFFF)
+                simplified += 1
+                dropped += before - sum(len(r.get("segments", [])) for r in feat.get("rings", []))
+        geom, min_lat, min_lon, max_lat, max_lon = build_geometry(feat, string_offsets, grown_m, not args.sia1)
         geom_blocks.append(geom)
         idx_entries.append({
             "name": name,
+            "type_code": (props.get("TYPE_CODE") or "").strip(),
             "name_offset": name_off,
             "geom_offset": geom_offset,
             "geom_length": len(geom),
@@ -155,12 +806,13 @@ def main():
             "min_lon": min_lon,
             "max_lat": max_lat,
             "max_lon": max_lon,
+            "band": altitude_band(props),
         })
         geom_offset += len(geom)
 
     bin_header = struct.pack(
         "<4sHHIII",
-        MAGIC,
+        MAGIC if args.sia1 else MAGIC_V2,
         VERSION,
         0,
         20,
@@ -169,22 +821,7 @@ def main():
     )
     BIN.write_bytes(bin_header + string_table + b"".join(geom_blocks))
 
-    idx_header = struct.pack("<4sHHII", MAGIC, VERSION, 32, len(idx_entries), 0)
-    idx_data = bytearray()
-    for entry in idx_entries:
-        id_hash = fnv1a_32(entry["name"].upper())
-        idx_data.extend(struct.pack(
-            "<IIIIiiii",
-            id_hash,
-            entry["name_offset"],
-            entry["geom_offset"],
-            entry["geom_length"],
-            entry["min_lat"],
-            entry["min_lon"],
-            entry["max_lat"],
-            entry["max_lon"],
-        ))
-    IDX.write_bytes(idx_header + idx_data)
+    IDX.write_bytes(pack_index(idx_entries))
 
     meta = {
         "as_of": as_of,
@@ -193,6 +830,8 @@ def main():
     META.write_text(json.dumps(meta, separators=(",", ":")))
 
     print(f"Wrote {IDX} and {BIN} ({len(idx_entries)} areas)")
+    if args.simplify_m > 0:
+        print(f"Simplified {simplified} areas to {args.simplify_m:g} m, {dropped} vertices dropped")
 
 
 if __name__ == "__main__":
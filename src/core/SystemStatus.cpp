@@ -11,6 +11,9 @@ namespace {
   int s_batteryPct = -1;
   uint8_t s_geoCount = 0;
   bool s_geoOk = true;
+  bool s_geoMarginValid = false;
+  float s_geoMarginM = 0.0f;
+  float s_geoClosingMps = 0.0f;
   bool s_containedLaunch = false;
 }
 
@@ -71,6 +74,13 @@ void setGeoStatus(uint8_t count, bool ok)
   s_geoOk = ok;
 }
 
+void setGeoMargin(bool valid, float meters, float closingMps)
+{
+  s_geoMarginValid = valid;
+  s_geoMarginM = meters;
+  s_geoClosingMps = closingMps;
+}
+
 void setContainedLaunch(bool inside)
 {
   s_containedLaunch = inside;
@@ -85,6 +95,9 @@ const char *satcomState() { return s_satcomState; }
 int batteryPct() { return s_batteryPct; }
 uint8_t geoCount() { return s_geoCount; }
 bool geoOk() { return s_geoOk; }
+bool geoMarginValid() { return s_geoMarginValid; }
+float geoMarginM() { return s_geoMarginM; }
+float geoClosingMps() { return s_geoClosingMps; }
 bool containedLaunch() { return s_containedLaunch; }
 
 }  // namespace SystemStatus
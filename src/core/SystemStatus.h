@@ -12,6 +12,7 @@ void setLoraState(const char *state);
 void setSatcomState(const char *state);
 void setBatteryPct(int pct);
 void setGeoStatus(uint8_t count, bool ok);
+void setGeoMargin(bool valid, float meters, float closingMps);
 void setContainedLaunch(bool inside);
 
 const char *callsign();
@@ -23,6 +24,9 @@ const char *satcomState();
 int batteryPct();
 uint8_t geoCount();
 bool geoOk();
+bool geoMarginValid();
+float geoMarginM();
+float geoClosingMps();
 bool containedLaunch();
 
 }  // namespace SystemStatus
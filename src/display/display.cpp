@@ -26,6 +26,8 @@ static const char *lora = "Disabled";
 static uint8_t batteryPct = 0;
 static uint8_t geoCount = 0;
 static bool geoOk = true;
+static bool geoMarginValid = false;
+static float geoMarginM = 0.0f;
 static const char *flightState = "GROUND";
 static char flightBuf[12] = "GROUND";
 static const char *holdState = "HOLD";
@@ -120,6 +122,20 @@ void display_show_status()
 
     u8g2.drawStr(xLabel, 48, "LoRa:");
     u8g2.drawStr(xVal,   48, lora);
+    if (geoMarginValid) {
+        // Distance to the nearest geofence boundary, negative when violating.
+        char marginBuf[8];
+        const float m = geoMarginM;
+        if (fabsf(m) < 1000.0f) {
+            snprintf(marginBuf, sizeof(marginBuf), "%dm", (int)m);
+        } else if (fabsf(m) < 10000.0f) {
+            snprintf(marginBuf, sizeof(marginBuf), "%.1fk", m / 1000.0f);
+        } else {
+            snprintf(marginBuf, sizeof(marginBuf), "%dk", (int)(m / 1000.0f) > 999 ? 999 : (int)(m / 1000.0f));
+        }
+        int marginWidth = u8g2.getStrWidth(marginBuf);
+        u8g2.drawStr(128 - marginWidth, 48, marginBuf);
+    }
 
     u8g2.drawStr(xLabel, 60, "STATUS:");
     int holdWidth = u8g2.getStrWidth(holdState);
@@ -164,6 +180,7 @@ void display_set_satcom(const char *s) {
 void display_set_lora(const char *s) { lora = s; }
 void display_set_battery(uint8_t p) { batteryPct = p; }
 void display_set_geo(uint8_t count, bool ok) { geoCount = count; geoOk = ok; }
+void display_set_geo_margin(bool valid, float meters) { geoMarginValid = valid; geoMarginM = meters; }
 void display_set_flight_state(const char *state) {
     if (!state) state = "";
     if (strcasecmp(state, "GROUND") == 0 || strcasecmp(state, "GND") == 0) {
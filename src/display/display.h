@@ -14,6 +14,7 @@ void display_set_satcom(const char *state);
 void display_set_lora(const char *state);
 void display_set_battery(uint8_t pct);
 void display_set_geo(uint8_t count, bool ok);
+void display_set_geo_margin(bool valid, float meters);
 void display_set_flight_state(const char *state);
 void display_set_hold_state(const char *state);
 void display_set_balloon_type(const char *type);
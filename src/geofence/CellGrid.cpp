@@ -0,0 +1,248 @@
+#include "geofence/CellGrid.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include "geofence/GeoMath.h"
+
+namespace {
+  bool sameExtent(const CellGrid::Extent &a, const CellGrid::Extent &b)
+  {
+    return a.rows == b.rows && a.cols == b.cols &&
+           a.box.min_lat == b.box.min_lat && a.box.min_lon == b.box.min_lon &&
+           a.box.max_lat == b.box.max_lat && a.box.max_lon == b.box.max_lon;
+  }
+
+  bool sameBox(const CellGrid::Box &a, const CellGrid::Box &b)
+  {
+    return a.min_lat == b.min_lat && a.min_lon == b.min_lon &&
+           a.max_lat == b.max_lat && a.max_lon == b.max_lon;
+  }
+
+  // First integer offset mapped to slot i of n over span (ceil(i * span / n)).
+  int64_t slotStart(uint32_t i, uint32_t n, int64_t span)
+  {
+    return ((int64_t)i * span + n - 1) / n;
+  }
+
+  uint32_t slotOf(int32_t v, int32_t lo, int64_t span, uint32_t n)
+  {
+    if (v <= lo) return 0;
+    const int64_t s = ((int64_t)v - lo) * n / span;
+    return s >= n ? n - 1 : (uint32_t)s;
+  }
+}
+
+CellGrid::Extent CellGrid::extentFor(const Box &b)
+{
+  const int64_t span_lat = (int64_t)b.max_lat - b.min_lat + 1;
+  const int64_t span_lon = (int64_t)b.max_lon - b.min_lon + 1;
+  const int32_t mid_lat = (int32_t)(((int64_t)b.min_lat + b.max_lat) / 2);
+  const double h = (double)span_lat * (GeoMath::kMetersPerDegLat / 1e6);
+  const double w = (double)span_lon * GeoMath::metersPerLonE6(mid_lat);
+  double cols = floor(sqrt((double)kMaxCells * w / h));
+  cols = std::max(1.0, std::min(cols, std::min((double)kMaxCells, (double)span_lon)));
+  double rows = floor((double)kMaxCells / cols);
+  rows = std::max(1.0, std::min(rows, (double)span_lat));
+  return Extent{b, (uint16_t)rows, (uint16_t)cols};
+}
+
+void CellGrid::clear()
+{
+  _extent = Extent{Box{0, 0, 0, 0}, 0, 0};
+  _cells.clear();
+  _setStart.clear();
+  _setItems.clear();
+  _boxes.clear();
+  _keys.clear();
+}
+
+size_t CellGrid::countCells(uint8_t value) const
+{
+  return (size_t)std::count(_cells.begin(), _cells.end(), value);
+}
+
+CellGrid::Box CellGrid::blockBox(uint32_t r0, uint32_t r1, uint32_t c0, uint32_t c1) const
+{
+  const Box &b = _extent.box;
+  const int64_t span_lat = (int64_t)b.max_lat - b.min_lat + 1;
+  const int64_t span_lon = (int64_t)b.max_lon - b.min_lon + 1;
+  return Box{(int32_t)(b.min_lat + slotStart(r0, _extent.rows, span_lat)),
+             (int32_t)(b.min_lon + slotStart(c0, _extent.cols, span_lon)),
+             (int32_t)(b.min_lat + slotStart(r1, _extent.rows, span_lat) - 1),
+             (int32_t)(b.min_lon + slotStart(c1, _extent.cols, span_lon) - 1)};
+}
+
+uint8_t CellGrid::setFor(const std::vector<uint16_t> &items)
+{
+  const size_t sets = setCount();
+  for (size_t s = 0; s < sets; s++) {
+    const uint32_t begin = _setStart[s];
+    if (_setStart[s + 1] - begin == items.size() &&
+        std::equal(items.begin(), items.end(), _setItems.begin() + begin)) {
+      return (uint8_t)(s + 1);
+    }
+  }
+  if (sets >= kMaxSets) return kExact;
+  _setItems.insert(_setItems.end(), items.begin(), items.end());
+  _setStart.push_back((uint32_t)_setItems.size());
+  return (uint8_t)(sets + 1);
+}
+
+uint32_t CellGrid::rebuild(const Extent &extent, std::vector<Box> &&boxes, std::vector<uint32_t> &&keys,
+                           const CellGrid &prev, Classify classify, void *ctx)
+{
+  clear();
+  const uint32_t n = (uint32_t)extent.rows * extent.cols;
+  if (n == 0 || n > kMaxCells || boxes.empty() || boxes.size() != keys.size()) return 0;
+  _extent = extent;
+  _boxes = std::move(boxes);
+  _keys = std::move(keys);
+  _cells.assign(n, kExact);
+  _setStart.assign(1, 0);
+
+  std::vector<uint8_t> dirty(n, 1);
+  if (!prev.empty() && sameExtent(prev._extent, _extent)) {
+    // Pair unchanged items by key; the rest mark their boxes dirty.
+    std::vector<std::pair<uint32_t, uint16_t>> order;
+    order.reserve(_keys.size());
+    for (size_t i = 0; i < _keys.size(); i++) order.push_back(std::make_pair(_keys[i], (uint16_t)i));
+    std::sort(order.begin(), order.end());
+    std::vector<uint8_t> matched(_keys.size(), 0);
+    std::vector<int32_t> remap(prev._keys.size(), -1);
+    for (size_t p = 0; p < prev._keys.size(); p++) {
+      auto it = std::lower_bound(order.begin(), order.end(), std::make_pair(prev._keys[p], (uint16_t)0));
+      for (; it != order.end() && it->first == prev._keys[p]; ++it) {
+        if (!matched[it->second] && sameBox(_boxes[it->second], prev._boxes[p])) {
+          matched[it->second] = 1;
+          remap[p] = it->second;
+          break;
+        }
+      }
+    }
+
+    std::fill(dirty.begin(), dirty.end(), 0);
+    const Box &g = _extent.box;
+    const int64_t span_lat = (int64_t)g.max_lat - g.min_lat + 1;
+    const int64_t span_lon = (int64_t)g.max_lon - g.min_lon + 1;
+    auto markDirty = [&](const Box &b) {
+      if (b.max_lat < g.min_lat || b.min_lat > g.max_lat || b.max_lon < g.min_lon || b.min_lon > g.max_lon) {
+        return;
+      }
+      const uint32_t r0 = slotOf(b.min_lat, g.min_lat, span_lat, _extent.rows);
+      const uint32_t r1 = slotOf(b.max_lat, g.min_lat, span_lat, _extent.rows);
+      const uint32_t c0 = slotOf(b.min_lon, g.min_lon, span_lon, _extent.cols);
+      const uint32_t c1 = slotOf(b.max_lon, g.min_lon, span_lon, _extent.cols);
+      for (uint32_t r = r0; r <= r1; r++) {
+        memset(&dirty[r * _extent.cols + c0], 1, c1 - c0 + 1);
+      }
+    };
+    for (size_t i = 0; i < _boxes.size(); i++) {
+      if (!matched[i]) markDirty(_boxes[i]);
+    }
+    for (size_t p = 0; p < prev._boxes.size(); p++) {
+      if (remap[p] < 0) markDirty(prev._boxes[p]);
+    }
+
+    std::vector<uint16_t> items;
+    for (uint32_t k = 0; k < n; k++) {
+      if (dirty[k]) continue;
+      const uint8_t v = prev._cells[k];
+      if (v == kClear || v == kExact) {
+        _cells[k] = v;
+        continue;
+      }
+      items.clear();
+      for (const uint16_t *it = prev.setBegin(v); it != prev.setEnd(v); ++it) {
+        if (remap[*it] < 0) break;
+        items.push_back((uint16_t)remap[*it]);
+      }
+      if (items.size() != (size_t)(prev.setEnd(v) - prev.setBegin(v))) {
+        dirty[k] = 1;
+        continue;
+      }
+      std::sort(items.begin(), items.end());
+      _cells[k] = setFor(items);
+    }
+  }
+
+  Build b{classify, ctx, &dirty, 0};
+  std::vector<uint16_t> all(_boxes.size());
+  for (size_t i = 0; i < all.size(); i++) all[i] = (uint16_t)i;
+  fill(b, 0, _extent.rows, 0, _extent.cols, all, std::vector<uint16_t>());
+  return b.classified;
+}
+
+void CellGrid::fill(Build &b, uint32_t r0, uint32_t r1, uint32_t c0, uint32_t c1,
+                    const std::vector<uint16_t> &undecided, const std::vector<uint16_t> &inside)
+{
+  const std::vector<uint8_t> &dirty = *b.dirty;
+  bool any = false;
+  for (uint32_t r = r0; r < r1 && !any; r++) {
+    for (uint32_t c = c0; c < c1 && !any; c++) any = dirty[r * _extent.cols + c] != 0;
+  }
+  if (!any) return;
+
+  // Items settle for the whole block or stay open for its quarters.
+  const Box box = blockBox(r0, r1, c0, c1);
+  std::vector<uint16_t> open;
+  std::vector<uint16_t> in = inside;
+  for (uint16_t i : undecided) {
+    const Box &ib = _boxes[i];
+    if (ib.max_lat < box.min_lat || ib.min_lat > box.max_lat ||
+        ib.max_lon < box.min_lon || ib.min_lon > box.max_lon) {
+      continue;
+    }
+    const Side s = b.classify(b.ctx, i, box);
+    if (s == Side::Inside) in.push_back(i);
+    else if (s == Side::Edge) open.push_back(i);
+  }
+
+  if (open.empty() || (r1 - r0 == 1 && c1 - c0 == 1)) {
+    uint8_t v = kExact;
+    if (open.empty()) {
+      std::sort(in.begin(), in.end());
+      v = in.empty() ? kClear : setFor(in);
+    }
+    for (uint32_t r = r0; r < r1; r++) {
+      for (uint32_t c = c0; c < c1; c++) {
+        if (!dirty[r * _extent.cols + c]) continue;
+        _cells[r * _extent.cols + c] = v;
+        b.classified++;
+      }
+    }
+    return;
+  }
+
+  const uint32_t rm = r1 - r0 > 1 ? r0 + (r1 - r0) / 2 : r1;
+  const uint32_t cm = c1 - c0 > 1 ? c0 + (c1 - c0) / 2 : c1;
+  fill(b, r0, rm, c0, cm, open, in);
+  if (cm < c1) fill(b, r0, rm, cm, c1, open, in);
+  if (rm < r1) {
+    fill(b, rm, r1, c0, cm, open, in);
+    if (cm < c1) fill(b, rm, r1, cm, c1, open, in);
+  }
+}
+
+bool CellGrid::assign(const Extent &extent, std::vector<uint8_t> &&cells, std::vector<uint32_t> &&setStart,
+                      std::vector<uint16_t> &&setItems, std::vector<Box> &&boxes, std::vector<uint32_t> &&keys)
+{
+  clear();
+  const size_t n = (size_t)extent.rows * extent.cols;
+  if (cells.empty() && setStart.empty() && setItems.empty()) return true;  // no grid was built
+  bool ok = n > 0 && n <= kMaxCells && cells.size() == n && boxes.size() == keys.size() &&
+            extent.box.min_lat <= extent.box.max_lat && extent.box.min_lon <= extent.box.max_lon &&
+            !setStart.empty() && setStart.size() - 1 <= kMaxSets &&
+            setStart.front() == 0 && setStart.back() == setItems.size();
+  for (size_t s = 1; ok && s < setStart.size(); s++) ok = setStart[s - 1] <= setStart[s];
+  for (size_t i = 0; ok && i < setItems.size(); i++) ok = setItems[i] < boxes.size();
+  for (size_t k = 0; ok && k < n; k++) ok = cells[k] == kExact || cells[k] < setStart.size();
+  if (!ok) return false;
+  _extent = extent;
+  _cells = std::move(cells);
+  _setStart = std::move(setStart);
+  _setItems = std::move(setItems);
+  _boxes = std::move(boxes);
+  _keys = std::move(keys);
+  return true;
+}
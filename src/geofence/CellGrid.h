@@ -0,0 +1,126 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Raster cache over a fixed int32 micro-degree extent. Each cell is either
+// clear of every item, wholly inside a fixed set of items with no item
+// boundary crossing it (an interior set), or needs the exact test. Cells
+// are one byte; interior sets are stored once and shared. Built top-down
+// (quadtree-style), so an item is only classified against the cells its
+// boundary actually runs through.
+//
+// A rebuild takes the previous grid: items whose key (a fingerprint of
+// their geometry) is unchanged keep their cells, and only cells under the
+// boxes of added or removed items are classified again.
+class CellGrid {
+public:
+  struct Box {
+    int32_t min_lat;
+    int32_t min_lon;
+    int32_t max_lat;
+    int32_t max_lon;
+  };
+
+  struct Extent {
+    Box box;
+    uint16_t rows;
+    uint16_t cols;
+  };
+
+  enum class Side : uint8_t {
+    Outside,
+    Inside,
+    Edge  // the item's boundary may cross the box
+  };
+
+  static constexpr uint8_t kClear = 0;     // no item covers the cell
+  static constexpr uint8_t kExact = 0xFF;  // boundary cell, or outside the grid
+  static constexpr uint32_t kMaxCells = 4096;
+  static constexpr uint32_t kMaxSets = 254;
+
+  // Roughly square cells over b, at most kMaxCells of them.
+  static Extent extentFor(const Box &b);
+
+  // Rebuilds over extent for items with the given boxes and keys, reusing
+  // prev where it allows. classify(item, box) says where the box lies
+  // relative to the item; it is only called when the two boxes overlap.
+  // Returns the number of cells classified.
+  template <typename Fn>
+  uint32_t build(const Extent &extent, std::vector<Box> &&boxes, std::vector<uint32_t> &&keys,
+                 const CellGrid &prev, Fn &&classify)
+  {
+    typedef typename std::remove_reference<Fn>::type F;
+    return rebuild(extent, std::move(boxes), std::move(keys), prev,
+                   [](void *ctx, uint32_t item, const Box &box) {
+                     return (*static_cast<F *>(ctx))(item, box);
+                   },
+                   &classify);
+  }
+  void clear();
+
+  bool empty() const { return _cells.empty(); }
+  const Extent &extent() const { return _extent; }
+  size_t cellCount() const { return _cells.size(); }
+  size_t setCount() const { return _setStart.empty() ? 0 : _setStart.size() - 1; }
+  size_t countCells(uint8_t value) const;
+
+  uint8_t at(int32_t lat, int32_t lon) const
+  {
+    const Box &b = _extent.box;
+    if (_cells.empty() || lat < b.min_lat || lat > b.max_lat || lon < b.min_lon || lon > b.max_lon) {
+      return kExact;
+    }
+    const uint32_t row = (uint32_t)((int64_t)(lat - b.min_lat) * _extent.rows /
+                                    ((int64_t)b.max_lat - b.min_lat + 1));
+    const uint32_t col = (uint32_t)((int64_t)(lon - b.min_lon) * _extent.cols /
+                                    ((int64_t)b.max_lon - b.min_lon + 1));
+    return _cells[row * _extent.cols + col];
+  }
+
+  // Items covering a cell of the given value (none for kClear).
+  const uint16_t *setBegin(uint8_t value) const
+  {
+    return value == kClear ? nullptr : _setItems.data() + _setStart[value - 1];
+  }
+  const uint16_t *setEnd(uint8_t value) const
+  {
+    return value == kClear ? nullptr : _setItems.data() + _setStart[value];
+  }
+
+  // Raw tables, for persisting a built grid. assign() takes them back,
+  // with the item boxes and keys the grid was built for, and returns false
+  // (leaving the grid empty) when they do not fit together.
+  const std::vector<uint8_t> &cells() const { return _cells; }
+  const std::vector<uint32_t> &setStarts() const { return _setStart; }
+  const std::vector<uint16_t> &setItems() const { return _setItems; }
+  bool assign(const Extent &extent, std::vector<uint8_t> &&cells, std::vector<uint32_t> &&setStart,
+              std::vector<uint16_t> &&setItems, std::vector<Box> &&boxes, std::vector<uint32_t> &&keys);
+
+private:
+  typedef Side (*Classify)(void *ctx, uint32_t item, const Box &box);
+
+  struct Build {
+    Classify classify;
+    void *ctx;
+    const std::vector<uint8_t> *dirty;
+    uint32_t classified;
+  };
+
+  uint32_t rebuild(const Extent &extent, std::vector<Box> &&boxes, std::vector<uint32_t> &&keys,
+                   const CellGrid &prev, Classify classify, void *ctx);
+  void fill(Build &b, uint32_t r0, uint32_t r1, uint32_t c0, uint32_t c1,
+            const std::vector<uint16_t> &undecided, const std::vector<uint16_t> &inside);
+  Box blockBox(uint32_t r0, uint32_t r1, uint32_t c0, uint32_t c1) const;
+  uint8_t setFor(const std::vector<uint16_t> &items);
+
+  Extent _extent = Extent{Box{0, 0, 0, 0}, 0, 0};
+  std::vector<uint8_t> _cells;      // row-major, row 0 at min_lat
+  std::vector<uint32_t> _setStart;  // set v - 1 is _setItems[_setStart[v - 1], _setStart[v])
+  std::vector<uint16_t> _setItems;  // sorted item ids per set
+  std::vector<Box> _boxes;          // per item, as built
+  std::vector<uint32_t> _keys;
+};
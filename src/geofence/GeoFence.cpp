@@ -3,14 +3,20 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <LittleFS.h>
+#include <algorithm>
+#include <math.h>
+#include <mutex>
+#include <string.h>
+#include <type_traits>
+#include <utility>
 #include <vector>
+#include "geofence/CellGrid.h"
+#include "geofence/GeoMath.h"
+#include "geofence/GeoSimplify.h"
+#include "geofence/PackedRTree.h"
+#include "geofence/SuaCatalog.h"
 
 namespace {
-  struct Point {
-    double lat;
-    double lon;
-  };
-
   enum class RuleType {
     KeepOut,
     StayIn,
@@ -24,78 +30,1159 @@ namespace {
 
   struct Rule {
     RuleType type;
-    String id;
-    String detail;
-    std::vector<Point> polygon;  // for KeepOut/StayIn
+    uint32_t id = 0;             // offset into s_strings
+    uint32_t detail = 0;         // offset into s_strings
+    uint32_t first = 0;          // first vertex in the arena (KeepOut/StayIn)
+    uint32_t count = 0;          // vertex count over all rings, closing vertices included
+    uint32_t count_in = 0;       // same, as loaded before simplification
+    uint16_t eval_ns = 0;        // sampled containment test cost (simplified rules)
+    uint16_t eval_ns_in = 0;     // same, before simplification
+    uint32_t arc_first = 0;      // first entry in s_arcs
+    uint16_t arc_count = 0;
+    uint16_t rings = 0;          // outline plus holes, stored back to back
+    int16_t sua = -1;            // index into s_sua when streamed from the catalog
+    bool sua_type = false;       // added by a "sua_type" category keep-out
+    uint16_t erode_m = 0;        // SUA stay-in: catalog geometry was grown by this
+    int32_t min_lat = 0;         // bbox, micro-degrees
+    int32_t min_lon = 0;
+    int32_t max_lat = 0;
+    int32_t max_lon = 0;
+    int32_t floor_m = SuaCatalog::kNoFloorM;    // altitude band, metres MSL
+    int32_t ceil_m = SuaCatalog::kNoCeilingM;
     LineAxis axis = LineAxis::NorthSouth;
-    double value = 0.0;          // lon for NS, lat for EW
+    int32_t value = 0;           // lon for NS, lat for EW (micro-degrees)
     bool armed = false;          // for StayIn
+    bool inside = false;         // scratch: set by the index pass in update()
   };
 
   std::vector<Rule> s_rules;
+  // Rule ids by kind so update() never scans the full rule list.
+  std::vector<uint16_t> s_stay_in_ids;
+  std::vector<uint16_t> s_line_ids;
+  // Spatial index over polygon rule bboxes and altitude bands (item id =
+  // rule index).
+  PackedRTree s_index;
+  std::vector<uint16_t> s_index_ids;
+  // Raster over the mission area (items = index slots): most fixes land in
+  // a cell no boundary crosses and skip the exact tests entirely.
+  CellGrid s_grid;
+
+  // Vertex arena shared by all polygon rules (structure of arrays, int32
+  // micro-degrees). Every ring is stored closed (first vertex repeated) so
+  // edge i is (i, i + 1); a rule's rings follow each other, and the edge
+  // from one ring's closing vertex to the next ring is a link, not a side.
+  std::vector<int32_t> s_lat;
+  std::vector<int32_t> s_lon;
+  // Per-edge deltas precomputed at load time (v[i + 1] - v[i]) so the
+  // crossing test is a single exact int64 cross product. Ring links carry
+  // a zero delta and are skipped by every edge walk.
+  std::vector<int32_t> s_dlat;
+  std::vector<int32_t> s_dlon;
+  // Arc edges: the chord stays in the vertex arena, and s_arc_edge holds the
+  // arena index of its first vertex.
+  std::vector<GeoMath::Arc> s_arcs;
+  std::vector<uint32_t> s_arc_edge;
+  // Catalog entries for rules that reference an SUA area by name; their
+  // geometry is decoded from flash on demand instead of living in the arena.
+  std::vector<SuaCatalog::Entry> s_sua;
+  // NUL-terminated rule ids/details; offset 0 is always "".
+  std::vector<char> s_strings;
   std::vector<GeoFence::Violation> s_violations;
+  // Transit events (line crossings, keep-outs clipped or stay-ins left
+  // between fixes) happen on a single hop, so the per-fix debounce alone
+  // would discard them. Each is re-checked on the next plausible fixes from
+  // the fix before its hop: still past the line, or the path from there
+  // still touching the boundary (or now inside the keep-out / outside the
+  // stay-in). The first fix that does not confirm it drops it, so one bad
+  // fix cannot latch a crossing, and if it was made on the last hop that
+  // fix is forgotten too, so the hop back from it is not a new transit.
+  // After TRANSIT_CONFIRM_FIXES confirmations it stays reported until
+  // reload() or clearViolations().
+  struct Transit {
+    uint16_t rule;
+    const char *detail;
+    int32_t from_lat;
+    int32_t from_lon;
+    uint8_t confirms;
+  };
+  std::vector<Transit> s_transits;
+
+  // Held by every public call: update() runs in loop() while the portal's
+  // AsyncTCP task validates tracks, benchmarks rules and reads stats, all
+  // over the rule arrays, the index and the grid that a load rebuilds.
+  // Recursive, as SuaCatalog's, so one public call may use another.
+  std::recursive_mutex s_lock;
+  typedef std::lock_guard<std::recursive_mutex> Guard;
 
   bool s_loaded = false;
   bool s_force_violation = false;
   bool s_has_prev = false;
-  double s_prev_lat = 0.0;
-  double s_prev_lon = 0.0;
+  int32_t s_prev_lat = 0;
+  int32_t s_prev_lon = 0;
+  float s_prev_alt = NAN;
+  uint32_t s_prev_ms = 0;
   bool s_violation_pending = false;
   uint32_t s_violation_start_ms = 0;
-  constexpr uint32_t VIOLATION_SUSTAIN_MS = 30000;
+  uint8_t s_violation_fixes = 0;
+  // Evaluation now runs per GPS fix, so debounce on consecutive violating
+  // fixes plus a short hold instead of a 30 s wall-clock window.
+  constexpr uint32_t VIOLATION_SUSTAIN_MS = 5000;
+  constexpr uint8_t VIOLATION_SUSTAIN_FIXES = 3;
+  // Later fixes that must agree with a transit before it latches.
+  constexpr uint8_t TRANSIT_CONFIRM_FIXES = VIOLATION_SUSTAIN_FIXES - 1;
+  // Slack on the cell-vs-boundary distance test (equirectangular distances
+  // drift with latitude across a block).
+  constexpr float GRID_SLACK_M = 1.0f;
+  // Containment tests timed per ring when reporting simplification savings.
+  constexpr uint32_t RING_COST_SAMPLES = 256;
+  // Tables per "sua_type" area (rule, catalog entry, id, index slot), and
+  // the free heap a load must leave once they are added for the index,
+  // the grid and the web server.
+  constexpr uint32_t SUA_TYPE_AREA_BYTES = 130;
+  constexpr uint32_t LOAD_HEAP_RESERVE = 48 * 1024;
+  // Upper bound on benchmarkRule() points (about 10 B of scratch each).
+  constexpr uint32_t BENCH_MAX_POINTS = 2048;
+  // Fix-to-fix hops faster than this are treated as GPS glitches and get
+  // no swept or line-crossing check (the endpoint tests still run).
+  constexpr float MAX_PLAUSIBLE_SPEED_MPS = 150.0f;
+  // First margin search square (half side, m) beyond the last margin, and
+  // the size at which it has covered the globe.
+  constexpr float MARGIN_SEARCH_M = 1000.0f;
+  constexpr float MARGIN_SEARCH_MAX_M = 2.0e7f;
+
+  // Signed distance to the nearest enforced boundary at the last fix.
+  bool s_margin_valid = false;
+  float s_margin_m = 0.0f;
+  float s_closing_mps = 0.0f;
+  uint32_t s_margin_ms = 0;
+  int32_t s_margin_rule = -1;
+  uint32_t s_revision = 0;
 
-  bool pointInPolygon(const std::vector<Point> &poly, double lat, double lon)
+  GeoFence::Stats s_stats;
+  GeoFence::LoadInfo s_load_info;
+  constexpr uint32_t RATE_WINDOW_MS = 1000;
+  uint32_t s_rate_window_ms = 0;
+  uint32_t s_rate_window_count = 0;
+
+  // Closes the rate window once it has run its length. A window that ran
+  // past twice its length saw no evaluations in its last second, so the
+  // rate drops to 0 instead of repeating the last busy second.
+  void rollRateWindow(uint32_t now)
   {
-    if (poly.size() < 3) return false;
-    int cnt = 0;
-    for (size_t i = 0; i < poly.size(); i++) {
-      const Point &p1 = poly[i];
-      const Point &p2 = poly[(i + 1) % poly.size()];
-      const double x1 = p1.lat;
-      const double y1 = p1.lon;
-      const double x2 = p2.lat;
-      const double y2 = p2.lon;
-      const double xp = lat;
-      const double yp = lon;
+    const uint32_t age = now - s_rate_window_ms;
+    if (age < RATE_WINDOW_MS) return;
+    s_stats.evalsPerSec = age < 2 * RATE_WINDOW_MS ? s_rate_window_count : 0;
+    s_rate_window_count = 0;
+    s_rate_window_ms = now;
+  }
+
+  // No logging here: this runs on every fix, and a UART write would add
+  // to the latency it measures. Slow evaluations show up in the stats.
+  void recordEvaluation(uint32_t start_us)
+  {
+    const uint32_t elapsed = micros() - start_us;
+    s_stats.evaluations++;
+    s_stats.lastEvalUs = elapsed;
+    if (elapsed > s_stats.worstEvalUs) s_stats.worstEvalUs = elapsed;
+    if (s_stats.slowEvalUs > 0 && elapsed > s_stats.slowEvalUs) s_stats.slowEvals++;
+
+    const uint32_t now = millis();
+    rollRateWindow(now);
+    s_rate_window_count++;
+  }
+
+  uint32_t addString(const char *text)
+  {
+    const uint32_t off = (uint32_t)s_strings.size();
+    if (!text) text = "";
+    s_strings.insert(s_strings.end(), text, text + strlen(text) + 1);
+    return off;
+  }
 
-      if (((yp < y2) != (yp < y1)) &&
-          (xp < x1 + ((yp - y1) / (y2 - y1)) * (x2 - x1))) {
-        cnt++;
+  const char *ruleString(uint32_t off)
+  {
+    return &s_strings[off];
+  }
+
+  // Mean cost (ns) of one containment test against the rule's rings,
+  // sampled on a grid over its bbox. Only used to report what
+  // simplification saved.
+  uint16_t ringCostNs(const Rule &r)
+  {
+    volatile uint32_t hits = 0;
+    const uint32_t start_us = micros();
+    for (uint32_t k = 0; k < RING_COST_SAMPLES; k++) {
+      const int32_t p_lat = r.min_lat + (int32_t)((int64_t)(r.max_lat - r.min_lat) * (k / 16) / 15);
+      const int32_t p_lon = r.min_lon + (int32_t)((int64_t)(r.max_lon - r.min_lon) * (k % 16) / 15);
+      if (GeoMath::pointInRing(&s_lat[r.first], &s_lon[r.first], &s_dlat[r.first], &s_dlon[r.first],
+                               r.count, p_lat, p_lon)) {
+        hits = hits + 1;
       }
     }
-    return (cnt % 2) == 1;
+    const uint32_t ns = (micros() - start_us) * 1000u / RING_COST_SAMPLES;
+    return (uint16_t)min(ns, (uint32_t)0xFFFF);
+  }
+
+  // One ring as parsed: open (closing vertex not repeated), plus the index
+  // it had in the JSON (0 = "polygon", k = holes[k - 1]) for arcs to refer to.
+  struct RingIn {
+    std::vector<int32_t> lat;
+    std::vector<int32_t> lon;
+    uint32_t src = 0;
+  };
+
+  RingIn parseRing(JsonArray pts, uint32_t src)
+  {
+    RingIn ring;
+    ring.src = src;
+    for (JsonArray p : pts) {
+      if (p.size() < 2) continue;
+      ring.lat.push_back(GeoMath::toE6(p[0].as<double>()));
+      ring.lon.push_back(GeoMath::toE6(p[1].as<double>()));
+    }
+    const size_t n = ring.lat.size();
+    if (n >= 2 && ring.lat[0] == ring.lat[n - 1] && ring.lon[0] == ring.lon[n - 1]) {
+      ring.lat.pop_back();  // portal sends closed rings; keep distinct vertices
+      ring.lon.pop_back();
+    }
+    return ring;
   }
 
-  bool crossedLine(LineAxis axis, double value,
-                   double prev_lat, double prev_lon,
-                   double lat, double lon)
+  bool ringHasArc(JsonArray arcs, uint32_t src)
   {
-    if (axis == LineAxis::NorthSouth) {
-      const double a = prev_lon - value;
-      const double b = lon - value;
-      return (a == 0.0) ? (b != 0.0) : (a < 0.0 && b >= 0.0) || (a > 0.0 && b <= 0.0);
+    for (JsonObject a : arcs) {
+      if ((a["ring"] | 0u) == src) return true;
     }
-    const double a = prev_lat - value;
-    const double b = lat - value;
-    return (a == 0.0) ? (b != 0.0) : (a < 0.0 && b >= 0.0) || (a > 0.0 && b <= 0.0);
+    return false;
   }
 
-  void addViolation(const Rule &rule, const char *detail)
+  bool ringContains(const RingIn &ring, int32_t lat, int32_t lon)
+  {
+    bool inside = false;
+    const size_t n = ring.lat.size();
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+      if (GeoMath::crossesRay(ring.lat[j], ring.lon[j], ring.lat[i], ring.lon[i], lat, lon)) inside = !inside;
+    }
+    return inside;
+  }
+
+  // True when an edge of one ring touches an edge of another. Simplifying
+  // a stay-in pulls its outline in and pushes its holes out, so the two
+  // can meet; such a rule keeps its rings as loaded.
+  bool ringsTouch(const std::vector<RingIn> &rings)
+  {
+    for (size_t a = 0; a < rings.size(); a++) {
+      const RingIn &ra = rings[a];
+      for (size_t b = a + 1; b < rings.size(); b++) {
+        const RingIn &rb = rings[b];
+        for (size_t i = 0, pi = ra.lat.size() - 1; i < ra.lat.size(); pi = i++) {
+          const int32_t min_lat = min(ra.lat[pi], ra.lat[i]), max_lat = max(ra.lat[pi], ra.lat[i]);
+          const int32_t min_lon = min(ra.lon[pi], ra.lon[i]), max_lon = max(ra.lon[pi], ra.lon[i]);
+          for (size_t k = 0, pk = rb.lat.size() - 1; k < rb.lat.size(); pk = k++) {
+            if (max(rb.lat[pk], rb.lat[k]) < min_lat || min(rb.lat[pk], rb.lat[k]) > max_lat ||
+                max(rb.lon[pk], rb.lon[k]) < min_lon || min(rb.lon[pk], rb.lon[k]) > max_lon) {
+              continue;
+            }
+            if (GeoMath::segmentsIntersect(ra.lat[pi], ra.lon[pi], ra.lat[i], ra.lon[i],
+                                           rb.lat[pk], rb.lon[pk], rb.lat[k], rb.lon[k])) {
+              return true;
+            }
+          }
+        }
+      }
+    }
+    return false;
+  }
+
+  // Writes the rings closed and back to back from the rule's first vertex,
+  // with their edge deltas and the rule's bbox. Each closing vertex gets a
+  // zero delta, which makes the link to the next ring inert.
+  void storeRings(Rule &r, const std::vector<RingIn> &rings)
+  {
+    s_lat.resize(r.first);
+    s_lon.resize(r.first);
+    for (const RingIn &ring : rings) {
+      s_lat.insert(s_lat.end(), ring.lat.begin(), ring.lat.end());
+      s_lon.insert(s_lon.end(), ring.lon.begin(), ring.lon.end());
+      s_lat.push_back(ring.lat[0]);
+      s_lon.push_back(ring.lon[0]);
+    }
+    r.count = (uint32_t)(s_lat.size() - r.first);
+    r.rings = (uint16_t)rings.size();
+
+    r.min_lat = r.max_lat = s_lat[r.first];
+    r.min_lon = r.max_lon = s_lon[r.first];
+    s_dlat.resize(s_lat.size());
+    s_dlon.resize(s_lat.size());
+    for (uint32_t i = r.first; i < r.first + r.count; i++) {
+      if (s_lat[i] < r.min_lat) r.min_lat = s_lat[i];
+      if (s_lat[i] > r.max_lat) r.max_lat = s_lat[i];
+      if (s_lon[i] < r.min_lon) r.min_lon = s_lon[i];
+      if (s_lon[i] > r.max_lon) r.max_lon = s_lon[i];
+      const bool closing = i + 1 == r.first + r.count;
+      s_dlat[i] = closing ? 0 : s_lat[i + 1] - s_lat[i];
+      s_dlon[i] = closing ? 0 : s_lon[i + 1] - s_lon[i];
+    }
+    uint32_t v = r.first;
+    for (const RingIn &ring : rings) {
+      v += (uint32_t)ring.lat.size();
+      s_dlat[v] = 0;
+      s_dlon[v] = 0;
+      v++;
+    }
+  }
+
+  // Appends a polygon to the vertex arena and fills the rule's range, bbox
+  // and edge deltas. "polygon" is the outline and optional "holes" are
+  // further rings; all rings combine even-odd, so a hole cuts the area out
+  // and a ring inside a hole is an island. Optional arcs replace ring edges:
+  //   {"edge": i, "center": [lat, lon], "ccw": true, "ring": k}
+  // bends the edge from vertex i to i + 1 of ring k (0 = the outline,
+  // default). A single vertex plus an arc on edge 0 is a full circle. An
+  // outline with too few vertices leaves an empty range; such holes are
+  // dropped. Arc-free rules are simplified to simplify_m first: the area
+  // only grows for keep-outs and only shrinks for stay-ins, so holes move
+  // the other way from outlines.
+  void addPolygon(Rule &r, JsonObject o, float simplify_m)
+  {
+    JsonArray arcs = o["arcs"].as<JsonArray>();
+    r.first = (uint32_t)s_lat.size();
+    r.count = 0;
+    r.rings = 0;
+    r.arc_first = (uint32_t)s_arcs.size();
+    r.arc_count = 0;
+    std::vector<RingIn> rings;
+    rings.push_back(parseRing(o["polygon"].as<JsonArray>(), 0));
+    uint32_t src = 1;
+    for (JsonArray hole : o["holes"].as<JsonArray>()) {
+      rings.push_back(parseRing(hole, src++));
+    }
+    for (size_t k = 0; k < rings.size();) {
+      const size_t n = rings[k].lat.size();
+      if (n == 0 || (n < 3 && !ringHasArc(arcs, rings[k].src))) {
+        if (k == 0) return;
+        rings.erase(rings.begin() + k);
+        continue;
+      }
+      k++;
+    }
+
+    storeRings(r, rings);
+    r.count_in = r.count;
+    if (simplify_m > 0.0f && arcs.size() == 0) {
+      r.eval_ns_in = ringCostNs(r);
+      std::vector<RingIn> simple = rings;
+      for (size_t k = 0; k < simple.size(); k++) {
+        RingIn &ring = simple[k];
+        // Nesting depth decides whether the ring bounds area or a hole.
+        bool hole = false;
+        for (size_t j = 0; j < rings.size(); j++) {
+          if (j != k && ringContains(rings[j], rings[k].lat[0], rings[k].lon[0])) hole = !hole;
+        }
+        if (ring.lat.size() <= 3) continue;
+        const size_t n = GeoSimplify::conservative(ring.lat.data(), ring.lon.data(), ring.lat.size(),
+                                                   simplify_m, (r.type == RuleType::KeepOut) != hole);
+        ring.lat.resize(n);
+        ring.lon.resize(n);
+      }
+      if (simple.size() > 1 && ringsTouch(simple)) {
+        Serial.printf("[GEOFENCE] %s rings meet when simplified, kept as loaded\n", ruleString(r.id));
+      } else {
+        storeRings(r, simple);
+        rings.swap(simple);
+      }
+    }
+
+    uint32_t ring_first = r.first;
+    for (const RingIn &ring : rings) {
+      const uint32_t n = (uint32_t)ring.lat.size();
+      for (JsonObject a : arcs) {
+        if ((a["ring"] | 0u) != ring.src) continue;
+        const uint32_t edge = a["edge"] | 0u;
+        JsonArray c = a["center"].as<JsonArray>();
+        const uint32_t v = ring_first + edge;
+        bool taken = false;
+        for (uint32_t k = r.arc_first; k < s_arc_edge.size(); k++) taken |= s_arc_edge[k] == v;
+        if (edge >= n || c.size() < 2 || taken) continue;
+        GeoMath::Arc arc;
+        if (!GeoMath::makeArc(s_lat[v], s_lon[v], s_lat[v + 1], s_lon[v + 1],
+                              GeoMath::toE6(c[0].as<double>()), GeoMath::toE6(c[1].as<double>()),
+                              a["radius_m"] | 0u, a["ccw"] | true, arc)) {
+          continue;  // stays a straight edge
+        }
+        GeoMath::arcBounds(arc, r.min_lat, r.min_lon, r.max_lat, r.max_lon);
+        s_arcs.push_back(arc);
+        s_arc_edge.push_back(v);
+        r.arc_count++;
+      }
+      ring_first += n + 1;
+    }
+    // Keep arcs in arena order so boundary walks can merge them with edges.
+    for (uint32_t i = r.arc_first + 1; i < s_arcs.size(); i++) {
+      for (uint32_t k = i; k > r.arc_first && s_arc_edge[k - 1] > s_arc_edge[k]; k--) {
+        std::swap(s_arc_edge[k - 1], s_arc_edge[k]);
+        std::swap(s_arcs[k - 1], s_arcs[k]);
+      }
+    }
+    if (rings[0].lat.size() < 3 && r.arc_count == 0) {
+      s_lat.resize(r.first);
+      s_lon.resize(r.first);
+      r.count = 0;
+      r.rings = 0;
+      return;
+    }
+
+    if (r.eval_ns_in > 0) {
+      r.eval_ns = ringCostNs(r);
+      Serial.printf("[GEOFENCE] %s simplified %lu -> %lu vertices, test %uns -> %uns\n",
+                    ruleString(r.id), (unsigned long)r.count_in, (unsigned long)r.count,
+                    (unsigned)r.eval_ns_in, (unsigned)r.eval_ns);
+    }
+  }
+
+  // Points the rule at a catalog entry: bbox and band from the index.
+  void useSuaEntry(Rule &r, const SuaCatalog::Entry &e)
+  {
+    r.sua = (int16_t)s_sua.size();
+    s_sua.push_back(e);
+    SuaCatalog::GeometryReader rd;
+    if (rd.open(e)) r.rings = rd.ringCount();
+    r.min_lat = e.min_lat;
+    r.min_lon = e.min_lon;
+    r.max_lat = e.max_lat;
+    r.max_lon = e.max_lon;
+    r.floor_m = e.floor_m;
+    r.ceil_m = e.ceil_m;
+    if (r.type == RuleType::StayIn) r.erode_m = SuaCatalog::grownM(e);
+  }
+
+  // Resolves an "sua" reference against the catalog and points the rule at
+  // it. False leaves the rule untouched so the inline polygon is used.
+  bool addSuaArea(Rule &r, const char *name)
+  {
+    if (!name || !*name) return false;
+    if (!SuaCatalog::ready() && !SuaCatalog::begin()) return false;
+    const int32_t idx = SuaCatalog::findByName(name);
+    SuaCatalog::Entry e;
+    if (idx < 0 || !SuaCatalog::entry((uint32_t)idx, e)) {
+      Serial.printf("[GEOFENCE] SUA area not in catalog: %s\n", name);
+      return false;
+    }
+    useSuaEntry(r, e);
+    return true;
+  }
+
+  // Optional "floor_m"/"ceil_m" (metres MSL) override the catalog band.
+  void parseBand(Rule &r, JsonObject o)
+  {
+    if (o.containsKey("floor_m")) r.floor_m = (int32_t)floorf(o["floor_m"].as<float>());
+    if (o.containsKey("ceil_m")) r.ceil_m = (int32_t)ceilf(o["ceil_m"].as<float>());
+    if (r.floor_m > r.ceil_m) {
+      Serial.printf("[GEOFENCE] empty altitude band on %s, ignored\n", ruleString(r.id));
+      r.floor_m = SuaCatalog::kNoFloorM;
+      r.ceil_m = SuaCatalog::kNoCeilingM;
+    }
+  }
+
+  // Keep-outs for every catalog area of one airspace type ("sua_type":
+  // "R"), taken from the index's type section without decoding geometry.
+  // With stay-ins loaded, only areas overlapping their bbox are added: the
+  // flight cannot reach the others without leaving the stay-in first.
+  // Band overrides on the category apply to each area. All of them go
+  // into the index and the grid; false when the heap cannot hold them,
+  // which fails the load rather than fly with part of the category.
+  bool addSuaType(JsonObject o, bool clip, const PackedRTree::Box &area)
+  {
+    const char *code = o["sua_type"] | "";
+    if (!SuaCatalog::ready() && !SuaCatalog::begin()) return true;
+    const int32_t t = SuaCatalog::findType(code);
+    if (t < 0) {
+      Serial.printf("[GEOFENCE] SUA type not in catalog index: %s\n", code);
+      return true;
+    }
+    std::vector<uint32_t> areas;
+    if (clip) {
+      SuaCatalog::queryType((size_t)t, area.min_lat, area.min_lon, area.max_lat, area.max_lon, areas);
+    } else {
+      SuaCatalog::queryType((size_t)t, INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX, areas);
+    }
+    const uint32_t need = (uint32_t)areas.size() * SUA_TYPE_AREA_BYTES;
+    const uint32_t free_heap = ESP.getFreeHeap();
+    if (free_heap < need + LOAD_HEAP_RESERVE) {
+      Serial.printf("[GEOFENCE] SUA type %s: %u areas need %u B, %u B free (add a stay-in to narrow it)\n", code,
+                    (unsigned)areas.size(), (unsigned)need, (unsigned)free_heap);
+      s_load_info.suaTypeRefused += (uint32_t)areas.size();
+      return false;
+    }
+    const uint32_t detail = addString(o["id"] | code);
+    char name[64];
+    for (uint32_t idx : areas) {
+      SuaCatalog::Entry e;
+      if (!SuaCatalog::entry(idx, e) || !SuaCatalog::name(e, name, sizeof(name))) continue;
+      Rule r;
+      r.type = RuleType::KeepOut;
+      r.id = addString(name);
+      r.detail = detail;
+      r.sua_type = true;
+      useSuaEntry(r, e);
+      parseBand(r, o);
+      s_rules.push_back(r);
+    }
+    Serial.printf("[GEOFENCE] SUA type %s: %u keep-outs\n", code, (unsigned)areas.size());
+    return true;
+  }
+
+  bool hasBand(const Rule &r)
+  {
+    return r.floor_m != SuaCatalog::kNoFloorM || r.ceil_m != SuaCatalog::kNoCeilingM;
+  }
+
+  // Vertical distance (m) from alt to the rule's band; 0 inside the band or
+  // when the altitude is unknown.
+  float bandGap(const Rule &r, float alt)
+  {
+    if (isnan(alt)) return 0.0f;
+    if (r.floor_m != SuaCatalog::kNoFloorM && alt < (float)r.floor_m) return (float)r.floor_m - alt;
+    if (r.ceil_m != SuaCatalog::kNoCeilingM && alt > (float)r.ceil_m) return alt - (float)r.ceil_m;
+    return 0.0f;
+  }
+
+  // Vertical distance (m) from alt inside the band to its nearer edge.
+  float bandDepth(const Rule &r, float alt)
+  {
+    float d = INFINITY;
+    if (isnan(alt)) return d;
+    if (r.floor_m != SuaCatalog::kNoFloorM) d = alt - (float)r.floor_m;
+    if (r.ceil_m != SuaCatalog::kNoCeilingM) d = min(d, (float)r.ceil_m - alt);
+    return d;
+  }
+
+  bool hasArea(const Rule &r)
+  {
+    return r.sua >= 0 || r.count >= 4 || r.arc_count > 0;
+  }
+
+  bool pointInRule(const Rule &r, int32_t lat, int32_t lon)
+  {
+    if (!hasArea(r)) return false;
+    if (lat < r.min_lat || lat > r.max_lat || lon < r.min_lon || lon > r.max_lon) {
+      return false;
+    }
+    if (r.sua >= 0) {
+      const SuaCatalog::Entry &e = s_sua[r.sua];
+      if (!SuaCatalog::contains(e, lat, lon)) return false;
+      return r.erode_m == 0 || SuaCatalog::boundaryDistanceM(e, lat, lon) >= (float)r.erode_m;
+    }
+    bool inside = GeoMath::pointInRing(&s_lat[r.first], &s_lon[r.first],
+                                       &s_dlat[r.first], &s_dlon[r.first],
+                                       r.count, lat, lon);
+    for (uint32_t i = r.arc_first; i < r.arc_first + r.arc_count; i++) {
+      if (GeoMath::inArcSegment(s_arcs[i], lat, lon)) inside = !inside;
+    }
+    return inside;
+  }
+
+  // Distance (m) from p to the rule's boundary; arcs replace their chords.
+  float boundaryDistance(const Rule &r, int32_t lat, int32_t lon)
+  {
+    if (r.sua >= 0) {
+      const SuaCatalog::Entry &e = s_sua[r.sua];
+      const float d = SuaCatalog::boundaryDistanceM(e, lat, lon);
+      if (r.erode_m == 0) return d;
+      // Distance to the boundary pulled in by erode_m.
+      return SuaCatalog::contains(e, lat, lon) ? fabsf(d - (float)r.erode_m) : d + (float)r.erode_m;
+    }
+    float best = INFINITY;
+    uint32_t k = r.arc_first;
+    const uint32_t arc_end = r.arc_first + r.arc_count;
+    for (uint32_t i = r.first; i + 1 < r.first + r.count; i++) {
+      float d;
+      if (k < arc_end && s_arc_edge[k] == i) {
+        d = GeoMath::arcDistanceM(s_arcs[k++], lat, lon);
+      } else if (s_dlat[i] == 0 && s_dlon[i] == 0) {
+        continue;  // link to the next ring
+      } else {
+        d = GeoMath::segmentDistanceM(s_lat[i], s_lon[i], s_lat[i + 1], s_lon[i + 1], lat, lon);
+      }
+      if (d < best) best = d;
+    }
+    return best;
+  }
+
+  // Index box around p holding everything within radius_m of it, in the
+  // bboxDistanceM() frame.
+  PackedRTree::Box marginBox(int32_t lat, int32_t lon, float radius_m)
+  {
+    const double half_lat = (double)radius_m / (GeoMath::kMetersPerDegLat / 1e6) + 1.0;
+    const double half_lon = (double)radius_m / max(GeoMath::metersPerLonE6(lat), 1e-6f) + 1.0;
+    auto clamp = [](double v) { return (int32_t)max(min(v, (double)INT32_MAX), (double)INT32_MIN); };
+    return PackedRTree::Box{clamp(lat - half_lat), clamp(lon - half_lon), clamp(lat + half_lat),
+                            clamp(lon + half_lon), PackedRTree::kAltMin, PackedRTree::kAltMax};
+  }
+
+  bool boxesOverlap(const PackedRTree::Box &a, int32_t min_lat, int32_t min_lon, int32_t max_lat, int32_t max_lon)
+  {
+    return a.min_lat <= max_lat && min_lat <= a.max_lat && a.min_lon <= max_lon && min_lon <= a.max_lon;
+  }
+
+  // Nearest enforced boundary, signed so the violating side is negative.
+  // Unarmed stay-ins cannot trip yet and are ignored; lines count their
+  // distance either side. Rules are prisms: inside one, the nearer of the
+  // walls and the band edges counts; outside, the vertical gap combines
+  // with the horizontal distance. Rules whose bbox or band is already
+  // farther than the best candidate are skipped without walking their edges;
+  // candidates come from index queries around the fix, not every rule.
+  void updateMargin(int32_t lat, int32_t lon, float alt)
+  {
+    float best = INFINITY;
+    int32_t best_rule = -1;
+    uint32_t evaluated = 0;
+    auto consider = [&](uint16_t id) {
+      const Rule &r = s_rules[id];
+      if (r.type == RuleType::StayIn && !r.armed) return;
+      const bool violating = (r.type == RuleType::KeepOut) ? r.inside : !r.inside;
+      const float gap = bandGap(r, alt);
+      if (!violating &&
+          max(gap, GeoMath::bboxDistanceM(r.min_lat, r.min_lon, r.max_lat, r.max_lon, lat, lon)) >= best) {
+        return;
+      }
+      evaluated++;
+      float d;
+      if (r.inside) {
+        d = min(boundaryDistance(r, lat, lon), bandDepth(r, alt));
+      } else if (gap > 0.0f && pointInRule(r, lat, lon)) {
+        d = gap;  // right above or below it
+      } else {
+        d = hypotf(boundaryDistance(r, lat, lon), gap);
+      }
+      const float m = violating ? -d : d;
+      if (m < best) {
+        best = m;
+        best_rule = id;
+      }
+    };
+
+    // Armed stay-ins we are outside of may be anywhere; there are few.
+    for (uint16_t id : s_stay_in_ids) {
+      if (s_rules[id].armed && !s_rules[id].inside) consider(id);
+    }
+    // Everything else from the index, in squares growing from the last
+    // margin until the best so far lies within the square searched: any
+    // rule outside it is further away than that by its bbox alone.
+    // Keep-outs we are inside hold the fix in their bbox, so the first
+    // square always has them.
+    float radius = s_margin_valid ? fabsf(s_margin_m) * 1.5f + MARGIN_SEARCH_M : MARGIN_SEARCH_M;
+    bool searched = false;
+    PackedRTree::Box done{};
+    PackedRTree::Stats q;
+    for (;;) {
+      const PackedRTree::Box box = marginBox(lat, lon, radius);
+      s_index.query(box, q, [&](uint32_t slot) {
+        const Rule &r = s_rules[s_index_ids[slot]];
+        if (r.type == RuleType::StayIn && !r.inside) return;  // done above
+        if (searched && boxesOverlap(done, r.min_lat, r.min_lon, r.max_lat, r.max_lon)) return;
+        consider(s_index_ids[slot]);
+      });
+      if (best <= radius || radius >= MARGIN_SEARCH_MAX_M) break;
+      done = box;
+      searched = true;
+      radius *= 4.0f;
+    }
+    s_stats.lastMarginRules = evaluated;
+    for (uint16_t id : s_line_ids) {
+      const Rule &r = s_rules[id];
+      const float d = (r.axis == LineAxis::NorthSouth)
+                          ? fabsf((float)(lon - r.value)) * GeoMath::metersPerLonE6(lat)
+                          : fabsf((float)(lat - r.value)) * (GeoMath::kMetersPerDegLat / 1e6f);
+      if (d < best) {
+        best = d;
+        best_rule = id;
+      }
+    }
+
+    const uint32_t now = millis();
+    if (best_rule < 0) {
+      s_margin_valid = false;
+      s_margin_rule = -1;
+      s_closing_mps = 0.0f;
+      return;
+    }
+    if (s_margin_valid && best_rule == s_margin_rule && now != s_margin_ms) {
+      // Lightly smoothed; GPS jitter alone is a few m/s at 1 Hz.
+      const float inst = (s_margin_m - best) * 1000.0f / (float)(now - s_margin_ms);
+      s_closing_mps = 0.5f * (s_closing_mps + inst);
+    } else {
+      s_closing_mps = 0.0f;
+    }
+    s_margin_valid = true;
+    s_margin_m = best;
+    s_margin_ms = now;
+    s_margin_rule = best_rule;
+  }
+
+  // True when the path a-b touches the rule's boundary; arcs replace their
+  // chords. Edges are bbox-rejected before the exact test.
+  bool pathCrossesRule(const Rule &r, int32_t a_lat, int32_t a_lon, int32_t b_lat, int32_t b_lon)
+  {
+    if (r.sua >= 0) return SuaCatalog::boundaryIntersects(s_sua[r.sua], a_lat, a_lon, b_lat, b_lon);
+    const int32_t min_lat = min(a_lat, b_lat);
+    const int32_t max_lat = max(a_lat, b_lat);
+    const int32_t min_lon = min(a_lon, b_lon);
+    const int32_t max_lon = max(a_lon, b_lon);
+    uint32_t k = r.arc_first;
+    const uint32_t arc_end = r.arc_first + r.arc_count;
+    for (uint32_t i = r.first; i + 1 < r.first + r.count; i++) {
+      if (k < arc_end && s_arc_edge[k] == i) {
+        if (GeoMath::segmentIntersectsArc(s_arcs[k++], a_lat, a_lon, b_lat, b_lon)) return true;
+        continue;
+      }
+      if (s_dlat[i] == 0 && s_dlon[i] == 0) continue;  // link to the next ring
+      if (max(s_lat[i], s_lat[i + 1]) < min_lat || min(s_lat[i], s_lat[i + 1]) > max_lat ||
+          max(s_lon[i], s_lon[i + 1]) < min_lon || min(s_lon[i], s_lon[i + 1]) > max_lon) {
+        continue;
+      }
+      if (GeoMath::segmentsIntersect(s_lat[i], s_lon[i], s_lat[i + 1], s_lon[i + 1],
+                                     a_lat, a_lon, b_lat, b_lon)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void rememberFix(int32_t lat, int32_t lon, float alt, uint32_t now)
+  {
+    s_prev_lat = lat;
+    s_prev_lon = lon;
+    s_prev_alt = alt;
+    s_prev_ms = now;
+    s_has_prev = true;
+  }
+
+  bool plausibleHop(int32_t lat, int32_t lon, uint32_t now)
+  {
+    const float dy = (float)(lat - s_prev_lat) * (GeoMath::kMetersPerDegLat / 1e6f);
+    const float dx = (float)(lon - s_prev_lon) * GeoMath::metersPerLonE6(lat);
+    const float d = sqrtf(dx * dx + dy * dy);
+    const float dt = (float)(now - s_prev_ms) / 1000.0f;
+    return d <= MAX_PLAUSIBLE_SPEED_MPS * (dt > 1.0f ? dt : 1.0f);
+  }
+
+  bool crossedLine(LineAxis axis, int32_t value,
+                   int32_t prev_lat, int32_t prev_lon,
+                   int32_t lat, int32_t lon)
+  {
+    return (axis == LineAxis::NorthSouth) ? GeoMath::crossesAxis(value, prev_lon, lon)
+                                          : GeoMath::crossesAxis(value, prev_lat, lat);
+  }
+
+  // Re-checks the unconfirmed transits against the current fix (see
+  // Transit); needs r.inside from this fix.
+  void confirmTransits(int32_t lat, int32_t lon)
+  {
+    size_t kept = 0;
+    for (size_t i = 0; i < s_transits.size(); i++) {
+      Transit t = s_transits[i];
+      if (t.confirms < TRANSIT_CONFIRM_FIXES) {
+        const Rule &r = s_rules[t.rule];
+        bool still;
+        if (r.type == RuleType::Line) {
+          still = crossedLine(r.axis, r.value, t.from_lat, t.from_lon, lat, lon);
+        } else {
+          still = (r.type == RuleType::KeepOut) == r.inside ||
+                  pathCrossesRule(r, t.from_lat, t.from_lon, lat, lon);
+        }
+        if (!still) {
+          s_stats.transitsDropped++;
+          if (t.confirms == 0) {
+            s_prev_lat = t.from_lat;
+            s_prev_lon = t.from_lon;
+          }
+          continue;
+        }
+        t.confirms++;
+      }
+      s_transits[kept++] = t;
+    }
+    s_transits.resize(kept);
+  }
+
+  const char *ruleTypeName(RuleType type)
+  {
+    return type == RuleType::KeepOut ? "keep_out" : type == RuleType::StayIn ? "stay_in" : "line";
+  }
+
+  GeoFence::Violation makeViolation(const Rule &rule, const char *detail)
   {
     GeoFence::Violation v;
-    v.id = rule.id;
-    if (rule.type == RuleType::KeepOut) v.type = "keep_out";
-    else if (rule.type == RuleType::StayIn) v.type = "stay_in";
-    else v.type = "line";
+    v.id = ruleString(rule.id);
+    v.type = ruleTypeName(rule.type);
     v.detail = detail;
-    s_violations.push_back(v);
+    return v;
   }
 
-  bool loadFromJson(const char *path)
+  void addViolation(const Rule &rule, const char *detail)
+  {
+    s_violations.push_back(makeViolation(rule, detail));
+  }
+
+  void addTransit(uint16_t rule, const char *detail)
+  {
+    for (const Transit &t : s_transits) {
+      if (t.rule == rule && t.detail == detail) return;
+    }
+    s_transits.push_back(Transit{rule, detail, s_prev_lat, s_prev_lon, 0});
+  }
+
+  // Polygon rings laid out like the arena (closed, back to back, zero-delta
+  // links, arcs by their first vertex) but owned, so a track check decodes
+  // each rule or catalog area once and walks it with the same kernels.
+  struct Shape {
+    std::vector<int32_t> lat;
+    std::vector<int32_t> lon;
+    std::vector<int32_t> dlat;
+    std::vector<int32_t> dlon;
+    std::vector<GeoMath::Arc> arcs;
+    std::vector<uint32_t> arc_edge;  // relative to lat[0]
+  };
+
+  void shapeFromRule(const Rule &r, Shape &s)
+  {
+    s.lat.assign(s_lat.begin() + r.first, s_lat.begin() + r.first + r.count);
+    s.lon.assign(s_lon.begin() + r.first, s_lon.begin() + r.first + r.count);
+    s.dlat.assign(s_dlat.begin() + r.first, s_dlat.begin() + r.first + r.count);
+    s.dlon.assign(s_dlon.begin() + r.first, s_dlon.begin() + r.first + r.count);
+    s.arcs.assign(s_arcs.begin() + r.arc_first, s_arcs.begin() + r.arc_first + r.arc_count);
+    s.arc_edge.clear();
+    for (uint32_t k = r.arc_first; k < r.arc_first + r.arc_count; k++) {
+      s.arc_edge.push_back(s_arc_edge[k] - r.first);
+    }
+  }
+
+  // Catalog rings the way SuaCatalog::contains() walks them: gaps between
+  // segments and each ring's closure become straight edges.
+  bool shapeFromEntry(const SuaCatalog::Entry &e, Shape &s)
+  {
+    s.lat.clear();
+    s.lon.clear();
+    s.arcs.clear();
+    s.arc_edge.clear();
+    std::vector<uint32_t> closing;
+    SuaCatalog::GeometryReader rd;
+    if (!rd.open(e)) return false;
+    uint16_t segs = 0;
+    SuaCatalog::Segment g;
+    while (rd.nextRing(segs)) {
+      const size_t ring = s.lat.size();
+      while (rd.nextSegment(g)) {
+        if (s.lat.size() == ring || s.lat.back() != g.start_lat || s.lon.back() != g.start_lon) {
+          s.lat.push_back(g.start_lat);
+          s.lon.push_back(g.start_lon);
+        }
+        GeoMath::Arc arc;
+        const bool is_arc = g.type == SuaCatalog::SEG_ARC &&
+                            GeoMath::makeArc(g.start_lat, g.start_lon, g.end_lat, g.end_lon,
+                                             g.center_lat, g.center_lon, g.radius_m, g.direction != 0, arc);
+        if (is_arc) {
+          s.arcs.push_back(arc);
+          s.arc_edge.push_back((uint32_t)s.lat.size() - 1);
+        }
+        // An arc keeps its end even when it equals the start (full circle).
+        if (is_arc || s.lat.back() != g.end_lat || s.lon.back() != g.end_lon) {
+          s.lat.push_back(g.end_lat);
+          s.lon.push_back(g.end_lon);
+        }
+      }
+      if (s.lat.size() == ring) continue;
+      if (s.lat.size() - ring == 1 || s.lat.back() != s.lat[ring] || s.lon.back() != s.lon[ring]) {
+        s.lat.push_back(s.lat[ring]);
+        s.lon.push_back(s.lon[ring]);
+      }
+      closing.push_back((uint32_t)s.lat.size() - 1);
+    }
+    s.dlat.assign(s.lat.size(), 0);
+    s.dlon.assign(s.lon.size(), 0);
+    for (size_t i = 0; i + 1 < s.lat.size(); i++) {
+      s.dlat[i] = s.lat[i + 1] - s.lat[i];
+      s.dlon[i] = s.lon[i + 1] - s.lon[i];
+    }
+    for (uint32_t i : closing) s.dlat[i] = s.dlon[i] = 0;
+    return !s.lat.empty();
+  }
+
+  bool shapeContains(const Shape &s, int32_t lat, int32_t lon)
+  {
+    bool inside = GeoMath::pointInRing(s.lat.data(), s.lon.data(), s.dlat.data(), s.dlon.data(),
+                                       (uint32_t)s.lat.size(), lat, lon);
+    for (const GeoMath::Arc &a : s.arcs) {
+      if (GeoMath::inArcSegment(a, lat, lon)) inside = !inside;
+    }
+    return inside;
+  }
+
+  // Horizontal containment for every track point in one batch.
+  void shapeStates(const Shape &s, const std::vector<int32_t> &lat, const std::vector<int32_t> &lon,
+                   std::vector<uint8_t> &inside)
+  {
+    inside.assign(lat.size(), 0);
+    GeoMath::pointsInRing(s.lat.data(), s.lon.data(), s.dlat.data(), s.dlon.data(), (uint32_t)s.lat.size(),
+                          lat.data(), lon.data(), (uint32_t)lat.size(), inside.data());
+    for (const GeoMath::Arc &a : s.arcs) {
+      for (size_t k = 0; k < lat.size(); k++) {
+        if (GeoMath::inArcSegment(a, lat[k], lon[k])) inside[k] ^= 1;
+      }
+    }
+  }
+
+  // First boundary contact along a->b with t in [t_min, t_max], or INFINITY.
+  // Same edge walk as pathCrossesRule().
+  float shapeFirstHit(const Shape &s, int32_t a_lat, int32_t a_lon, int32_t b_lat, int32_t b_lon,
+                      float t_min, float t_max)
+  {
+    const int32_t min_lat = min(a_lat, b_lat);
+    const int32_t max_lat = max(a_lat, b_lat);
+    const int32_t min_lon = min(a_lon, b_lon);
+    const int32_t max_lon = max(a_lon, b_lon);
+    float best = INFINITY;
+    float t;
+    size_t k = 0;
+    for (uint32_t i = 0; i + 1 < s.lat.size(); i++) {
+      if (k < s.arcs.size() && s.arc_edge[k] == i) {
+        if (GeoMath::arcHitParam(s.arcs[k++], a_lat, a_lon, b_lat, b_lon, t_min, t) && t < best) best = t;
+        continue;
+      }
+      if (s.dlat[i] == 0 && s.dlon[i] == 0) continue;  // link to the next ring
+      if (max(s.lat[i], s.lat[i + 1]) < min_lat || min(s.lat[i], s.lat[i + 1]) > max_lat ||
+          max(s.lon[i], s.lon[i + 1]) < min_lon || min(s.lon[i], s.lon[i + 1]) > max_lon) {
+        continue;
+      }
+      if (GeoMath::segmentHitParam(a_lat, a_lon, b_lat, b_lon, s.lat[i], s.lon[i], s.lat[i + 1], s.lon[i + 1],
+                                   t_min, t) && t < best) {
+        best = t;
+      }
+    }
+    return best <= t_max ? best : INFINITY;
+  }
+
+  // A planned track in arena units, with cumulative leg lengths.
+  struct Track {
+    std::vector<int32_t> lat;
+    std::vector<int32_t> lon;
+    std::vector<float> alt;
+    std::vector<float> along;
+  };
+
+  bool inBand(const PackedRTree::Box &b, float alt)
+  {
+    if (isnan(alt)) return true;
+    const int32_t a = (int32_t)lroundf(alt);
+    return a >= b.min_alt && a <= b.max_alt;
+  }
+
+  // Part [t0, t1] of leg i whose altitude lies in the band; t0 > t1 when
+  // none does. Unknown altitude at either end matches the whole leg.
+  void legBand(const Track &tk, uint32_t i, const PackedRTree::Box &b, float &t0, float &t1)
+  {
+    t0 = 0.0f;
+    t1 = 1.0f;
+    const float a0 = tk.alt[i];
+    const float a1 = tk.alt[i + 1];
+    if (isnan(a0) || isnan(a1)) return;
+    const float d = a1 - a0;
+    if (b.min_alt != PackedRTree::kAltMin) {
+      const float t = (d == 0.0f) ? (a0 >= (float)b.min_alt ? 0.0f : 2.0f) : ((float)b.min_alt - a0) / d;
+      if (d >= 0.0f) t0 = max(t0, t);
+      else t1 = min(t1, t);
+    }
+    if (b.max_alt != PackedRTree::kAltMax) {
+      const float t = (d == 0.0f) ? (a0 <= (float)b.max_alt ? 1.0f : -1.0f) : ((float)b.max_alt - a0) / d;
+      if (d > 0.0f) t1 = min(t1, t);
+      else if (d < 0.0f) t0 = max(t0, t);
+      else t1 = min(t1, t);
+    }
+  }
+
+  PackedRTree::Box legBox(const Track &tk, uint32_t i)
+  {
+    const uint32_t j = (i + 1 < tk.lat.size()) ? i + 1 : i;
+    const bool has_alt = !isnan(tk.alt[i]) && !isnan(tk.alt[j]);
+    const int32_t a0 = has_alt ? (int32_t)lroundf(tk.alt[i]) : 0;
+    const int32_t a1 = has_alt ? (int32_t)lroundf(tk.alt[j]) : 0;
+    return PackedRTree::Box{min(tk.lat[i], tk.lat[j]), min(tk.lon[i], tk.lon[j]),
+                            max(tk.lat[i], tk.lat[j]), max(tk.lon[i], tk.lon[j]),
+                            has_alt ? min(a0, a1) : PackedRTree::kAltMin,
+                            has_alt ? max(a0, a1) : PackedRTree::kAltMax};
+  }
+
+  void trackHit(const Track &tk, uint32_t leg, float t, const char *id, const char *type, const String &detail,
+                std::vector<GeoFence::TrackHit> &out)
+  {
+    const uint32_t j = (leg + 1 < tk.lat.size()) ? leg + 1 : leg;
+    GeoFence::TrackHit h;
+    h.id = id;
+    h.type = type;
+    h.detail = detail;
+    h.leg = leg;
+    h.alongM = tk.along[leg] + t * (tk.along[j] - tk.along[leg]);
+    h.lat = GeoMath::fromE6(tk.lat[leg]) + t * (GeoMath::fromE6(tk.lat[j]) - GeoMath::fromE6(tk.lat[leg]));
+    h.lon = GeoMath::fromE6(tk.lon[leg]) + t * (GeoMath::fromE6(tk.lon[j]) - GeoMath::fromE6(tk.lon[leg]));
+    h.altM = tk.alt[leg] + t * (tk.alt[j] - tk.alt[leg]);
+    out.push_back(h);
+  }
+
+  // Keep-outs and catalog areas: a leg that starts outside enters where
+  // its altitude first reaches the band over the area, or at its first
+  // boundary contact inside the band. Like the swept check, touching
+  // counts. inside[] is the horizontal state of every track point.
+  void areaEntries(const Track &tk, const Shape &s, const PackedRTree::Box &box, const std::vector<uint8_t> &inside,
+                   const char *id, const char *type, const String &what, std::vector<GeoFence::TrackHit> &out)
+  {
+    if (inside[0] && inBand(box, tk.alt[0])) trackHit(tk, 0, 0.0f, id, type, "starts inside " + what, out);
+    for (uint32_t i = 0; i + 1 < tk.lat.size(); i++) {
+      if (inside[i] && inBand(box, tk.alt[i])) continue;
+      const PackedRTree::Box leg = legBox(tk, i);
+      if (leg.max_lat < box.min_lat || leg.min_lat > box.max_lat ||
+          leg.max_lon < box.min_lon || leg.min_lon > box.max_lon) {
+        continue;
+      }
+      float t0;
+      float t1;
+      legBand(tk, i, box, t0, t1);
+      if (t0 > t1) continue;
+      const int32_t dlat = tk.lat[i + 1] - tk.lat[i];
+      const int32_t dlon = tk.lon[i + 1] - tk.lon[i];
+      float t;
+      if (shapeContains(s, tk.lat[i] + (int32_t)lround(t0 * (double)dlat),
+                        tk.lon[i] + (int32_t)lround(t0 * (double)dlon))) {
+        t = t0;  // climbs or descends into it
+      } else {
+        t = shapeFirstHit(s, tk.lat[i], tk.lon[i], tk.lat[i + 1], tk.lon[i + 1], t0, t1);
+      }
+      if (!isinf(t)) trackHit(tk, i, t, id, type, "enters " + what, out);
+    }
+  }
+
+  // Stay-ins: a leg that starts inside (the stay-in is armed by then, as
+  // update() arms it on a fix) leaves at its first boundary contact or
+  // where it climbs or descends out of the band.
+  void areaExits(const Track &tk, const Shape &s, const PackedRTree::Box &box, const std::vector<uint8_t> &inside,
+                 const char *id, std::vector<GeoFence::TrackHit> &out)
+  {
+    if (!inside[0] || !inBand(box, tk.alt[0])) trackHit(tk, 0, 0.0f, id, "stay_in", "starts outside stay-in", out);
+    for (uint32_t i = 0; i + 1 < tk.lat.size(); i++) {
+      if (!inside[i] || !inBand(box, tk.alt[i])) continue;
+      float t0;
+      float t1;
+      legBand(tk, i, box, t0, t1);
+      float t = (t1 < 1.0f) ? max(t1, 0.0f) : INFINITY;
+      t = min(t, shapeFirstHit(s, tk.lat[i], tk.lon[i], tk.lat[i + 1], tk.lon[i + 1], 0.0f, min(t1, 1.0f)));
+      if (!isinf(t)) trackHit(tk, i, t, id, "stay_in", "leaves stay-in", out);
+    }
+  }
+
+  void clearRules()
   {
     s_rules.clear();
+    s_stay_in_ids.clear();
+    s_line_ids.clear();
+    s_index.clear();
+    s_index_ids.clear();
+    s_grid.clear();
+    s_lat.clear();
+    s_lon.clear();
+    s_dlat.clear();
+    s_dlon.clear();
+    s_arcs.clear();
+    s_arc_edge.clear();
+    s_sua.clear();
+    s_strings.assign(1, '\0');  // offset 0 is the empty string
     s_violations.clear();
+    s_transits.clear();
     s_loaded = false;
+    s_margin_valid = false;
+    s_margin_rule = -1;
+    s_closing_mps = 0.0f;
+    s_revision++;
+  }
+
+  // Rule id lists and the spatial index, derived from s_rules.
+  void buildIndex()
+  {
+    std::vector<PackedRTree::Box> boxes;
+    for (size_t i = 0; i < s_rules.size(); i++) {
+      const Rule &r = s_rules[i];
+      if (r.type == RuleType::StayIn) s_stay_in_ids.push_back((uint16_t)i);
+      if (r.type == RuleType::Line) {
+        s_line_ids.push_back((uint16_t)i);
+        continue;
+      }
+      if (!hasArea(r)) continue;
+      boxes.push_back(PackedRTree::Box{r.min_lat, r.min_lon, r.max_lat, r.max_lon, r.floor_m, r.ceil_m});
+      s_index_ids.push_back((uint16_t)i);
+    }
+    s_index.build(boxes);
+    s_dlat.resize(s_lat.size());
+    s_dlon.resize(s_lat.size());
+  }
+
+  void finishLoad(const char *source)
+  {
+    s_rules.shrink_to_fit();
+    s_lat.shrink_to_fit();
+    s_lon.shrink_to_fit();
+    s_dlat.shrink_to_fit();
+    s_dlon.shrink_to_fit();
+    s_arcs.shrink_to_fit();
+    s_arc_edge.shrink_to_fit();
+    s_sua.shrink_to_fit();
+    s_strings.shrink_to_fit();
+    uint32_t banded = 0;
+    uint32_t rings = 0;
+    for (uint16_t id : s_index_ids) {
+      if (hasBand(s_rules[id])) banded++;
+      if (s_rules[id].sua < 0) rings += s_rules[id].rings;
+      if (s_rules[id].sua_type) s_load_info.suaTypeAreas++;
+    }
+    s_loaded = true;
+    Serial.printf("[GEOFENCE] loaded %u rules (%u vertices in %u rings, %u arcs, %u SUA, %u banded, %u index nodes) from %s\n",
+                  (unsigned)s_rules.size(), (unsigned)s_lat.size(), (unsigned)rings, (unsigned)s_arcs.size(),
+                  (unsigned)s_sua.size(), (unsigned)banded,
+                  (unsigned)s_index.nodeCount(), source);
+  }
+
+  // ArduinoJson capacity that always holds the file: one slot per value
+  // (at most one per ',', '[' or '{' outside strings, plus the root) and
+  // room for every string it copies (the quoted bytes, closing quote
+  // standing in for the terminator).
+  size_t jsonCapacity(File &f)
+  {
+    size_t slots = 1;
+    size_t text = 0;
+    bool in_str = false;
+    bool escaped = false;
+    uint8_t buf[256];
+    size_t n;
+    while ((n = f.read(buf, sizeof(buf))) > 0) {
+      for (size_t i = 0; i < n; i++) {
+        const uint8_t c = buf[i];
+        if (in_str) {
+          text++;
+          if (escaped) escaped = false;
+          else if (c == '\\') escaped = true;
+          else if (c == '"') in_str = false;
+        } else if (c == '"') {
+          in_str = true;
+        } else {
+          slots += c == ',' || c == '[' || c == '{';
+        }
+      }
+    }
+    f.seek(0);
+    return JSON_ARRAY_SIZE(slots) + text;
+  }
+
+  bool loadFromJson(const char *path)
+  {
+    clearRules();
 
     if (!LittleFS.begin(true)) {
       Serial.println("[GEOFENCE] LittleFS mount failed");
@@ -112,7 +1199,15 @@ namespace {
       return false;
     }
 
-    DynamicJsonDocument doc(8192);
+    // Sized from the file: outlines with holes, or thousands of vertices
+    // left for simplification, run far past any fixed document.
+    const size_t capacity = jsonCapacity(f);
+    DynamicJsonDocument doc(capacity);
+    if (doc.capacity() == 0) {
+      f.close();
+      Serial.printf("[GEOFENCE] no memory for a %u byte JSON document\n", (unsigned)capacity);
+      return false;
+    }
     const DeserializationError err = deserializeJson(doc, f);
     f.close();
     if (err) {
@@ -120,17 +1215,23 @@ namespace {
       return false;
     }
 
+    // Simplification tolerance (m); per-rule "simplify_m" overrides it.
+    const float simplify_m = doc["simplify_m"] | 0.0f;
+    // Category keep-outs wait for the stay-ins, which bound them.
+    std::vector<JsonObject> sua_types;
     auto parsePolyRules = [&](JsonArray arr, RuleType type) {
       for (JsonObject o : arr) {
+        if (type == RuleType::KeepOut && o.containsKey("sua_type")) {
+          sua_types.push_back(o);
+          continue;
+        }
         Rule r;
         r.type = type;
-        r.id = o["id"] | String("rule");
-        JsonArray pts = o["polygon"].as<JsonArray>();
-        for (JsonArray p : pts) {
-          if (p.size() < 2) continue;
-          Point pt{p[0].as<double>(), p[1].as<double>()};
-          r.polygon.push_back(pt);
+        r.id = addString(o["id"] | "rule");
+        if (!addSuaArea(r, o["sua"] | "")) {
+          addPolygon(r, o, o["simplify_m"] | simplify_m);
         }
+        parseBand(r, o);
         if (type == RuleType::StayIn) r.armed = false;
         s_rules.push_back(r);
       }
@@ -142,12 +1243,30 @@ namespace {
     if (doc.containsKey("stay_in")) {
       parsePolyRules(doc["stay_in"].as<JsonArray>(), RuleType::StayIn);
     }
+    if (!sua_types.empty()) {
+      bool clip = false;
+      PackedRTree::Box area{INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN, 0, 0};
+      for (const Rule &r : s_rules) {
+        if (r.type != RuleType::StayIn || !hasArea(r)) continue;
+        clip = true;
+        area.min_lat = min(area.min_lat, r.min_lat);
+        area.min_lon = min(area.min_lon, r.min_lon);
+        area.max_lat = max(area.max_lat, r.max_lat);
+        area.max_lon = max(area.max_lon, r.max_lon);
+      }
+      bool fits = true;
+      for (JsonObject o : sua_types) fits &= addSuaType(o, clip, area);
+      if (!fits) {
+        clearRules();
+        return false;
+      }
+    }
 
     if (doc.containsKey("lines")) {
       for (JsonObject o : doc["lines"].as<JsonArray>()) {
         Rule r;
         r.type = RuleType::Line;
-        r.id = o["id"] | String("line");
+        r.id = addString(o["id"] | "line");
         String axis = o["axis"] | String("N/S");
         axis.toUpperCase();
         if (axis == "E/W") {
@@ -155,35 +1274,465 @@ namespace {
         } else {
           r.axis = LineAxis::NorthSouth;
         }
-        r.value = o["value"] | 0.0;
-        r.detail = o["detail"] | String("");
+        r.value = GeoMath::toE6(o["value"] | 0.0);
+        r.detail = addString(o["detail"] | "");
         s_rules.push_back(r);
       }
     }
 
-    s_loaded = true;
-    Serial.printf("[GEOFENCE] loaded %u rules from %s\n",
-                  (unsigned)s_rules.size(), path);
+    buildIndex();
+    finishLoad(path);
     return true;
   }
+
+  // Compiled rule set (/geofence.bin next to /geofence.json): the tables
+  // above dumped as-is behind a header, so boot reads them straight into
+  // place with no JSON parse. Raw structs are only readable by a build
+  // with the same layout (the layout word; bump BLOB_VERSION when a field
+  // changes meaning), and the source CRC catches a geofence.json replaced
+  // behind our back. Any mismatch falls back to the JSON and recompiles.
+  constexpr char BLOB_MAGIC[4] = {'G', 'F', 'B', '1'};
+  constexpr uint16_t BLOB_VERSION = 3;
+
+  enum BlobSection : uint8_t {
+    SEC_RULES,
+    SEC_STAY_IN_IDS,
+    SEC_LINE_IDS,
+    SEC_INDEX_IDS,
+    SEC_LAT,
+    SEC_LON,
+    SEC_DLAT,
+    SEC_DLON,
+    SEC_ARCS,
+    SEC_ARC_EDGE,
+    SEC_SUA,
+    SEC_STRINGS,
+    SEC_TREE_BOXES,
+    SEC_TREE_IDS,
+    SEC_TREE_LEVELS,
+    SEC_GRID_EXTENT,
+    SEC_GRID_CELLS,
+    SEC_GRID_SET_START,
+    SEC_GRID_SET_ITEMS,
+    SEC_COUNT
+  };
+
+  constexpr uint32_t SECTION_SIZE[SEC_COUNT] = {
+    sizeof(Rule), sizeof(uint16_t), sizeof(uint16_t), sizeof(uint16_t),
+    sizeof(int32_t), sizeof(int32_t), sizeof(int32_t), sizeof(int32_t),
+    sizeof(GeoMath::Arc), sizeof(uint32_t), sizeof(SuaCatalog::Entry), sizeof(char),
+    sizeof(PackedRTree::Box), sizeof(uint32_t), sizeof(uint32_t),
+    sizeof(CellGrid::Extent), sizeof(uint8_t), sizeof(uint32_t), sizeof(uint16_t)
+  };
+
+  static_assert(std::is_trivially_copyable<Rule>::value &&
+                std::is_trivially_copyable<GeoMath::Arc>::value &&
+                std::is_trivially_copyable<SuaCatalog::Entry>::value &&
+                std::is_trivially_copyable<PackedRTree::Box>::value &&
+                std::is_trivially_copyable<CellGrid::Extent>::value,
+                "blob sections are raw struct dumps");
+
+  struct BlobHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t sections;
+    uint32_t layout;        // hash of the section element sizes
+    uint32_t source_len;    // geofence.json it was compiled from
+    uint32_t source_crc;
+    uint32_t sua_stamp;     // SuaCatalog::stamp() when SUA rules are present
+    uint32_t payload_crc;
+    uint32_t count[SEC_COUNT];
+  };
+
+  // CRC-32 (IEEE, reflected), nibble table.
+  uint32_t crc32(uint32_t crc, const uint8_t *p, size_t len)
+  {
+    static const uint32_t CRC_NIBBLE[16] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+      0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    crc = ~crc;
+    while (len--) {
+      crc ^= *p++;
+      crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+      crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+    }
+    return ~crc;
+  }
+
+  uint32_t fileCrc(const char *path, uint32_t &len)
+  {
+    len = 0;
+    File f = LittleFS.open(path, "r");
+    if (!f) return 0;
+    uint8_t buf[256];
+    uint32_t crc = 0;
+    size_t n;
+    while ((n = f.read(buf, sizeof(buf))) > 0) {
+      crc = crc32(crc, buf, n);
+      len += n;
+    }
+    f.close();
+    return crc;
+  }
+
+  uint32_t blobLayout()
+  {
+    uint32_t h = 0x811C9DC5u;
+    for (uint32_t size : SECTION_SIZE) {
+      h ^= size;
+      h *= 0x01000193u;
+    }
+    return h;
+  }
+
+  void blobPathFor(const char *json_path, char *out, size_t len)
+  {
+    size_t n = strlen(json_path);
+    if (n >= 5 && strcmp(json_path + n - 5, ".json") == 0) n -= 5;
+    snprintf(out, len, "%.*s.bin", (int)n, json_path);
+  }
+
+  struct Span {
+    const void *data;
+    size_t bytes;
+  };
+
+  template <typename T>
+  Span span(const std::vector<T> &v)
+  {
+    return Span{v.data(), v.size() * sizeof(T)};
+  }
+
+  template <typename T>
+  bool readSection(File &f, std::vector<T> &v, uint32_t count, uint32_t &crc)
+  {
+    v.resize(count);
+    const size_t bytes = (size_t)count * sizeof(T);
+    if (bytes == 0) return true;
+    uint8_t *dst = reinterpret_cast<uint8_t *>(v.data());
+    if (f.read(dst, bytes) != bytes) return false;
+    crc = crc32(crc, dst, bytes);
+    return true;
+  }
+
+  // Fingerprint of everything that decides where a rule's area is, so a
+  // grid rebuild can keep the cells of rules that did not change.
+  uint32_t ruleKey(const Rule &r)
+  {
+    uint32_t h = crc32(0, reinterpret_cast<const uint8_t *>(&r.type), sizeof(r.type));
+    const int32_t shape[] = {r.min_lat, r.min_lon, r.max_lat, r.max_lon, r.erode_m};
+    h = crc32(h, reinterpret_cast<const uint8_t *>(shape), sizeof(shape));
+    if (r.sua >= 0) {
+      const SuaCatalog::Entry &e = s_sua[r.sua];
+      const uint32_t ref[] = {e.geom_offset, e.geom_length, SuaCatalog::stamp()};
+      return crc32(h, reinterpret_cast<const uint8_t *>(ref), sizeof(ref));
+    }
+    h = crc32(h, reinterpret_cast<const uint8_t *>(s_lat.data() + r.first), r.count * sizeof(int32_t));
+    h = crc32(h, reinterpret_cast<const uint8_t *>(s_lon.data() + r.first), r.count * sizeof(int32_t));
+    return crc32(h, reinterpret_cast<const uint8_t *>(s_arcs.data() + r.arc_first),
+                 r.arc_count * sizeof(GeoMath::Arc));
+  }
+
+  // Where a grid block lies relative to a rule, horizontally. Bands are
+  // left to update(): a cell inside a banded rule still needs the altitude.
+  CellGrid::Side classifyCell(const Rule &r, const CellGrid::Box &b)
+  {
+    const int32_t lat = (int32_t)(((int64_t)b.min_lat + b.max_lat) / 2);
+    const int32_t lon = (int32_t)(((int64_t)b.min_lon + b.max_lon) / 2);
+    // Half diagonal, measured where a degree of longitude is widest.
+    const int32_t wide_lat = b.min_lat > 0 ? b.min_lat : (b.max_lat < 0 ? b.max_lat : 0);
+    const float half_lat = (float)(b.max_lat - b.min_lat) * 0.5f * (GeoMath::kMetersPerDegLat / 1e6f);
+    const float half_lon = (float)(b.max_lon - b.min_lon) * 0.5f * GeoMath::metersPerLonE6(wide_lat);
+    const float reach = hypotf(half_lat, half_lon);
+    // Distances are taken in the frame at the centre; longitude scale
+    // drifts by about tan(lat) * dlat across the reach.
+    const float far_lat = fabsf((float)GeoMath::fromE6(abs(lat) > abs(wide_lat) ? lat : wide_lat)) +
+                          reach / GeoMath::kMetersPerDegLat;
+    const float drift = tanf(min(far_lat, 85.0f) * (float)M_PI / 180.0f) * (reach / 6371000.0f);
+    if (boundaryDistance(r, lat, lon) <= reach * (1.02f + 2.0f * drift) + GRID_SLACK_M) {
+      return CellGrid::Side::Edge;
+    }
+    return pointInRule(r, lat, lon) ? CellGrid::Side::Inside : CellGrid::Side::Outside;
+  }
+
+  void gridItems(std::vector<CellGrid::Box> &boxes, std::vector<uint32_t> &keys)
+  {
+    boxes.clear();
+    keys.clear();
+    for (uint16_t id : s_index_ids) {
+      const Rule &r = s_rules[id];
+      boxes.push_back(CellGrid::Box{r.min_lat, r.min_lon, r.max_lat, r.max_lon});
+      keys.push_back(ruleKey(r));
+    }
+  }
+
+  // Grid over the stay-ins (the mission area), or over every area rule
+  // when there are none; fixes outside it take the exact path.
+  void buildGrid(const CellGrid &prev)
+  {
+    std::vector<CellGrid::Box> boxes;
+    std::vector<uint32_t> keys;
+    gridItems(boxes, keys);
+    bool any = false;
+    CellGrid::Box area = CellGrid::Box{0, 0, 0, 0};
+    const bool stay_in = !s_stay_in_ids.empty();
+    for (size_t i = 0; i < boxes.size(); i++) {
+      if (stay_in && s_rules[s_index_ids[i]].type != RuleType::StayIn) continue;
+      const CellGrid::Box &b = boxes[i];
+      area = any ? CellGrid::Box{min(area.min_lat, b.min_lat), min(area.min_lon, b.min_lon),
+                                 max(area.max_lat, b.max_lat), max(area.max_lon, b.max_lon)}
+                 : b;
+      any = true;
+    }
+    s_load_info.gridCells = 0;
+    s_load_info.gridExactCells = 0;
+    s_load_info.gridClassified = 0;
+    s_load_info.gridUs = 0;
+    if (!any) {
+      s_grid.clear();
+      return;
+    }
+    const uint32_t start_us = micros();
+    const uint32_t classified = s_grid.build(CellGrid::extentFor(area), std::move(boxes), std::move(keys), prev,
+                                             [](uint32_t slot, const CellGrid::Box &b) {
+                                               return classifyCell(s_rules[s_index_ids[slot]], b);
+                                             });
+    s_load_info.gridUs = micros() - start_us;
+    s_load_info.gridCells = (uint32_t)s_grid.cellCount();
+    s_load_info.gridExactCells = (uint32_t)s_grid.countCells(CellGrid::kExact);
+    s_load_info.gridClassified = classified;
+    Serial.printf("[GEOFENCE] cell grid %ux%u: %u clear, %u boundary, %u interior sets; %u cells classified in %luus\n",
+                  (unsigned)s_grid.extent().rows, (unsigned)s_grid.extent().cols,
+                  (unsigned)s_grid.countCells(CellGrid::kClear), (unsigned)s_load_info.gridExactCells,
+                  (unsigned)s_grid.setCount(), (unsigned)classified, (unsigned long)s_load_info.gridUs);
+  }
+
+  bool writeBlob(const char *blob_path, const char *json_path)
+  {
+    std::vector<CellGrid::Extent> grid_extent;
+    if (!s_grid.empty()) grid_extent.push_back(s_grid.extent());
+    const Span spans[SEC_COUNT] = {
+      span(s_rules), span(s_stay_in_ids), span(s_line_ids), span(s_index_ids),
+      span(s_lat), span(s_lon), span(s_dlat), span(s_dlon),
+      span(s_arcs), span(s_arc_edge), span(s_sua), span(s_strings),
+      span(s_index.boxes()), span(s_index.ids()), span(s_index.levelStarts()),
+      span(grid_extent), span(s_grid.cells()), span(s_grid.setStarts()), span(s_grid.setItems())
+    };
+    BlobHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, BLOB_MAGIC, sizeof(h.magic));
+    h.version = BLOB_VERSION;
+    h.sections = SEC_COUNT;
+    h.layout = blobLayout();
+    h.source_crc = fileCrc(json_path, h.source_len);
+    h.sua_stamp = s_sua.empty() ? 0 : SuaCatalog::stamp();
+    for (uint8_t i = 0; i < SEC_COUNT; i++) {
+      h.count[i] = (uint32_t)(spans[i].bytes / SECTION_SIZE[i]);
+      h.payload_crc = crc32(h.payload_crc, static_cast<const uint8_t *>(spans[i].data), spans[i].bytes);
+    }
+
+    // Written aside and renamed so a power cut never leaves a torn blob.
+    char tmp[48];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", blob_path);
+    File f = LittleFS.open(tmp, "w");
+    if (!f) {
+      Serial.printf("[GEOFENCE] failed to open: %s\n", tmp);
+      return false;
+    }
+    size_t total = sizeof(h);
+    bool ok = f.write(reinterpret_cast<const uint8_t *>(&h), sizeof(h)) == sizeof(h);
+    for (uint8_t i = 0; ok && i < SEC_COUNT; i++) {
+      if (spans[i].bytes == 0) continue;
+      ok = f.write(static_cast<const uint8_t *>(spans[i].data), spans[i].bytes) == spans[i].bytes;
+      total += spans[i].bytes;
+    }
+    f.close();
+    if (ok) {
+      LittleFS.remove(blob_path);
+      ok = LittleFS.rename(tmp, blob_path);
+    }
+    if (!ok) {
+      LittleFS.remove(tmp);
+      Serial.printf("[GEOFENCE] failed to write %s\n", blob_path);
+      return false;
+    }
+    s_load_info.blobBytes = (uint32_t)total;
+    Serial.printf("[GEOFENCE] compiled %s (%u bytes)\n", blob_path, (unsigned)total);
+    return true;
+  }
+
+  // Cross-references a blob could still get wrong despite a good CRC
+  // (e.g. written by a buggy build); cheap next to the read itself.
+  bool blobConsistent()
+  {
+    const size_t verts = s_lat.size();
+    if (s_lon.size() != verts || s_dlat.size() != verts || s_dlon.size() != verts ||
+        s_arc_edge.size() != s_arcs.size() || s_strings.empty() || s_strings.back() != '\0' ||
+        s_index.size() != s_index_ids.size()) {
+      return false;
+    }
+    for (const Rule &r : s_rules) {
+      if ((uint64_t)r.first + r.count > verts ||
+          (uint64_t)r.arc_first + r.arc_count > s_arcs.size() ||
+          r.sua >= (int32_t)s_sua.size() ||
+          r.id >= s_strings.size() || r.detail >= s_strings.size()) {
+        return false;
+      }
+    }
+    for (const std::vector<uint16_t> *ids : {&s_stay_in_ids, &s_line_ids, &s_index_ids}) {
+      for (uint16_t id : *ids) {
+        if (id >= s_rules.size()) return false;
+      }
+    }
+    for (uint32_t v : s_arc_edge) {
+      if (v + 1 >= verts) return false;
+    }
+    return true;
+  }
+
+  bool loadFromBlob(const char *blob_path, const char *json_path)
+  {
+    if (!LittleFS.begin(true) || !LittleFS.exists(blob_path)) return false;
+    File f = LittleFS.open(blob_path, "r");
+    if (!f) return false;
+
+    BlobHeader h;
+    uint64_t payload = 0;
+    const bool header_ok = f.read(reinterpret_cast<uint8_t *>(&h), sizeof(h)) == sizeof(h) &&
+                           memcmp(h.magic, BLOB_MAGIC, sizeof(h.magic)) == 0 &&
+                           h.version == BLOB_VERSION && h.sections == SEC_COUNT &&
+                           h.layout == blobLayout();
+    if (header_ok) {
+      for (uint8_t i = 0; i < SEC_COUNT; i++) payload += (uint64_t)h.count[i] * SECTION_SIZE[i];
+    }
+    if (!header_ok || sizeof(h) + payload != f.size()) {
+      f.close();
+      Serial.printf("[GEOFENCE] %s unreadable or from another build\n", blob_path);
+      return false;
+    }
+    uint32_t source_len = 0;
+    const uint32_t source_crc = fileCrc(json_path, source_len);
+    if (source_len == 0 || source_len != h.source_len || source_crc != h.source_crc) {
+      f.close();
+      Serial.printf("[GEOFENCE] %s out of date with %s\n", blob_path, json_path);
+      return false;
+    }
+    if (h.count[SEC_SUA] > 0 &&
+        (!(SuaCatalog::ready() || SuaCatalog::begin()) || SuaCatalog::stamp() != h.sua_stamp)) {
+      f.close();
+      Serial.printf("[GEOFENCE] %s built against another SUA catalog\n", blob_path);
+      return false;
+    }
+
+    clearRules();
+    std::vector<PackedRTree::Box> tree_boxes;
+    std::vector<uint32_t> tree_ids;
+    std::vector<uint32_t> tree_levels;
+    std::vector<CellGrid::Extent> grid_extent;
+    std::vector<uint8_t> grid_cells;
+    std::vector<uint32_t> grid_set_start;
+    std::vector<uint16_t> grid_set_items;
+    uint32_t crc = 0;
+    bool ok = readSection(f, s_rules, h.count[SEC_RULES], crc) &&
+              readSection(f, s_stay_in_ids, h.count[SEC_STAY_IN_IDS], crc) &&
+              readSection(f, s_line_ids, h.count[SEC_LINE_IDS], crc) &&
+              readSection(f, s_index_ids, h.count[SEC_INDEX_IDS], crc) &&
+              readSection(f, s_lat, h.count[SEC_LAT], crc) &&
+              readSection(f, s_lon, h.count[SEC_LON], crc) &&
+              readSection(f, s_dlat, h.count[SEC_DLAT], crc) &&
+              readSection(f, s_dlon, h.count[SEC_DLON], crc) &&
+              readSection(f, s_arcs, h.count[SEC_ARCS], crc) &&
+              readSection(f, s_arc_edge, h.count[SEC_ARC_EDGE], crc) &&
+              readSection(f, s_sua, h.count[SEC_SUA], crc) &&
+              readSection(f, s_strings, h.count[SEC_STRINGS], crc) &&
+              readSection(f, tree_boxes, h.count[SEC_TREE_BOXES], crc) &&
+              readSection(f, tree_ids, h.count[SEC_TREE_IDS], crc) &&
+              readSection(f, tree_levels, h.count[SEC_TREE_LEVELS], crc) &&
+              readSection(f, grid_extent, h.count[SEC_GRID_EXTENT], crc) &&
+              readSection(f, grid_cells, h.count[SEC_GRID_CELLS], crc) &&
+              readSection(f, grid_set_start, h.count[SEC_GRID_SET_START], crc) &&
+              readSection(f, grid_set_items, h.count[SEC_GRID_SET_ITEMS], crc);
+    f.close();
+    ok = ok && crc == h.payload_crc &&
+         s_index.assign(std::move(tree_boxes), std::move(tree_ids), std::move(tree_levels)) &&
+         blobConsistent() && grid_extent.size() <= 1;
+    if (ok) {
+      std::vector<CellGrid::Box> grid_boxes;
+      std::vector<uint32_t> grid_keys;
+      gridItems(grid_boxes, grid_keys);
+      const CellGrid::Extent extent = grid_extent.empty() ? CellGrid::Extent{CellGrid::Box{0, 0, 0, 0}, 0, 0}
+                                                          : grid_extent[0];
+      ok = s_grid.assign(extent, std::move(grid_cells), std::move(grid_set_start), std::move(grid_set_items),
+                         std::move(grid_boxes), std::move(grid_keys));
+    }
+    if (!ok) {
+      clearRules();
+      Serial.printf("[GEOFENCE] %s corrupt\n", blob_path);
+      return false;
+    }
+    s_load_info.blobBytes = (uint32_t)(sizeof(h) + payload);
+    s_load_info.gridCells = (uint32_t)s_grid.cellCount();
+    s_load_info.gridExactCells = (uint32_t)s_grid.countCells(CellGrid::kExact);
+    s_load_info.gridClassified = 0;
+    s_load_info.gridUs = 0;
+    finishLoad(blob_path);
+    return true;
+  }
+
+  // JSON parse plus recompile, or the compiled blob when it is current.
+  // The blob carries the cell grid; a JSON load rebuilds it, keeping the
+  // cells of rules the new set shares with the old one.
+  bool load(const char *path, bool prefer_blob)
+  {
+    char blob_path[48];
+    blobPathFor(path, blob_path, sizeof(blob_path));
+    CellGrid prev = std::move(s_grid);
+    s_grid.clear();
+    const uint32_t start_us = micros();
+    const uint32_t heap_before = ESP.getFreeHeap();
+    s_load_info.suaTypeAreas = 0;
+    s_load_info.suaTypeRefused = 0;
+    s_load_info.fromBlob = prefer_blob && loadFromBlob(blob_path, path);
+    const bool ok = s_load_info.fromBlob || loadFromJson(path);
+    if (ok && !s_load_info.fromBlob) buildGrid(prev);
+    s_load_info.ok = ok;
+    s_load_info.loadUs = micros() - start_us;
+    s_load_info.heapBytes = (int32_t)(heap_before - ESP.getFreeHeap());
+    s_load_info.minFreeHeap = ESP.getMinFreeHeap();
+    Serial.printf("[GEOFENCE] load from %s took %luus, heap %+ld B (min free %lu B)\n",
+                  s_load_info.fromBlob ? "blob" : "json", (unsigned long)s_load_info.loadUs,
+                  (long)s_load_info.heapBytes, (unsigned long)s_load_info.minFreeHeap);
+    if (ok && !s_load_info.fromBlob) writeBlob(blob_path, path);
+    return ok;
+  }
 }  // namespace
 
 namespace GeoFence {
 
 bool begin(const char *path)
 {
-  return loadFromJson(path);
+  const Guard guard(s_lock);
+  return load(path, true);
 }
 
 bool reload(const char *path)
 {
+  const Guard guard(s_lock);
   s_violation_pending = false;
   s_violation_start_ms = 0;
-  return loadFromJson(path);
+  s_violation_fixes = 0;
+  return load(path, false);
 }
 
-bool update(double lat, double lon)
+static bool evaluate(double lat_deg, double lon_deg, float alt)
 {
+  const int32_t lat = GeoMath::toE6(lat_deg);
+  const int32_t lon = GeoMath::toE6(lon_deg);
+  const uint32_t now = millis();
+  // Unknown altitude matches every band.
+  const bool has_alt = !isnan(alt);
+  const int32_t alt_m = has_alt ? (int32_t)lroundf(alt) : 0;
   s_violations.clear();
   if (s_force_violation) {
     GeoFence::Violation v;
@@ -191,102 +1740,427 @@ bool update(double lat, double lon)
     v.type = "test";
     v.detail = "forced geofence violation";
     s_violations.push_back(v);
-    s_prev_lat = lat;
-    s_prev_lon = lon;
-    s_has_prev = true;
+    rememberFix(lat, lon, alt, now);
     return true;
   }
   if (!s_loaded) {
-    s_prev_lat = lat;
-    s_prev_lon = lon;
-    s_has_prev = true;
+    s_margin_valid = false;
+    rememberFix(lat, lon, alt, now);
     return false;
   }
 
-  for (Rule &r : s_rules) {
-    if (r.type == RuleType::KeepOut) {
-      if (pointInPolygon(r.polygon, lat, lon)) {
-        addViolation(r, "entered keep-out");
-      }
-    } else if (r.type == RuleType::StayIn) {
-      const bool inside = pointInPolygon(r.polygon, lat, lon);
-      if (!r.armed) {
-        if (inside) r.armed = true;
-        continue;
-      }
-      if (!inside) {
-        addViolation(r, "left stay-in");
-      }
-    } else if (r.type == RuleType::Line) {
-      if (s_has_prev && crossedLine(r.axis, r.value, s_prev_lat, s_prev_lon, lat, lon)) {
-        addViolation(r, "crossed line");
+  // Only rules whose bbox and band hold the fix come back from the index;
+  // any rule not visited is therefore outside.
+  for (uint16_t id : s_index_ids) s_rules[id].inside = false;
+  PackedRTree::Stats q;
+  const uint8_t cell = s_grid.at(lat, lon);
+  if (cell != CellGrid::kExact) {
+    // No boundary crosses this cell: the rules covering it are exactly
+    // its interior set, less those whose band misses the fix.
+    s_stats.cellHits++;
+    for (const uint16_t *it = s_grid.setBegin(cell); it != s_grid.setEnd(cell); ++it) {
+      Rule &r = s_rules[s_index_ids[*it]];
+      if (has_alt && (alt_m < r.floor_m || alt_m > r.ceil_m)) continue;
+      q.candidates++;
+      r.inside = true;
+      if (r.type == RuleType::KeepOut) addViolation(r, "entered keep-out");
+    }
+  } else {
+    s_index.query(lat, lon, has_alt ? alt_m : PackedRTree::kAltMin, has_alt ? alt_m : PackedRTree::kAltMax,
+                  q, [&](uint32_t slot) {
+      Rule &r = s_rules[s_index_ids[slot]];
+      if (!pointInRule(r, lat, lon)) return;
+      r.inside = true;
+      if (r.type == RuleType::KeepOut) addViolation(r, "entered keep-out");
+    });
+  }
+  s_stats.lastNodesVisited = q.nodesVisited;
+  s_stats.lastCandidates = q.candidates;
+  s_stats.totalNodesVisited += q.nodesVisited;
+  s_stats.totalCandidates += q.candidates;
+
+  // Swept check: the straight path since the last fix must not touch a
+  // keep-out we are now outside of, nor the edge of an armed stay-in we
+  // are still inside. Runs before arming so a stay-in entered on this fix
+  // does not count its own entry. Any rule whose band overlaps the climb
+  // or descent between the fixes is checked.
+  const bool hop_ok = s_has_prev && plausibleHop(lat, lon, now);
+  if (s_has_prev && !hop_ok) s_stats.glitchHops++;
+  if (hop_ok) confirmTransits(lat, lon);
+  if (hop_ok && (s_prev_lat != lat || s_prev_lon != lon)) {
+    const bool path_alt = has_alt && !isnan(s_prev_alt);
+    const int32_t prev_alt_m = path_alt ? (int32_t)lroundf(s_prev_alt) : 0;
+    const PackedRTree::Box path{min(s_prev_lat, lat), min(s_prev_lon, lon),
+                                max(s_prev_lat, lat), max(s_prev_lon, lon),
+                                path_alt ? min(prev_alt_m, alt_m) : PackedRTree::kAltMin,
+                                path_alt ? max(prev_alt_m, alt_m) : PackedRTree::kAltMax};
+    PackedRTree::Stats sq;
+    s_index.query(path, sq, [&](uint32_t slot) {
+      const Rule &r = s_rules[s_index_ids[slot]];
+      const bool watch = (r.type == RuleType::KeepOut) ? !r.inside : (r.armed && r.inside);
+      if (!watch || !pathCrossesRule(r, s_prev_lat, s_prev_lon, lat, lon)) return;
+      s_stats.sweptHits++;
+      addTransit(s_index_ids[slot], r.type == RuleType::KeepOut ? "clipped keep-out" : "left stay-in between fixes");
+    });
+  }
+
+  for (uint16_t id : s_stay_in_ids) {
+    Rule &r = s_rules[id];
+    if (!r.armed) {
+      if (r.inside) r.armed = true;
+      continue;
+    }
+    if (!r.inside) {
+      addViolation(r, "left stay-in");
+    }
+  }
+
+  if (hop_ok) {
+    for (uint16_t id : s_line_ids) {
+      const Rule &r = s_rules[id];
+      if (crossedLine(r.axis, r.value, s_prev_lat, s_prev_lon, lat, lon)) {
+        addTransit(id, "crossed line");
       }
     }
   }
+  for (const Transit &t : s_transits) s_violations.push_back(makeViolation(s_rules[t.rule], t.detail));
+
+  updateMargin(lat, lon, alt);
 
   if (!s_violations.empty()) {
+    if (s_violation_fixes < 0xFF) s_violation_fixes++;
     if (!s_violation_pending) {
       s_violation_pending = true;
       s_violation_start_ms = millis();
       s_violations.clear();
-    } else if (millis() - s_violation_start_ms < VIOLATION_SUSTAIN_MS) {
+    } else if (s_violation_fixes < VIOLATION_SUSTAIN_FIXES ||
+               millis() - s_violation_start_ms < VIOLATION_SUSTAIN_MS) {
       s_violations.clear();
     }
   } else {
     s_violation_pending = false;
     s_violation_start_ms = 0;
+    s_violation_fixes = 0;
   }
 
-  s_prev_lat = lat;
-  s_prev_lon = lon;
-  s_has_prev = true;
-
+  rememberFix(lat, lon, alt, now);
   return !s_violations.empty();
 }
 
+bool update(double lat, double lon, float altM)
+{
+  const Guard guard(s_lock);
+  const uint32_t start_us = micros();
+  const bool violated = evaluate(lat, lon, altM);
+  recordEvaluation(start_us);
+  return violated;
+}
+
+bool margin(float &meters, float &closingMps)
+{
+  const Guard guard(s_lock);
+  if (!s_margin_valid) return false;
+  meters = s_margin_m;
+  closingMps = s_closing_mps;
+  return true;
+}
+
+String marginRuleId()
+{
+  const Guard guard(s_lock);
+  return s_margin_rule >= 0 ? String(ruleString(s_rules[s_margin_rule].id)) : String();
+}
+
+uint32_t revision()
+{
+  const Guard guard(s_lock);
+  return s_revision;
+}
+
+Stats stats()
+{
+  const Guard guard(s_lock);
+  rollRateWindow(millis());
+  return s_stats;
+}
+
+LoadInfo loadInfo()
+{
+  const Guard guard(s_lock);
+  return s_load_info;
+}
+
+bool ruleInfo(size_t idx, RuleInfo &out)
+{
+  const Guard guard(s_lock);
+  if (idx >= s_rules.size()) return false;
+  const Rule &r = s_rules[idx];
+  out.id = ruleString(r.id);
+  out.type = ruleTypeName(r.type);
+  out.sua = r.sua >= 0;
+  out.rings = r.rings;
+  out.vertices = r.count;
+  out.verticesIn = r.count_in ? r.count_in : r.count;
+  out.evalNs = r.eval_ns;
+  out.evalNsIn = r.eval_ns_in;
+  out.floorM = r.floor_m;
+  out.ceilM = r.ceil_m;
+  return true;
+}
+
+bool benchmarkRule(size_t idx, uint32_t points, BatchBench &out)
+{
+  const Guard guard(s_lock);
+  if (idx >= s_rules.size()) return false;
+  const Rule &r = s_rules[idx];
+  if (r.type == RuleType::Line || r.sua >= 0 || r.count < 4) return false;
+  points = points < 1 ? 1 : (points > BENCH_MAX_POINTS ? BENCH_MAX_POINTS : points);
+  std::vector<int32_t> lat(points);
+  std::vector<int32_t> lon(points);
+  std::vector<uint8_t> single(points);
+  std::vector<uint8_t> batch(points);
+  uint32_t seed = 0x9E3779B9u;
+  for (uint32_t k = 0; k < points; k++) {
+    seed = seed * 1664525u + 1013904223u;
+    lat[k] = r.min_lat + (int32_t)((uint64_t)(seed >> 8) * (uint32_t)(r.max_lat - r.min_lat) >> 24);
+    seed = seed * 1664525u + 1013904223u;
+    lon[k] = r.min_lon + (int32_t)((uint64_t)(seed >> 8) * (uint32_t)(r.max_lon - r.min_lon) >> 24);
+  }
+
+  uint32_t start_us = micros();
+  for (uint32_t k = 0; k < points; k++) {
+    single[k] = GeoMath::pointInRing(&s_lat[r.first], &s_lon[r.first], &s_dlat[r.first], &s_dlon[r.first],
+                                     r.count, lat[k], lon[k]) ? 1 : 0;
+  }
+  out.singleUs = micros() - start_us;
+  start_us = micros();
+  GeoMath::pointsInRing(&s_lat[r.first], &s_lon[r.first], &s_dlat[r.first], &s_dlon[r.first], r.count,
+                        lat.data(), lon.data(), points, batch.data());
+  out.batchUs = micros() - start_us;
+  if (out.singleUs == 0) out.singleUs = 1;
+  if (out.batchUs == 0) out.batchUs = 1;
+
+  out.points = points;
+  out.singlePps = (uint32_t)((uint64_t)points * 1000000u / out.singleUs);
+  out.batchPps = (uint32_t)((uint64_t)points * 1000000u / out.batchUs);
+  out.mismatches = 0;
+  for (uint32_t k = 0; k < points; k++) out.mismatches += single[k] != batch[k];
+  return true;
+}
+
+bool validateTrack(const TrackPoint *points, size_t count, bool catalog, TrackReport &out)
+{
+  const Guard guard(s_lock);
+  out = TrackReport();
+  if (!points || count == 0 || count > kTrackMaxPoints) return false;
+  const uint32_t start_us = micros();
+
+  Track tk;
+  tk.lat.resize(count);
+  tk.lon.resize(count);
+  tk.alt.resize(count);
+  tk.along.resize(count);
+  for (size_t i = 0; i < count; i++) {
+    tk.lat[i] = GeoMath::toE6(points[i].lat);
+    tk.lon[i] = GeoMath::toE6(points[i].lon);
+    tk.alt[i] = points[i].altM;
+    tk.along[i] = 0.0f;
+    if (i == 0) continue;
+    const float dy = (float)(tk.lat[i] - tk.lat[i - 1]) * (GeoMath::kMetersPerDegLat / 1e6f);
+    const float dx = (float)(tk.lon[i] - tk.lon[i - 1]) *
+                     GeoMath::metersPerLonE6(tk.lat[i - 1] / 2 + tk.lat[i] / 2);
+    tk.along[i] = tk.along[i - 1] + sqrtf(dx * dx + dy * dy);
+  }
+  out.lengthM = tk.along.back();
+  const uint32_t legs = count > 1 ? (uint32_t)count - 1 : 1;
+
+  // Rules: whatever the index returns for some leg, plus every stay-in so
+  // a track that never reaches the mission area still says so.
+  std::vector<uint8_t> slots(s_index_ids.size(), 0);
+  PackedRTree::Stats q;
+  for (uint32_t i = 0; i < legs; i++) {
+    s_index.query(legBox(tk, i), q, [&](uint32_t slot) { slots[slot] = 1; });
+  }
+  Shape shape;
+  std::vector<uint8_t> inside;
+  for (size_t slot = 0; slot < slots.size(); slot++) {
+    const Rule &r = s_rules[s_index_ids[slot]];
+    if (!slots[slot] && r.type != RuleType::StayIn) continue;
+    if (!hasArea(r)) continue;
+    if (r.sua < 0) {
+      shapeFromRule(r, shape);
+    } else if (!shapeFromEntry(s_sua[r.sua], shape)) {
+      continue;
+    }
+    out.rulesChecked++;
+    if (r.sua >= 0 && r.erode_m > 0) {
+      // Eroded stay-in: the states come from the enforced boundary, the
+      // exit points from the catalog one, up to erode_m early.
+      inside.resize(count);
+      for (size_t k = 0; k < count; k++) inside[k] = pointInRule(r, tk.lat[k], tk.lon[k]) ? 1 : 0;
+    } else {
+      shapeStates(shape, tk.lat, tk.lon, inside);
+    }
+    const PackedRTree::Box box{r.min_lat, r.min_lon, r.max_lat, r.max_lon, r.floor_m, r.ceil_m};
+    if (r.type == RuleType::StayIn) {
+      areaExits(tk, shape, box, inside, ruleString(r.id), out.hits);
+    } else {
+      areaEntries(tk, shape, box, inside, ruleString(r.id), "keep_out", "keep-out", out.hits);
+    }
+  }
+  for (uint16_t id : s_line_ids) {
+    const Rule &r = s_rules[id];
+    out.rulesChecked++;
+    bool landed = false;  // previous leg ended on the line and was reported
+    for (uint32_t i = 0; i + 1 < count; i++) {
+      const bool ns = r.axis == LineAxis::NorthSouth;
+      const int32_t a = ns ? tk.lon[i] : tk.lat[i];
+      const int32_t b = ns ? tk.lon[i + 1] : tk.lat[i + 1];
+      const bool crossed = crossedLine(r.axis, r.value, tk.lat[i], tk.lon[i], tk.lat[i + 1], tk.lon[i + 1]);
+      if (crossed && !(landed && a == r.value)) {
+        const float t = (a == b) ? 0.0f : (float)((double)(r.value - a) / (double)(b - a));
+        trackHit(tk, i, t, ruleString(r.id), "line", "crosses line", out.hits);
+      }
+      landed = crossed && b == r.value;
+    }
+  }
+
+  // Catalog areas the rules above do not already cover.
+  if (catalog && (SuaCatalog::ready() || SuaCatalog::begin())) {
+    std::vector<uint32_t> areas;
+    for (uint32_t i = 0; i < legs; i++) SuaCatalog::query(legBox(tk, i), q, areas);
+    std::sort(areas.begin(), areas.end());
+    areas.erase(std::unique(areas.begin(), areas.end()), areas.end());
+    SuaCatalog::Entry e;
+    char name[64];
+    char code[16];
+    for (uint32_t idx : areas) {
+      if (!SuaCatalog::entry(idx, e)) continue;
+      bool loaded = false;
+      for (const SuaCatalog::Entry &l : s_sua) loaded |= l.geom_offset == e.geom_offset;
+      if (loaded || !shapeFromEntry(e, shape)) continue;
+      out.areasChecked++;
+      if (!SuaCatalog::name(e, name, sizeof(name))) snprintf(name, sizeof(name), "#%lu", (unsigned long)idx);
+      if (!SuaCatalog::typeCode(e, code, sizeof(code))) strcpy(code, "SUA");
+      shapeStates(shape, tk.lat, tk.lon, inside);
+      const PackedRTree::Box box{e.min_lat, e.min_lon, e.max_lat, e.max_lon, e.floor_m, e.ceil_m};
+      areaEntries(tk, shape, box, inside, name, "sua", String(code), out.hits);
+    }
+  }
+
+  std::stable_sort(out.hits.begin(), out.hits.end(),
+                   [](const TrackHit &a, const TrackHit &b) { return a.alongM < b.alongM; });
+  if (out.hits.size() > kTrackMaxHits) {
+    out.hits.resize(kTrackMaxHits);
+    out.truncated = true;
+  }
+  out.elapsedUs = micros() - start_us;
+  return true;
+}
+
+void resetStats()
+{
+  const Guard guard(s_lock);
+  const uint32_t slow_us = s_stats.slowEvalUs;
+  s_stats = Stats();
+  s_stats.slowEvalUs = slow_us;
+  s_rate_window_ms = millis();
+  s_rate_window_count = 0;
+}
+
+void setSlowEvalUs(uint32_t us)
+{
+  const Guard guard(s_lock);
+  s_stats.slowEvalUs = us;
+}
+
 void setForcedViolation(bool enabled)
 {
+  const Guard guard(s_lock);
   s_force_violation = enabled;
   if (!s_force_violation) {
     s_violations.clear();
   }
   s_violation_pending = false;
   s_violation_start_ms = 0;
+  s_violation_fixes = 0;
 }
 
 bool forcedViolation()
 {
+  const Guard guard(s_lock);
   return s_force_violation;
 }
 
 size_t violationCount()
 {
+  const Guard guard(s_lock);
   return s_violations.size();
 }
 
+bool violationPending()
+{
+  const Guard guard(s_lock);
+  return s_violation_pending && s_violations.empty();
+}
+
 size_t ruleCount()
 {
+  const Guard guard(s_lock);
   return s_rules.size();
 }
 
+size_t vertexCount()
+{
+  const Guard guard(s_lock);
+  return s_lat.size();
+}
+
+size_t arcCount()
+{
+  const Guard guard(s_lock);
+  return s_arcs.size();
+}
+
+size_t suaRuleCount()
+{
+  const Guard guard(s_lock);
+  return s_sua.size();
+}
+
+size_t indexNodeCount()
+{
+  const Guard guard(s_lock);
+  return s_index.nodeCount();
+}
+
 const Violation &violation(size_t idx)
 {
+  const Guard guard(s_lock);
   return s_violations[idx];
 }
 
 void clearViolations()
 {
+  const Guard guard(s_lock);
   s_violations.clear();
+  s_transits.clear();
+  s_violation_pending = false;
+  s_violation_start_ms = 0;
+  s_violation_fixes = 0;
 }
 
-bool containedAt(double lat, double lon, bool *hasStayIn)
+bool containedAt(double lat_deg, double lon_deg, bool *hasStayIn)
 {
+  const Guard guard(s_lock);
+  const int32_t lat = GeoMath::toE6(lat_deg);
+  const int32_t lon = GeoMath::toE6(lon_deg);
   bool has = false;
   bool inside = false;
-  for (const Rule &r : s_rules) {
-    if (r.type != RuleType::StayIn) continue;
+  for (uint16_t id : s_stay_in_ids) {
+    const Rule &r = s_rules[id];
     has = true;
-    if (pointInPolygon(r.polygon, lat, lon)) {
+    if (pointInRule(r, lat, lon)) {
       inside = true;
       break;
     }
@@ -2,7 +2,11 @@
 
 #include <Arduino.h>
 #include <stddef.h>
+#include <vector>
 
+// Calls are serialised internally, so loop() (update()) and the web server
+// task (validateTrack(), benchmarkRule(), stats) may both use the engine.
+// violation() references stay valid only until the next update() or load.
 namespace GeoFence {
   struct Violation {
     String id;
@@ -10,20 +14,161 @@ namespace GeoFence {
     String detail;
   };
 
-  // Load rules from LittleFS JSON (default: /geofence.json).
+  // Evaluation cost counters (updated by update()).
+  struct Stats {
+    uint32_t evaluations = 0;     // total update() calls since boot/reset
+    uint32_t evalsPerSec = 0;     // evaluations in the last complete 1 s window (0 once idle)
+    uint32_t lastEvalUs = 0;      // latency of the most recent update()
+    uint32_t worstEvalUs = 0;     // worst-case update() latency
+    uint32_t slowEvalUs = 0;      // latency above which an evaluation counts as slow
+    uint32_t slowEvals = 0;       // evaluations that took longer than slowEvalUs
+    // Spatial index work for the last / all evaluations.
+    uint32_t lastNodesVisited = 0;
+    uint32_t lastCandidates = 0;
+    uint32_t totalNodesVisited = 0;
+    uint32_t totalCandidates = 0;
+    uint32_t lastMarginRules = 0;   // rules whose distance the last margin computed
+    // Swept (fix-to-fix path) checks.
+    uint32_t sweptHits = 0;       // paths that clipped a keep-out / left a stay-in
+    uint32_t transitsDropped = 0; // swept hits / line crossings later fixes did not confirm
+    uint32_t glitchHops = 0;      // hops too fast to be real, not swept
+    uint32_t cellHits = 0;        // fixes settled by the cell grid, no exact test
+  };
+
+  // Cost and provenance of the last begin()/reload().
+  struct LoadInfo {
+    bool ok = false;           // rules in force; false leaves none loaded
+    bool fromBlob = false;     // compiled blob used, no JSON parse
+    uint32_t loadUs = 0;
+    int32_t heapBytes = 0;     // free-heap drop across the load
+    uint32_t minFreeHeap = 0;  // heap low-water mark right after it
+    uint32_t blobBytes = 0;    // size of the compiled blob on flash
+    // Cell grid: size, cells left to the exact test, and how many cells
+    // the last rebuild had to classify (0 when it came from the blob).
+    uint32_t gridCells = 0;
+    uint32_t gridExactCells = 0;
+    uint32_t gridClassified = 0;
+    uint32_t gridUs = 0;
+    // "sua_type" keep-outs: catalog areas loaded, and areas the heap could
+    // not hold (the load then fails rather than drop part of a category).
+    uint32_t suaTypeAreas = 0;
+    uint32_t suaTypeRefused = 0;
+  };
+
+  // Load rules (default: /geofence.json). begin() uses the compiled
+  // /geofence.bin when it matches the JSON and rebuilds it otherwise;
+  // reload() always parses the JSON and recompiles (portal save path).
   bool begin(const char *path = "/geofence.json");
   bool reload(const char *path = "/geofence.json");
+  LoadInfo loadInfo();
+
+  // Per-rule geometry report. Vertex counts cover every ring (outline and
+  // holes) and include each ring's closing vertex;
+  // the eval times are sampled containment tests, set only for rules the
+  // load simplified ("simplify_m" in geofence.json).
+  struct RuleInfo {
+    String id;
+    const char *type;
+    bool sua;
+    uint16_t rings;
+    uint32_t vertices;
+    uint32_t verticesIn;
+    uint16_t evalNs;
+    uint16_t evalNsIn;
+    int32_t floorM;
+    int32_t ceilM;
+  };
+  bool ruleInfo(size_t idx, RuleInfo &out);
+
+  // Containment throughput on one polygon rule's rings (ring kernel only,
+  // arcs not applied): the same random points over its bbox tested one at
+  // a time with GeoMath::pointInRing() and as one GeoMath::pointsInRing()
+  // batch. mismatches counts points the two disagree on and must be 0.
+  // False for SUA and line rules.
+  struct BatchBench {
+    uint32_t points;
+    uint32_t singleUs;
+    uint32_t batchUs;
+    uint32_t singlePps;  // points per second
+    uint32_t batchPps;
+    uint32_t mismatches;
+  };
+  bool benchmarkRule(size_t idx, uint32_t points, BatchBench &out);
+
+  // Pre-flight route check: a planned track against every loaded rule and,
+  // optionally, every SUA catalog area, through the same index and
+  // containment/crossing predicates as update(). Legs are straight in
+  // lat/lon like fix-to-fix paths; altitudes are metres MSL and NAN
+  // matches every band. Keep-outs and catalog areas report each entry,
+  // stay-ins each exit once the track has been inside, lines each
+  // crossing, with the point and along-track distance where it happens.
+  // False when the track is empty or longer than kTrackMaxPoints.
+  constexpr size_t kTrackMaxPoints = 1024;
+  constexpr size_t kTrackMaxHits = 64;
+
+  struct TrackPoint {
+    double lat;
+    double lon;
+    float altM;
+  };
+
+  struct TrackHit {
+    String id;        // rule id, or catalog area name
+    String type;      // keep_out / stay_in / line / sua
+    String detail;
+    uint32_t leg;     // 0 = first point to second
+    float alongM;
+    double lat;
+    double lon;
+    float altM;       // NAN when the track has no altitude there
+  };
+
+  struct TrackReport {
+    float lengthM = 0.0f;
+    uint32_t rulesChecked = 0;   // rules whose index box the track touched
+    uint32_t areasChecked = 0;   // catalog areas likewise
+    uint32_t elapsedUs = 0;
+    bool truncated = false;      // more than kTrackMaxHits, earliest kept
+    std::vector<TrackHit> hits;  // ordered by alongM
+  };
+  bool validateTrack(const TrackPoint *points, size_t count, bool catalog, TrackReport &out);
 
   // Evaluate current position. Returns true if any violations.
-  bool update(double lat, double lon);
+  // Intended to be called once per new GPS fix. Rules with a floor_m /
+  // ceil_m band (metres MSL) only apply inside it; NAN altitude is unknown
+  // and matches every band.
+  bool update(double lat, double lon, float altM = NAN);
+
+  // Signed distance (m) from the last evaluated fix to the nearest enforced
+  // boundary (> 0 safe side, < 0 violating) and how fast it is shrinking
+  // (m/s, > 0 approaching). False when no rule applies.
+  bool margin(float &meters, float &closingMps);
+  String marginRuleId();
+  // Bumped on every (re)load so schedulers can drop stale cadence.
+  uint32_t revision();
+
+  Stats stats();
+  void resetStats();
+  // Only counted, never enforced: update() always finishes its checks.
+  void setSlowEvalUs(uint32_t us);
 
   // Test hook to force a geofence violation regardless of position.
   void setForcedViolation(bool enabled);
   bool forcedViolation();
 
   size_t ruleCount();
+  size_t vertexCount();
+  size_t arcCount();
+  // Rules streamed from the SUA catalog rather than stored as polygons.
+  size_t suaRuleCount();
+  size_t indexNodeCount();
   size_t violationCount();
+  // True while violating fixes are being debounced, before update()
+  // reports them: the first sign of an excursion.
+  bool violationPending();
   const Violation &violation(size_t idx);
+  // Drops the current violations, confirmed transits included, and
+  // restarts the debounce.
   void clearViolations();
 
   // Check if point is inside any stay-in polygon. hasStayIn is set if any exist.
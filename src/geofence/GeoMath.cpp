@@ -0,0 +1,336 @@
+#include "geofence/GeoMath.h"
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+namespace GeoMath {
+
+namespace {
+  // True when angle theta lies within the arc's sweep.
+  bool inSweep(const Arc &a, float theta)
+  {
+    const float two_pi = 2.0f * (float)M_PI;
+    float off = (a.sweep_rad >= 0.0f) ? theta - a.start_rad : a.start_rad - theta;
+    while (off < 0.0f) off += two_pi;
+    while (off >= two_pi) off -= two_pi;
+    return off <= fabsf(a.sweep_rad);
+  }
+
+  int sign(int64_t v) { return (v > 0) - (v < 0); }
+
+  // pointsInRing() only sorts when the edge walk it saves outweighs the
+  // sort and the per-edge searches: enough points, a ring of some size,
+  // and enough of both (vertices x points). Measured on the host against
+  // the single-point loop; below these it was 0.5-0.9x as fast.
+  constexpr uint32_t kBatchMinPoints = 16;
+  constexpr uint32_t kBatchMinVertices = 64;
+  constexpr uint64_t kBatchMinWork = 32768;
+
+  // c is collinear with a-b; true when it lies within the segment's bbox.
+  bool onSegment(int32_t a_lat, int32_t a_lon, int32_t b_lat, int32_t b_lon,
+                 int32_t c_lat, int32_t c_lon)
+  {
+    return c_lat >= (a_lat < b_lat ? a_lat : b_lat) && c_lat <= (a_lat > b_lat ? a_lat : b_lat) &&
+           c_lon >= (a_lon < b_lon ? a_lon : b_lon) && c_lon <= (a_lon > b_lon ? a_lon : b_lon);
+  }
+}  // namespace
+
+int32_t toE6(double deg)
+{
+  return (int32_t)lround(deg * 1e6);
+}
+
+double fromE6(int32_t e6)
+{
+  return (double)e6 / 1e6;
+}
+
+bool makeArc(int32_t start_lat, int32_t start_lon,
+             int32_t end_lat, int32_t end_lon,
+             int32_t center_lat, int32_t center_lon,
+             uint32_t radius_m, bool ccw, Arc &out)
+{
+  out.start_lat = start_lat;
+  out.start_lon = start_lon;
+  out.end_lat = end_lat;
+  out.end_lon = end_lon;
+  out.center_lat = center_lat;
+  out.center_lon = center_lon;
+  out.m_per_lat = kMetersPerDegLat / 1e6f;
+  out.m_per_lon = metersPerLonE6(center_lat);
+
+  const float sx = (float)(start_lon - center_lon) * out.m_per_lon;
+  const float sy = (float)(start_lat - center_lat) * out.m_per_lat;
+  const float ex = (float)(end_lon - center_lon) * out.m_per_lon;
+  const float ey = (float)(end_lat - center_lat) * out.m_per_lat;
+  const float ds = sqrtf(sx * sx + sy * sy);
+  const float de = sqrtf(ex * ex + ey * ey);
+  out.radius_m = (ds > 0.0f || de > 0.0f) ? 0.5f * (ds + de) : (float)radius_m;
+  if (out.radius_m <= 0.0f || out.radius_m > kMaxArcRadiusM) return false;
+
+  const float two_pi = 2.0f * (float)M_PI;
+  out.start_rad = atan2f(sy, sx);
+  out.chord_nx = out.chord_ny = out.chord_c = 0.0f;
+  if (start_lat == end_lat && start_lon == end_lon) {
+    out.sweep_rad = ccw ? two_pi : -two_pi;
+    return true;
+  }
+  float sweep = atan2f(ey, ex) - out.start_rad;
+  if (ccw) {
+    while (sweep <= 0.0f) sweep += two_pi;
+  } else {
+    while (sweep >= 0.0f) sweep -= two_pi;
+  }
+  out.sweep_rad = sweep;
+
+  const float mid = out.start_rad + 0.5f * sweep;
+  const float mx = cosf(mid) * out.radius_m;
+  const float my = sinf(mid) * out.radius_m;
+  out.chord_nx = -(ey - sy);
+  out.chord_ny = ex - sx;
+  out.chord_c = out.chord_nx * sx + out.chord_ny * sy;
+  if (out.chord_nx * mx + out.chord_ny * my < out.chord_c) {
+    out.chord_nx = -out.chord_nx;
+    out.chord_ny = -out.chord_ny;
+    out.chord_c = -out.chord_c;
+  }
+  return true;
+}
+
+void arcPoint(const Arc &a, float angle_rad, int32_t &lat, int32_t &lon)
+{
+  lat = a.center_lat + (int32_t)lroundf(sinf(angle_rad) * a.radius_m / a.m_per_lat);
+  lon = a.center_lon + (int32_t)lroundf(cosf(angle_rad) * a.radius_m / a.m_per_lon);
+}
+
+void arcBounds(const Arc &a, int32_t &min_lat, int32_t &min_lon,
+               int32_t &max_lat, int32_t &max_lon)
+{
+  auto grow = [&](int32_t lat, int32_t lon) {
+    if (lat < min_lat) min_lat = lat;
+    if (lat > max_lat) max_lat = lat;
+    if (lon < min_lon) min_lon = lon;
+    if (lon > max_lon) max_lon = lon;
+  };
+  grow(a.start_lat, a.start_lon);
+  grow(a.end_lat, a.end_lon);
+
+  for (int k = 0; k < 4; k++) {
+    const float theta = (float)k * 0.5f * (float)M_PI;
+    if (inSweep(a, theta)) {
+      int32_t lat, lon;
+      arcPoint(a, theta, lat, lon);
+      grow(lat, lon);
+    }
+  }
+}
+
+bool segmentsIntersect(int32_t a_lat, int32_t a_lon, int32_t b_lat, int32_t b_lon,
+                       int32_t c_lat, int32_t c_lon, int32_t d_lat, int32_t d_lon)
+{
+  const int o1 = sign(orient(a_lat, a_lon, b_lat, b_lon, c_lat, c_lon));
+  const int o2 = sign(orient(a_lat, a_lon, b_lat, b_lon, d_lat, d_lon));
+  const int o3 = sign(orient(c_lat, c_lon, d_lat, d_lon, a_lat, a_lon));
+  const int o4 = sign(orient(c_lat, c_lon, d_lat, d_lon, b_lat, b_lon));
+  if (o1 != o2 && o3 != o4) return true;
+  if (o1 == 0 && onSegment(a_lat, a_lon, b_lat, b_lon, c_lat, c_lon)) return true;
+  if (o2 == 0 && onSegment(a_lat, a_lon, b_lat, b_lon, d_lat, d_lon)) return true;
+  if (o3 == 0 && onSegment(c_lat, c_lon, d_lat, d_lon, a_lat, a_lon)) return true;
+  if (o4 == 0 && onSegment(c_lat, c_lon, d_lat, d_lon, b_lat, b_lon)) return true;
+  return false;
+}
+
+bool segmentIntersectsArc(const Arc &arc, int32_t a_lat, int32_t a_lon,
+                          int32_t b_lat, int32_t b_lon)
+{
+  // |A + t (B - A)|^2 = r^2 in the arc's frame, t in [0, 1].
+  const float ax = (float)(a_lon - arc.center_lon) * arc.m_per_lon;
+  const float ay = (float)(a_lat - arc.center_lat) * arc.m_per_lat;
+  const float dx = (float)(b_lon - a_lon) * arc.m_per_lon;
+  const float dy = (float)(b_lat - a_lat) * arc.m_per_lat;
+  const float qa = dx * dx + dy * dy;
+  const float qb = 2.0f * (ax * dx + ay * dy);
+  const float qc = ax * ax + ay * ay - arc.radius_m * arc.radius_m;
+  if (qa <= 0.0f) return false;
+  const float disc = qb * qb - 4.0f * qa * qc;
+  if (disc < 0.0f) return false;
+  const float root = sqrtf(disc);
+  const float ts[2] = {(-qb - root) / (2.0f * qa), (-qb + root) / (2.0f * qa)};
+  for (float t : ts) {
+    if (t < 0.0f || t > 1.0f) continue;
+    if (inSweep(arc, atan2f(ay + t * dy, ax + t * dx))) return true;
+  }
+  return false;
+}
+
+bool segmentHitParam(int32_t a_lat, int32_t a_lon, int32_t b_lat, int32_t b_lon,
+                     int32_t c_lat, int32_t c_lon, int32_t d_lat, int32_t d_lon,
+                     float t_min, float &t)
+{
+  if (!segmentsIntersect(a_lat, a_lon, b_lat, b_lon, c_lat, c_lon, d_lat, d_lon)) return false;
+  const int64_t oa = orient(c_lat, c_lon, d_lat, d_lon, a_lat, a_lon);
+  const int64_t ob = orient(c_lat, c_lon, d_lat, d_lon, b_lat, b_lon);
+  float lo;
+  float hi;
+  if (oa != ob) {
+    lo = hi = (float)((double)oa / (double)(oa - ob));
+  } else {
+    // Collinear: the overlap is c-d projected onto a->b, clipped to it.
+    const double dx = (double)b_lon - a_lon;
+    const double dy = (double)b_lat - a_lat;
+    const double len2 = dx * dx + dy * dy;
+    if (len2 == 0.0) {
+      lo = hi = 0.0f;
+    } else {
+      const float tc = (float)((((double)c_lon - a_lon) * dx + ((double)c_lat - a_lat) * dy) / len2);
+      const float td = (float)((((double)d_lon - a_lon) * dx + ((double)d_lat - a_lat) * dy) / len2);
+      lo = tc < td ? tc : td;
+      hi = tc < td ? td : tc;
+    }
+  }
+  lo = lo < 0.0f ? 0.0f : (lo > 1.0f ? 1.0f : lo);
+  hi = hi < 0.0f ? 0.0f : (hi > 1.0f ? 1.0f : hi);
+  if (hi < t_min) return false;
+  t = lo > t_min ? lo : t_min;
+  return true;
+}
+
+bool arcHitParam(const Arc &arc, int32_t a_lat, int32_t a_lon,
+                 int32_t b_lat, int32_t b_lon, float t_min, float &t)
+{
+  // Same quadratic as segmentIntersectsArc(); roots come out ascending.
+  const float ax = (float)(a_lon - arc.center_lon) * arc.m_per_lon;
+  const float ay = (float)(a_lat - arc.center_lat) * arc.m_per_lat;
+  const float dx = (float)(b_lon - a_lon) * arc.m_per_lon;
+  const float dy = (float)(b_lat - a_lat) * arc.m_per_lat;
+  const float qa = dx * dx + dy * dy;
+  const float qb = 2.0f * (ax * dx + ay * dy);
+  const float qc = ax * ax + ay * ay - arc.radius_m * arc.radius_m;
+  if (qa <= 0.0f) return false;
+  const float disc = qb * qb - 4.0f * qa * qc;
+  if (disc < 0.0f) return false;
+  const float root = sqrtf(disc);
+  const float ts[2] = {(-qb - root) / (2.0f * qa), (-qb + root) / (2.0f * qa)};
+  for (float r : ts) {
+    if (r < t_min || r < 0.0f || r > 1.0f) continue;
+    if (inSweep(arc, atan2f(ay + r * dy, ax + r * dx))) {
+      t = r;
+      return true;
+    }
+  }
+  return false;
+}
+
+float metersPerLonE6(int32_t lat)
+{
+  const float cos_lat = cosf((float)fromE6(lat) * (float)M_PI / 180.0f);
+  return kMetersPerDegLat / 1e6f * (cos_lat > 1e-6f ? cos_lat : 1e-6f);
+}
+
+float segmentDistanceM(int32_t a_lat, int32_t a_lon,
+                       int32_t b_lat, int32_t b_lon,
+                       int32_t p_lat, int32_t p_lon)
+{
+  const float m_lat = kMetersPerDegLat / 1e6f;
+  const float m_lon = metersPerLonE6(p_lat);
+  const float ax = (float)(a_lon - p_lon) * m_lon;
+  const float ay = (float)(a_lat - p_lat) * m_lat;
+  const float dx = (float)(b_lon - a_lon) * m_lon;
+  const float dy = (float)(b_lat - a_lat) * m_lat;
+  const float len2 = dx * dx + dy * dy;
+  float t = (len2 > 0.0f) ? -(ax * dx + ay * dy) / len2 : 0.0f;
+  if (t < 0.0f) t = 0.0f;
+  if (t > 1.0f) t = 1.0f;
+  return sqrtf((ax + t * dx) * (ax + t * dx) + (ay + t * dy) * (ay + t * dy));
+}
+
+float arcDistanceM(const Arc &a, int32_t p_lat, int32_t p_lon)
+{
+  const float x = (float)(p_lon - a.center_lon) * a.m_per_lon;
+  const float y = (float)(p_lat - a.center_lat) * a.m_per_lat;
+  const float d = sqrtf(x * x + y * y);
+  if (d > 0.0f && inSweep(a, atan2f(y, x))) return fabsf(d - a.radius_m);
+  const float sx = (float)(a.start_lon - p_lon) * a.m_per_lon;
+  const float sy = (float)(a.start_lat - p_lat) * a.m_per_lat;
+  const float ex = (float)(a.end_lon - p_lon) * a.m_per_lon;
+  const float ey = (float)(a.end_lat - p_lat) * a.m_per_lat;
+  const float ds = sqrtf(sx * sx + sy * sy);
+  const float de = sqrtf(ex * ex + ey * ey);
+  return ds < de ? ds : de;
+}
+
+float bboxDistanceM(int32_t min_lat, int32_t min_lon,
+                    int32_t max_lat, int32_t max_lon,
+                    int32_t p_lat, int32_t p_lon)
+{
+  int32_t dlat = 0;
+  int32_t dlon = 0;
+  if (p_lat < min_lat) dlat = min_lat - p_lat;
+  else if (p_lat > max_lat) dlat = p_lat - max_lat;
+  if (p_lon < min_lon) dlon = min_lon - p_lon;
+  else if (p_lon > max_lon) dlon = p_lon - max_lon;
+  if (dlat == 0 && dlon == 0) return 0.0f;
+  // Same frame as segmentDistanceM, so this never exceeds an edge distance.
+  const float y = (float)dlat * (kMetersPerDegLat / 1e6f);
+  const float x = (float)dlon * metersPerLonE6(p_lat);
+  return sqrtf(x * x + y * y);
+}
+
+bool pointInRing(const int32_t *lat, const int32_t *lon,
+                 const int32_t *dlat, const int32_t *dlon,
+                 uint32_t count, int32_t p_lat, int32_t p_lon)
+{
+  if (count < 4) return false;
+  bool inside = false;
+  const uint32_t edges = count - 1;
+  for (uint32_t i = 0; i < edges; i++) {
+    // Edge straddles the point's longitude (half-open, so shared vertices
+    // are counted once), then test which side of the edge the point is on.
+    // Taken from the delta so ring links (zero delta) never straddle.
+    if ((p_lon < lon[i] + dlon[i]) != (p_lon < lon[i])) {
+      const int64_t cross = (int64_t)dlat[i] * (int64_t)(p_lon - lon[i]) -
+                            (int64_t)dlon[i] * (int64_t)(p_lat - lat[i]);
+      if ((cross > 0) == (dlon[i] > 0)) inside = !inside;
+    }
+  }
+  return inside;
+}
+
+void pointsInRing(const int32_t *lat, const int32_t *lon,
+                  const int32_t *dlat, const int32_t *dlon, uint32_t count,
+                  const int32_t *p_lat, const int32_t *p_lon, uint32_t n,
+                  uint8_t *inside)
+{
+  if (n < kBatchMinPoints || count < kBatchMinVertices || (uint64_t)count * n < kBatchMinWork) {
+    for (uint32_t k = 0; k < n; k++) {
+      inside[k] = pointInRing(lat, lon, dlat, dlon, count, p_lat[k], p_lon[k]) ? 1 : 0;
+    }
+    return;
+  }
+  std::vector<uint32_t> order(n);
+  for (uint32_t k = 0; k < n; k++) {
+    order[k] = k;
+    inside[k] = 0;
+  }
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return p_lon[a] < p_lon[b]; });
+  std::vector<int32_t> sorted_lon(n);
+  for (uint32_t j = 0; j < n; j++) sorted_lon[j] = p_lon[order[j]];
+
+  const uint32_t edges = count - 1;
+  for (uint32_t i = 0; i < edges; i++) {
+    if (dlon[i] == 0) continue;  // vertical edge or ring link: straddles nothing
+    // Same half-open straddle as pointInRing(): lo <= p_lon < hi.
+    const int32_t lo = dlon[i] > 0 ? lon[i] : lon[i] + dlon[i];
+    const int32_t hi = dlon[i] > 0 ? lon[i] + dlon[i] : lon[i];
+    const uint32_t begin = (uint32_t)(std::lower_bound(sorted_lon.begin(), sorted_lon.end(), lo) - sorted_lon.begin());
+    for (uint32_t j = begin; j < n && sorted_lon[j] < hi; j++) {
+      const uint32_t k = order[j];
+      const int64_t cross = (int64_t)dlat[i] * (int64_t)(p_lon[k] - lon[i]) -
+                            (int64_t)dlon[i] * (int64_t)(p_lat[k] - lat[i]);
+      if ((cross > 0) == (dlon[i] > 0)) inside[k] ^= 1;
+    }
+  }
+}
+
+}  // namespace GeoMath
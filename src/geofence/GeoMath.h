@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stdint.h>
+
+// Fixed-point planar geometry for geofencing. Coordinates are int32
+// micro-degrees (deg * 1e6), the same encoding the SUA catalog uses, and
+// every predicate is evaluated exactly with int64 intermediates so the
+// single-precision ESP32-S3 FPU is never asked to emulate doubles.
+namespace GeoMath {
+  constexpr int32_t E6 = 1000000;
+
+  // Rounds degrees to micro-degrees.
+  int32_t toE6(double deg);
+  double fromE6(int32_t e6);
+
+  // Twice the signed area of (a, b, c): > 0 when c is left of a->b,
+  // < 0 when right, 0 when collinear. Exact for any int32 e6 inputs.
+  inline int64_t orient(int32_t a_lat, int32_t a_lon,
+                        int32_t b_lat, int32_t b_lon,
+                        int32_t c_lat, int32_t c_lon)
+  {
+    return (int64_t)(b_lat - a_lat) * (int64_t)(c_lon - a_lon) -
+           (int64_t)(b_lon - a_lon) * (int64_t)(c_lat - a_lat);
+  }
+
+  // True when edge a->b toggles even-odd parity for point p (ray cast
+  // toward increasing latitude, half-open in longitude).
+  inline bool crossesRay(int32_t a_lat, int32_t a_lon,
+                         int32_t b_lat, int32_t b_lon,
+                         int32_t p_lat, int32_t p_lon)
+  {
+    if ((p_lon < b_lon) == (p_lon < a_lon)) return false;
+    return (orient(a_lat, a_lon, b_lat, b_lon, p_lat, p_lon) > 0) == (b_lon > a_lon);
+  }
+
+  // True when a step from prev to cur along one axis reaches or passes
+  // value (an axis-aligned line). A step that starts on the line counts as
+  // soon as it leaves it.
+  inline bool crossesAxis(int32_t value, int32_t prev, int32_t cur)
+  {
+    const int32_t a = prev - value;
+    const int32_t b = cur - value;
+    return (a == 0) ? (b != 0) : (a < 0 && b >= 0) || (a > 0 && b <= 0);
+  }
+
+  // Circular arc in a local equirectangular frame around its centre
+  // (metres, x = east, y = north). Start/end angles are taken from the
+  // stored endpoints rather than the catalog's centi-degree fields, and the
+  // radius is the mean endpoint distance, so the arc always meets its
+  // neighbouring segments exactly.
+  struct Arc {
+    int32_t start_lat;
+    int32_t start_lon;
+    int32_t end_lat;
+    int32_t end_lon;
+    int32_t center_lat;
+    int32_t center_lon;
+    float radius_m;
+    float start_rad;   // 0 = east, counter-clockwise positive
+    float sweep_rad;   // signed: > 0 CCW, < 0 CW; +-2*pi for a full circle
+    float m_per_lat;   // metres per micro-degree of latitude
+    float m_per_lon;   // metres per micro-degree of longitude at the centre
+    // Chord line start->end as n . p = c (local metres), n pointing at the
+    // arc side. Zero for a full circle.
+    float chord_nx;
+    float chord_ny;
+    float chord_c;
+  };
+
+  constexpr float kMetersPerDegLat = 111320.0f;
+  // Above this the local frame is meaningless. The SUA catalog encodes
+  // parallels of latitude as arcs around near-polar centres; their chord is
+  // the exact edge in lat/lon space, so callers fall back to it.
+  constexpr float kMaxArcRadiusM = 500000.0f;
+
+  // Builds an Arc; radius_m is used only when both endpoints sit on the
+  // centre. start == end means a full circle. False for degenerate or
+  // oversized arcs, which callers treat as a straight chord.
+  bool makeArc(int32_t start_lat, int32_t start_lon,
+               int32_t end_lat, int32_t end_lon,
+               int32_t center_lat, int32_t center_lon,
+               uint32_t radius_m, bool ccw, Arc &out);
+
+  // Point at angle (radians) on the arc's circle, back in micro-degrees.
+  void arcPoint(const Arc &a, float angle_rad, int32_t &lat, int32_t &lon);
+
+  // Grows a bbox (micro-degrees) to cover the arc, including any
+  // north/south/east/west extreme inside its sweep.
+  void arcBounds(const Arc &a, int32_t &min_lat, int32_t &min_lon,
+                 int32_t &max_lat, int32_t &max_lon);
+
+  // True when p lies in the circular segment between the arc and its chord
+  // (the whole disk for a full circle). A ring's ray-cast parity with the
+  // arc is its parity with the chord XOR this test, which is the same as
+  // counting ray/arc intersections but needs no angle-range checks.
+  inline bool inArcSegment(const Arc &a, int32_t p_lat, int32_t p_lon)
+  {
+    const float x = (float)(p_lon - a.center_lon) * a.m_per_lon;
+    const float y = (float)(p_lat - a.center_lat) * a.m_per_lat;
+    if (x * x + y * y >= a.radius_m * a.radius_m) return false;
+    if (a.chord_nx == 0.0f && a.chord_ny == 0.0f) return true;
+    return x * a.chord_nx + y * a.chord_ny > a.chord_c;
+  }
+
+  // True when segments a-b and c-d share at least one point. Exact.
+  bool segmentsIntersect(int32_t a_lat, int32_t a_lon, int32_t b_lat, int32_t b_lon,
+                         int32_t c_lat, int32_t c_lon, int32_t d_lat, int32_t d_lon);
+
+  // True when segment a-b touches the arc itself (not its chord or disk).
+  bool segmentIntersectsArc(const Arc &arc, int32_t a_lat, int32_t a_lon,
+                            int32_t b_lat, int32_t b_lon);
+
+  // First point along a->b, at or after parameter t_min (t in [0, 1]),
+  // that segment c-d / the arc touches; false when there is none. Whether
+  // they meet is decided exactly as above, only t itself is rounded.
+  bool segmentHitParam(int32_t a_lat, int32_t a_lon, int32_t b_lat, int32_t b_lon,
+                       int32_t c_lat, int32_t c_lon, int32_t d_lat, int32_t d_lon,
+                       float t_min, float &t);
+  bool arcHitParam(const Arc &arc, int32_t a_lat, int32_t a_lon,
+                   int32_t b_lat, int32_t b_lon, float t_min, float &t);
+
+  // Metres per micro-degree of longitude at the given latitude.
+  float metersPerLonE6(int32_t lat);
+
+  // Distance (m) from p to segment a-b in a local frame at p.
+  float segmentDistanceM(int32_t a_lat, int32_t a_lon,
+                         int32_t b_lat, int32_t b_lon,
+                         int32_t p_lat, int32_t p_lon);
+
+  // Distance (m) from p to the arc itself (not the disk).
+  float arcDistanceM(const Arc &a, int32_t p_lat, int32_t p_lon);
+
+  // Lower bound (m) on the distance from p to anything inside the bbox;
+  // 0 when p is inside it.
+  float bboxDistanceM(int32_t min_lat, int32_t min_lon,
+                      int32_t max_lat, int32_t max_lon,
+                      int32_t p_lat, int32_t p_lon);
+
+  // Even-odd ray cast over closed rings stored back to back (vertex count - 1
+  // edges). dlat/dlon hold the precomputed per-edge deltas (v[i + 1] - v[i]);
+  // each ring's closing vertex carries a zero delta, so the link to the next
+  // ring never counts and all rings of a polygon with holes are one pass.
+  bool pointInRing(const int32_t *lat, const int32_t *lon,
+                   const int32_t *dlat, const int32_t *dlon,
+                   uint32_t count, int32_t p_lat, int32_t p_lon);
+
+  // Batch form of pointInRing() for many points against the same rings
+  // (trajectories, routes, swept checks): inside[k] is set to 1 or 0 for
+  // point k, identical to the single-point test. Points are sorted by
+  // longitude once, then each edge visits only the points whose longitude
+  // it straddles, found by binary search: one pass over the edges,
+  // O((edges + n) log n + crossings) instead of O(edges * n). Small rings
+  // and small batches, where that is slower, take the single-point loop.
+  void pointsInRing(const int32_t *lat, const int32_t *lon,
+                    const int32_t *dlat, const int32_t *dlon, uint32_t count,
+                    const int32_t *p_lat, const int32_t *p_lon, uint32_t n,
+                    uint8_t *inside);
+}
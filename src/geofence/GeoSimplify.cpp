@@ -0,0 +1,290 @@
+#include "geofence/GeoSimplify.h"
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+#include "geofence/GeoMath.h"
+
+namespace {
+  // Working copy of the ring as a linked list so steps don't shift the
+  // arrays. dev[i] bounds how far edge i -> nxt[i] is from the original
+  // boundary (m); side is +1 or -1 so that orient() * side > 0 means "on the
+  // side that must not lose area".
+  struct Ring {
+    std::vector<int32_t> lat;
+    std::vector<int32_t> lon;
+    std::vector<float> dev;
+    std::vector<uint32_t> nxt;
+    std::vector<uint32_t> prv;
+    std::vector<uint32_t> touched;  // pass that last changed the vertex
+    uint32_t head = 0;
+    size_t live = 0;
+    int side = 1;
+  };
+
+  struct Point {
+    int32_t lat;
+    int32_t lon;
+  };
+
+  // One candidate step around vertex b (a = prev, c = next, d = next of c).
+  // Drop: b goes, a -> c becomes an edge. Merge: b moves to x and c goes.
+  struct Step {
+    float cost;
+    uint32_t a, b, c, d;
+    bool merge;
+    Point x;
+  };
+
+  Point at(const Ring &r, uint32_t i)
+  {
+    return Point{r.lat[i], r.lon[i]};
+  }
+
+  int64_t orient(const Point &a, const Point &b, const Point &c)
+  {
+    return GeoMath::orient(a.lat, a.lon, b.lat, b.lon, c.lat, c.lon);
+  }
+
+  int sideOf(int64_t o, int side)
+  {
+    return o == 0 ? 0 : ((o > 0) == (side > 0) ? 1 : -1);
+  }
+
+  float dist(const Point &a, const Point &b, const Point &p)
+  {
+    return GeoMath::segmentDistanceM(a.lat, a.lon, b.lat, b.lon, p.lat, p.lon);
+  }
+
+  bool same(const Point &a, const Point &b)
+  {
+    return a.lat == b.lat && a.lon == b.lon;
+  }
+
+  // p lies on segment a-b (collinear and inside its box).
+  bool onSegment(const Point &a, const Point &b, const Point &p)
+  {
+    return orient(a, b, p) == 0 &&
+           p.lat >= std::min(a.lat, b.lat) && p.lat <= std::max(a.lat, b.lat) &&
+           p.lon >= std::min(a.lon, b.lon) && p.lon <= std::max(a.lon, b.lon);
+  }
+
+  bool intersects(const Point &a, const Point &b, const Point &c, const Point &d)
+  {
+    return GeoMath::segmentsIntersect(a.lat, a.lon, b.lat, b.lon, c.lat, c.lon, d.lat, d.lon);
+  }
+
+  // Where lines a->b and d->c meet beyond b and c, rounded to a grid point
+  // that keeps b and c on the protected side of the new edges a-x and x-d.
+  bool meetBeyond(const Ring &r, const Point &a, const Point &b, const Point &c, const Point &d,
+                  Point &x)
+  {
+    const double rx = (double)b.lon - a.lon, ry = (double)b.lat - a.lat;
+    const double qx = (double)c.lon - d.lon, qy = (double)c.lat - d.lat;
+    const double den = rx * qy - ry * qx;
+    if (fabs(den) < 1e-9) return false;
+    const double ax = (double)d.lon - a.lon, ay = (double)d.lat - a.lat;
+    const double t = (ax * qy - ay * qx) / den;
+    const double u = (ax * ry - ay * rx) / den;
+    if (!(t > 1.0) || !(u > 1.0)) return false;
+    const double x_lon = a.lon + t * rx;
+    const double x_lat = a.lat + t * ry;
+    if (fabs(x_lon) > 1.8e8 || fabs(x_lat) > 0.9e8) return false;
+
+    bool found = false;
+    float best = INFINITY;
+    for (int k = 0; k < 4; k++) {
+      const Point p{(int32_t)((k & 1) ? ceil(x_lat) : floor(x_lat)),
+                    (int32_t)((k & 2) ? ceil(x_lon) : floor(x_lon))};
+      if (sideOf(orient(a, p, b), r.side) < 0 || sideOf(orient(p, d, c), r.side) < 0 ||
+          sideOf(orient(b, c, p), r.side) >= 0) {
+        continue;
+      }
+      const float e = dist(b, c, p);
+      if (e < best) {
+        best = e;
+        x = p;
+        found = true;
+      }
+    }
+    return found;
+  }
+
+  // Checks replacing the chain a, b, c[, d] by a, c (drop) or a, x, d
+  // (merge): the new segments must not touch the rest of the ring and no
+  // other vertex may sit inside the region between the two paths.
+  bool clear(const Ring &r, const Step &s)
+  {
+    uint32_t chain[4] = {s.a, s.b, s.c, s.d};
+    const size_t chain_n = s.merge ? 4 : 3;
+    Point path[3];
+    size_t path_n = 0;
+    path[path_n++] = at(r, s.a);
+    if (s.merge) path[path_n++] = s.x;
+    path[path_n++] = at(r, chain[chain_n - 1]);
+
+    // Region: old chain, then back along the new path.
+    Point region[5];
+    size_t region_n = 0;
+    for (size_t i = 0; i < chain_n; i++) region[region_n++] = at(r, chain[i]);
+    if (s.merge) region[region_n++] = s.x;
+    int32_t min_lat = region[0].lat, max_lat = min_lat, min_lon = region[0].lon, max_lon = min_lon;
+    for (size_t i = 1; i < region_n; i++) {
+      min_lat = std::min(min_lat, region[i].lat);
+      max_lat = std::max(max_lat, region[i].lat);
+      min_lon = std::min(min_lon, region[i].lon);
+      max_lon = std::max(max_lon, region[i].lon);
+    }
+
+    uint32_t k = r.head;
+    for (size_t n = 0; n < r.live; n++, k = r.nxt[k]) {
+      const uint32_t k1 = r.nxt[k];
+      const Point e0 = at(r, k);
+      const Point e1 = at(r, k1);
+      // Everything tested below lies inside the region's box.
+      if (std::max(e0.lat, e1.lat) < min_lat || std::min(e0.lat, e1.lat) > max_lat ||
+          std::max(e0.lon, e1.lon) < min_lon || std::min(e0.lon, e1.lon) > max_lon) {
+        continue;
+      }
+      bool in_chain = false;
+      for (size_t i = 0; i + 1 < chain_n; i++) in_chain |= (chain[i] == k);
+      if (!in_chain) {
+        for (size_t p = 0; p + 1 < path_n; p++) {
+          const Point &p0 = path[p];
+          const Point &p1 = path[p + 1];
+          const bool share0 = same(e0, p0) || same(e0, p1);
+          const bool share1 = same(e1, p0) || same(e1, p1);
+          if (share0 && share1) return false;  // would duplicate an edge
+          if (share0 || share1) {
+            // Sharing an endpoint is fine unless the two overlap.
+            const Point &other = share0 ? e1 : e0;
+            const Point &shared = share0 ? e0 : e1;
+            const Point &far = same(shared, p0) ? p1 : p0;
+            if (onSegment(p0, p1, other) || onSegment(e0, e1, far)) return false;
+            continue;
+          }
+          if (intersects(e0, e1, p0, p1)) return false;
+        }
+      }
+
+      // Vertex k inside the region (even-odd; boundary hits were caught above).
+      bool chain_vertex = false;
+      for (size_t i = 0; i < chain_n; i++) chain_vertex |= (chain[i] == k);
+      if (chain_vertex) continue;
+      bool inside = false;
+      for (size_t i = 0; i < region_n; i++) {
+        const Point &a = region[i];
+        const Point &b = region[i + 1 == region_n ? 0 : i + 1];
+        if (GeoMath::crossesRay(a.lat, a.lon, b.lat, b.lon, e0.lat, e0.lon)) inside = !inside;
+      }
+      if (inside) return false;
+    }
+    return true;
+  }
+
+  void collect(const Ring &r, float tolerance_m, std::vector<Step> &steps)
+  {
+    steps.clear();
+    uint32_t b = r.head;
+    for (size_t n = 0; n < r.live; n++, b = r.nxt[b]) {
+      const uint32_t a = r.prv[b];
+      const uint32_t c = r.nxt[b];
+      const Point pa = at(r, a), pb = at(r, b), pc = at(r, c);
+      const int turn = sideOf(orient(pa, pb, pc), r.side);
+      if (turn <= 0) {
+        const float cost = dist(pa, pc, pb) + std::max(r.dev[a], r.dev[b]);
+        if (cost <= tolerance_m) steps.push_back(Step{cost, a, b, c, c, false, Point{0, 0}});
+        continue;
+      }
+      if (r.live < 4) continue;
+      const uint32_t d = r.nxt[c];
+      const Point pd = at(r, d);
+      Point x;
+      if (sideOf(orient(pb, pc, pd), r.side) <= 0 || !meetBeyond(r, pa, pb, pc, pd, x)) continue;
+      const float e = std::max(dist(pb, pc, x), std::max(dist(pa, x, pb), dist(x, pd, pc)));
+      const float cost = e + std::max(r.dev[a], std::max(r.dev[b], r.dev[c]));
+      if (cost <= tolerance_m) steps.push_back(Step{cost, a, b, c, d, true, x});
+    }
+    std::sort(steps.begin(), steps.end(), [](const Step &l, const Step &rr) { return l.cost < rr.cost; });
+  }
+
+  void unlink(Ring &r, uint32_t v)
+  {
+    r.nxt[r.prv[v]] = r.nxt[v];
+    r.prv[r.nxt[v]] = r.prv[v];
+    if (r.head == v) r.head = r.nxt[v];
+    r.live--;
+  }
+
+  void apply(Ring &r, const Step &s)
+  {
+    if (!s.merge) {
+      unlink(r, s.b);
+      r.dev[s.a] = s.cost;
+      return;
+    }
+    r.lat[s.b] = s.x.lat;
+    r.lon[s.b] = s.x.lon;
+    unlink(r, s.c);
+    r.dev[s.a] = s.cost;
+    r.dev[s.b] = s.cost;
+  }
+}  // namespace
+
+namespace GeoSimplify {
+
+size_t conservative(int32_t *lat, int32_t *lon, size_t n, float tolerance_m, bool grow)
+{
+  if (!lat || !lon || n <= 3 || !(tolerance_m > 0.0f)) return n;
+
+  Ring r;
+  r.lat.assign(lat, lat + n);
+  r.lon.assign(lon, lon + n);
+  r.dev.assign(n, 0.0f);
+  r.nxt.resize(n);
+  r.prv.resize(n);
+  r.touched.assign(n, 0);
+  for (size_t i = 0; i < n; i++) {
+    r.nxt[i] = (uint32_t)(i + 1 == n ? 0 : i + 1);
+    r.prv[i] = (uint32_t)(i == 0 ? n - 1 : i - 1);
+  }
+  r.live = n;
+  double area = 0.0;
+  for (size_t i = 1; i + 1 < n; i++) {
+    area += (double)orient(at(r, 0), at(r, i), at(r, i + 1));
+  }
+  if (area == 0.0) return n;
+  // Interior is on the orient() > 0 side for positive area; a stay-in
+  // protects its exterior instead, which is the same problem mirrored.
+  r.side = ((area > 0.0) == grow) ? 1 : -1;
+
+  // Each pass applies the cheapest steps whose vertices no earlier step of
+  // the same pass has touched, so its candidates stay valid without a rescan.
+  std::vector<Step> steps;
+  for (uint32_t pass = 1;; pass++) {
+    collect(r, tolerance_m, steps);
+    bool applied = false;
+    for (const Step &s : steps) {
+      if (r.live <= 3 || (s.merge && r.live < 4)) break;
+      if (r.touched[s.a] == pass || r.touched[s.b] == pass || r.touched[s.c] == pass ||
+          r.touched[s.d] == pass) {
+        continue;
+      }
+      if (!clear(r, s)) continue;
+      apply(r, s);
+      r.touched[s.a] = r.touched[s.b] = r.touched[s.c] = r.touched[s.d] = pass;
+      applied = true;
+    }
+    if (!applied) break;
+  }
+
+  // Write back starting from the first surviving original vertex.
+  uint32_t v = r.head;
+  for (size_t i = 0; i < r.live; i++, v = r.nxt[v]) {
+    lat[i] = r.lat[v];
+    lon[i] = r.lon[v];
+  }
+  return r.live;
+}
+
+}  // namespace GeoSimplify
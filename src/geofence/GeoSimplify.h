@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// One-sided polygon simplification for geofence rings. The result never
+// crosses to the protected side of the original boundary: with grow = true
+// (keep-outs) it only gains area, with grow = false (stay-ins) it only loses
+// area, and no point of either boundary ends up farther than tolerance_m
+// from the other. Two steps are used, cheapest first:
+//   - drop a vertex whose removal only adds area (reflex or collinear);
+//   - replace two vertices bulging the other way by the point where their
+//     neighbouring edges meet when extended.
+// Every step is checked with exact integer predicates against the whole
+// ring, so the ring stays simple. special_use_airspace/build_sua_catalog.py
+// carries a Python copy of the same algorithm.
+namespace GeoSimplify {
+  // Simplifies an open ring (closing vertex not repeated) of int32
+  // micro-degree vertices in place. Returns the new vertex count; rings of
+  // three vertices or fewer, or tolerance_m <= 0, are left unchanged.
+  size_t conservative(int32_t *lat, int32_t *lon, size_t n, float tolerance_m, bool grow);
+}
@@ -0,0 +1,104 @@
+#include "geofence/PackedRTree.h"
+
+#include <algorithm>
+#include <math.h>
+#include <utility>
+
+namespace {
+  int64_t centerLat(const PackedRTree::Box &b) { return (int64_t)b.min_lat + b.max_lat; }
+  int64_t centerLon(const PackedRTree::Box &b) { return (int64_t)b.min_lon + b.max_lon; }
+}
+
+void PackedRTree::clear()
+{
+  _boxes.clear();
+  _ids.clear();
+  _levelStart.clear();
+}
+
+void PackedRTree::build(const std::vector<Box> &items)
+{
+  clear();
+  const uint32_t n = (uint32_t)items.size();
+  if (n == 0) return;
+
+  // STR leaf packing: sort by longitude into vertical slices of S * F
+  // items, then by latitude inside each slice.
+  std::vector<uint32_t> order(n);
+  for (uint32_t i = 0; i < n; i++) order[i] = i;
+  const uint32_t leaves = (n + kFanout - 1) / kFanout;
+  const uint32_t slices = (uint32_t)ceil(sqrt((double)leaves));
+  const uint32_t slice_len = slices * kFanout;
+  std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+    return centerLon(items[a]) < centerLon(items[b]);
+  });
+  for (uint32_t s = 0; s < n; s += slice_len) {
+    const uint32_t e = std::min(n, s + slice_len);
+    std::sort(order.begin() + s, order.begin() + e, [&](uint32_t a, uint32_t b) {
+      return centerLat(items[a]) < centerLat(items[b]);
+    });
+  }
+
+  _ids = order;
+  _boxes.reserve(n + n / (kFanout - 1) + 2);
+  for (uint32_t i = 0; i < n; i++) _boxes.push_back(items[order[i]]);
+  _levelStart.push_back(0);
+
+  // Each upper level groups kFanout consecutive nodes of the level below.
+  // Always emit at least one level above the items so the root is a node.
+  uint32_t level_base = 0;
+  uint32_t level_count = n;
+  do {
+    const uint32_t next_base = (uint32_t)_boxes.size();
+    for (uint32_t i = 0; i < level_count; i += kFanout) {
+      Box b = _boxes[level_base + i];
+      const uint32_t end = std::min(level_count, i + kFanout);
+      for (uint32_t j = i + 1; j < end; j++) {
+        const Box &c = _boxes[level_base + j];
+        if (c.min_lat < b.min_lat) b.min_lat = c.min_lat;
+        if (c.min_lon < b.min_lon) b.min_lon = c.min_lon;
+        if (c.max_lat > b.max_lat) b.max_lat = c.max_lat;
+        if (c.max_lon > b.max_lon) b.max_lon = c.max_lon;
+        if (c.min_alt < b.min_alt) b.min_alt = c.min_alt;
+        if (c.max_alt > b.max_alt) b.max_alt = c.max_alt;
+      }
+      _boxes.push_back(b);
+    }
+    _levelStart.push_back(next_base);
+    level_base = next_base;
+    level_count = (uint32_t)_boxes.size() - next_base;
+  } while (level_count > 1);
+  _levelStart.push_back((uint32_t)_boxes.size());
+  _boxes.shrink_to_fit();
+}
+
+bool PackedRTree::assign(std::vector<Box> &&boxes, std::vector<uint32_t> &&ids,
+                         std::vector<uint32_t> &&levelStart)
+{
+  clear();
+  if (boxes.empty() && ids.empty() && levelStart.empty()) return true;
+
+  // Same shape build() produces: items, then levels of ceil(n / kFanout)
+  // nodes up to a single root, with at least one level above the items.
+  const uint32_t n = (uint32_t)ids.size();
+  if (n == 0 || levelStart.size() < 3 || levelStart[0] != 0 || levelStart[1] != n ||
+      levelStart.back() != boxes.size()) {
+    return false;
+  }
+  for (size_t l = 1; l + 1 < levelStart.size(); l++) {
+    const uint32_t below = levelStart[l] - levelStart[l - 1];
+    if (levelStart[l + 1] < levelStart[l] ||
+        levelStart[l + 1] - levelStart[l] != (below + kFanout - 1) / kFanout) {
+      return false;
+    }
+  }
+  if (levelStart[levelStart.size() - 1] - levelStart[levelStart.size() - 2] != 1) return false;
+  for (uint32_t id : ids) {
+    if (id >= n) return false;
+  }
+
+  _boxes = std::move(boxes);
+  _ids = std::move(ids);
+  _levelStart = std::move(levelStart);
+  return true;
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Static, bulk-loaded R-tree (Sort-Tile-Recursive packing) over int32
+// micro-degree bounding boxes with an altitude interval. Packing is purely
+// horizontal; the interval rides along in every node so subtrees outside
+// the queried altitude band are pruned before any horizontal test. Built
+// once when a rule set is loaded; the nodes live in one flat array, level
+// by level, with no per-node allocations and no child pointers (children
+// of node j on level L are slots [j * kFanout, (j + 1) * kFanout) on
+// level L - 1).
+class PackedRTree {
+public:
+  struct Box {
+    int32_t min_lat;
+    int32_t min_lon;
+    int32_t max_lat;
+    int32_t max_lon;
+    int32_t min_alt;  // metres MSL, kAltMin/kAltMax when unbounded
+    int32_t max_alt;
+  };
+
+  struct Stats {
+    uint32_t nodesVisited = 0;  // internal nodes whose children were scanned
+    uint32_t candidates = 0;    // items whose box matched the query
+  };
+
+  static constexpr uint32_t kFanout = 8;
+  static constexpr int32_t kAltMin = INT32_MIN;
+  static constexpr int32_t kAltMax = INT32_MAX;
+
+  // Item i keeps id i; the caller resolves ids back to its own records.
+  void build(const std::vector<Box> &items);
+  void clear();
+
+  size_t size() const { return _ids.size(); }
+  size_t nodeCount() const { return _boxes.size() - _ids.size(); }
+  size_t levels() const { return _levelStart.empty() ? 0 : _levelStart.size() - 1; }
+
+  // Raw tables, for persisting a built tree. assign() takes them back and
+  // returns false (leaving the tree empty) when they do not form a tree.
+  const std::vector<Box> &boxes() const { return _boxes; }
+  const std::vector<uint32_t> &ids() const { return _ids; }
+  const std::vector<uint32_t> &levelStarts() const { return _levelStart; }
+  bool assign(std::vector<Box> &&boxes, std::vector<uint32_t> &&ids,
+              std::vector<uint32_t> &&levelStart);
+
+  // Calls fn(id) for every item whose box intersects q. Adds to stats.
+  template <typename Fn>
+  void query(const Box &q, Stats &stats, Fn &&fn) const
+  {
+    if (_ids.empty()) return;
+    struct Slot { uint8_t level; uint32_t index; };
+    Slot stack[kStackDepth];
+    size_t sp = 0;
+    stack[sp++] = Slot{(uint8_t)(_levelStart.size() - 2), 0};
+    while (sp > 0) {
+      const Slot node = stack[--sp];
+      stats.nodesVisited++;
+      const uint8_t child_level = node.level - 1;
+      const uint32_t level_base = _levelStart[child_level];
+      const uint32_t level_count = _levelStart[child_level + 1] - level_base;
+      const uint32_t begin = node.index * kFanout;
+      uint32_t end = begin + kFanout;
+      if (end > level_count) end = level_count;
+      for (uint32_t c = begin; c < end; c++) {
+        if (!intersects(_boxes[level_base + c], q)) continue;
+        if (child_level == 0) {
+          stats.candidates++;
+          fn(_ids[c]);
+        } else if (sp < kStackDepth) {
+          stack[sp++] = Slot{child_level, c};
+        }
+      }
+    }
+  }
+
+  template <typename Fn>
+  void query(int32_t lat, int32_t lon, int32_t min_alt, int32_t max_alt, Stats &stats, Fn &&fn) const
+  {
+    query(Box{lat, lon, lat, lon, min_alt, max_alt}, stats, fn);
+  }
+
+private:
+  // Depth-first: at most (kFanout - 1) siblings parked per level, and a
+  // 2^32-item tree is only 11 levels deep at fanout 8.
+  static constexpr size_t kStackDepth = 96;
+
+  static bool intersects(const Box &a, const Box &b)
+  {
+    return a.min_alt <= b.max_alt && a.max_alt >= b.min_alt &&
+           a.min_lat <= b.max_lat && a.max_lat >= b.min_lat &&
+           a.min_lon <= b.max_lon && a.max_lon >= b.min_lon;
+  }
+
+  std::vector<Box> _boxes;            // level 0 (items) first, root last
+  std::vector<uint32_t> _ids;         // item id for each level-0 slot
+  std::vector<uint32_t> _levelStart;  // offset of each level in _boxes, plus end
+};
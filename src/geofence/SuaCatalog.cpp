@@ -0,0 +1,986 @@
+#include "geofence/SuaCatalog.h"
+
+#include <LittleFS.h>
+#include <algorithm>
+#include <math.h>
+#include <mutex>
+#include "geofence/GeoMath.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_idf_version.h>
+#include <esp_partition.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+  constexpr uint32_t kIdxHeaderLen = 16;
+  constexpr uint32_t kBinHeaderLen = 20;
+  constexpr uint32_t kMinEntrySize = 32;
+  constexpr uint32_t kBandEntrySize = 40;
+  constexpr uint32_t kRingHeaderLen = 4;
+  constexpr uint32_t kGeomHeaderLen = 12;
+  constexpr uint32_t kLineLen = 1 + 16;
+  constexpr uint32_t kArcLen = 1 + 24 + 4 + 2 + 2 + 1;
+  // SIA2 rings: varint segment count, then per segment varint(zigzag(d_lat)
+  // << 3 | flags), start deltas on a jump, zigzag(d_lon), and for arcs the
+  // centre deltas, radius and both angles (build_sua_catalog.py).
+  constexpr uint8_t kSeg2Arc = 0x01;
+  constexpr uint8_t kSeg2Jump = 0x02;
+  constexpr uint8_t kSeg2Ccw = 0x04;
+  constexpr uint32_t kSeg2MaxLen = 48;
+
+  // SUAP partition image: this header, then the .idx and .bin files
+  // verbatim at the offsets it gives.
+  constexpr uint32_t kPartHeaderLen = 32;
+  constexpr uint16_t kPartVersion = 1;
+
+  constexpr uint32_t kHashHeaderLen = 8;
+  constexpr uint32_t kHashItemLen = 8;
+  constexpr uint32_t kTypeHeaderLen = 8;
+  constexpr uint32_t kTypeRecordLen = 8 + 12;
+  constexpr uint32_t kTypeItemLen = 20;
+
+  constexpr size_t kBlockSize = 256;
+  constexpr size_t kCacheBlocks = 8;  // 2 KB total
+
+  enum FileId : uint8_t { FILE_IDX = 0, FILE_BIN = 1 };
+
+  struct CacheBlock {
+    bool valid = false;
+    uint8_t file = 0;
+    uint32_t block = 0;
+    uint32_t stamp = 0;
+    uint16_t len = 0;
+    uint8_t data[kBlockSize];
+  };
+
+  File s_files[2];
+  // Both files straight from flash when the catalog partition is mapped;
+  // reads are then pointers into the flash cache and the blocks below
+  // stay unused.
+  const uint8_t *s_map[2] = {nullptr, nullptr};
+#ifdef ESP_PLATFORM
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_partition_mmap_handle_t s_map_handle = 0;
+  constexpr esp_partition_mmap_memory_t kMapData = ESP_PARTITION_MMAP_DATA;
+#else
+  spi_flash_mmap_handle_t s_map_handle = 0;
+  constexpr spi_flash_mmap_memory_t kMapData = SPI_FLASH_MMAP_DATA;
+#endif
+#else
+  void *s_map_base = nullptr;
+  size_t s_map_len = 0;
+#endif
+  uint32_t s_sizes[2] = {0, 0};
+  bool s_ready = false;
+  uint16_t s_entry_size = 0;
+  uint32_t s_entry_count = 0;
+  uint32_t s_string_off = 0;
+  uint32_t s_geom_off = 0;
+  uint32_t s_stamp_hash = 0;
+  bool s_geom_v2 = false;
+
+  // Type section of the index, read once at begin(); offsets are absolute
+  // within the .idx file.
+  struct TypeInfo {
+    char code[9];
+    uint32_t count;
+    uint32_t bitset;
+    uint32_t list;
+  };
+  TypeInfo s_types[SuaCatalog::kMaxTypes];
+  size_t s_type_count = 0;
+
+  // Hash section right after the records: (id_hash, record) pairs sorted
+  // by hash. 0 when the catalog predates it (names are then scanned).
+  uint32_t s_hash_off = 0;
+
+  // Bboxes of every area, for queries over the whole catalog.
+  PackedRTree s_area_index;
+  bool s_area_index_built = false;
+
+  CacheBlock s_cache[kCacheBlocks];
+  uint32_t s_stamp = 0;
+  SuaCatalog::CacheStats s_cache_stats;
+
+  // Held by every public call: loop() reads the catalog through GeoFence
+  // while the portal's AsyncTCP task serves /api/sua/*, and both go through
+  // the block cache, the File handles and the lazily built area index (a
+  // block pointer must not be evicted under its reader). Recursive because
+  // public calls nest, e.g. nearby() -> contains() -> GeometryReader.
+  std::recursive_mutex s_lock;
+  typedef std::lock_guard<std::recursive_mutex> Guard;
+
+  const CacheBlock *loadBlock(uint8_t file, uint32_t block)
+  {
+    CacheBlock *victim = &s_cache[0];
+    for (CacheBlock &b : s_cache) {
+      if (b.valid && b.file == file && b.block == block) {
+        b.stamp = ++s_stamp;
+        s_cache_stats.hits++;
+        return &b;
+      }
+      if (!b.valid || (victim->valid && b.stamp < victim->stamp)) victim = &b;
+    }
+
+    s_cache_stats.misses++;
+    File &f = s_files[file];
+    const uint32_t off = block * kBlockSize;
+    if (!f || off >= s_sizes[file] || !f.seek(off)) return nullptr;
+    const size_t want = min((size_t)kBlockSize, (size_t)(s_sizes[file] - off));
+    const size_t got = f.read(victim->data, want);
+    if (got == 0) return nullptr;
+    s_cache_stats.bytesRead += got;
+    victim->valid = true;
+    victim->file = file;
+    victim->block = block;
+    victim->len = (uint16_t)got;
+    victim->stamp = ++s_stamp;
+    return victim;
+  }
+
+  bool readAt(uint8_t file, uint32_t off, void *dst, size_t len)
+  {
+    if (s_map[file]) {
+      if (off > s_sizes[file] || len > s_sizes[file] - off) return false;
+      memcpy(dst, s_map[file] + off, len);
+      return true;
+    }
+    uint8_t *out = static_cast<uint8_t *>(dst);
+    while (len > 0) {
+      const CacheBlock *b = loadBlock(file, off / kBlockSize);
+      if (!b) return false;
+      const uint32_t in_block = off % kBlockSize;
+      if (in_block >= b->len) return false;
+      const size_t n = min(len, (size_t)(b->len - in_block));
+      memcpy(out, b->data + in_block, n);
+      out += n;
+      off += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  // len bytes at off: a pointer into the mapping when there is one,
+  // otherwise copied into scratch (at least len bytes).
+  const uint8_t *bytesAt(uint8_t file, uint32_t off, size_t len, uint8_t *scratch)
+  {
+    if (s_map[file]) {
+      return (off <= s_sizes[file] && len <= s_sizes[file] - off) ? s_map[file] + off : nullptr;
+    }
+    return readAt(file, off, scratch, len) ? scratch : nullptr;
+  }
+
+  uint16_t u16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+  uint32_t u32(const uint8_t *p)
+  {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+  int32_t i32(const uint8_t *p) { return (int32_t)u32(p); }
+
+  // LEB128 varint from [p, end); false when it runs off the end.
+  bool varint(const uint8_t *&p, const uint8_t *end, uint64_t &v)
+  {
+    v = 0;
+    for (uint8_t shift = 0; p < end && shift < 64; shift += 7) {
+      const uint8_t b = *p++;
+      v |= (uint64_t)(b & 0x7F) << shift;
+      if (b < 0x80) return true;
+    }
+    return false;
+  }
+  int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+  // The builder stores angles as (cd & 0xFFFF), so negatives wrap.
+  int32_t centiDeg(const uint8_t *p)
+  {
+    const int32_t raw = u16(p);
+    return raw > 36000 ? raw - 65536 : raw;
+  }
+
+  bool readCString(uint32_t off, char *buf, size_t len)
+  {
+    if (!buf || len == 0) return false;
+    size_t i = 0;
+    if (s_map[FILE_BIN]) {
+      const uint8_t *p = s_map[FILE_BIN];
+      while (i + 1 < len && off + i < s_sizes[FILE_BIN] && p[off + i] != '\0') {
+        buf[i] = (char)p[off + i];
+        i++;
+      }
+      buf[i] = '\0';
+      return i > 0;
+    }
+    while (i + 1 < len) {
+      char c;
+      if (!readAt(FILE_BIN, off + i, &c, 1)) break;
+      if (c == '\0') break;
+      buf[i++] = c;
+    }
+    buf[i] = '\0';
+    return i > 0;
+  }
+
+  // Accumulates even-odd crossings over a chain of edges; gaps between
+  // consecutive segments and the ring closure are bridged with straight
+  // edges so bad data cannot leave the parity half-counted.
+  struct RingParity {
+    int32_t p_lat;
+    int32_t p_lon;
+    bool inside = false;
+    bool has_last = false;
+    int32_t first_lat = 0;
+    int32_t first_lon = 0;
+    int32_t last_lat = 0;
+    int32_t last_lon = 0;
+
+    void edge(int32_t a_lat, int32_t a_lon, int32_t b_lat, int32_t b_lon)
+    {
+      if (GeoMath::crossesRay(a_lat, a_lon, b_lat, b_lon, p_lat, p_lon)) inside = !inside;
+    }
+
+    void to(int32_t lat, int32_t lon)
+    {
+      if (!has_last) {
+        first_lat = last_lat = lat;
+        first_lon = last_lon = lon;
+        has_last = true;
+        return;
+      }
+      edge(last_lat, last_lon, lat, lon);
+      last_lat = lat;
+      last_lon = lon;
+    }
+
+    void closeRing()
+    {
+      if (has_last) edge(last_lat, last_lon, first_lat, first_lon);
+      has_last = false;
+    }
+  };
+
+  // An arc contributes its chord to the ring parity plus a flip when the
+  // point sits between chord and arc; no tessellation, no chord error.
+  void arcEdge(const SuaCatalog::Segment &s, RingParity &acc)
+  {
+    acc.to(s.start_lat, s.start_lon);
+    acc.to(s.end_lat, s.end_lon);
+    GeoMath::Arc arc;
+    if (GeoMath::makeArc(s.start_lat, s.start_lon, s.end_lat, s.end_lon,
+                         s.center_lat, s.center_lon, s.radius_m, s.direction != 0, arc) &&
+        GeoMath::inArcSegment(arc, acc.p_lat, acc.p_lon)) {
+      acc.inside = !acc.inside;
+    }
+  }
+  void unmapPartition()
+  {
+#ifdef ESP_PLATFORM
+#if ESP_IDF_VERSION_MAJOR >= 5
+    if (s_map[FILE_IDX]) esp_partition_munmap(s_map_handle);
+#else
+    if (s_map[FILE_IDX]) spi_flash_munmap(s_map_handle);
+#endif
+#else
+    if (s_map_base) munmap(s_map_base, s_map_len);
+    s_map_base = nullptr;
+    s_map_len = 0;
+#endif
+    s_map[FILE_IDX] = s_map[FILE_BIN] = nullptr;
+  }
+
+  // Points s_map/s_sizes at the sections of a mapped SUAP image of len
+  // bytes; false when the header does not describe one.
+  bool useImage(const uint8_t *base, size_t len)
+  {
+    if (len < kPartHeaderLen || memcmp(base, "SUAP", 4) != 0 || u16(base + 4) != kPartVersion) return false;
+    const uint32_t idx_off = u32(base + 8);
+    const uint32_t idx_len = u32(base + 12);
+    const uint32_t bin_off = u32(base + 16);
+    const uint32_t bin_len = u32(base + 20);
+    if ((uint64_t)idx_off + idx_len > len || (uint64_t)bin_off + bin_len > len) return false;
+    s_map[FILE_IDX] = base + idx_off;
+    s_map[FILE_BIN] = base + bin_off;
+    s_sizes[FILE_IDX] = idx_len;
+    s_sizes[FILE_BIN] = bin_len;
+    return true;
+  }
+
+  // Maps the catalog partition (on the host, label is the path of an
+  // image file). Only the header's extent is mapped, not the whole
+  // partition.
+  bool mapPartition(const char *label)
+  {
+#ifdef ESP_PLATFORM
+    const esp_partition_t *part =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    uint8_t h[kPartHeaderLen];
+    if (!part || esp_partition_read(part, 0, h, sizeof(h)) != ESP_OK || memcmp(h, "SUAP", 4) != 0) {
+      return false;
+    }
+    const uint32_t len = max(u32(h + 8) + u32(h + 12), u32(h + 16) + u32(h + 20));
+    if (len > part->size) return false;
+    const void *ptr = nullptr;
+    if (esp_partition_mmap(part, 0, len, kMapData, &ptr, &s_map_handle) != ESP_OK) return false;
+    s_map[FILE_IDX] = static_cast<const uint8_t *>(ptr);  // for unmapPartition() on failure
+    if (!useImage(static_cast<const uint8_t *>(ptr), len)) {
+      unmapPartition();
+      return false;
+    }
+    return true;
+#else
+    const int fd = open(label, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    void *ptr = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (ptr == MAP_FAILED) return false;
+    s_map_base = ptr;
+    s_map_len = (size_t)st.st_size;
+    if (!useImage(static_cast<const uint8_t *>(ptr), s_map_len)) {
+      unmapPartition();
+      return false;
+    }
+    return true;
+#endif
+  }
+}  // namespace
+
+namespace SuaCatalog {
+
+// Reads the type table at off (0 = none). A table that does not fit the
+// file is ignored rather than failing the catalog.
+static void loadTypes(uint32_t off)
+{
+  s_type_count = 0;
+  uint8_t h[kTypeHeaderLen];
+  if (off == 0 || !readAt(FILE_IDX, off, h, sizeof(h)) || memcmp(h, "TYP1", 4) != 0) return;
+  const size_t n = min((size_t)u16(h + 4), kMaxTypes);
+  const uint32_t bitset_len = (s_entry_count + 7) / 8;
+  for (size_t t = 0; t < n; t++) {
+    uint8_t rec[kTypeRecordLen];
+    if (!readAt(FILE_IDX, off + kTypeHeaderLen + t * kTypeRecordLen, rec, sizeof(rec))) return;
+    TypeInfo &ti = s_types[s_type_count];
+    memcpy(ti.code, rec, 8);
+    ti.code[8] = '\0';
+    ti.count = u32(rec + 8);
+    ti.bitset = off + u32(rec + 12);
+    ti.list = off + u32(rec + 16);
+    if ((uint64_t)ti.bitset + bitset_len > s_sizes[FILE_IDX] ||
+        (uint64_t)ti.list + (uint64_t)ti.count * kTypeItemLen > s_sizes[FILE_IDX]) {
+      Serial.println("[SUA] type section truncated, ignored");
+      s_type_count = 0;
+      return;
+    }
+    s_type_count++;
+  }
+}
+
+// Finds the hash section directly after the records, when present and
+// covering every record.
+static void loadHashes()
+{
+  s_hash_off = 0;
+  const uint32_t off = kIdxHeaderLen + s_entry_size * s_entry_count;
+  uint8_t h[kHashHeaderLen];
+  if (!readAt(FILE_IDX, off, h, sizeof(h)) || memcmp(h, "HSH1", 4) != 0) return;
+  if (u32(h + 4) != s_entry_count ||
+      off + kHashHeaderLen + (uint64_t)s_entry_count * kHashItemLen > s_sizes[FILE_IDX]) {
+    Serial.println("[SUA] hash section does not match the index, ignored");
+    return;
+  }
+  s_hash_off = off + kHashHeaderLen;
+}
+
+// Header checks shared by both sources, once s_files or s_map are set.
+static bool openCatalog()
+{
+  uint8_t ih[kIdxHeaderLen];
+  uint8_t bh[kBinHeaderLen];
+  if (!readAt(FILE_IDX, 0, ih, sizeof(ih)) || !readAt(FILE_BIN, 0, bh, sizeof(bh)) ||
+      memcmp(ih, "SIA1", 4) != 0 || (memcmp(bh, "SIA1", 4) != 0 && memcmp(bh, "SIA2", 4) != 0)) {
+    Serial.println("[SUA] invalid catalog header");
+    end();
+    return false;
+  }
+  s_geom_v2 = memcmp(bh, "SIA2", 4) == 0;
+  s_entry_size = u16(ih + 6);
+  s_entry_count = u32(ih + 8);
+  s_string_off = u32(bh + 8);
+  s_geom_off = u32(bh + 12);
+  // FNV-1a over both headers and file sizes: cheap, and any rebuild of
+  // the catalog changes at least one of them.
+  s_stamp_hash = 0x811C9DC5u;
+  auto mix = [](const uint8_t *p, size_t n) {
+    while (n--) {
+      s_stamp_hash ^= *p++;
+      s_stamp_hash *= 0x01000193u;
+    }
+  };
+  mix(ih, sizeof(ih));
+  mix(bh, sizeof(bh));
+  mix(reinterpret_cast<const uint8_t *>(s_sizes), sizeof(s_sizes));
+  if (s_entry_size < kMinEntrySize ||
+      kIdxHeaderLen + (uint64_t)s_entry_size * s_entry_count > s_sizes[FILE_IDX]) {
+    Serial.println("[SUA] index truncated");
+    end();
+    return false;
+  }
+  loadHashes();
+  loadTypes(u32(ih + 12));
+
+  s_ready = true;
+  Serial.printf("[SUA] catalog ready: %lu areas (%s)\n", (unsigned long)s_entry_count,
+                mapped() ? "partition" : "LittleFS");
+  return true;
+}
+
+bool begin(const char *idxPath, const char *binPath)
+{
+  const Guard guard(s_lock);
+  if (beginPartition()) return true;
+  end();
+  if (!LittleFS.begin(true)) {
+    Serial.println("[SUA] LittleFS mount failed");
+    return false;
+  }
+  s_files[FILE_IDX] = LittleFS.open(idxPath, "r");
+  s_files[FILE_BIN] = LittleFS.open(binPath, "r");
+  if (!s_files[FILE_IDX] || !s_files[FILE_BIN]) {
+    Serial.printf("[SUA] catalog not found: %s / %s\n", idxPath, binPath);
+    end();
+    return false;
+  }
+  s_sizes[FILE_IDX] = s_files[FILE_IDX].size();
+  s_sizes[FILE_BIN] = s_files[FILE_BIN].size();
+  return openCatalog();
+}
+
+bool beginPartition(const char *label)
+{
+  const Guard guard(s_lock);
+  end();
+  if (!mapPartition(label)) return false;
+  return openCatalog();
+}
+
+void end()
+{
+  const Guard guard(s_lock);
+  for (File &f : s_files) {
+    if (f) f.close();
+  }
+  unmapPartition();
+  for (CacheBlock &b : s_cache) b.valid = false;
+  s_area_index.clear();
+  s_area_index_built = false;
+  s_sizes[FILE_IDX] = s_sizes[FILE_BIN] = 0;
+  s_entry_count = 0;
+  s_type_count = 0;
+  s_hash_off = 0;
+  s_geom_v2 = false;
+  s_ready = false;
+}
+
+bool ready()
+{
+  const Guard guard(s_lock);
+  return s_ready;
+}
+
+bool mapped()
+{
+  const Guard guard(s_lock);
+  return s_map[FILE_IDX] != nullptr;
+}
+
+const uint8_t *mappedIdx(size_t &len)
+{
+  const Guard guard(s_lock);
+  len = s_map[FILE_IDX] ? s_sizes[FILE_IDX] : 0;
+  return s_map[FILE_IDX];
+}
+
+const uint8_t *mappedBin(size_t &len)
+{
+  const Guard guard(s_lock);
+  len = s_map[FILE_BIN] ? s_sizes[FILE_BIN] : 0;
+  return s_map[FILE_BIN];
+}
+
+uint32_t count()
+{
+  const Guard guard(s_lock);
+  return s_entry_count;
+}
+
+uint32_t stamp()
+{
+  const Guard guard(s_lock);
+  return s_ready ? s_stamp_hash : 0;
+}
+
+bool entry(uint32_t idx, Entry &out)
+{
+  const Guard guard(s_lock);
+  if (!s_ready || idx >= s_entry_count) return false;
+  uint8_t buf[kBandEntrySize];
+  const size_t len = s_entry_size >= kBandEntrySize ? kBandEntrySize : kMinEntrySize;
+  const uint8_t *rec = bytesAt(FILE_IDX, kIdxHeaderLen + idx * s_entry_size, len, buf);
+  if (!rec) return false;
+  out.id_hash = u32(rec + 0);
+  out.name_offset = u32(rec + 4);
+  out.geom_offset = u32(rec + 8);
+  out.geom_length = u32(rec + 12);
+  out.min_lat = i32(rec + 16);
+  out.min_lon = i32(rec + 20);
+  out.max_lat = i32(rec + 24);
+  out.max_lon = i32(rec + 28);
+  out.floor_m = len >= kBandEntrySize ? i32(rec + 32) : SuaCatalog::kNoFloorM;
+  out.ceil_m = len >= kBandEntrySize ? i32(rec + 36) : SuaCatalog::kNoCeilingM;
+  return true;
+}
+
+bool name(const Entry &e, char *buf, size_t len)
+{
+  const Guard guard(s_lock);
+  return s_ready && readCString(s_string_off + e.name_offset, buf, len);
+}
+
+bool typeCode(const Entry &e, char *buf, size_t len)
+{
+  const Guard guard(s_lock);
+  if (!s_ready || !buf || len == 0) return false;
+  uint8_t gh[kGeomHeaderLen];
+  if (!readAt(FILE_BIN, s_geom_off + e.geom_offset, gh, sizeof(gh))) return false;
+  if (u16(gh + 4) == 0) {
+    buf[0] = '\0';
+    return false;
+  }
+  return readCString(s_string_off + u32(gh + 8), buf, len);
+}
+
+uint16_t grownM(const Entry &e)
+{
+  const Guard guard(s_lock);
+  if (!s_ready) return 0;
+  uint8_t gh[kGeomHeaderLen];
+  if (!readAt(FILE_BIN, s_geom_off + e.geom_offset, gh, sizeof(gh))) return 0;
+  return u16(gh + 2);
+}
+
+uint32_t nameHash(const char *name)
+{
+  uint32_t h = 0x811C9DC5u;
+  for (const char *p = name; p && *p; p++) {
+    h ^= (uint8_t)toupper((unsigned char)*p);
+    h *= 0x01000193u;
+  }
+  return h;
+}
+
+int32_t findByName(const char *name)
+{
+  const Guard guard(s_lock);
+  if (!s_ready || !name || !*name) return -1;
+  const uint32_t h = nameHash(name);
+  char buf[64];
+  if (s_hash_off) {
+    // Lower bound of h in the sorted pairs, then the records sharing it.
+    uint8_t scratch[kHashItemLen];
+    uint32_t lo = 0;
+    uint32_t hi = s_entry_count;
+    while (lo < hi) {
+      const uint32_t mid = lo + (hi - lo) / 2;
+      const uint8_t *it = bytesAt(FILE_IDX, s_hash_off + mid * kHashItemLen, kHashItemLen, scratch);
+      if (!it) return -1;
+      if (u32(it) < h) lo = mid + 1;
+      else hi = mid;
+    }
+    for (; lo < s_entry_count; lo++) {
+      const uint8_t *it = bytesAt(FILE_IDX, s_hash_off + lo * kHashItemLen, kHashItemLen, scratch);
+      if (!it || u32(it) != h) return -1;
+      Entry e;
+      const uint32_t idx = u32(it + 4);
+      if (entry(idx, e) && SuaCatalog::name(e, buf, sizeof(buf)) && strcasecmp(buf, name) == 0) {
+        return (int32_t)idx;
+      }
+    }
+    return -1;
+  }
+  for (uint32_t i = 0; i < s_entry_count; i++) {
+    uint8_t scratch[4];
+    const uint8_t *hb = bytesAt(FILE_IDX, kIdxHeaderLen + i * s_entry_size, sizeof(scratch), scratch);
+    if (!hb) return -1;
+    if (u32(hb) != h) continue;
+    Entry e;
+    if (entry(i, e) && SuaCatalog::name(e, buf, sizeof(buf)) && strcasecmp(buf, name) == 0) {
+      return (int32_t)i;
+    }
+  }
+  return -1;
+}
+
+bool hashIndexed()
+{
+  const Guard guard(s_lock);
+  return s_hash_off != 0;
+}
+
+size_t typeCount()
+{
+  const Guard guard(s_lock);
+  return s_type_count;
+}
+
+const char *typeName(size_t t)
+{
+  const Guard guard(s_lock);
+  return t < s_type_count ? s_types[t].code : "";
+}
+
+uint32_t typeSize(size_t t)
+{
+  const Guard guard(s_lock);
+  return t < s_type_count ? s_types[t].count : 0;
+}
+
+int32_t findType(const char *code)
+{
+  const Guard guard(s_lock);
+  for (size_t t = 0; code && t < s_type_count; t++) {
+    if (strcasecmp(s_types[t].code, code) == 0) return (int32_t)t;
+  }
+  return -1;
+}
+
+bool isType(uint32_t idx, size_t t)
+{
+  const Guard guard(s_lock);
+  if (t >= s_type_count || idx >= s_entry_count) return false;
+  uint8_t scratch[1];
+  const uint8_t *b = bytesAt(FILE_IDX, s_types[t].bitset + idx / 8, 1, scratch);
+  return b && (*b >> (idx % 8)) & 1;
+}
+
+int32_t entryType(uint32_t idx)
+{
+  const Guard guard(s_lock);
+  for (size_t t = 0; t < s_type_count; t++) {
+    if (isType(idx, t)) return (int32_t)t;
+  }
+  return -1;
+}
+
+void queryType(size_t t, int32_t min_lat, int32_t min_lon, int32_t max_lat, int32_t max_lon,
+               std::vector<uint32_t> &out)
+{
+  const Guard guard(s_lock);
+  if (t >= s_type_count) return;
+  const TypeInfo &ti = s_types[t];
+  uint8_t scratch[kTypeItemLen];
+  // Items are sorted by min_lat: those starting north of the box are a
+  // suffix, found by binary search.
+  uint32_t lo = 0;
+  uint32_t hi = ti.count;
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    const uint8_t *it = bytesAt(FILE_IDX, ti.list + mid * kTypeItemLen, kTypeItemLen, scratch);
+    if (!it) return;
+    if (i32(it + 4) <= max_lat) lo = mid + 1;
+    else hi = mid;
+  }
+  for (uint32_t k = 0; k < lo; k++) {
+    const uint8_t *it = bytesAt(FILE_IDX, ti.list + k * kTypeItemLen, kTypeItemLen, scratch);
+    if (!it) return;
+    if (i32(it + 12) < min_lat || i32(it + 8) > max_lon || i32(it + 16) < min_lon) continue;
+    out.push_back(u32(it));
+  }
+}
+
+void query(const PackedRTree::Box &q, PackedRTree::Stats &stats, std::vector<uint32_t> &out)
+{
+  const Guard guard(s_lock);
+  if (!s_ready) return;
+  if (!s_area_index_built) {
+    std::vector<PackedRTree::Box> boxes;
+    boxes.reserve(s_entry_count);
+    Entry e;
+    for (uint32_t i = 0; i < s_entry_count && entry(i, e); i++) {
+      boxes.push_back(PackedRTree::Box{e.min_lat, e.min_lon, e.max_lat, e.max_lon, e.floor_m, e.ceil_m});
+    }
+    if (boxes.size() != s_entry_count) return;
+    s_area_index.build(boxes);
+    s_area_index_built = true;
+    Serial.printf("[SUA] area index: %lu areas, %lu nodes\n",
+                  (unsigned long)s_area_index.size(), (unsigned long)s_area_index.nodeCount());
+  }
+  s_area_index.query(q, stats, [&](uint32_t idx) { out.push_back(idx); });
+}
+
+size_t areaIndexNodes()
+{
+  const Guard guard(s_lock);
+  return s_area_index.nodeCount();
+}
+
+bool contains(const Entry &e, int32_t lat, int32_t lon)
+{
+  const Guard guard(s_lock);
+  if (lat < e.min_lat || lat > e.max_lat || lon < e.min_lon || lon > e.max_lon) return false;
+  GeometryReader rd;
+  if (!rd.open(e)) return false;
+  RingParity acc;
+  acc.p_lat = lat;
+  acc.p_lon = lon;
+  uint16_t segs = 0;
+  Segment s;
+  while (rd.nextRing(segs)) {
+    while (rd.nextSegment(s)) {
+      if (s.type == SEG_ARC) {
+        arcEdge(s, acc);
+      } else {
+        acc.to(s.start_lat, s.start_lon);
+        acc.to(s.end_lat, s.end_lon);
+      }
+    }
+    acc.closeRing();
+  }
+  return acc.inside;
+}
+
+float boundaryDistanceM(const Entry &e, int32_t lat, int32_t lon)
+{
+  const Guard guard(s_lock);
+  float best = INFINITY;
+  GeometryReader rd;
+  if (!rd.open(e)) return best;
+  uint16_t segs = 0;
+  Segment s;
+  while (rd.nextRing(segs)) {
+    while (rd.nextSegment(s)) {
+      GeoMath::Arc arc;
+      const float d = (s.type == SEG_ARC &&
+                       GeoMath::makeArc(s.start_lat, s.start_lon, s.end_lat, s.end_lon,
+                                        s.center_lat, s.center_lon, s.radius_m,
+                                        s.direction != 0, arc))
+                          ? GeoMath::arcDistanceM(arc, lat, lon)
+                          : GeoMath::segmentDistanceM(s.start_lat, s.start_lon,
+                                                      s.end_lat, s.end_lon, lat, lon);
+      if (d < best) best = d;
+    }
+  }
+  return best;
+}
+
+bool boundaryIntersects(const Entry &e, int32_t a_lat, int32_t a_lon,
+                        int32_t b_lat, int32_t b_lon)
+{
+  const Guard guard(s_lock);
+  GeometryReader rd;
+  if (!rd.open(e)) return false;
+  uint16_t segs = 0;
+  Segment s;
+  while (rd.nextRing(segs)) {
+    while (rd.nextSegment(s)) {
+      GeoMath::Arc arc;
+      const bool hit = (s.type == SEG_ARC &&
+                        GeoMath::makeArc(s.start_lat, s.start_lon, s.end_lat, s.end_lon,
+                                         s.center_lat, s.center_lon, s.radius_m,
+                                         s.direction != 0, arc))
+                           ? GeoMath::segmentIntersectsArc(arc, a_lat, a_lon, b_lat, b_lon)
+                           : GeoMath::segmentsIntersect(s.start_lat, s.start_lon,
+                                                        s.end_lat, s.end_lon,
+                                                        a_lat, a_lon, b_lat, b_lon);
+      if (hit) return true;
+    }
+  }
+  return false;
+}
+
+size_t nearby(int32_t lat, int32_t lon, float radius_m, int32_t type, size_t limit,
+              std::vector<Near> &out)
+{
+  const Guard guard(s_lock);
+  out.clear();
+  if (!s_ready || !(radius_m >= 0.0f)) return 0;
+  // The bbox bound and the exact distance use different flat frames, which
+  // drift apart by a few percent over long ranges: search a little wider,
+  // with the longitude span taken at the poleward edge.
+  const float reach = radius_m * 1.1f;
+  const double dlat = reach / GeoMath::kMetersPerDegLat * GeoMath::E6;
+  const int32_t edge_lat = (int32_t)min(90.0 * GeoMath::E6, fabs((double)lat) + dlat);
+  const double dlon = reach / max(GeoMath::metersPerLonE6(edge_lat), 0.001f);
+  const int32_t min_lat = (int32_t)max(-90.0 * GeoMath::E6, lat - dlat);
+  const int32_t max_lat = (int32_t)min(90.0 * GeoMath::E6, lat + dlat);
+  const int32_t min_lon = (int32_t)max(-180.0 * GeoMath::E6, lon - dlon);
+  const int32_t max_lon = (int32_t)min(180.0 * GeoMath::E6, lon + dlon);
+
+  std::vector<uint32_t> candidates;
+  if (type >= 0) {
+    queryType((size_t)type, min_lat, min_lon, max_lat, max_lon, candidates);
+  } else {
+    PackedRTree::Stats stats;
+    query(PackedRTree::Box{min_lat, min_lon, max_lat, max_lon, PackedRTree::kAltMin, PackedRTree::kAltMax},
+          stats, candidates);
+  }
+  Entry e;
+  for (uint32_t idx : candidates) {
+    if (!entry(idx, e)) continue;
+    if (GeoMath::bboxDistanceM(e.min_lat, e.min_lon, e.max_lat, e.max_lon, lat, lon) > reach) continue;
+    const float d = contains(e, lat, lon) ? 0.0f : boundaryDistanceM(e, lat, lon);
+    if (d <= radius_m) out.push_back(Near{idx, d});
+  }
+  std::sort(out.begin(), out.end(), [](const Near &a, const Near &b) {
+    return a.distM < b.distM || (a.distM == b.distM && a.idx < b.idx);
+  });
+  const size_t matched = out.size();
+  if (out.size() > limit) out.resize(limit);
+  return matched;
+}
+
+const CacheStats &cacheStats()
+{
+  const Guard guard(s_lock);
+  return s_cache_stats;
+}
+
+bool GeometryReader::open(const Entry &e)
+{
+  const Guard guard(s_lock);
+  _rings = _ringsLeft = _segsLeft = 0;
+  if (!s_ready) return false;
+  _pos = s_geom_off + e.geom_offset;
+  _end = _pos + e.geom_length;
+  uint8_t gh[kGeomHeaderLen];
+  if (e.geom_length < kGeomHeaderLen || !readAt(FILE_BIN, _pos, gh, sizeof(gh))) return false;
+  _pos += kGeomHeaderLen;
+  _rings = _ringsLeft = u16(gh + 0);
+  return true;
+}
+
+bool GeometryReader::nextRing(uint16_t &segments)
+{
+  const Guard guard(s_lock);
+  // Skip whatever the caller left unread in the previous ring.
+  Segment skip;
+  while (_segsLeft > 0 && nextSegment(skip)) {}
+  if (_ringsLeft == 0) return false;
+  if (s_geom_v2) {
+    uint8_t scratch[5];
+    const uint32_t len = min((uint32_t)sizeof(scratch), _end - _pos);
+    const uint8_t *p = bytesAt(FILE_BIN, _pos, len, scratch);
+    const uint8_t *q = p;
+    uint64_t count = 0;
+    if (!p || !varint(q, p + len, count) || count > 0xFFFF) {
+      _ringsLeft = 0;
+      return false;
+    }
+    _pos += q - p;
+    _ringsLeft--;
+    _segsLeft = segments = (uint16_t)count;
+    // Each ring's first segment jumps from the origin to its first vertex.
+    _lat = _lon = 0;
+    return true;
+  }
+  if (_pos + kRingHeaderLen > _end) return false;
+  uint8_t rh[kRingHeaderLen];
+  if (!readAt(FILE_BIN, _pos, rh, sizeof(rh))) return false;
+  _pos += kRingHeaderLen;
+  _ringsLeft--;
+  _segsLeft = segments = u16(rh);
+  return true;
+}
+
+bool GeometryReader::nextSegment(Segment &seg)
+{
+  const Guard guard(s_lock);
+  if (_segsLeft == 0 || _pos >= _end) return false;
+  if (s_geom_v2) return nextSegmentV2(seg);
+  uint8_t scratch[kArcLen];
+  const uint8_t *buf = bytesAt(FILE_BIN, _pos, 1, scratch);
+  if (!buf) return false;
+  seg.type = buf[0];
+  const uint32_t len = (seg.type == SEG_ARC) ? kArcLen : kLineLen;
+  if ((seg.type != SEG_LINE && seg.type != SEG_ARC) || _pos + len > _end ||
+      !(buf = bytesAt(FILE_BIN, _pos, len, scratch))) {
+    _segsLeft = _ringsLeft = 0;
+    return false;
+  }
+  _pos += len;
+  _segsLeft--;
+  seg.start_lat = i32(buf + 1);
+  seg.start_lon = i32(buf + 5);
+  seg.end_lat = i32(buf + 9);
+  seg.end_lon = i32(buf + 13);
+  if (seg.type == SEG_ARC) {
+    seg.center_lat = i32(buf + 17);
+    seg.center_lon = i32(buf + 21);
+    seg.radius_m = u32(buf + 25);
+    seg.start_cd = centiDeg(buf + 29);
+    seg.end_cd = centiDeg(buf + 31);
+    seg.direction = buf[33];
+  } else {
+    seg.center_lat = seg.center_lon = 0;
+    seg.radius_m = 0;
+    seg.start_cd = seg.end_cd = 0;
+    seg.direction = 0;
+  }
+  return true;
+}
+
+bool GeometryReader::nextSegmentV2(Segment &seg)
+{
+  uint8_t scratch[kSeg2MaxLen];
+  const uint32_t len = min(kSeg2MaxLen, _end - _pos);
+  const uint8_t *p = bytesAt(FILE_BIN, _pos, len, scratch);
+  const uint8_t *q = p;
+  const uint8_t *end = p + len;
+  uint64_t head = 0, v = 0;
+  bool ok = p && varint(q, end, head);
+  const uint8_t flags = (uint8_t)(head & 0x07);
+  int64_t lat = _lat, lon = _lon;
+  if (ok && (flags & kSeg2Jump)) {
+    ok = varint(q, end, v);
+    lat += unzigzag(v);
+    ok = ok && varint(q, end, v);
+    lon += unzigzag(v);
+  }
+  ok = ok && varint(q, end, v);
+  const int64_t end_lat = lat + unzigzag(head >> 3);
+  const int64_t end_lon = lon + unzigzag(v);
+  seg.type = (flags & kSeg2Arc) ? SEG_ARC : SEG_LINE;
+  seg.center_lat = seg.center_lon = 0;
+  seg.radius_m = 0;
+  seg.start_cd = seg.end_cd = 0;
+  seg.direction = 0;
+  if (ok && seg.type == SEG_ARC) {
+    uint64_t c_lat = 0, c_lon = 0, radius = 0, start_cd = 0, end_cd = 0;
+    ok = varint(q, end, c_lat) && varint(q, end, c_lon) && varint(q, end, radius) &&
+         varint(q, end, start_cd) && varint(q, end, end_cd);
+    seg.center_lat = (int32_t)(lat + unzigzag(c_lat));
+    seg.center_lon = (int32_t)(lon + unzigzag(c_lon));
+    seg.radius_m = (uint32_t)radius;
+    seg.start_cd = start_cd > 36000 ? (int32_t)start_cd - 65536 : (int32_t)start_cd;
+    seg.end_cd = end_cd > 36000 ? (int32_t)end_cd - 65536 : (int32_t)end_cd;
+    seg.direction = (flags & kSeg2Ccw) ? 1 : 0;
+  }
+  if (!ok) {
+    _segsLeft = _ringsLeft = 0;
+    return false;
+  }
+  _pos += q - p;
+  _segsLeft--;
+  seg.start_lat = (int32_t)lat;
+  seg.start_lon = (int32_t)lon;
+  seg.end_lat = _lat = (int32_t)end_lat;
+  seg.end_lon = _lon = (int32_t)end_lon;
+  return true;
+}
+
+}  // namespace SuaCatalog
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <Arduino.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "geofence/PackedRTree.h"
+
+// Read-only access to the SUA catalog (SIA1 sua_catalog.idx + SIA1 or SIA2
+// .bin built by special_use_airspace/build_sua_catalog.py). Nothing is
+// loaded up front.
+// When the "sua" data partition holds a catalog image (build_sua_catalog.py
+// --partition) both files are memory-mapped from flash and read in place;
+// otherwise they come from LittleFS through a small fixed block cache.
+// Calls are serialised internally, so loop() and the web server task may
+// both use the catalog.
+namespace SuaCatalog {
+  constexpr const char *kIdxPath = "/portal/sua_catalog.idx";
+  constexpr const char *kBinPath = "/portal/sua_catalog.bin";
+  constexpr const char *kPartitionLabel = "sua";
+
+  // Altitude band sentinels, metres MSL.
+  constexpr int32_t kNoFloorM = INT32_MIN;
+  constexpr int32_t kNoCeilingM = INT32_MAX;
+
+  // One index record (SIA1 entry, 40 bytes on disk; 32-byte entries from
+  // older builds read back with an unbounded altitude band).
+  struct Entry {
+    uint32_t id_hash;      // fnv1a_32(name.upper())
+    uint32_t name_offset;  // into the string table
+    uint32_t geom_offset;  // into the geometry section
+    uint32_t geom_length;
+    int32_t min_lat;       // bbox, micro-degrees
+    int32_t min_lon;
+    int32_t max_lat;
+    int32_t max_lon;
+    int32_t floor_m = kNoFloorM;     // metres MSL
+    int32_t ceil_m = kNoCeilingM;
+  };
+
+  enum SegmentType : uint8_t {
+    SEG_LINE = 0x01,
+    SEG_ARC = 0x02
+  };
+
+  struct Segment {
+    uint8_t type;
+    int32_t start_lat;
+    int32_t start_lon;
+    int32_t end_lat;
+    int32_t end_lon;
+    // ARC only
+    int32_t center_lat;
+    int32_t center_lon;
+    uint32_t radius_m;
+    int32_t start_cd;      // centi-degrees, 0 = east, counter-clockwise;
+    int32_t end_cd;        // approximate only, use the endpoints instead
+    uint8_t direction;     // 1 = CCW, 0 = CW
+  };
+
+  struct CacheStats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t bytesRead = 0;
+  };
+
+  // Prefers the catalog partition, then the LittleFS files.
+  bool begin(const char *idxPath = kIdxPath, const char *binPath = kBinPath);
+  // Catalog partition only. On host builds label is the path of an image
+  // file, mapped with mmap() so the same reader code runs on Linux.
+  bool beginPartition(const char *label = kPartitionLabel);
+  void end();
+  bool ready();
+  bool mapped();
+  // The two files in place in the mapped partition, for serving them
+  // without a copy; nullptr when the catalog comes from LittleFS.
+  const uint8_t *mappedIdx(size_t &len);
+  const uint8_t *mappedBin(size_t &len);
+
+  uint32_t count();
+  // Fingerprint of the open catalog files, for caches derived from them.
+  uint32_t stamp();
+  bool entry(uint32_t idx, Entry &out);
+  bool name(const Entry &e, char *buf, size_t len);
+  bool typeCode(const Entry &e, char *buf, size_t len);
+  // Metres the builder let the area grow when it simplified the geometry
+  // (0 when untouched); stay-ins pull their boundary in by this much.
+  uint16_t grownM(const Entry &e);
+
+  // Case-insensitive name lookup; returns the entry index or -1. A binary
+  // search of the index's hash section (id_hash order), a linear scan of
+  // the records for catalogs built without one.
+  int32_t findByName(const char *name);
+  bool hashIndexed();
+  uint32_t nameHash(const char *name);
+
+  // Airspace types from the index's type section ("TYP1", written after the
+  // records by build_sua_catalog.py): TYPE_CODE strings such as "R", "P",
+  // "W", "A", "MOA", each with a membership bitset and its areas' bboxes
+  // sorted by min_lat. Answers type questions from the index alone, without
+  // decoding geometry; catalogs built before it have no types.
+  constexpr size_t kMaxTypes = 16;
+  size_t typeCount();
+  const char *typeName(size_t t);
+  uint32_t typeSize(size_t t);
+  // Case-insensitive; -1 when the catalog has no such type.
+  int32_t findType(const char *code);
+  bool isType(uint32_t idx, size_t t);
+  // Type of an entry from the bitsets, -1 when untyped.
+  int32_t entryType(uint32_t idx);
+  // Entries of type t whose bbox meets the given one (horizontal only).
+  void queryType(size_t t, int32_t min_lat, int32_t min_lon, int32_t max_lat, int32_t max_lon,
+                 std::vector<uint32_t> &out);
+
+  // Entry indices whose bbox and altitude band intersect q, through a
+  // packed R-tree over every index record. Built on the first call (one
+  // pass over the index, about 28 B per area) and kept until end().
+  void query(const PackedRTree::Box &q, PackedRTree::Stats &stats, std::vector<uint32_t> &out);
+  size_t areaIndexNodes();
+
+  struct Near {
+    uint32_t idx;
+    float distM;  // 0 when the point is inside the area
+  };
+  // Areas within radius_m of the point (any altitude), nearest first and
+  // at most limit of them; type is a typeCount() index or -1 for all.
+  // Candidates come from the index, then the exact boundary distance.
+  // Returns how many matched before the limit.
+  size_t nearby(int32_t lat, int32_t lon, float radius_m, int32_t type, size_t limit,
+                std::vector<Near> &out);
+
+  // Even-odd containment over all rings of the entry (bbox prefiltered).
+  bool contains(const Entry &e, int32_t lat, int32_t lon);
+
+  // Distance (m) from the point to the nearest boundary segment of the entry.
+  float boundaryDistanceM(const Entry &e, int32_t lat, int32_t lon);
+
+  // True when segment a-b touches any boundary segment of the entry.
+  bool boundaryIntersects(const Entry &e, int32_t a_lat, int32_t a_lon,
+                          int32_t b_lat, int32_t b_lon);
+
+  const CacheStats &cacheStats();
+
+  // Sequential geometry decoder for one entry: fixed-width SIA1 segments,
+  // or SIA2 delta/varint rings decoded as they stream past.
+  class GeometryReader {
+  public:
+    bool open(const Entry &e);
+    uint16_t ringCount() const { return _rings; }
+    // Advances to the next ring; false when all rings are consumed.
+    bool nextRing(uint16_t &segments);
+    // Next segment of the current ring; false at ring end or on bad data.
+    bool nextSegment(Segment &seg);
+
+  private:
+    bool nextSegmentV2(Segment &seg);
+
+    uint32_t _pos = 0;
+    uint32_t _end = 0;
+    uint16_t _rings = 0;
+    uint16_t _ringsLeft = 0;
+    uint16_t _segsLeft = 0;
+    // SIA2: end of the previous segment, where the next one starts.
+    int32_t _lat = 0;
+    int32_t _lon = 0;
+  };
+}
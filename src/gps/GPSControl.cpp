@@ -30,9 +30,12 @@ static TinyGPSPlus gps;
 static float lastLat = 0.0f;
 static float lastLng = 0.0f;
 static float lastAlt = NAN;
+static float lastSpeedMps = 0.0f;
 static uint32_t lastTime = 0;
 static bool lastFix = false;
 static uint8_t lastSats = 0;
+static uint32_t fixSeq = 0;
+static uint32_t lastFixMs = 0;
 
 void GPSControl::begin()
 {
@@ -84,13 +87,20 @@ void GPSControl::poll()
     }
   }
 
-  if (gps.location.isUpdated()) {
+  // Each GGA/RMC sentence carrying a valid position bumps the sequence so
+  // consumers (geofence) can react per fix instead of polling on a timer.
+  if (gps.location.isUpdated() && gps.location.isValid()) {
     lastLat = gps.location.lat();
     lastLng = gps.location.lng();
+    fixSeq++;
+    lastFixMs = now;
   }
   if (gps.altitude.isUpdated()) {
     lastAlt = gps.altitude.meters();
   }
+  if (gps.speed.isUpdated() && gps.speed.isValid()) {
+    lastSpeedMps = (float)gps.speed.mps();
+  }
   if (gps.time.isUpdated()) {
     lastTime = gps.time.value();
   }
@@ -108,5 +118,8 @@ bool GPSControl::hasGoodFix() { return lastFix && lastSats >= 4; }
 float GPSControl::latitude() { return lastLat; }
 float GPSControl::longitude() { return lastLng; }
 float GPSControl::altitudeMeters() { return lastAlt; }
+float GPSControl::speedMps() { return lastSpeedMps; }
 uint32_t GPSControl::timeValue() { return lastTime; }
 uint8_t GPSControl::satellites() { return lastSats; }
+uint32_t GPSControl::fixSequence() { return fixSeq; }
+uint32_t GPSControl::lastFixMillis() { return lastFixMs; }
@@ -10,6 +10,11 @@ namespace GPSControl {
   float latitude();
   float longitude();
   float altitudeMeters();
+  // Ground speed from the last RMC/VTG sentence.
+  float speedMps();
   uint32_t timeValue();
   uint8_t satellites();
+  // Increments on every new position sentence; compare against a saved value to detect fresh fixes.
+  uint32_t fixSequence();
+  uint32_t lastFixMillis();
 }
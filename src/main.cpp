@@ -5,6 +5,7 @@
 #include "display/display.h"
 #include "gps/GPSControl.h"
 #include "satcom/SatCom.h"
+#include "satcom/TxQueue.h"
 #include "message/MessageCodec.h"
 #include "sensors/BME280.h"
 #include "sensors/PMU_AXP2101.h"
@@ -32,6 +33,12 @@ static uint32_t lastConfigCheckMs = 0;
 static bool defaultCallsignApplied = false;
 static bool satcomIdApplied = false;
 static bool configDisplayDirty = false;
+static uint32_t lastGeoFixSeq = 0;
+static uint32_t lastGeoEvalMs = 0;
+static uint32_t geoEvalIntervalMs = 0;
+static uint32_t geoRevision = 0;
+static bool geoViolation = false;
+static bool geoPending = false;
 
 static ConfigStore portalConfig("/mission_active.json");
 static String cachedCallsign = "";
@@ -41,6 +48,17 @@ static constexpr uint32_t MIN_BOOT_MS = 5000;
 static constexpr uint32_t SAT_SEND_INTERVAL_MS = 120000;
 static constexpr uint32_t STATUS_REFRESH_MS = 30000;
 static constexpr uint32_t CONFIG_REFRESH_MS = 3000;
+// Geofence runs on every new GPS fix, but never more often than this so a
+// chatty receiver cannot starve the rest of loop().
+static constexpr uint32_t GEOFENCE_MIN_EVAL_MS = 200;
+static constexpr uint32_t GEOFENCE_SLOW_EVAL_US = 2000;
+// Far from every boundary the fence is re-checked less often: the next
+// evaluation is due when the boundary could be reached at the faster of the
+// closing speed and GPS ground speed (never below GEOFENCE_MIN_SPEED_MPS),
+// keeping GEOFENCE_GUARD_M in hand. GEOFENCE_MAX_EVAL_MS caps the latency.
+static constexpr uint32_t GEOFENCE_MAX_EVAL_MS = 30000;
+static constexpr float GEOFENCE_GUARD_M = 500.0f;
+static constexpr float GEOFENCE_MIN_SPEED_MPS = 5.0f;
 
 static void fillConfigDefaults(JsonDocument &doc) {
   doc.clear();
@@ -123,6 +141,41 @@ static void applyConfigToDisplay(const JsonDocument &cfg) {
   }
 }
 
+static uint32_t geofenceIntervalMs() {
+  float marginM = 0.0f;
+  float closingMps = 0.0f;
+  if (GeoFence::forcedViolation()) return GEOFENCE_MIN_EVAL_MS;
+  if (!GeoFence::margin(marginM, closingMps)) return GEOFENCE_MAX_EVAL_MS;
+  if (marginM <= GEOFENCE_GUARD_M) return GEOFENCE_MIN_EVAL_MS;
+  float speed = max(closingMps, GPSControl::speedMps());
+  if (speed < GEOFENCE_MIN_SPEED_MPS) speed = GEOFENCE_MIN_SPEED_MPS;
+  const float ms = (marginM - GEOFENCE_GUARD_M) / speed * 1000.0f;
+  if (ms >= (float)GEOFENCE_MAX_EVAL_MS) return GEOFENCE_MAX_EVAL_MS;
+  if (ms <= (float)GEOFENCE_MIN_EVAL_MS) return GEOFENCE_MIN_EVAL_MS;
+  return (uint32_t)ms;
+}
+
+// Current position as a raw 0x27 frame on the persistent SATCOM queue.
+static bool queuePosition(TxQueue::Priority priority) {
+  MessageCodec::Fields fields;
+  fields.time_value = GPSControl::timeValue();
+  fields.latitude = GPSControl::latitude();
+  fields.longitude = GPSControl::longitude();
+  fields.altitude_m = GPSControl::altitudeMeters();
+  fields.temp_k = BME280Sensor::temperatureC() + 273.15f;
+  fields.pressure_hpa = BME280Sensor::pressureHpa();
+
+  MessageCodec::EncodedMessage msg;
+  return MessageCodec::encodeRaw27(fields, msg) && TxQueue::push(priority, msg.bytes, msg.len);
+}
+
+// Every termination (geofence, forced, flight timer) is logged to the queue
+// before the relay fires, in case the burn browns us out.
+static void onTermination(const char *reason) {
+  (void)reason;
+  queuePosition(TxQueue::Priority::TERMINATION);
+}
+
 // Helper: only redraw when % changes
 static void setBoot(uint8_t pct) {
   if (pct > 100) pct = 100;
@@ -154,6 +207,9 @@ void setup() {
   BME280Sensor::begin();
   PMU_AXP2101::begin();
   GeoFence::begin();
+  GeoFence::setSlowEvalUs(GEOFENCE_SLOW_EVAL_US);
+  TxQueue::begin();
+  Termination::onTrigger(onTermination);
   MissionController::begin();
 
   // ---------------- Optional: GPS bring-up (keep, but if it spams / blocks, comment it) ----------------
@@ -163,8 +219,6 @@ void setup() {
 
   // ---------------- Optional: Portal server ----------------
   PortalServer::begin();
-  // If PortalServer requires servicing in loop, uncomment below in loop().
-  // PortalServer::loop();
 
   // ---------------- Display boot screen ----------------
   display_init();
@@ -217,9 +271,10 @@ void loop() {
 
   // ---------------- SATCOM ----------------
   SatCom::poll();
+  TxQueue::update(now);
   
-  // ---------------- Optional: Portal server servicing ----------------
-  // PortalServer::loop();
+  // ---------------- Portal server servicing ----------------
+  PortalServer::loop();
 
   // ---------------- GPS polling (raw NMEA passthrough / debug) ----------------
   GPSControl::poll();
@@ -292,6 +347,43 @@ void loop() {
     return;
   }
 
+  // ---------------- GEOFENCE (per GPS fix, adaptive cadence) ----------------
+  const uint32_t geoFixSeq = GPSControl::fixSequence();
+  if (GeoFence::revision() != geoRevision || GeoFence::forcedViolation()) {
+    geoRevision = GeoFence::revision();
+    geoEvalIntervalMs = GEOFENCE_MIN_EVAL_MS;
+  }
+  if (geoFixSeq != lastGeoFixSeq && GPSControl::hasFix() &&
+      (now - lastGeoEvalMs >= max(geoEvalIntervalMs, GEOFENCE_MIN_EVAL_MS))) {
+    lastGeoFixSeq = geoFixSeq;
+    lastGeoEvalMs = now;
+    const bool violation = GeoFence::update(GPSControl::latitude(), GPSControl::longitude(),
+                                            GPSControl::altitudeMeters());
+    const bool pending = GeoFence::violationPending();
+    // One GEOFENCE alert per confirmed violation, queued ahead of any
+    // TERMINATION; entering the debounce only sends a routine position.
+    if (violation && !geoViolation) {
+      queuePosition(TxQueue::Priority::GEOFENCE);
+    } else if (pending && !geoPending) {
+      queuePosition(TxQueue::Priority::ROUTINE);
+    }
+    geoPending = pending;
+    if (violation && !Termination::triggered() && GeoFence::violationCount() > 0) {
+      const GeoFence::Violation &v = GeoFence::violation(0);
+      Termination::trigger(v.detail.c_str());
+    }
+    if (violation != geoViolation) {
+      geoViolation = violation;
+      SystemStatus::setGeoStatus((uint8_t)GeoFence::ruleCount(), !geoViolation);
+    }
+    float marginM = 0.0f;
+    float closingMps = 0.0f;
+    const bool hasMargin = GeoFence::margin(marginM, closingMps);
+    SystemStatus::setGeoMargin(hasMargin, marginM, closingMps);
+    display_set_geo_margin(hasMargin, marginM);
+    geoEvalIntervalMs = geofenceIntervalMs();
+  }
+
   // ---------------- STATUS ----------------
   if (now - lastStatusDrawMs >= STATUS_REFRESH_MS) {
     BME280Sensor::update();
@@ -307,16 +399,11 @@ void loop() {
       containedEnabled = statusCfg["contained_enabled"] | false;
     }
     if (GPSControl::hasFix()) {
-      const bool violation = GeoFence::update(GPSControl::latitude(), GPSControl::longitude());
-      if (violation && !Termination::triggered() && GeoFence::violationCount() > 0) {
-        const GeoFence::Violation &v = GeoFence::violation(0);
-        Termination::trigger(v.detail.c_str());
-      }
       if (containedEnabled) {
         containedLaunch = GeoFence::containedAt(GPSControl::latitude(), GPSControl::longitude(), &hasStayIn);
       }
-      display_set_geo((uint8_t)GeoFence::ruleCount(), !violation);
-      SystemStatus::setGeoStatus((uint8_t)GeoFence::ruleCount(), !violation);
+      display_set_geo((uint8_t)GeoFence::ruleCount(), !geoViolation);
+      SystemStatus::setGeoStatus((uint8_t)GeoFence::ruleCount(), !geoViolation);
     } else {
       display_set_geo((uint8_t)GeoFence::ruleCount(), true);
       SystemStatus::setGeoStatus((uint8_t)GeoFence::ruleCount(), true);
@@ -391,18 +478,7 @@ void loop() {
   if (now - lastSatSendMs >= SAT_SEND_INTERVAL_MS) {
     lastSatSendMs = now;
     if (GPSControl::hasFix()) {
-      MessageCodec::Fields fields;
-      fields.time_value = GPSControl::timeValue();
-      fields.latitude = GPSControl::latitude();
-      fields.longitude = GPSControl::longitude();
-      fields.altitude_m = GPSControl::altitudeMeters();
-      fields.temp_k = BME280Sensor::temperatureC() + 273.15f;
-      fields.pressure_hpa = BME280Sensor::pressureHpa();
-
-      MessageCodec::EncodedMessage msg;
-      if (MessageCodec::encodeRaw27(fields, msg)) {
-        SatCom::sendRawFrame(msg.bytes, msg.len);
-      }
+      queuePosition(TxQueue::Priority::ROUTINE);
     }
   }
 
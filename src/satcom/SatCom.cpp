@@ -2,6 +2,7 @@
 #include <Arduino.h>
 #include <HardwareSerial.h>
 #include "satcom/SatCom.h"
+#include "satcom/SmartOneParser.h"
 
 // Pins from legacy flight software
 static const int SAT_RX_PIN = 46;   // ESP RX  <- SatCom TX
@@ -10,144 +11,344 @@ static const int SAT_HS_PIN = 39;   // handshake / wake
 
 static const uint32_t SAT_BAUD = 9600;
 
+// Handshake timing from the legacy wakeSat()/sendCmd() delays: HS pulsed
+// LOW then HIGH to wake the modem, LOW again 2-3 ms before the frame, and
+// back HIGH once the last byte has left the UART.
+static const uint32_t SAT_WAKE_LOW_MS = 70;
+static const uint32_t SAT_WAKE_HIGH_MS = 72;
+static const uint32_t SAT_SELECT_MS = 3;
+// Pause before retrying after a NAK (modem busy) or a silent attempt.
+static const uint32_t SAT_NAK_BACKOFF_MS = 400;
+static const uint32_t SAT_TIMEOUT_BACKOFF_MS = 200;
+// poll() takes at most this many RX bytes per call (~0.25 s of line time).
+static const size_t SAT_RX_PER_POLL = 256;
+// A partial frame with no new byte for this long was a false start.
+static const uint32_t SAT_RX_GAP_MS = 50;
+
+static const uint8_t SAT_NAK = SmartOne::CMD_NAK;
+static const size_t SAT_MAX_FRAME = 64;
+static const size_t SAT_QUEUE_DEPTH = 4;
+static const size_t SAT_MAX_HANDLERS = 8;
+
 static uint32_t totalRx = 0;
 static uint32_t totalTx = 0;
 static uint32_t lastIdValue = 0;
+static bool idPending = false;
 
 static uint32_t lastPrintMs = 0;
 static uint32_t lastRxSnapshot = 0;
 
-static void wakeSat()
+static SatCom::Stats satStats;
+static SatCom::ModemQueue modemQueueState;
+
+// One queued command and how to recognise its answer.
+struct Transaction {
+  uint8_t frame[SAT_MAX_FRAME];
+  uint8_t len;
+  uint8_t cmd;            // response command code to wait for
+  bool expectResponse;    // false: done once the frame is on the wire
+  bool anyResponse;       // legacy hex-dump helpers take whatever comes back
+  uint8_t attemptsLeft;
+  bool firstAttempt;
+  uint32_t timeoutMs;
+  uint32_t queuedMs;
+  SatCom::Callback done;
+};
+
+enum class Phase : uint8_t { IDLE, WAKE_LOW, WAKE_HIGH, SELECT, SENDING, AWAIT, BACKOFF };
+
+static Transaction queue[SAT_QUEUE_DEPTH];
+static size_t queueHead = 0;
+static size_t queueCount = 0;
+static Phase phase = Phase::IDLE;
+static uint32_t phaseStartMs = 0;
+static uint32_t phaseMs = 0;
+
+static SmartOneParser parser;
+static uint8_t rxFrame[SmartOneParser::kMaxFrame];
+static uint32_t lastRxByteMs = 0;
+static volatile uint32_t uartOverruns = 0;
+static uint32_t unclaimedFrames = 0;
+
+struct HandlerSlot {
+  uint8_t cmd;
+  SatCom::FrameHandler handler;
+};
+static HandlerSlot handlers[SAT_MAX_HANDLERS];
+static size_t handlerCount = 0;
+
+static void noteCallUs(uint32_t startUs)
 {
-  digitalWrite(SAT_HS_PIN, LOW);
-  delay(70);
-  digitalWrite(SAT_HS_PIN, HIGH);
-  delay(70);
+  satStats.lastPollUs = micros() - startUs;
+  if (satStats.lastPollUs > satStats.worstPollUs) satStats.worstPollUs = satStats.lastPollUs;
 }
 
-static void drainForMs(uint32_t ms, bool hexDump)
+static void enterPhase(Phase next, uint32_t now, uint32_t ms)
 {
-  const uint32_t start = millis();
-  bool any = false;
-
-  while (millis() - start < ms) {
-    while (Serial2.available()) {
-      uint8_t b = (uint8_t)Serial2.read();
-      totalRx++;
-      any = true;
-      if (hexDump) Serial.printf("%02X ", b);
-    }
-    delay(2);
-  }
-
-  if (hexDump) {
-    if (!any) Serial.print("(no bytes)");
-    Serial.println();
-  }
+  phase = next;
+  phaseStartMs = now;
+  phaseMs = ms;
 }
 
-// -------- Packet read helper (AA LEN ... CRC) --------
-static bool readPacket(uint8_t *buf, size_t bufMax, size_t &outLen, uint32_t timeoutMs)
+// -------- Documented command frame (AA LEN CMD ... CRC) --------
+static size_t buildCmd(uint8_t cmd, const uint8_t *payload, size_t payloadLen, uint8_t *msg)
 {
-  outLen = 0;
+  const size_t headerLen = 3; // AA, LEN, CMD
+  const size_t crcLen    = 2;
 
-  // Find 0xAA start
-  uint32_t t0 = millis();
-  while (millis() - t0 < timeoutMs) {
-    if (Serial2.available()) {
-      uint8_t b = (uint8_t)Serial2.read();
-      totalRx++;
-      if (b == 0xAA) {
-        buf[outLen++] = b;
-        break;
-      }
-    }
-    delay(1);
-  }
-  if (outLen == 0) return false;
-
-  // Read LEN
-  t0 = millis();
-  while (millis() - t0 < timeoutMs) {
-    if (Serial2.available()) {
-      buf[outLen++] = (uint8_t)Serial2.read();
-      totalRx++;
-      break;
-    }
-    delay(1);
-  }
-  if (outLen < 2) return false;
+  const size_t totalLen = headerLen + payloadLen + crcLen;
+  if (totalLen > SAT_MAX_FRAME) return 0;
 
-  const uint8_t totalLen = buf[1];
-  if (totalLen < 5 || totalLen > bufMax) return false;
+  msg[0] = 0xAA;
+  msg[1] = (uint8_t)totalLen;
+  msg[2] = cmd;
 
-  // Read rest
-  while (outLen < totalLen && (millis() - t0 < timeoutMs)) {
-    while (Serial2.available() && outLen < totalLen) {
-      buf[outLen++] = (uint8_t)Serial2.read();
-      totalRx++;
-    }
-    delay(1);
-  }
+  if (payloadLen && payload) memcpy(&msg[3], payload, payloadLen);
 
-  return (outLen == totalLen);
-}
+  const uint16_t crc = SmartOneParser::crc(msg, headerLen + payloadLen);
 
-// -------- CRC helper (same algo as your legacy code) --------
-static uint16_t crcSmartOne(const uint8_t *data, size_t len)
-{
-  uint16_t crc = 0xFFFF;
-  while (len--) {
-    uint16_t d = 0x00FF & *data++;
-    crc ^= d;
-    for (uint8_t i = 0; i < 8; i++) {
-      if (crc & 0x0001) crc = (crc >> 1) ^ 0x8408;
-      else             crc >>= 1;
-    }
-  }
-  crc = ~crc;
-  return crc;
+  // Spec order: CRC low byte, then high byte
+  msg[headerLen + payloadLen + 0] = (uint8_t)(crc & 0xFF);
+  msg[headerLen + payloadLen + 1] = (uint8_t)((crc >> 8) & 0xFF);
+  return totalLen;
 }
 
-// -------- Documented command sender (AA LEN CMD ... CRC) --------
-// SmartOne C spec: pull HS LOW, wait 2-3 ms, send cmd, then raise HS HIGH.
-static void sendCmd(uint8_t cmd, const uint8_t *payload, size_t payloadLen)
+// Your old raw payload exercise (0x27 frame)
+// Keep it if you want, but it is NOT a “status/query” command.
+static size_t buildRaw27(const uint8_t *payload, size_t payloadLen, uint8_t *msg)
 {
-  uint8_t msg[64];
-  const size_t headerLen = 3; // AA, LEN, CMD
-  const size_t crcLen    = 2;
+  const uint8_t headerLen = 4;
+  const uint8_t crcLen = 2;
 
-  const uint8_t totalLen = (uint8_t)(headerLen + payloadLen + crcLen);
-  if (totalLen > sizeof(msg)) return;
+  const size_t totalLen = headerLen + payloadLen + crcLen;
+  if (totalLen > SAT_MAX_FRAME) return 0;
 
   msg[0] = 0xAA;
-  msg[1] = totalLen;
-  msg[2] = cmd;
+  msg[1] = (uint8_t)totalLen;
+  msg[2] = 0x27;
+  msg[3] = 0x00;
 
-  if (payloadLen && payload) memcpy(&msg[3], payload, payloadLen);
+  memcpy(&msg[4], payload, payloadLen);
 
-  const uint16_t crc = crcSmartOne(msg, headerLen + payloadLen);
+  const uint16_t crc = SmartOneParser::crc(msg, headerLen + payloadLen);
 
-  // Spec order: CRC low byte, then high byte
+  // legacy raw used LO then HI — keep it exactly as you had it
   msg[headerLen + payloadLen + 0] = (uint8_t)(crc & 0xFF);
   msg[headerLen + payloadLen + 1] = (uint8_t)((crc >> 8) & 0xFF);
+  return totalLen;
+}
 
-  wakeSat();
-  delay(2);
+static bool enqueue(const uint8_t *frame, size_t len, bool expectResponse, bool anyResponse,
+                    uint32_t timeoutMs, uint8_t attempts, SatCom::Callback done)
+{
+  if (!frame || len < 3 || len > SAT_MAX_FRAME || queueCount >= SAT_QUEUE_DEPTH) {
+    satStats.rejected++;
+    return false;
+  }
+  Transaction &t = queue[(queueHead + queueCount) % SAT_QUEUE_DEPTH];
+  memcpy(t.frame, frame, len);
+  t.len = (uint8_t)len;
+  t.cmd = frame[2];
+  t.expectResponse = expectResponse;
+  t.anyResponse = anyResponse;
+  t.attemptsLeft = attempts ? attempts : 1;
+  t.firstAttempt = true;
+  t.timeoutMs = timeoutMs;
+  t.queuedMs = millis();
+  t.done = done;
+  queueCount++;
+  satStats.requests++;
+  return true;
+}
+
+// Retires the active transaction, then reports it; the callback may queue more.
+static void finish(SatCom::Result result, const uint8_t *frame, size_t len, uint32_t now)
+{
+  Transaction &t = queue[queueHead];
+  const SatCom::Callback done = t.done;
+  // A reply can beat the end-of-frame timer; never leave HS asserted.
+  digitalWrite(SAT_HS_PIN, HIGH);
+  satStats.lastLatencyMs = now - t.queuedMs;
+  if (result == SatCom::Result::OK) satStats.completed++;
+  queueHead = (queueHead + 1) % SAT_QUEUE_DEPTH;
+  queueCount--;
+  enterPhase(Phase::IDLE, now, 0);
+  if (done) done(result, frame, len);
+}
 
+static void startAttempt(uint32_t now)
+{
+  Transaction &t = queue[queueHead];
+  if (!t.firstAttempt) satStats.retries++;
+  t.firstAttempt = false;
+  t.attemptsLeft--;
   digitalWrite(SAT_HS_PIN, LOW);
-  delay(3);
-  Serial2.write(msg, totalLen);
-  Serial2.flush();
+  enterPhase(Phase::WAKE_LOW, now, SAT_WAKE_LOW_MS);
+}
+
+// Retry after a pause, or give up with result.
+static void attemptFailed(SatCom::Result result, uint32_t backoffMs,
+                          const uint8_t *frame, size_t len, uint32_t now)
+{
   digitalWrite(SAT_HS_PIN, HIGH);
+  if (queue[queueHead].attemptsLeft > 0) enterPhase(Phase::BACKOFF, now, backoffMs);
+  else finish(result, frame, len, now);
+}
+
+// Offers a frame to the transaction on the wire; true if it was the answer.
+static bool matchTransaction(const uint8_t *frame, size_t len, uint32_t now)
+{
+  if (phase != Phase::SENDING && phase != Phase::AWAIT) return false;
+  const Transaction &t = queue[queueHead];
+  if (!t.expectResponse) return false;
+  const uint8_t cmd = frame[2];
+  if (cmd == SAT_NAK && !t.anyResponse) {
+    satStats.naks++;
+    attemptFailed(SatCom::Result::NAK, SAT_NAK_BACKOFF_MS, frame, len, now);
+    return true;
+  }
+  if (cmd == t.cmd || t.anyResponse) {
+    finish(SatCom::Result::OK, frame, len, now);
+    return true;
+  }
+  return false;
+}
+
+static void dispatch(const uint8_t *frame, size_t len, uint32_t now)
+{
+  bool claimed = matchTransaction(frame, len, now);
+  for (size_t i = 0; i < handlerCount; i++) {
+    if (handlers[i].cmd != frame[2]) continue;
+    handlers[i].handler(frame, len);
+    claimed = true;
+  }
+  if (!claimed) unclaimedFrames++;
+}
 
-  totalTx += totalLen;
+// Moves UART bytes into the parser (never more than it has room for; the
+// rest waits in the driver buffer) and dispatches every complete frame.
+static void readRx(uint32_t now)
+{
+  size_t budget = SAT_RX_PER_POLL;
+  while (budget-- > 0 && parser.space() > 0 && Serial2.available()) {
+    const uint8_t b = (uint8_t)Serial2.read();
+    totalRx++;
+    parser.push(&b, 1);
+    lastRxByteMs = now;
+  }
+  size_t len = 0;
+  while (parser.next(rxFrame, len)) dispatch(rxFrame, len, now);
+  if (!parser.pending() || now - lastRxByteMs < SAT_RX_GAP_MS) return;
+  while (parser.abandonPartial()) {
+    while (parser.next(rxFrame, len)) dispatch(rxFrame, len, now);
+  }
+}
 
-  Serial.print("[SAT] TX: ");
-  for (size_t i = 0; i < totalLen; i++) Serial.printf("%02X ", msg[i]);
+// UART driver callback (event task): RX buffer or FIFO overflowed.
+static void onUartError(hardwareSerial_error_t err)
+{
+  if (err == UART_BUFFER_FULL_ERROR || err == UART_FIFO_OVF_ERROR) uartOverruns++;
+}
+
+static void step(uint32_t now)
+{
+  if (phase == Phase::IDLE) {
+    if (queueCount > 0) startAttempt(now);
+    return;
+  }
+  if (now - phaseStartMs < phaseMs) return;
+
+  Transaction &t = queue[queueHead];
+  switch (phase) {
+    case Phase::WAKE_LOW:
+      digitalWrite(SAT_HS_PIN, HIGH);
+      enterPhase(Phase::WAKE_HIGH, now, SAT_WAKE_HIGH_MS);
+      break;
+    case Phase::WAKE_HIGH:
+      digitalWrite(SAT_HS_PIN, LOW);
+      enterPhase(Phase::SELECT, now, SAT_SELECT_MS);
+      break;
+    case Phase::SELECT: {
+      // Only write what the TX FIFO takes at once, so write() never waits.
+      if ((size_t)Serial2.availableForWrite() < t.len) break;
+      Serial2.write(t.frame, t.len);
+      totalTx += t.len;
+      Serial.printf("[SAT] TX cmd=0x%02X len=%u (%u tries left)\n",
+                    t.cmd, (unsigned)t.len, (unsigned)t.attemptsLeft);
+      // 10 bits per byte on the wire, plus a millisecond of slack.
+      const uint32_t lineMs = (t.len * 10UL * 1000UL + SAT_BAUD - 1) / SAT_BAUD + 1;
+      enterPhase(Phase::SENDING, now, lineMs);
+      break;
+    }
+    case Phase::SENDING:
+      digitalWrite(SAT_HS_PIN, HIGH);
+      // A new message is in the modem; its last queue report is stale.
+      if (t.cmd == SmartOne::CMD_SEND_RAW) modemQueueState.known = false;
+      if (!t.expectResponse) finish(SatCom::Result::OK, nullptr, 0, now);
+      else enterPhase(Phase::AWAIT, now, t.timeoutMs);
+      break;
+    case Phase::AWAIT:
+      satStats.timeouts++;
+      attemptFailed(SatCom::Result::TIMEOUT, SAT_TIMEOUT_BACKOFF_MS, nullptr, 0, now);
+      break;
+    case Phase::BACKOFF:
+      startAttempt(now);
+      break;
+    case Phase::IDLE:
+      break;
+  }
+}
+
+static void printHex(const char *label, const uint8_t *frame, size_t len)
+{
+  Serial.print(label);
+  for (size_t i = 0; i < len; i++) Serial.printf("%02X ", frame[i]);
   Serial.println();
 }
 
+static void onIdResponse(SatCom::Result result, const uint8_t *rx, size_t n)
+{
+  idPending = false;
+  if (result != SatCom::Result::OK) {
+    Serial.printf("[SAT] getId: %s\n",
+                  result == SatCom::Result::NAK ? "NAK after retries" : "no response packet");
+    return;
+  }
+  printHex("[SAT] RX: ", rx, n);
+  SmartOne::EsnResponse rsp;
+  if (rsp.decode(rx, n)) {
+    lastIdValue = rsp.esn;
+    Serial.printf("[SAT] SmartOne ID (ESN int) = %lu (0x%08lX)\n",
+                  (unsigned long)lastIdValue, (unsigned long)lastIdValue);
+    return;
+  }
+  Serial.println("[SAT] getId: unexpected response format");
+}
+
+static void onQueueReply(SatCom::Result result, const uint8_t *rx, size_t n)
+{
+  modemQueueState.queryPending = false;
+  SmartOne::BurstsResponse rsp;
+  if (result != SatCom::Result::OK || !rsp.decode(rx, n)) {
+    if (modemQueueState.failures < 255) modemQueueState.failures++;
+    return;
+  }
+  modemQueueState.known = true;
+  modemQueueState.burstsRemaining = rsp.remaining;
+  modemQueueState.updatedMs = millis();
+  modemQueueState.failures = 0;
+}
+
+static void onHexDump(SatCom::Result result, const uint8_t *rx, size_t n)
+{
+  if (result == SatCom::Result::TIMEOUT) {
+    Serial.println("[SAT] query: no response packet");
+    return;
+  }
+  Serial.printf("[SAT] rsp (%u bytes): ", (unsigned)n);
+  printHex("", rx, n);
+}
+
 void SatCom::begin()
 {
   pinMode(SAT_HS_PIN, OUTPUT);
@@ -157,69 +358,97 @@ void SatCom::begin()
   delay(50);
   Serial2.setRxBufferSize(4096);
   Serial2.begin(SAT_BAUD, SERIAL_8N1, SAT_RX_PIN, SAT_TX_PIN);
+  Serial2.onReceiveError(onUartError);
 
   Serial.printf("[SAT] Serial2 @%lu RX=%d TX=%d HS=%d\n",
                 (unsigned long)SAT_BAUD, SAT_RX_PIN, SAT_TX_PIN, SAT_HS_PIN);
 
+  queueHead = queueCount = 0;
+  parser.reset();
+  idPending = false;
+  modemQueueState = SatCom::ModemQueue();
+  enterPhase(Phase::IDLE, millis(), 0);
   lastPrintMs = millis();
   lastRxSnapshot = totalRx;
 }
 
 void SatCom::poll()
 {
-  // Drain incoming bytes quietly
-  while (Serial2.available()) {
-    (void)Serial2.read();
-    totalRx++;
-  }
+  const uint32_t startUs = micros();
+  const uint32_t now = millis();
+  readRx(now);
+  step(now);
 
   // Once per second summary
-  const uint32_t now = millis();
   if (now - lastPrintMs >= 1000) {
     const uint32_t rxThisSec = totalRx - lastRxSnapshot;
     lastRxSnapshot = totalRx;
     lastPrintMs = now;
 
-    Serial.printf("[SAT] rxBytes/s=%lu totalRx=%lu totalTx=%lu\n",
+    const SmartOneParser::Stats &rx = parser.stats();
+    Serial.printf("[SAT] rxBytes/s=%lu totalRx=%lu totalTx=%lu frames=%lu crcErr=%lu resync=%lu queued=%u worstPollUs=%lu\n",
                   (unsigned long)rxThisSec,
                   (unsigned long)totalRx,
-                  (unsigned long)totalTx);
+                  (unsigned long)totalTx,
+                  (unsigned long)rx.frames,
+                  (unsigned long)rx.crcErrors,
+                  (unsigned long)rx.resyncs,
+                  (unsigned)queueCount,
+                  (unsigned long)satStats.worstPollUs);
   }
+  noteCallUs(startUs);
 }
 
-// Your old raw payload exercise (0x27 frame)
-// Keep it if you want, but it is NOT a “status/query” command.
-static void sendRaw27(const uint8_t *payload, size_t payloadLen)
+bool SatCom::request(uint8_t cmd, const uint8_t *payload, size_t payloadLen,
+                     Callback done, uint32_t timeoutMs, uint8_t attempts)
 {
-  uint8_t msg[64];
-  const uint8_t headerLen = 4;
-  const uint8_t crcLen = 2;
-
-  const uint8_t totalLen = (uint8_t)(headerLen + payloadLen + crcLen);
-  if (totalLen > sizeof(msg)) return;
-
-  msg[0] = 0xAA;
-  msg[1] = totalLen;
-  msg[2] = 0x27;
-  msg[3] = 0x00;
-
-  memcpy(&msg[4], payload, payloadLen);
+  const uint32_t startUs = micros();
+  uint8_t msg[SAT_MAX_FRAME];
+  const size_t len = buildCmd(cmd, payload, payloadLen, msg);
+  const bool ok = len > 0 && enqueue(msg, len, true, false, timeoutMs, attempts, done);
+  if (len == 0) satStats.rejected++;
+  noteCallUs(startUs);
+  return ok;
+}
 
-  const uint16_t crc = crcSmartOne(msg, headerLen + payloadLen);
+bool SatCom::onFrame(uint8_t cmd, FrameHandler handler)
+{
+  for (size_t i = 0; i < handlerCount; i++) {
+    if (handlers[i].cmd != cmd) continue;
+    if (handler) {
+      handlers[i].handler = handler;
+    } else {
+      handlers[i] = handlers[--handlerCount];
+    }
+    return true;
+  }
+  if (!handler) return true;
+  if (handlerCount >= SAT_MAX_HANDLERS) return false;
+  handlers[handlerCount++] = {cmd, handler};
+  return true;
+}
 
-  // legacy raw used LO then HI — keep it exactly as you had it
-  msg[headerLen + payloadLen + 0] = (uint8_t)(crc & 0xFF);
-  msg[headerLen + payloadLen + 1] = (uint8_t)((crc >> 8) & 0xFF);
+SatCom::RxStats SatCom::rxStats()
+{
+  const SmartOneParser::Stats &p = parser.stats();
+  RxStats out;
+  out.frames = p.frames;
+  out.crcErrors = p.crcErrors;
+  out.resyncs = p.resyncs;
+  out.discarded = p.discarded;
+  out.overruns = uartOverruns;
+  out.unclaimed = unclaimedFrames;
+  return out;
+}
 
-  wakeSat();
-  digitalWrite(SAT_HS_PIN, LOW);
-  delay(3);
-  Serial2.write(msg, totalLen);
-  Serial2.flush();
-  digitalWrite(SAT_HS_PIN, HIGH);
+bool SatCom::busy()
+{
+  return queueCount > 0;
+}
 
-  totalTx += totalLen;
-  Serial.printf("[SAT] sent raw27 len=%u\n", totalLen);
+const SatCom::Stats &SatCom::stats()
+{
+  return satStats;
 }
 
 void SatCom::ping()
@@ -227,128 +456,91 @@ void SatCom::ping()
   Serial.println("[SAT] ping()");
 
   const uint8_t payload[] = {0xDE, 0xAD, 0xBE, 0xEF};
-  sendRaw27(payload, sizeof(payload));
+  uint8_t msg[SAT_MAX_FRAME];
+  const size_t len = buildRaw27(payload, sizeof(payload), msg);
 
-  Serial.println("[SAT] listening 1000ms for response (hex)...");
-  drainForMs(1000, true);
+  // Whatever comes back within 1000 ms is dumped as hex.
+  if (enqueue(msg, len, true, true, 1000, 1, onHexDump)) {
+    Serial.println("[SAT] ping queued, listening 1000ms for response (hex)...");
+  }
 }
 
-void SatCom::sendRawFrame(const uint8_t *frame, size_t len)
+bool SatCom::sendRawFrame(const uint8_t *frame, size_t len, Callback done)
 {
-  if (!frame || len == 0) return;
-
-  wakeSat();
-  digitalWrite(SAT_HS_PIN, LOW);
-  delay(3);
-  Serial2.write(frame, len);
-  Serial2.flush();
-  digitalWrite(SAT_HS_PIN, HIGH);
-
-  totalTx += len;
-  Serial.printf("[SAT] sent raw frame len=%u\n", (unsigned)len);
+  const uint32_t startUs = micros();
+  const bool ok = enqueue(frame, len, false, false, 0, 1, done);
+  if (ok) Serial.printf("[SAT] queued raw frame len=%u\n", (unsigned)len);
+  else Serial.printf("[SAT] raw frame len=%u rejected (queue full)\n", (unsigned)len);
+  noteCallUs(startUs);
+  return ok;
 }
 
 void SatCom::getIdAndPrint()
 {
+  if (idPending) return;
   Serial.println("[SAT] getId (0x01) ...");
+  idPending = request(SmartOne::CMD_QUERY_ESN, nullptr, 0, onIdResponse, 1500, 5);
+}
 
-  for (int attempt = 1; attempt <= 5; attempt++) {
-    Serial.printf("[SAT] attempt %d\n", attempt);
-
-    sendCmd(0x01, nullptr, 0);
-
-    uint8_t rx[64];
-    size_t n = 0;
-    if (!readPacket(rx, sizeof(rx), n, 1500)) {
-      Serial.println("[SAT] getId: no response packet");
-      delay(250);
-      continue;
-    }
-
-    Serial.print("[SAT] RX: ");
-    for (size_t i = 0; i < n; i++) Serial.printf("%02X ", rx[i]);
-    Serial.println();
-
-    const uint8_t cmd = rx[2];
-    Serial.printf("[SAT] rsp cmd=0x%02X len=%u\n", cmd, (unsigned)rx[1]);
-
-    // NAK/busy → retry
-    if (cmd == 0xFF) {
-      delay(400);
-      continue;
-    }
+bool SatCom::getId(uint32_t &id)
+{
+  if (lastIdValue != 0) {
+    id = lastIdValue;
+    return true;
+  }
+  if (!idPending) idPending = request(SmartOne::CMD_QUERY_ESN, nullptr, 0, onIdResponse, 1500, 3);
+  return false;
+}
 
-    if (cmd == 0x01 && rx[1] == 0x09) {
-      uint32_t id =
-        ((uint32_t)rx[3] << 24) |
-        ((uint32_t)rx[4] << 16) |
-        ((uint32_t)rx[5] <<  8) |
-        ((uint32_t)rx[6] <<  0);
-
-      lastIdValue = id;
-      Serial.printf("[SAT] SmartOne ID (ESN int) = %lu (0x%08lX)\n",
-                    (unsigned long)id, (unsigned long)id);
-      return;
-    }
+uint32_t SatCom::lastId()
+{
+  return lastIdValue;
+}
 
-    Serial.println("[SAT] getId: unexpected response format");
-    return;
-  }
+bool SatCom::queryQueue()
+{
+  if (modemQueueState.queryPending) return true;
+  modemQueueState.queryPending = request(SmartOne::CMD_QUERY_BURSTS, nullptr, 0, onQueueReply, 1000, 2);
+  return modemQueueState.queryPending;
+}
 
-  Serial.println("[SAT] getId: giving up after retries");
+const SatCom::ModemQueue &SatCom::modemQueue()
+{
+  return modemQueueState;
 }
 
-bool SatCom::getId(uint32_t &id)
+bool SatCom::abortTransmission(Callback done)
 {
-  for (int attempt = 1; attempt <= 3; attempt++) {
-    sendCmd(0x01, nullptr, 0);
+  modemQueueState.known = false;
+  return request(SmartOne::CMD_ABORT, nullptr, 0, done);
+}
 
-    uint8_t rx[64];
-    size_t n = 0;
-    if (!readPacket(rx, sizeof(rx), n, 1500)) {
-      delay(200);
-      continue;
-    }
+bool SatCom::configure(const SmartOne::Setup &setup, Callback done)
+{
+  uint8_t payload[SmartOne::Setup::kPayloadLen];
+  const size_t len = setup.encode(payload);
+  return request(SmartOne::CMD_SETUP, payload, len, done);
+}
 
-    const uint8_t cmd = rx[2];
-    if (cmd == 0xFF) {
-      delay(400);
-      continue;
-    }
+bool SatCom::querySetup(Callback done)
+{
+  return request(SmartOne::CMD_QUERY_SETUP, nullptr, 0, done);
+}
 
-    if (cmd == 0x01 && rx[1] == 0x09) {
-      id =
-        ((uint32_t)rx[3] << 24) |
-        ((uint32_t)rx[4] << 16) |
-        ((uint32_t)rx[5] <<  8) |
-        ((uint32_t)rx[6] <<  0);
-      lastIdValue = id;
-      return true;
-    }
-    return false;
-  }
-  return false;
+bool SatCom::queryFirmware(Callback done)
+{
+  return request(SmartOne::CMD_QUERY_FIRMWARE, nullptr, 0, done);
 }
 
-uint32_t SatCom::lastId()
+bool SatCom::queryHardware(Callback done)
 {
-  return lastIdValue;
+  return request(SmartOne::CMD_QUERY_HARDWARE, nullptr, 0, done);
 }
 
 void SatCom::queryAndHexDump(uint8_t cmd, const uint8_t *payload, size_t payloadLen, uint32_t timeoutMs)
 {
   Serial.printf("[SAT] query cmd=0x%02X ...\n", cmd);
-
-  sendCmd(cmd, payload, payloadLen);
-
-  uint8_t rx[128];
-  size_t n = 0;
-  if (!readPacket(rx, sizeof(rx), n, timeoutMs)) {
-    Serial.println("[SAT] query: no response packet");
-    return;
+  if (!request(cmd, payload, payloadLen, onHexDump, timeoutMs, 1)) {
+    Serial.println("[SAT] query: queue full");
   }
-
-  Serial.printf("[SAT] rsp (%u bytes): ", (unsigned)n);
-  for (size_t i = 0; i < n; i++) Serial.printf("%02X ", rx[i]);
-  Serial.println();
 }
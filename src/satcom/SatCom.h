@@ -1,22 +1,101 @@
 // src/satcom/SatCom.h
 #pragma once
 #include <Arduino.h>
+#include "satcom/SmartOneCommands.h"
 
+// SmartOne C driver. Nothing here blocks: commands are queued as
+// transactions and poll() (called every loop()) steps the handshake-pin
+// sequence, the UART and the response timers. One transaction is on the
+// wire at a time; its response is the next frame carrying the same command
+// code, or a NAK (0xFF). Every CRC-checked frame is also offered to the
+// handler registered for its command code, solicited or not.
 class SatCom {
 public:
+  enum class Result : uint8_t {
+    OK,       // response frame received (or, with no response expected, sent)
+    NAK,      // modem answered 0xFF on the last attempt
+    TIMEOUT,  // no response on the last attempt
+  };
+
+  // Completion hook, called from poll(). frame/len are the whole response
+  // (AA LEN CMD ... CRC) for OK and NAK, nullptr/0 otherwise.
+  typedef void (*Callback)(Result result, const uint8_t *frame, size_t len);
+
+  // Called from poll() with the whole frame (AA LEN CMD ... CRC).
+  typedef void (*FrameHandler)(const uint8_t *frame, size_t len);
+
+  struct RxStats {
+    uint32_t frames = 0;     // frames that passed the CRC
+    uint32_t crcErrors = 0;  // complete frames with a bad CRC
+    uint32_t resyncs = 0;    // sync losses: junk, bad LEN or bad CRC
+    uint32_t discarded = 0;  // bytes skipped while resynchronising
+    uint32_t overruns = 0;   // UART driver buffer/FIFO overflows
+    uint32_t unclaimed = 0;  // frames no request or handler took
+  };
+
+  struct Stats {
+    uint32_t requests = 0;      // transactions accepted
+    uint32_t completed = 0;     // finished with OK
+    uint32_t naks = 0;          // NAK frames received
+    uint32_t timeouts = 0;      // attempts that saw no response
+    uint32_t retries = 0;       // attempts after the first
+    uint32_t rejected = 0;      // queue full or frame too long
+    uint32_t lastLatencyMs = 0; // queue-to-completion of the last transaction
+    uint32_t lastPollUs = 0;    // time the most recent SatCom call held loop()
+    uint32_t worstPollUs = 0;   // worst poll()/request() time since boot
+  };
+
+  // Modem's outbound queue as last reported by QUERY_BURSTS.
+  struct ModemQueue {
+    bool known = false;           // a reply has arrived since the last send
+    uint8_t burstsRemaining = 0;  // 0: nothing left to transmit
+    uint32_t updatedMs = 0;
+    bool queryPending = false;
+    uint8_t failures = 0;         // consecutive queries without a reply
+  };
+
   static void begin();
   static void poll();
 
+  // Queues cmd with payload. Never blocks; false when the queue is full or
+  // the frame does not fit.
+  static bool request(uint8_t cmd,
+                      const uint8_t *payload = nullptr,
+                      size_t payloadLen = 0,
+                      Callback done = nullptr,
+                      uint32_t timeoutMs = 1500,
+                      uint8_t attempts = 3);
+  static bool busy();
+
+  // One handler per command code (0xFF for NAKs); registering again
+  // replaces it, nullptr removes it. False when the table is full.
+  static bool onFrame(uint8_t cmd, FrameHandler handler);
+  static RxStats rxStats();
+  static const Stats &stats();
+
   // Legacy raw payload exercise (0x27 frame)
   static void ping();
-  static void sendRawFrame(const uint8_t *frame, size_t len);
+  // Queues a prebuilt frame; no response is expected, so done (if any)
+  // reports OK once it is on the wire.
+  static bool sendRawFrame(const uint8_t *frame, size_t len, Callback done = nullptr);
 
-  // Documented command: Get ID (0x01)
+  // Documented command: Get ID (0x01). getId() returns the cached ID, and
+  // queues a query (at most one at a time) until one has been read.
   static void getIdAndPrint();
   static bool getId(uint32_t &id);
   static uint32_t lastId();
 
-  // Generic documented command helper (prints response as hex)
+  // Typed SmartOne commands (SmartOneCommands.h). Callbacks get the raw
+  // reply; decode it with the matching response struct.
+  static bool queryQueue();
+  static const ModemQueue &modemQueue();
+  static bool abortTransmission(Callback done = nullptr);
+  static bool configure(const SmartOne::Setup &setup, Callback done = nullptr);
+  static bool querySetup(Callback done);
+  static bool queryFirmware(Callback done);
+  static bool queryHardware(Callback done);
+
+  // Generic documented command helper (prints response as hex when it arrives)
   static void queryAndHexDump(uint8_t cmd,
                               const uint8_t *payload = nullptr,
                               size_t payloadLen = 0,
@@ -0,0 +1,74 @@
+// src/satcom/SmartOneCommands.cpp
+#include "satcom/SmartOneCommands.h"
+
+namespace SmartOne {
+
+const uint8_t *payload(const uint8_t *frame, size_t len, Command cmd, size_t minPayload)
+{
+  if (!frame || len < kHeaderLen + minPayload + kCrcLen) return nullptr;
+  if (frame[0] != 0xAA || frame[1] != len || frame[2] != cmd) return nullptr;
+  return frame + kHeaderLen;
+}
+
+bool Ack::decode(const uint8_t *frame, size_t len, Command cmd)
+{
+  return payload(frame, len, cmd, 0) != nullptr;
+}
+
+bool EsnResponse::decode(const uint8_t *frame, size_t len)
+{
+  const uint8_t *p = payload(frame, len, CMD_QUERY_ESN, 4);
+  if (!p) return false;
+  esn = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+  return true;
+}
+
+bool BurstsResponse::decode(const uint8_t *frame, size_t len)
+{
+  const uint8_t *p = payload(frame, len, CMD_QUERY_BURSTS, 1);
+  if (!p) return false;
+  remaining = p[0];
+  return true;
+}
+
+bool FirmwareResponse::decode(const uint8_t *frame, size_t len)
+{
+  const uint8_t *p = payload(frame, len, CMD_QUERY_FIRMWARE, 2);
+  if (!p) return false;
+  major = p[0];
+  minor = p[1];
+  return true;
+}
+
+bool HardwareResponse::decode(const uint8_t *frame, size_t len)
+{
+  const uint8_t *p = payload(frame, len, CMD_QUERY_HARDWARE, 4);
+  if (!p) return false;
+  deviceCode = (uint16_t)((p[0] << 8) | p[1]);
+  cpuRevision = p[2];
+  radioRevision = p[3];
+  return true;
+}
+
+size_t Setup::encode(uint8_t *out) const
+{
+  memset(out, 0, kPayloadLen);
+  out[4] = rfChannel;
+  out[5] = bursts;
+  out[6] = minInterval;
+  out[7] = maxInterval;
+  return kPayloadLen;
+}
+
+bool Setup::decode(const uint8_t *frame, size_t len)
+{
+  const uint8_t *p = payload(frame, len, CMD_QUERY_SETUP, 8);
+  if (!p) return false;
+  rfChannel = p[4];
+  bursts = p[5];
+  minInterval = p[6];
+  maxInterval = p[7];
+  return true;
+}
+
+}  // namespace SmartOne
@@ -0,0 +1,68 @@
+// src/satcom/SmartOneCommands.h
+#pragma once
+#include <Arduino.h>
+
+// SmartOne C serial commands as typed requests and responses. Requests
+// encode only their payload (SatCom adds AA LEN CMD and the CRC);
+// responses decode a whole CRC-checked frame and refuse one that is too
+// short or carries another command code.
+namespace SmartOne {
+  enum Command : uint8_t {
+    CMD_QUERY_ESN = 0x01,
+    CMD_ABORT = 0x03,           // drop the message being sent, clearing the queue
+    CMD_QUERY_BURSTS = 0x04,    // bursts left for the queued message; 0 = idle
+    CMD_QUERY_FIRMWARE = 0x05,
+    CMD_SETUP = 0x06,
+    CMD_QUERY_SETUP = 0x07,
+    CMD_QUERY_HARDWARE = 0x09,
+    CMD_SEND_RAW = 0x27,
+    CMD_NAK = 0xFF,
+  };
+
+  constexpr size_t kHeaderLen = 3;  // AA LEN CMD
+  constexpr size_t kCrcLen = 2;
+
+  // Payload of a frame that carries cmd and at least minPayload bytes.
+  const uint8_t *payload(const uint8_t *frame, size_t len, Command cmd, size_t minPayload);
+
+  // Acknowledgement with no payload (ABORT, SETUP).
+  struct Ack {
+    bool decode(const uint8_t *frame, size_t len, Command cmd);
+  };
+
+  struct EsnResponse {
+    uint32_t esn = 0;
+    bool decode(const uint8_t *frame, size_t len);
+  };
+
+  struct BurstsResponse {
+    uint8_t remaining = 0;
+    bool decode(const uint8_t *frame, size_t len);
+  };
+
+  struct FirmwareResponse {
+    uint8_t major = 0;
+    uint8_t minor = 0;
+    bool decode(const uint8_t *frame, size_t len);
+  };
+
+  struct HardwareResponse {
+    uint16_t deviceCode = 0;
+    uint8_t cpuRevision = 0;
+    uint8_t radioRevision = 0;
+    bool decode(const uint8_t *frame, size_t len);
+  };
+
+  // SETUP request and QUERY_SETUP response share this layout: four
+  // reserved bytes, RF channel, bursts per message, then the minimum and
+  // maximum gap between bursts in 5 s units.
+  struct Setup {
+    static constexpr size_t kPayloadLen = 9;
+    uint8_t rfChannel = 0;
+    uint8_t bursts = 3;
+    uint8_t minInterval = 1;
+    uint8_t maxInterval = 2;
+    size_t encode(uint8_t *out) const;
+    bool decode(const uint8_t *frame, size_t len);
+  };
+}
@@ -0,0 +1,94 @@
+// src/satcom/SmartOneParser.cpp
+#include "satcom/SmartOneParser.h"
+
+static const uint8_t SYNC = 0xAA;
+
+void SmartOneParser::reset()
+{
+  _head = 0;
+  _count = 0;
+  _inJunk = false;
+  _stats = Stats();
+}
+
+size_t SmartOneParser::push(const uint8_t *data, size_t len)
+{
+  const size_t n = min(len, space());
+  for (size_t i = 0; i < n; i++) _buf[(_head + _count + i) % kCapacity] = data[i];
+  _count += n;
+  return n;
+}
+
+void SmartOneParser::drop(size_t n)
+{
+  _head = (_head + n) % kCapacity;
+  _count -= n;
+}
+
+// Gives up on the 0xAA at the head and scans on from the next byte.
+void SmartOneParser::resync()
+{
+  _stats.resyncs++;
+  _stats.discarded++;
+  _inJunk = true;
+  drop(1);
+}
+
+bool SmartOneParser::abandonPartial()
+{
+  if (_count == 0) return false;
+  resync();
+  return true;
+}
+
+bool SmartOneParser::next(uint8_t *out, size_t &len)
+{
+  len = 0;
+  while (_count > 0) {
+    if (peek(0) != SYNC) {
+      // One resync per run of junk, however long.
+      if (!_inJunk) _stats.resyncs++;
+      _inJunk = true;
+      _stats.discarded++;
+      drop(1);
+      continue;
+    }
+    _inJunk = false;
+    if (_count < 2) return false;
+    const size_t frameLen = peek(1);
+    if (frameLen < kMinFrame) {
+      resync();
+      continue;
+    }
+    if (_count < frameLen) return false;
+
+    for (size_t i = 0; i < frameLen; i++) out[i] = peek(i);
+    const uint16_t want = (uint16_t)out[frameLen - 2] | ((uint16_t)out[frameLen - 1] << 8);
+    if (crc(out, frameLen - 2) != want) {
+      _stats.crcErrors++;
+      resync();
+      continue;
+    }
+    drop(frameLen);
+    _stats.frames++;
+    len = frameLen;
+    return true;
+  }
+  return false;
+}
+
+// -------- CRC helper (same algo as your legacy code) --------
+uint16_t SmartOneParser::crc(const uint8_t *data, size_t len)
+{
+  uint16_t crc = 0xFFFF;
+  while (len--) {
+    uint16_t d = 0x00FF & *data++;
+    crc ^= d;
+    for (uint8_t i = 0; i < 8; i++) {
+      if (crc & 0x0001) crc = (crc >> 1) ^ 0x8408;
+      else             crc >>= 1;
+    }
+  }
+  crc = ~crc;
+  return crc;
+}
@@ -0,0 +1,49 @@
+// src/satcom/SmartOneParser.h
+#pragma once
+#include <Arduino.h>
+
+// Incremental SmartOne frame parser: AA LEN CMD payload CRC(lo, hi), LEN
+// counting the whole frame. Bytes are pushed into a ring buffer as they come
+// off the UART and frames are pulled out once complete and CRC-checked. A
+// bad length or CRC drops only the leading 0xAA, so a real frame that
+// started inside the rejected one is still found.
+class SmartOneParser {
+public:
+  static constexpr size_t kCapacity = 512;
+  static constexpr size_t kMaxFrame = 255;
+  static constexpr size_t kMinFrame = 5;
+
+  struct Stats {
+    uint32_t frames = 0;     // frames that passed the CRC
+    uint32_t crcErrors = 0;  // complete frames with a bad CRC
+    uint32_t resyncs = 0;    // times sync was lost: junk, bad LEN or bad CRC
+    uint32_t discarded = 0;  // bytes skipped while resynchronising
+  };
+
+  void reset();
+  size_t space() const { return kCapacity - _count; }
+  // Appends up to space() bytes; returns how many were taken.
+  size_t push(const uint8_t *data, size_t len);
+  // Copies the next verified frame into out (kMaxFrame bytes). False when
+  // the buffer holds no complete frame yet.
+  bool next(uint8_t *out, size_t &len);
+  // For when the line has gone quiet with a partial frame buffered: gives
+  // up on its 0xAA, so a false start cannot hold the frames behind it
+  // until LEN bytes arrive. False when nothing is buffered.
+  bool abandonPartial();
+  bool pending() const { return _count > 0; }
+  const Stats &stats() const { return _stats; }
+
+  static uint16_t crc(const uint8_t *data, size_t len);
+
+private:
+  uint8_t peek(size_t i) const { return _buf[(_head + i) % kCapacity]; }
+  void drop(size_t n);
+  void resync();
+
+  uint8_t _buf[kCapacity];
+  size_t _head = 0;
+  size_t _count = 0;
+  bool _inJunk = false;
+  Stats _stats;
+};
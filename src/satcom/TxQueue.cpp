@@ -0,0 +1,367 @@
+#include "satcom/TxQueue.h"
+#include <LittleFS.h>
+#include "satcom/SatCom.h"
+#include "satcom/SmartOneParser.h"
+
+namespace {
+  constexpr size_t kCapacity = 16;
+  constexpr size_t kMaxFrame = 64;
+  // Compacted to the live frames at boot and whenever it outgrows this.
+  constexpr uint32_t kMaxLogBytes = 8192;
+  // Pause after SatCom refused or failed a frame.
+  constexpr uint32_t kRetryMs = 5000;
+  // Modem flow control: a frame goes out only on a QUERY_BURSTS reply
+  // younger than kQueueFreshMs saying the modem has nothing left to send.
+  // While it is still transmitting it is asked again every kQueuePollMs.
+  // After kQueryFailLimit unanswered queries, sends are paced
+  // kUnthrottledGapMs apart instead.
+  constexpr uint32_t kQueueFreshMs = 5000;
+  constexpr uint32_t kQueuePollMs = 15000;
+  constexpr uint8_t kQueryFailLimit = 3;
+  constexpr uint32_t kUnthrottledGapMs = 30000;
+
+  // Log record: kind, arg, frame length, seq (u32 LE), frame, CRC-16 of
+  // everything before it. ENQUEUE carries the priority and the frame;
+  // RETIRE carries why the frame left the queue.
+  constexpr uint8_t kRecEnqueue = 'E';
+  constexpr uint8_t kRecRetire = 'R';
+  constexpr size_t kRecHeaderLen = 7;
+  constexpr size_t kRecCrcLen = 2;
+
+  enum Retire : uint8_t { RETIRE_SENT = 0, RETIRE_DROPPED = 1, RETIRE_COALESCED = 2 };
+
+  struct Entry {
+    uint32_t seq;
+    uint32_t queuedMs;
+    TxQueue::Priority priority;
+    uint8_t len;
+    uint8_t frame[kMaxFrame];
+  };
+
+  Entry s_entries[kCapacity];
+  size_t s_count = 0;
+  uint32_t s_nextSeq = 1;
+  bool s_inFlight = false;
+  uint32_t s_inFlightSeq = 0;
+  uint32_t s_retryAtMs = 0;
+  bool s_retryPending = false;
+  bool s_sentAny = false;
+  uint32_t s_lastSendMs = 0;
+  uint32_t s_lastQueryMs = 0;
+  uint32_t s_lastBusyReplyMs = 0;
+  TxQueue::Priority s_lastSentPriority = TxQueue::Priority::ROUTINE;
+  bool s_abortSent = false;
+  String s_logPath;
+  String s_tmpPath;
+  bool s_ready = false;
+  TxQueue::Stats s_stats;
+
+  int findSeq(uint32_t seq)
+  {
+    for (size_t i = 0; i < s_count; i++) {
+      if (s_entries[i].seq == seq) return (int)i;
+    }
+    return -1;
+  }
+
+  void removeAt(size_t i)
+  {
+    s_entries[i] = s_entries[--s_count];
+    s_stats.depth = s_count;
+  }
+
+  size_t encodeRecord(uint8_t kind, uint8_t arg, uint32_t seq, const uint8_t *frame, uint8_t len, uint8_t *out)
+  {
+    out[0] = kind;
+    out[1] = arg;
+    out[2] = len;
+    for (int i = 0; i < 4; i++) out[3 + i] = (uint8_t)(seq >> (8 * i));
+    if (len) memcpy(out + kRecHeaderLen, frame, len);
+    const uint16_t crc = SmartOneParser::crc(out, kRecHeaderLen + len);
+    out[kRecHeaderLen + len + 0] = (uint8_t)(crc & 0xFF);
+    out[kRecHeaderLen + len + 1] = (uint8_t)((crc >> 8) & 0xFF);
+    return kRecHeaderLen + len + kRecCrcLen;
+  }
+
+  void compact();
+
+  // Each record is one write() and close(); LittleFS commits on close, so a
+  // power cut leaves at worst a torn last record, which begin() drops.
+  void appendRecord(uint8_t kind, uint8_t arg, uint32_t seq, const uint8_t *frame = nullptr, uint8_t len = 0)
+  {
+    if (!s_ready) return;
+    uint8_t rec[kRecHeaderLen + kMaxFrame + kRecCrcLen];
+    const size_t n = encodeRecord(kind, arg, seq, frame, len, rec);
+    File f = LittleFS.open(s_logPath.c_str(), "a");
+    if (!f) {
+      Serial.printf("[SATQ] failed to open %s\n", s_logPath.c_str());
+      return;
+    }
+    const bool ok = f.write(rec, n) == n;
+    f.close();
+    if (!ok) Serial.printf("[SATQ] failed to append to %s\n", s_logPath.c_str());
+    s_stats.logBytes += n;
+    if (s_stats.logBytes > kMaxLogBytes) compact();
+  }
+
+  // Removed before logging, so a compaction the append triggers already
+  // leaves the frame out.
+  void retire(size_t i, Retire why)
+  {
+    const uint32_t seq = s_entries[i].seq;
+    removeAt(i);
+    appendRecord(kRecRetire, why, seq);
+  }
+
+  // Rewrites the log as one ENQUEUE per live frame, aside and renamed like
+  // the geofence blob.
+  void compact()
+  {
+    File f = LittleFS.open(s_tmpPath.c_str(), "w");
+    if (!f) {
+      Serial.printf("[SATQ] failed to open %s\n", s_tmpPath.c_str());
+      return;
+    }
+    uint8_t rec[kRecHeaderLen + kMaxFrame + kRecCrcLen];
+    uint32_t total = 0;
+    bool ok = true;
+    for (size_t i = 0; ok && i < s_count; i++) {
+      const Entry &e = s_entries[i];
+      const size_t n = encodeRecord(kRecEnqueue, (uint8_t)e.priority, e.seq, e.frame, e.len, rec);
+      ok = f.write(rec, n) == n;
+      total += n;
+    }
+    f.close();
+    if (ok) {
+      LittleFS.remove(s_logPath.c_str());
+      ok = LittleFS.rename(s_tmpPath.c_str(), s_logPath.c_str());
+    }
+    if (!ok) {
+      LittleFS.remove(s_tmpPath.c_str());
+      Serial.printf("[SATQ] failed to compact %s\n", s_logPath.c_str());
+      return;
+    }
+    s_stats.logBytes = total;
+  }
+
+  // Frame to evict for one of priority p: the oldest of the lowest class
+  // below p, never the one on the wire.
+  int evictionVictim(TxQueue::Priority p)
+  {
+    int victim = -1;
+    for (size_t i = 0; i < s_count; i++) {
+      const Entry &e = s_entries[i];
+      if (e.priority >= p || (s_inFlight && e.seq == s_inFlightSeq)) continue;
+      if (victim < 0 || e.priority < s_entries[victim].priority ||
+          (e.priority == s_entries[victim].priority && e.seq < s_entries[victim].seq)) {
+        victim = (int)i;
+      }
+    }
+    return victim;
+  }
+
+  // Rebuilds the queue from the log; stops at the first record that is
+  // short or fails its CRC (the write a power cut interrupted).
+  void recover()
+  {
+    // A cut between compact()'s remove and rename leaves only the copy.
+    if (!LittleFS.exists(s_logPath.c_str()) && LittleFS.exists(s_tmpPath.c_str())) {
+      LittleFS.rename(s_tmpPath.c_str(), s_logPath.c_str());
+    }
+    File f = LittleFS.open(s_logPath.c_str(), "r");
+    if (!f) return;
+    const uint32_t size = (uint32_t)f.size();
+    uint32_t pos = 0;
+    uint8_t rec[kRecHeaderLen + kMaxFrame + kRecCrcLen];
+    while (pos + kRecHeaderLen + kRecCrcLen <= size) {
+      if (f.read(rec, kRecHeaderLen) != kRecHeaderLen) break;
+      const uint8_t kind = rec[0];
+      const uint8_t len = rec[2];
+      if ((kind != kRecEnqueue && kind != kRecRetire) || len > kMaxFrame ||
+          (kind == kRecRetire && len != 0)) {
+        break;
+      }
+      const size_t rest = len + kRecCrcLen;
+      if (f.read(rec + kRecHeaderLen, rest) != rest) break;
+      const uint16_t want = (uint16_t)rec[kRecHeaderLen + len] | ((uint16_t)rec[kRecHeaderLen + len + 1] << 8);
+      if (SmartOneParser::crc(rec, kRecHeaderLen + len) != want) break;
+      pos += kRecHeaderLen + rest;
+
+      const uint32_t seq = (uint32_t)rec[3] | ((uint32_t)rec[4] << 8) |
+                           ((uint32_t)rec[5] << 16) | ((uint32_t)rec[6] << 24);
+      if (seq >= s_nextSeq) s_nextSeq = seq + 1;
+      if (kind == kRecRetire) {
+        const int i = findSeq(seq);
+        if (i >= 0) removeAt((size_t)i);
+        continue;
+      }
+      const TxQueue::Priority p = (TxQueue::Priority)min<uint8_t>(rec[1], (uint8_t)TxQueue::Priority::TERMINATION);
+      if (s_count >= kCapacity) {
+        const int victim = evictionVictim(p);
+        if (victim < 0) continue;
+        removeAt((size_t)victim);
+      }
+      Entry &e = s_entries[s_count++];
+      e.seq = seq;
+      e.queuedMs = millis();
+      e.priority = p;
+      e.len = len;
+      memcpy(e.frame, rec + kRecHeaderLen, len);
+    }
+    f.close();
+    s_stats.tornBytes = size - pos;
+    s_stats.recovered = s_count;
+    s_stats.depth = s_count;
+  }
+
+  // Highest priority first, oldest first within a class.
+  int nextToSend()
+  {
+    int best = -1;
+    for (size_t i = 0; i < s_count; i++) {
+      const Entry &e = s_entries[i];
+      if (best < 0 || e.priority > s_entries[best].priority ||
+          (e.priority == s_entries[best].priority && e.seq < s_entries[best].seq)) {
+        best = (int)i;
+      }
+    }
+    return best;
+  }
+
+  // True when the modem can take the next frame (of priority p). Otherwise
+  // asks for its queue state when due; a termination alert waiting behind
+  // a routine position aborts it once. A geofence alert is left to finish:
+  // onSent() already retired it, so an abort would lose it, while a routine
+  // position is superseded by the next one anyway.
+  bool modemReady(uint32_t now, TxQueue::Priority p)
+  {
+    const SatCom::ModemQueue &mq = SatCom::modemQueue();
+    if (mq.queryPending) return false;
+    const bool fresh = mq.known && now - mq.updatedMs < kQueueFreshMs;
+    if (fresh && mq.burstsRemaining == 0) return true;
+    const bool transmitting = mq.known && mq.burstsRemaining > 0;
+    if (fresh && transmitting) {
+      if (mq.updatedMs != s_lastBusyReplyMs) {
+        s_lastBusyReplyMs = mq.updatedMs;
+        s_stats.throttled++;
+      }
+      if (p == TxQueue::Priority::TERMINATION && s_lastSentPriority == TxQueue::Priority::ROUTINE &&
+          !s_abortSent && SatCom::abortTransmission()) {
+        s_abortSent = true;
+        s_stats.aborts++;
+        Serial.println("[SATQ] aborting routine transmission for termination alert");
+        return false;
+      }
+    }
+    const bool unanswered = mq.failures >= kQueryFailLimit;
+    if (unanswered && (!s_sentAny || now - s_lastSendMs >= kUnthrottledGapMs)) return true;
+    const uint32_t gap = (transmitting || unanswered) ? kQueuePollMs : 0;
+    if (now - s_lastQueryMs >= gap && SatCom::queryQueue()) s_lastQueryMs = now;
+    return false;
+  }
+
+  void onSent(SatCom::Result result, const uint8_t *, size_t)
+  {
+    s_inFlight = false;
+    const int i = findSeq(s_inFlightSeq);
+    if (i < 0) return;
+    if (result != SatCom::Result::OK) {
+      s_retryPending = true;
+      s_retryAtMs = millis() + kRetryMs;
+      return;
+    }
+    const uint32_t latency = millis() - s_entries[i].queuedMs;
+    s_stats.lastLatencyMs = latency;
+    if (latency > s_stats.worstLatencyMs) s_stats.worstLatencyMs = latency;
+    s_stats.sent++;
+    retire((size_t)i, RETIRE_SENT);
+  }
+}
+
+namespace TxQueue {
+
+void begin(const char *logPath)
+{
+  s_count = 0;
+  s_inFlight = false;
+  s_retryPending = false;
+  s_stats = Stats();
+  s_logPath = logPath;
+  s_tmpPath = s_logPath + ".tmp";
+  if (!LittleFS.begin(true)) {
+    Serial.println("[SATQ] LittleFS mount failed; queue is RAM only");
+    s_ready = false;
+    return;
+  }
+  recover();
+  s_ready = true;
+  compact();
+  Serial.printf("[SATQ] recovered %u frame(s) from %s (%u torn bytes dropped)\n",
+                (unsigned)s_stats.recovered, s_logPath.c_str(), (unsigned)s_stats.tornBytes);
+}
+
+bool push(Priority priority, const uint8_t *frame, size_t len)
+{
+  if (!frame || len == 0 || len > kMaxFrame) {
+    s_stats.dropped++;
+    return false;
+  }
+  // A fresh position makes any routine one still waiting stale.
+  if (priority == Priority::ROUTINE) {
+    for (size_t i = s_count; i-- > 0;) {
+      const Entry &e = s_entries[i];
+      if (e.priority != Priority::ROUTINE || (s_inFlight && e.seq == s_inFlightSeq)) continue;
+      retire(i, RETIRE_COALESCED);
+      s_stats.coalesced++;
+    }
+  }
+  if (s_count >= kCapacity) {
+    const int victim = evictionVictim(priority);
+    if (victim < 0) {
+      s_stats.dropped++;
+      Serial.printf("[SATQ] full, dropped priority %u frame\n", (unsigned)priority);
+      return false;
+    }
+    retire((size_t)victim, RETIRE_DROPPED);
+    s_stats.dropped++;
+  }
+  Entry &e = s_entries[s_count++];
+  e.seq = s_nextSeq++;
+  e.queuedMs = millis();
+  e.priority = priority;
+  e.len = (uint8_t)len;
+  memcpy(e.frame, frame, len);
+  s_stats.enqueued++;
+  s_stats.depth = s_count;
+  appendRecord(kRecEnqueue, (uint8_t)priority, e.seq, e.frame, e.len);
+  return true;
+}
+
+void update(uint32_t now_ms)
+{
+  if (s_inFlight || s_count == 0 || SatCom::busy()) return;
+  if (s_retryPending && (int32_t)(now_ms - s_retryAtMs) < 0) return;
+  s_retryPending = false;
+  const int i = nextToSend();
+  if (i < 0) return;
+  const Entry &e = s_entries[i];
+  if (!modemReady(now_ms, e.priority)) return;
+  s_inFlightSeq = e.seq;
+  s_inFlight = SatCom::sendRawFrame(e.frame, e.len, onSent);
+  if (s_inFlight) {
+    s_sentAny = true;
+    s_lastSendMs = now_ms;
+    s_lastSentPriority = e.priority;
+    s_abortSent = false;
+  } else {
+    s_retryPending = true;
+    s_retryAtMs = now_ms + kRetryMs;
+  }
+}
+
+const Stats &stats()
+{
+  return s_stats;
+}
+
+}  // namespace TxQueue
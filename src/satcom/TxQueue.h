@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Outbound SATCOM frames, queued by priority and handed to SatCom one at a
+// time, each once the modem reports its own queue empty. Every enqueue and
+// every retirement is appended to a LittleFS log, so frames still waiting
+// at a reboot or brown-out are recovered by begin(). A frame that was on
+// the wire when power went may go out twice; none is lost.
+namespace TxQueue {
+  enum class Priority : uint8_t {
+    ROUTINE = 0,      // periodic position; a newer one supersedes it
+    GEOFENCE = 1,     // geofence violation event
+    TERMINATION = 2,  // termination alert
+  };
+
+  struct Stats {
+    uint32_t depth = 0;           // frames waiting, including one in flight
+    uint32_t enqueued = 0;
+    uint32_t sent = 0;
+    uint32_t dropped = 0;         // rejected or evicted while full
+    uint32_t coalesced = 0;       // routine positions superseded by newer ones
+    uint32_t recovered = 0;       // frames restored from the log at boot
+    uint32_t lastLatencyMs = 0;   // enqueue (or recovery) to on-the-wire
+    uint32_t worstLatencyMs = 0;
+    uint32_t logBytes = 0;
+    uint32_t tornBytes = 0;       // log tail discarded at boot (partial write)
+    uint32_t throttled = 0;       // modem replies that held a frame back (still sending)
+    uint32_t aborts = 0;          // routine transmissions aborted for a termination alert
+  };
+
+  void begin(const char *logPath = "/satq.log");
+  void update(uint32_t now_ms);
+
+  // Queues a complete SmartOne frame. A full queue evicts its oldest
+  // lowest-priority frame for a more urgent one; otherwise false.
+  bool push(Priority priority, const uint8_t *frame, size_t len);
+
+  const Stats &stats();
+}
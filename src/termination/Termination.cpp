@@ -9,6 +9,7 @@ namespace {
   bool s_triggered = false;
   bool s_pinInit = false;
   String s_reason;
+  Termination::Hook s_hook = nullptr;
 
   void ensureRelayReady()
   {
@@ -26,11 +27,19 @@ void Termination::trigger(const char *reason)
   ensureRelayReady();
   s_triggered = true;
   s_reason = reason ? reason : "";
+  if (s_hook) {
+    s_hook(s_reason.c_str());
+  }
   digitalWrite(kRelayPin, kRelayOnLevel);
   delay(kRelayDurationMs);
   digitalWrite(kRelayPin, kRelayOffLevel);
 }
 
+void Termination::onTrigger(Hook hook)
+{
+  s_hook = hook;
+}
+
 bool Termination::triggered()
 {
   return s_triggered;
@@ -3,8 +3,13 @@
 #include <Arduino.h>
 
 namespace Termination {
-  // Marks the system as terminated and records the reason (no hardware action yet).
+  // Called by trigger() with the reason, before the relay fires.
+  typedef void (*Hook)(const char *reason);
+
+  // Marks the system as terminated, records the reason and pulses the relay.
   void trigger(const char *reason);
+  // One hook for every termination path, so alerts don't depend on the caller.
+  void onTrigger(Hook hook);
   bool triggered();
   const char *reason();
   void reset();
@@ -4,21 +4,33 @@
 #include <ESPAsyncWebServer.h>
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
 
 #include "core/ConfigStore.h"
 #include "core/SystemStatus.h"
 #include "geofence/GeoFence.h"
+#include "geofence/GeoMath.h"
+#include "geofence/SuaCatalog.h"
 #include "gps/GPSControl.h"
 #include "mission/MissionController.h"
 #include "satcom/SatCom.h"
+#include "satcom/TxQueue.h"
 
 static const char* AP_SSID = "SABER-T2C";
 static const char* GEOFENCE_PATH = "/geofence.json";
 static const char* GEOFENCE_DB_PATH = "/geofence_db.json";
 static const char* MISSION_LIBRARY_PATH = "/mission_library.json";
+// Largest planned track body /api/geofence/validate buffers (~1500 points).
+static const size_t VALIDATE_BODY_MAX = 48 * 1024;
 
 static AsyncWebServer server(80);
 static ConfigStore store("/mission_active.json");
+// Set by POST /api/geofence once the rules are saved. loop() clears it and
+// reloads, so the full load (index, grid, blob) stays off the AsyncTCP task;
+// a save during that load sets it again for the next pass.
+static std::atomic<bool> geofenceReloadRequested(false);
 
 // Default config returned when file is missing/corrupt
 static void fillDefaults(JsonDocument& doc) {
@@ -76,6 +88,185 @@ static bool saveJsonFile(const char* path, const JsonDocument& doc) {
   return true;
 }
 
+// /api/sua/near and /api/sua/bbox answer from the on-device catalog index,
+// so the portal no longer downloads the whole catalog to find a few areas.
+static constexpr size_t SUA_DEFAULT_LIMIT = 50;
+static constexpr size_t SUA_MAX_LIMIT = 100;
+static constexpr float SUA_MAX_RADIUS_KM = 300.0f;
+
+// One area as JSON: name, type, band, bbox, distance (near queries) and
+// the decoded rings in the portal's segment form. The document is sized
+// from a counting pass over the geometry.
+static bool suaAreaJson(uint32_t idx, float distM, bool geometry, String &out) {
+  SuaCatalog::Entry e;
+  char name[64];
+  char type[16];
+  if (!SuaCatalog::entry(idx, e) || !SuaCatalog::name(e, name, sizeof(name))) return false;
+  if (!SuaCatalog::typeCode(e, type, sizeof(type))) type[0] = '\0';
+
+  SuaCatalog::GeometryReader rd;
+  SuaCatalog::Segment seg;
+  uint16_t segs = 0;
+  size_t rings = 0, lines = 0, arcs = 0;
+  if (geometry) {
+    if (!rd.open(e)) return false;
+    while (rd.nextRing(segs)) {
+      rings++;
+      while (rd.nextSegment(seg)) (seg.type == SuaCatalog::SEG_ARC ? arcs : lines)++;
+    }
+  }
+  DynamicJsonDocument doc(JSON_OBJECT_SIZE(8) + JSON_ARRAY_SIZE(4) + JSON_ARRAY_SIZE(rings) +
+                          JSON_ARRAY_SIZE(lines + arcs) +
+                          lines * (JSON_OBJECT_SIZE(3) + 2 * JSON_ARRAY_SIZE(2)) +
+                          arcs * (JSON_OBJECT_SIZE(8) + 3 * JSON_ARRAY_SIZE(2)) +
+                          sizeof(name) + sizeof(type));
+  doc["name"] = name;
+  doc["type"] = type;
+  if (e.floor_m != SuaCatalog::kNoFloorM) doc["floor_m"] = e.floor_m;
+  if (e.ceil_m != SuaCatalog::kNoCeilingM) doc["ceil_m"] = e.ceil_m;
+  JsonArray bbox = doc.createNestedArray("bbox");
+  bbox.add(e.min_lat / 1e6);
+  bbox.add(e.min_lon / 1e6);
+  bbox.add(e.max_lat / 1e6);
+  bbox.add(e.max_lon / 1e6);
+  if (distM >= 0.0f) doc["distance_m"] = lroundf(distM);
+  if (geometry) {
+    auto point = [](JsonObject o, const char *key, int32_t lat, int32_t lon) {
+      JsonArray p = o.createNestedArray(key);
+      p.add(lat / 1e6);
+      p.add(lon / 1e6);
+    };
+    JsonArray ringArr = doc.createNestedArray("rings");
+    rd.open(e);
+    while (rd.nextRing(segs)) {
+      JsonArray ring = ringArr.createNestedArray();
+      while (rd.nextSegment(seg)) {
+        JsonObject s = ring.createNestedObject();
+        point(s, "start", seg.start_lat, seg.start_lon);
+        point(s, "end", seg.end_lat, seg.end_lon);
+        if (seg.type != SuaCatalog::SEG_ARC) {
+          s["type"] = "LINE";
+          continue;
+        }
+        s["type"] = "ARC";
+        point(s, "center", seg.center_lat, seg.center_lon);
+        s["radius_m"] = seg.radius_m;
+        s["start_cd"] = seg.start_cd;
+        s["end_cd"] = seg.end_cd;
+        s["direction"] = seg.direction;
+      }
+    }
+  }
+  if (doc.overflowed()) return false;
+  out = String();
+  serializeJson(doc, out);
+  return true;
+}
+
+// A matched area list streamed as a chunked response, one area's JSON in
+// RAM at a time however many areas and vertices the query returns.
+struct SuaReply {
+  std::vector<SuaCatalog::Near> hits;
+  size_t matched = 0;
+  bool geometry = true;
+  bool near = false;
+  size_t next = 0;   // next hit to format
+  size_t written = 0;
+  uint8_t stage = 0; // 0 header, 1 areas, 2 footer, 3 done
+  String pending;
+  size_t sent = 0;
+
+  bool refill() {
+    pending = String();
+    sent = 0;
+    while (pending.length() == 0) {
+      if (stage == 0) {
+        char head[96];
+        snprintf(head, sizeof(head), "{\"ok\":true,\"count\":%u,\"matched\":%u,\"truncated\":%s,\"types\":[",
+                 (unsigned)hits.size(), (unsigned)matched, matched > hits.size() ? "true" : "false");
+        pending = head;
+        for (size_t t = 0; t < SuaCatalog::typeCount(); t++) {
+          char item[48];
+          snprintf(item, sizeof(item), "%s{\"code\":\"%s\",\"count\":%lu}", t ? "," : "",
+                   SuaCatalog::typeName(t), (unsigned long)SuaCatalog::typeSize(t));
+          pending += item;
+        }
+        pending += "],\"areas\":[";
+        stage = 1;
+      } else if (stage == 1) {
+        if (next >= hits.size()) {
+          stage = 2;
+          continue;
+        }
+        String area;
+        const SuaCatalog::Near &h = hits[next];
+        if (suaAreaJson(h.idx, near ? h.distM : -1.0f, geometry, area)) {
+          if (written++) pending = ",";
+          pending += area;
+        }
+        next++;
+      } else if (stage == 2) {
+        pending = "]}";
+        stage = 3;
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t fill(uint8_t *buf, size_t maxLen) {
+    size_t n = 0;
+    while (n < maxLen) {
+      if (sent == pending.length() && !refill()) break;
+      const size_t k = min(maxLen - n, (size_t)(pending.length() - sent));
+      memcpy(buf + n, pending.c_str() + sent, k);
+      n += k;
+      sent += k;
+    }
+    return n;
+  }
+};
+
+// Shared checks and reply for both SUA queries: a ready catalog, a known
+// "type" and a "limit"; fills the hits through find().
+template <typename Find>
+static void sendSuaReply(AsyncWebServerRequest *request, bool near, Find find) {
+  if (!SuaCatalog::ready() && !SuaCatalog::begin()) {
+    request->send(503, "application/json", "{\"ok\":false,\"error\":\"no_catalog\"}");
+    return;
+  }
+  int32_t type = -1;
+  if (request->hasParam("type") && request->getParam("type")->value().length() > 0) {
+    type = SuaCatalog::findType(request->getParam("type")->value().c_str());
+    if (type < 0) {
+      request->send(400, "application/json", "{\"ok\":false,\"error\":\"unknown_type\"}");
+      return;
+    }
+  }
+  long limit = request->hasParam("limit") ? request->getParam("limit")->value().toInt() : SUA_DEFAULT_LIMIT;
+  limit = constrain(limit, 1L, (long)SUA_MAX_LIMIT);
+
+  std::shared_ptr<SuaReply> reply = std::make_shared<SuaReply>();
+  reply->near = near;
+  reply->geometry = !(request->hasParam("geometry") && request->getParam("geometry")->value() == "0");
+  if (!find(type, (size_t)limit, *reply)) {
+    request->send(400, "application/json", "{\"ok\":false,\"error\":\"bad_query\"}");
+    return;
+  }
+  AsyncWebServerResponse *response = request->beginChunkedResponse(
+    "application/json", [reply](uint8_t *buf, size_t maxLen, size_t) { return reply->fill(buf, maxLen); });
+  request->send(response);
+}
+
+static bool paramDouble(AsyncWebServerRequest *request, const char *name, double lo, double hi, double &out) {
+  if (!request->hasParam(name)) return false;
+  const String &v = request->getParam(name)->value();
+  if (v.length() == 0) return false;
+  out = v.toDouble();
+  return out >= lo && out <= hi;
+}
+
 namespace PortalServer {
 
 void begin() {
@@ -117,6 +308,22 @@ void begin() {
   Serial.print("AP IP: ");
   Serial.println(WiFi.softAPIP());
 
+  // The catalog partition, when flashed, is the catalog: serve it from
+  // flash in place (ahead of the static handler, whose copy may be stale
+  // or absent).
+  if ((SuaCatalog::ready() || SuaCatalog::begin()) && SuaCatalog::mapped()) {
+    server.on("/sua_catalog.idx", HTTP_GET, [](AsyncWebServerRequest *request) {
+      size_t len = 0;
+      const uint8_t *data = SuaCatalog::mappedIdx(len);
+      request->send(request->beginResponse_P(200, "application/octet-stream", data, len));
+    });
+    server.on("/sua_catalog.bin", HTTP_GET, [](AsyncWebServerRequest *request) {
+      size_t len = 0;
+      const uint8_t *data = SuaCatalog::mappedBin(len);
+      request->send(request->beginResponse_P(200, "application/octet-stream", data, len));
+    });
+  }
+
   server.serveStatic("/", LittleFS, "/portal")
         .setDefaultFile("active_mission.html");
 
@@ -135,7 +342,7 @@ void begin() {
 
   // GET current status (callsign + GPS)
   server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request) {
-    StaticJsonDocument<1024> doc;
+    StaticJsonDocument<1536> doc;
     StaticJsonDocument<1024> cfg;
 
     if (!store.load(cfg)) {
@@ -151,6 +358,10 @@ void begin() {
     doc["battery"] = SystemStatus::batteryPct();
     doc["geoCount"] = SystemStatus::geoCount();
     doc["geoOk"] = SystemStatus::geoOk();
+    if (SystemStatus::geoMarginValid()) {
+      doc["geoMarginM"] = lroundf(SystemStatus::geoMarginM());
+      doc["geoClosingMps"] = SystemStatus::geoClosingMps();
+    }
     doc["missionId"] = cfg["missionId"] | "";
     doc["satcom_id"] = cfg["satcom_id"] | "";
     doc["time_kill_min"] = cfg["time_kill_min"] | 0;
@@ -166,6 +377,38 @@ void begin() {
     doc["alt_m"] = GPSControl::altitudeMeters();
     doc["sats"] = GPSControl::satellites();
     doc["flight_timer_sec"] = MissionController::flightTimerSeconds();
+    const GeoFence::Stats geoStats = GeoFence::stats();
+    doc["geo_evals"] = geoStats.evaluations;
+    doc["geo_evals_per_s"] = geoStats.evalsPerSec;
+    doc["geo_eval_us"] = geoStats.lastEvalUs;
+    doc["geo_eval_worst_us"] = geoStats.worstEvalUs;
+    doc["geo_slow_evals"] = geoStats.slowEvals;
+    const SatCom::Stats &satStats = SatCom::stats();
+    doc["sat_requests"] = satStats.requests;
+    doc["sat_completed"] = satStats.completed;
+    doc["sat_naks"] = satStats.naks;
+    doc["sat_timeouts"] = satStats.timeouts;
+    doc["sat_retries"] = satStats.retries;
+    doc["sat_latency_ms"] = satStats.lastLatencyMs;
+    doc["sat_poll_worst_us"] = satStats.worstPollUs;
+    const SatCom::RxStats satRx = SatCom::rxStats();
+    doc["sat_rx_frames"] = satRx.frames;
+    doc["sat_rx_crc_errors"] = satRx.crcErrors;
+    doc["sat_rx_resyncs"] = satRx.resyncs;
+    doc["sat_rx_overruns"] = satRx.overruns;
+    doc["sat_rx_unclaimed"] = satRx.unclaimed;
+    const TxQueue::Stats &satQueue = TxQueue::stats();
+    doc["sat_q_depth"] = satQueue.depth;
+    doc["sat_q_sent"] = satQueue.sent;
+    doc["sat_q_dropped"] = satQueue.dropped;
+    doc["sat_q_coalesced"] = satQueue.coalesced;
+    doc["sat_q_recovered"] = satQueue.recovered;
+    doc["sat_q_latency_ms"] = satQueue.lastLatencyMs;
+    doc["sat_q_worst_latency_ms"] = satQueue.worstLatencyMs;
+    doc["sat_q_throttled"] = satQueue.throttled;
+    doc["sat_q_aborts"] = satQueue.aborts;
+    const SatCom::ModemQueue &modemQueue = SatCom::modemQueue();
+    doc["sat_modem_bursts"] = modemQueue.known ? (int)modemQueue.burstsRemaining : -1;
     const uint32_t satId = SatCom::lastId();
     if (satId > 0) {
       char idBuf[16];
@@ -191,9 +434,176 @@ void begin() {
     request->send(200, "application/json", out);
   });
 
+  // GET geofence engine stats (registered before /api/geofence, which would
+  // otherwise prefix-match this URL)
+  server.on("/api/geofence/stats", HTTP_GET, [](AsyncWebServerRequest *request) {
+    StaticJsonDocument<1024> doc;
+    const GeoFence::Stats st = GeoFence::stats();
+    doc["rules"] = GeoFence::ruleCount();
+    doc["vertices"] = GeoFence::vertexCount();
+    doc["arcs"] = GeoFence::arcCount();
+    doc["index_nodes"] = GeoFence::indexNodeCount();
+    doc["sua_rules"] = GeoFence::suaRuleCount();
+    const GeoFence::LoadInfo load = GeoFence::loadInfo();
+    doc["loaded"] = load.ok;
+    doc["reload_pending"] = geofenceReloadRequested.load();
+    doc["load_source"] = load.fromBlob ? "blob" : "json";
+    doc["load_us"] = load.loadUs;
+    doc["load_heap_bytes"] = load.heapBytes;
+    doc["blob_bytes"] = load.blobBytes;
+    doc["grid_cells"] = load.gridCells;
+    doc["grid_exact_cells"] = load.gridExactCells;
+    doc["grid_classified"] = load.gridClassified;
+    doc["grid_us"] = load.gridUs;
+    doc["sua_type_areas"] = load.suaTypeAreas;
+    doc["sua_type_refused"] = load.suaTypeRefused;
+    doc["sua_source"] = !SuaCatalog::ready() ? "none" : SuaCatalog::mapped() ? "partition" : "littlefs";
+    const SuaCatalog::CacheStats &sua = SuaCatalog::cacheStats();
+    doc["sua_cache_hits"] = sua.hits;
+    doc["sua_cache_misses"] = sua.misses;
+    doc["sua_bytes_read"] = sua.bytesRead;
+    doc["evals"] = st.evaluations;
+    doc["evals_per_s"] = st.evalsPerSec;
+    doc["eval_us"] = st.lastEvalUs;
+    doc["eval_worst_us"] = st.worstEvalUs;
+    doc["slow_eval_us"] = st.slowEvalUs;
+    doc["slow_evals"] = st.slowEvals;
+    doc["nodes_visited"] = st.lastNodesVisited;
+    doc["candidates"] = st.lastCandidates;
+    doc["nodes_visited_total"] = st.totalNodesVisited;
+    doc["candidates_total"] = st.totalCandidates;
+    doc["margin_rules"] = st.lastMarginRules;
+    doc["swept_hits"] = st.sweptHits;
+    doc["transits_dropped"] = st.transitsDropped;
+    doc["glitch_hops"] = st.glitchHops;
+    doc["cell_hits"] = st.cellHits;
+    float marginM = 0.0f;
+    float closingMps = 0.0f;
+    if (GeoFence::margin(marginM, closingMps)) {
+      doc["margin_m"] = marginM;
+      doc["closing_mps"] = closingMps;
+      doc["margin_rule"] = GeoFence::marginRuleId();
+    }
+    String out;
+    serializeJson(doc, out);
+    request->send(200, "application/json", out);
+  });
+
+  // GET per-rule vertex counts and test cost before/after simplification
+  server.on("/api/geofence/rules", HTTP_GET, [](AsyncWebServerRequest *request) {
+    const size_t count = GeoFence::ruleCount();
+    // Ids are copied: a reload in loop() may replace the rules meanwhile.
+    DynamicJsonDocument doc(JSON_ARRAY_SIZE(count) + count * (JSON_OBJECT_SIZE(11) + 40) + 256);
+    JsonArray rules = doc.createNestedArray("rules");
+    GeoFence::RuleInfo info;
+    for (size_t i = 0; GeoFence::ruleInfo(i, info); i++) {
+      JsonObject r = rules.createNestedObject();
+      r["id"] = info.id;
+      r["type"] = info.type;
+      r["sua"] = info.sua;
+      r["rings"] = info.rings;
+      r["vertices"] = info.vertices;
+      r["vertices_in"] = info.verticesIn;
+      if (info.evalNsIn > 0) {
+        r["eval_ns"] = info.evalNs;
+        r["eval_ns_in"] = info.evalNsIn;
+      }
+      if (info.floorM != SuaCatalog::kNoFloorM) r["floor_m"] = info.floorM;
+      if (info.ceilM != SuaCatalog::kNoCeilingM) r["ceil_m"] = info.ceilM;
+    }
+    String out;
+    serializeJson(doc, out);
+    request->send(200, "application/json", out);
+  });
+
+  // GET containment throughput for one rule: single-point vs batch ring
+  // test (?rule=<index>&points=<n>, also ahead of /api/geofence)
+  server.on("/api/geofence/bench", HTTP_GET, [](AsyncWebServerRequest *request) {
+    const size_t rule = request->hasParam("rule") ? request->getParam("rule")->value().toInt() : 0;
+    const uint32_t points = request->hasParam("points") ? request->getParam("points")->value().toInt() : 1024;
+    GeoFence::BatchBench bench;
+    if (!GeoFence::benchmarkRule(rule, points, bench)) {
+      request->send(400, "application/json", "{\"ok\":false,\"error\":\"no_polygon_rule\"}");
+      return;
+    }
+    StaticJsonDocument<256> doc;
+    doc["ok"] = true;
+    doc["rule"] = rule;
+    doc["points"] = bench.points;
+    doc["single_us"] = bench.singleUs;
+    doc["batch_us"] = bench.batchUs;
+    doc["single_pps"] = bench.singlePps;
+    doc["batch_pps"] = bench.batchPps;
+    doc["mismatches"] = bench.mismatches;
+    String out;
+    serializeJson(doc, out);
+    request->send(200, "application/json", out);
+  });
+
+  // GET SUA areas within radius_km of a point, nearest first
+  // (?lat=&lon=&radius_km=[&type=R][&limit=50][&geometry=0])
+  server.on("/api/sua/near", HTTP_GET, [](AsyncWebServerRequest *request) {
+    sendSuaReply(request, true, [request](int32_t type, size_t limit, SuaReply &reply) {
+      double lat = 0.0, lon = 0.0, radiusKm = 0.0;
+      if (!paramDouble(request, "lat", -90.0, 90.0, lat) ||
+          !paramDouble(request, "lon", -180.0, 180.0, lon) ||
+          !paramDouble(request, "radius_km", 0.0, SUA_MAX_RADIUS_KM, radiusKm)) {
+        return false;
+      }
+      reply.matched = SuaCatalog::nearby(GeoMath::toE6(lat), GeoMath::toE6(lon), radiusKm * 1000.0f,
+                                         type, limit, reply.hits);
+      return true;
+    });
+  });
+
+  // GET SUA areas whose bbox meets the given one, in catalog order
+  // (?min_lat=&min_lon=&max_lat=&max_lon=[&type=R][&limit=50][&geometry=0])
+  server.on("/api/sua/bbox", HTTP_GET, [](AsyncWebServerRequest *request) {
+    sendSuaReply(request, false, [request](int32_t type, size_t limit, SuaReply &reply) {
+      double minLat = 0.0, minLon = 0.0, maxLat = 0.0, maxLon = 0.0;
+      if (!paramDouble(request, "min_lat", -90.0, 90.0, minLat) ||
+          !paramDouble(request, "min_lon", -180.0, 180.0, minLon) ||
+          !paramDouble(request, "max_lat", -90.0, 90.0, maxLat) ||
+          !paramDouble(request, "max_lon", -180.0, 180.0, maxLon) ||
+          minLat > maxLat || minLon > maxLon) {
+        return false;
+      }
+      const PackedRTree::Box box{GeoMath::toE6(minLat), GeoMath::toE6(minLon),
+                                 GeoMath::toE6(maxLat), GeoMath::toE6(maxLon),
+                                 PackedRTree::kAltMin, PackedRTree::kAltMax};
+      std::vector<uint32_t> ids;
+      if (type >= 0) {
+        SuaCatalog::queryType((size_t)type, box.min_lat, box.min_lon, box.max_lat, box.max_lon, ids);
+      } else {
+        PackedRTree::Stats stats;
+        SuaCatalog::query(box, stats, ids);
+      }
+      std::sort(ids.begin(), ids.end());
+      reply.matched = ids.size();
+      for (size_t i = 0; i < ids.size() && i < limit; i++) reply.hits.push_back(SuaCatalog::Near{ids[i], 0.0f});
+      return true;
+    });
+  });
+
+  // GET one SUA area by name (case-insensitive, ?name=R-2508), through the
+  // index's hash section; an empty list when there is no such area
+  server.on("/api/sua/area", HTTP_GET, [](AsyncWebServerRequest *request) {
+    sendSuaReply(request, false, [request](int32_t, size_t, SuaReply &reply) {
+      if (!request->hasParam("name") || request->getParam("name")->value().length() == 0) return false;
+      const int32_t idx = SuaCatalog::findByName(request->getParam("name")->value().c_str());
+      if (idx >= 0) reply.hits.push_back(SuaCatalog::Near{(uint32_t)idx, 0.0f});
+      reply.matched = reply.hits.size();
+      return true;
+    });
+  });
+
   // GET current geofence config
   server.on("/api/geofence", HTTP_GET, [](AsyncWebServerRequest *request) {
-    StaticJsonDocument<2048> doc;
+    // Sized from the file: SUA outlines with holes run well past 2 KB.
+    File f = LittleFS.open(GEOFENCE_PATH, "r");
+    const size_t fileLen = f ? f.size() : 0;
+    if (f) f.close();
+    DynamicJsonDocument doc(fileLen * 2 + 1024);
     if (!loadJsonFile(GEOFENCE_PATH, doc)) {
       fillGeofenceDefaults(doc);
     }
@@ -310,6 +720,78 @@ void begin() {
     }
   );
 
+  // POST a planned track for a pre-flight check against the loaded rules
+  // and the SUA catalog (ahead of /api/geofence):
+  //   {"track": [[lat, lon, alt_m], ...], "catalog": true}
+  // alt_m may be omitted or null (matches every altitude band).
+  server.on(
+    "/api/geofence/validate",
+    HTTP_POST,
+    [](AsyncWebServerRequest *request) {},
+    NULL,
+    [](AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) {
+      // The body is collected per request in _tempObject (freed with the
+      // request), so concurrent uploads cannot interleave.
+      if (index == 0 && total <= VALIDATE_BODY_MAX) request->_tempObject = malloc(total + 1);
+      char *body = static_cast<char *>(request->_tempObject);
+      if (!body || index + len > total) {
+        if (index + len == total) {
+          request->send(413, "application/json", "{\"ok\":false,\"error\":\"too_large\"}");
+        }
+        return;
+      }
+      memcpy(body + index, data, len);
+      if (index + len != total) return;
+
+      DynamicJsonDocument doc(std::max<size_t>(total * 2 + 1024, 2048));
+      DeserializationError err = deserializeJson(doc, body, total);
+      free(request->_tempObject);
+      request->_tempObject = nullptr;
+      if (err) {
+        request->send(400, "application/json", "{\"ok\":false,\"error\":\"invalid_json\"}");
+        return;
+      }
+
+      JsonArray pts = doc["track"].as<JsonArray>();
+      std::vector<GeoFence::TrackPoint> track;
+      track.reserve(pts.size());
+      for (JsonArray p : pts) {
+        if (p.size() < 2) continue;
+        track.push_back({p[0].as<double>(), p[1].as<double>(), p[2].isNull() ? NAN : p[2].as<float>()});
+      }
+      GeoFence::TrackReport report;
+      if (!GeoFence::validateTrack(track.data(), track.size(), doc["catalog"] | true, report)) {
+        request->send(400, "application/json", "{\"ok\":false,\"error\":\"bad_track\"}");
+        return;
+      }
+
+      DynamicJsonDocument res(JSON_ARRAY_SIZE(report.hits.size()) +
+                              report.hits.size() * (JSON_OBJECT_SIZE(9) + 96) + 256);
+      res["ok"] = true;
+      res["points"] = track.size();
+      res["length_m"] = report.lengthM;
+      res["rules_checked"] = report.rulesChecked;
+      res["areas_checked"] = report.areasChecked;
+      res["elapsed_us"] = report.elapsedUs;
+      res["truncated"] = report.truncated;
+      JsonArray hits = res.createNestedArray("hits");
+      for (const GeoFence::TrackHit &h : report.hits) {
+        JsonObject o = hits.createNestedObject();
+        o["id"] = h.id;
+        o["type"] = h.type;
+        o["detail"] = h.detail;
+        o["leg"] = h.leg;
+        o["along_m"] = h.alongM;
+        o["lat"] = h.lat;
+        o["lon"] = h.lon;
+        if (!isnan(h.altM)) o["alt_m"] = h.altM;
+      }
+      String out;
+      serializeJson(res, out);
+      request->send(200, "application/json", out);
+    }
+  );
+
   // POST new geofence config
   server.on(
     "/api/geofence",
@@ -343,7 +825,7 @@ void begin() {
         return;
       }
       (void)saveJsonFile(GEOFENCE_DB_PATH, doc);
-      (void)GeoFence::reload(GEOFENCE_PATH);
+      geofenceReloadRequested = true;
 
       request->send(200, "application/json", "{\"ok\":true}");
     }
@@ -500,4 +982,10 @@ void begin() {
   Serial.println("Web server started");
 }
 
+void loop() {
+  if (geofenceReloadRequested.exchange(false)) {
+    (void)GeoFence::reload(GEOFENCE_PATH);
+  }
+}
+
 } // namespace PortalServer
@@ -3,4 +3,7 @@
 
 namespace PortalServer {
   void begin();
+  // Work the web server hands to the main task (a geofence reload after
+  // new rules are saved). Call from loop().
+  void loop();
 }
@@ -0,0 +1,148 @@
+// tools/geofence_bench/batch.cpp
+// GeoMath::pointsInRing() against the single-point pointInRing() it must
+// reproduce exactly, on multi-ring spans (outline, holes, islands) with
+// points on vertices, on vertex latitudes/longitudes and on edges, then
+// points per second for both at batch sizes either side of the cut-over.
+#include "geofence_bench.h"
+
+#include "geofence/GeoMath.h"
+
+namespace {
+  constexpr uint32_t kSpans = 400;
+  constexpr uint32_t kPointsPerSpan = 2048;
+  constexpr uint32_t kTimedPoints = 400000;
+  constexpr uint32_t kBatchSizes[] = {16, 128, 1024, 2048};
+  constexpr size_t kRingSizes[] = {60, 400, 2000};
+
+  // Point that lands exactly on a ring feature most of the time.
+  void degeneratePoint(Bench::Rng &rng, const Bench::Arena &a, int32_t &lat, int32_t &lon)
+  {
+    const uint32_t v = rng.below(a.count());
+    const uint32_t w = (v + 1 < a.count()) ? v + 1 : v;
+    switch (rng.below(5)) {
+      case 0:  // the vertex itself
+        lat = a.lat[v];
+        lon = a.lon[v];
+        break;
+      case 1:  // on the vertex's longitude (vertical through it)
+        lon = a.lon[v];
+        break;
+      case 2:  // on the vertex's latitude
+        lat = a.lat[v];
+        break;
+      case 3:  // edge midpoint, on the edge when it divides evenly
+        lat = a.lat[v] + (a.lat[w] - a.lat[v]) / 2;
+        lon = a.lon[v] + (a.lon[w] - a.lon[v]) / 2;
+        break;
+      default:  // just off a vertex
+        lat = a.lat[v] + (int32_t)rng.below(3) - 1;
+        lon = a.lon[v] + (int32_t)rng.below(3) - 1;
+        break;
+    }
+  }
+
+  bool equivalence(const Bench::Options &options, Bench::Rng &rng)
+  {
+    const uint32_t spans = std::max<uint32_t>(20, (uint32_t)(kSpans * options.scale));
+    uint64_t points = 0, inside = 0, mismatches = 0, vertices = 0;
+    for (uint32_t s = 0; s < spans; s++) {
+      // One to four rings around nearby centres, mixed windings; overlaps
+      // are fine, even-odd is all either function computes.
+      Bench::Arena a;
+      const double lat = rng.uniform(-70.0, 70.0);
+      const double lon = rng.uniform(-179.0, 179.0);
+      const uint32_t rings = 1 + rng.below(4);
+      for (uint32_t k = 0; k < rings; k++) {
+        a.add(Bench::randomRing(rng, lat + rng.uniform(-0.05, 0.05), lon + rng.uniform(-0.05, 0.05),
+                                rng.uniform(0.01, 0.2), 3 + rng.below(300), rng.chance(0.5)));
+      }
+      // Axis-aligned edges too: a ring snapped to a coarse grid.
+      if (rng.chance(0.3)) {
+        Bench::Ring snapped = Bench::randomRing(rng, lat, lon, 0.1, 20 + rng.below(40));
+        for (size_t i = 0; i < snapped.size(); i++) {
+          snapped.lat[i] = Bench::quantize(lat + 0.01 * lround((snapped.lat[i] - lat) / 0.01));
+          snapped.lon[i] = Bench::quantize(lon + 0.01 * lround((snapped.lon[i] - lon) / 0.01));
+        }
+        a.add(snapped);
+      }
+      vertices += a.count();
+
+      int32_t min_lat = INT32_MAX, min_lon = INT32_MAX, max_lat = INT32_MIN, max_lon = INT32_MIN;
+      for (uint32_t i = 0; i < a.count(); i++) {
+        min_lat = std::min(min_lat, a.lat[i]);
+        max_lat = std::max(max_lat, a.lat[i]);
+        min_lon = std::min(min_lon, a.lon[i]);
+        max_lon = std::max(max_lon, a.lon[i]);
+      }
+      const uint32_t n = 1 + rng.below(kPointsPerSpan);
+      std::vector<int32_t> plat(n), plon(n);
+      for (uint32_t i = 0; i < n; i++) {
+        plat[i] = min_lat - 100 + (int32_t)rng.below((uint32_t)(max_lat - min_lat + 201));
+        plon[i] = min_lon - 100 + (int32_t)rng.below((uint32_t)(max_lon - min_lon + 201));
+        if (rng.chance(0.3)) degeneratePoint(rng, a, plat[i], plon[i]);
+        // Duplicates exercise equal keys in the longitude sort.
+        if (i && rng.chance(0.05)) {
+          plat[i] = plat[i - 1];
+          plon[i] = plon[i - 1];
+        }
+      }
+      std::vector<uint8_t> batch(n, 0xAA);
+      GeoMath::pointsInRing(a.lat.data(), a.lon.data(), a.dlat.data(), a.dlon.data(), a.count(), plat.data(),
+                            plon.data(), n, batch.data());
+      for (uint32_t i = 0; i < n; i++) {
+        const bool single = GeoMath::pointInRing(a.lat.data(), a.lon.data(), a.dlat.data(), a.dlon.data(),
+                                                 a.count(), plat[i], plon[i]);
+        inside += single;
+        mismatches += batch[i] != (single ? 1 : 0);
+      }
+      points += n;
+    }
+    return Bench::expect(mismatches == 0, "%u spans, %llu vertices, %llu points (%llu inside): %llu mismatches",
+                         (unsigned)spans, (unsigned long long)vertices, (unsigned long long)points,
+                         (unsigned long long)inside, (unsigned long long)mismatches);
+  }
+
+  void throughput(const Bench::Options &options, Bench::Rng &rng)
+  {
+    const uint32_t total = std::max<uint32_t>(40000, (uint32_t)(kTimedPoints * options.scale));
+    printf("       %-16s  %10s", "points/s (M)", "single");
+    for (uint32_t b : kBatchSizes) printf("  batch %4u", (unsigned)b);
+    printf("\n");
+    for (size_t n : kRingSizes) {
+      Bench::Arena a;
+      a.add(Bench::randomRing(rng, 35.0, -117.0, 0.2, n));
+      std::vector<int32_t> plat(total), plon(total);
+      for (uint32_t i = 0; i < total; i++) {
+        plat[i] = GeoMath::toE6(35.0 + rng.uniform(-0.2, 0.2));
+        plon[i] = GeoMath::toE6(-117.0 + rng.uniform(-0.25, 0.25));
+      }
+      std::vector<uint8_t> out(total);
+      volatile uint32_t sink = 0;
+      double t0 = Bench::nowSeconds();
+      for (uint32_t i = 0; i < total; i++) {
+        sink += GeoMath::pointInRing(a.lat.data(), a.lon.data(), a.dlat.data(), a.dlon.data(), a.count(), plat[i],
+                                     plon[i]);
+      }
+      const double single = total / (Bench::nowSeconds() - t0) / 1e6;
+      printf("       %4zu-vertex ring  %10.2f", n, single);
+      for (uint32_t b : kBatchSizes) {
+        t0 = Bench::nowSeconds();
+        for (uint32_t i = 0; i + b <= total; i += b) {
+          GeoMath::pointsInRing(a.lat.data(), a.lon.data(), a.dlat.data(), a.dlon.data(), a.count(), &plat[i],
+                                &plon[i], b, &out[i]);
+        }
+        printf("  %10.2f", (total / b * b) / (Bench::nowSeconds() - t0) / 1e6);
+      }
+      printf("\n");
+    }
+    fflush(stdout);
+  }
+}
+
+bool checkBatch(const Bench::Options &options)
+{
+  Bench::Rng rng(options.seed * 2654435761ULL + 17);
+  const bool ok = equivalence(options, rng);
+  throughput(options, rng);
+  return ok;
+}
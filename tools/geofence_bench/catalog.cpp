@@ -0,0 +1,162 @@
+// tools/geofence_bench/catalog.cpp
+// The SUA catalog read from LittleFS (block cache) and from the mapped
+// partition image must give the same answers: entries, names, type codes,
+// the stamp, containment and boundary distances at random points in each
+// area's bbox. Also times both sources on the same calls, and runs two
+// threads against the LittleFS block cache at once, as loop() and the
+// portal's AsyncTCP task do, expecting the single-threaded answers.
+#include "geofence_bench.h"
+
+#include <string.h>
+#include <thread>
+
+#include "geofence/GeoMath.h"
+#include "geofence/SuaCatalog.h"
+
+namespace {
+  constexpr uint32_t kPointsPerArea = 40;
+  constexpr uint32_t kConcurrentPoints = 4000;
+  constexpr int kConcurrentPasses = 4;
+
+  // Everything one pass over the catalog returns, for comparing sources.
+  struct Snapshot {
+    uint32_t count = 0;
+    uint32_t stamp = 0;
+    bool mapped = false;
+    std::vector<SuaCatalog::Entry> entries;
+    std::vector<std::string> names;
+    std::vector<std::string> codes;
+    std::vector<uint8_t> inside;
+    std::vector<float> distM;
+    double seconds = 0.0;
+    SuaCatalog::CacheStats cache;
+  };
+
+  // Same points for both sources: the generator is reseeded per pass.
+  void snapshot(uint64_t seed, uint32_t points, Snapshot &s)
+  {
+    Bench::Rng rng(seed);
+    s.count = SuaCatalog::count();
+    s.stamp = SuaCatalog::stamp();
+    s.mapped = SuaCatalog::mapped();
+    const SuaCatalog::CacheStats before = SuaCatalog::cacheStats();
+    const double t0 = Bench::nowSeconds();
+    char buf[64];
+    for (uint32_t idx = 0; idx < s.count; idx++) {
+      SuaCatalog::Entry e;
+      if (!SuaCatalog::entry(idx, e)) e = SuaCatalog::Entry();
+      s.entries.push_back(e);
+      s.names.push_back(SuaCatalog::name(e, buf, sizeof(buf)) ? buf : "");
+      s.codes.push_back(SuaCatalog::typeCode(e, buf, sizeof(buf)) ? buf : "");
+      for (uint32_t k = 0; k < points; k++) {
+        const int32_t lat = e.min_lat + (int32_t)rng.below((uint32_t)(e.max_lat - e.min_lat) + 1);
+        const int32_t lon = e.min_lon + (int32_t)rng.below((uint32_t)(e.max_lon - e.min_lon) + 1);
+        s.inside.push_back(SuaCatalog::contains(e, lat, lon));
+        s.distM.push_back(SuaCatalog::boundaryDistanceM(e, lat, lon));
+      }
+    }
+    s.seconds = Bench::nowSeconds() - t0;
+    const SuaCatalog::CacheStats &after = SuaCatalog::cacheStats();
+    s.cache.hits = after.hits - before.hits;
+    s.cache.misses = after.misses - before.misses;
+    s.cache.bytesRead = after.bytesRead - before.bytesRead;
+  }
+
+  // One reader's work: boundary distances at fixed points (the GeoFence
+  // side) or nearby() around them (the /api/sua/near side).
+  std::vector<float> readerPass(const std::vector<int32_t> &lat, const std::vector<int32_t> &lon, bool nearby)
+  {
+    std::vector<float> out;
+    SuaCatalog::Entry e;
+    std::vector<SuaCatalog::Near> hits;
+    for (size_t i = 0; i < lat.size(); i++) {
+      if (nearby) {
+        SuaCatalog::nearby(lat[i], lon[i], 50000.0f, -1, 8, hits);
+        for (const SuaCatalog::Near &h : hits) out.push_back(h.distM + (float)h.idx);
+      } else if (SuaCatalog::entry((uint32_t)i % SuaCatalog::count(), e)) {
+        out.push_back(SuaCatalog::boundaryDistanceM(e, lat[i], lon[i]));
+      }
+    }
+    return out;
+  }
+
+  bool sameEntry(const SuaCatalog::Entry &a, const SuaCatalog::Entry &b)
+  {
+    return a.id_hash == b.id_hash && a.name_offset == b.name_offset && a.geom_offset == b.geom_offset &&
+           a.geom_length == b.geom_length && a.min_lat == b.min_lat && a.min_lon == b.min_lon &&
+           a.max_lat == b.max_lat && a.max_lon == b.max_lon && a.floor_m == b.floor_m && a.ceil_m == b.ceil_m;
+  }
+}
+
+bool checkCatalog(const Bench::Options &options)
+{
+  bool ok = true;
+  const uint32_t points = std::max<uint32_t>(4, (uint32_t)(kPointsPerArea * options.scale));
+  const uint64_t seed = options.seed * 6700417ULL + 31;
+
+  Snapshot fs, part;
+  SuaCatalog::end();
+  // begin() tries the partition first; there is none at the default label
+  // on the host, so this is the LittleFS path.
+  if (!SuaCatalog::begin(options.catalogIdx.c_str(), options.catalogBin.c_str()) || SuaCatalog::mapped()) {
+    return Bench::expect(false, "LittleFS catalog did not open");
+  }
+  snapshot(seed, points, fs);
+  if (!SuaCatalog::beginPartition(options.partition.c_str()) || !SuaCatalog::mapped()) {
+    return Bench::expect(false, "catalog partition image %s did not map", options.partition.c_str());
+  }
+  snapshot(seed, points, part);
+  SuaCatalog::end();
+
+  uint32_t entries = 0, names = 0, inside = 0, dist = 0, in_count = 0;
+  for (uint32_t i = 0; i < std::min(fs.count, part.count); i++) {
+    entries += !sameEntry(fs.entries[i], part.entries[i]);
+    names += fs.names[i] != part.names[i] || fs.codes[i] != part.codes[i];
+  }
+  for (size_t i = 0; i < std::min(fs.inside.size(), part.inside.size()); i++) {
+    in_count += fs.inside[i];
+    inside += fs.inside[i] != part.inside[i];
+    dist += memcmp(&fs.distM[i], &part.distM[i], sizeof(float)) != 0;
+  }
+  ok &= Bench::expect(fs.count == part.count && fs.count > 0 && fs.stamp == part.stamp,
+                      "%u / %u areas, stamp %08x / %08x (LittleFS / partition)", (unsigned)fs.count,
+                      (unsigned)part.count, (unsigned)fs.stamp, (unsigned)part.stamp);
+  ok &= Bench::expect(entries == 0 && names == 0, "index records: %u differ, names and type codes: %u differ",
+                      (unsigned)entries, (unsigned)names);
+  ok &= Bench::expect(fs.inside.size() == part.inside.size() && inside == 0 && dist == 0,
+                      "%zu points (%u inside): %u containment and %u boundary distance differences",
+                      fs.inside.size(), (unsigned)in_count, (unsigned)inside, (unsigned)dist);
+  printf("       LittleFS  %.0f ms, block cache %u hits / %u misses, %u KB read\n", fs.seconds * 1e3,
+         (unsigned)fs.cache.hits, (unsigned)fs.cache.misses, (unsigned)(fs.cache.bytesRead / 1024));
+  printf("       partition %.0f ms (%.1fx)\n", part.seconds * 1e3, fs.seconds / part.seconds);
+  fflush(stdout);
+
+  // Concurrent readers on the LittleFS source, from a cold cache and area
+  // index, each checked against its single-threaded answers.
+  if (!SuaCatalog::begin(options.catalogIdx.c_str(), options.catalogBin.c_str())) {
+    return Bench::expect(false, "LittleFS catalog did not reopen");
+  }
+  Bench::Rng rng(seed);
+  const size_t n = std::max<size_t>(1000, (size_t)(kConcurrentPoints * options.scale));
+  std::vector<int32_t> plat(n), plon(n);
+  for (size_t i = 0; i < n; i++) {
+    plat[i] = GeoMath::toE6(rng.uniform(32.0, 38.0));
+    plon[i] = GeoMath::toE6(rng.uniform(-120.0, -114.0));
+  }
+  const std::vector<float> want_dist = readerPass(plat, plon, false);
+  const std::vector<float> want_near = readerPass(plat, plon, true);
+  SuaCatalog::end();
+  SuaCatalog::begin(options.catalogIdx.c_str(), options.catalogBin.c_str());
+  uint32_t wrong_dist = 0, wrong_near = 0;
+  std::thread portal([&] {
+    for (int k = 0; k < kConcurrentPasses; k++) wrong_near += readerPass(plat, plon, true) != want_near;
+  });
+  for (int k = 0; k < kConcurrentPasses; k++) wrong_dist += readerPass(plat, plon, false) != want_dist;
+  portal.join();
+  SuaCatalog::end();
+  ok &= Bench::expect(wrong_dist == 0 && wrong_near == 0,
+                      "two threads on the LittleFS cache, %d passes of %zu points each: %u distance and %u nearby "
+                      "passes differ from single-threaded",
+                      kConcurrentPasses, n, (unsigned)wrong_dist, (unsigned)wrong_near);
+  return ok;
+}
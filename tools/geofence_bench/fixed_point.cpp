@@ -0,0 +1,181 @@
+// tools/geofence_bench/fixed_point.cpp
+// The int32 micro-degree engine (GeoMath::pointInRing, GeoMath::crossesAxis
+// and GeoFence::containedAt) against the double ray cast and line test it
+// replaced. The reference functions are the pre-fixed-point GeoFence.cpp
+// code, unchanged.
+#include "geofence_bench.h"
+
+#include "geofence/GeoFence.h"
+#include "geofence/GeoMath.h"
+
+namespace {
+  struct Point {
+    double lat;
+    double lon;
+  };
+
+  enum class LineAxis { NorthSouth, EastWest };
+
+  bool pointInPolygon(const std::vector<Point> &poly, double lat, double lon)
+  {
+    if (poly.size() < 3) return false;
+    int cnt = 0;
+    for (size_t i = 0; i < poly.size(); i++) {
+      const Point &p1 = poly[i];
+      const Point &p2 = poly[(i + 1) % poly.size()];
+      const double x1 = p1.lat;
+      const double y1 = p1.lon;
+      const double x2 = p2.lat;
+      const double y2 = p2.lon;
+      const double xp = lat;
+      const double yp = lon;
+
+      if (((yp < y2) != (yp < y1)) &&
+          (xp < x1 + ((yp - y1) / (y2 - y1)) * (x2 - x1))) {
+        cnt++;
+      }
+    }
+    return (cnt % 2) == 1;
+  }
+
+  bool crossedLine(LineAxis axis, double value,
+                   double prev_lat, double prev_lon,
+                   double lat, double lon)
+  {
+    if (axis == LineAxis::NorthSouth) {
+      const double a = prev_lon - value;
+      const double b = lon - value;
+      return (a == 0.0) ? (b != 0.0) : (a < 0.0 && b >= 0.0) || (a > 0.0 && b <= 0.0);
+    }
+    const double a = prev_lat - value;
+    const double b = lat - value;
+    return (a == 0.0) ? (b != 0.0) : (a < 0.0 && b >= 0.0) || (a > 0.0 && b <= 0.0);
+  }
+
+  constexpr int kSeeds = 4;
+  constexpr int kRings = 7;
+  constexpr uint32_t kPointsPerSeed = 1000000;
+  constexpr uint32_t kLineSteps = 1000000;
+  // Box the rings and points live in (degrees).
+  constexpr double kLat0 = 35.0;
+  constexpr double kLon0 = -117.0;
+  constexpr double kSpan = 1.0;
+}
+
+bool checkFixedPoint(const Bench::Options &options)
+{
+  bool ok = true;
+  const uint32_t points = (uint32_t)(kPointsPerSeed * options.scale);
+  double t_double = 0.0;
+  double t_kernel = 0.0;
+  double t_engine = 0.0;
+  uint64_t ring_tests = 0;
+  uint64_t engine_tests = 0;
+
+  for (int s = 0; s < kSeeds; s++) {
+    Bench::Rng rng(options.seed * 1000003ULL + (uint64_t)s);
+    std::vector<Bench::Ring> rings;
+    std::vector<std::vector<Point>> polys;
+    std::vector<Bench::Arena> arenas(kRings);
+    std::string json = "{\"keep_out\":[],\"lines\":[],\"stay_in\":[";
+    uint32_t vertices = 0;
+    for (int r = 0; r < kRings; r++) {
+      const double lat = kLat0 + rng.uniform(0.2, kSpan - 0.2);
+      const double lon = kLon0 + rng.uniform(0.2, kSpan - 0.2);
+      rings.push_back(Bench::randomRing(rng, lat, lon, rng.uniform(0.05, 0.2), 8 + rng.below(33), rng.chance(0.5)));
+      const Bench::Ring &ring = rings.back();
+      polys.emplace_back();
+      for (size_t i = 0; i < ring.size(); i++) polys.back().push_back({ring.lat[i], ring.lon[i]});
+      arenas[r].add(ring);
+      vertices += (uint32_t)ring.size();
+      char head[48];
+      snprintf(head, sizeof(head), "%s{\"id\":\"r%d\",\"polygon\":", r ? "," : "", r);
+      json += head + Bench::ringJson(ring) + "}";
+    }
+    json += "]}";
+    if (!Bench::writeFile("/bench_fixed.json", json) || !GeoFence::reload("/bench_fixed.json")) {
+      return Bench::expect(false, "seed %d: rule set did not load", s);
+    }
+
+    // Points on the micro-degree grid; one in eight reuses a vertex
+    // latitude or longitude, so rays through vertices and points on
+    // vertical edges are well covered.
+    std::vector<double> plat(points);
+    std::vector<double> plon(points);
+    std::vector<int32_t> elat(points);
+    std::vector<int32_t> elon(points);
+    for (uint32_t i = 0; i < points; i++) {
+      plat[i] = Bench::quantize(kLat0 + rng.uniform(0.0, kSpan));
+      plon[i] = Bench::quantize(kLon0 + rng.uniform(0.0, kSpan));
+      if (rng.chance(0.125)) {
+        const Bench::Ring &ring = rings[rng.below(kRings)];
+        const size_t v = rng.below((uint32_t)ring.size());
+        if (rng.chance(0.5)) plon[i] = ring.lon[v];
+        else plat[i] = ring.lat[v];
+      }
+      elat[i] = GeoMath::toE6(plat[i]);
+      elon[i] = GeoMath::toE6(plon[i]);
+    }
+
+    std::vector<uint8_t> ref(points * kRings);
+    double t0 = Bench::nowSeconds();
+    for (uint32_t i = 0; i < points; i++) {
+      for (int r = 0; r < kRings; r++) ref[i * kRings + r] = pointInPolygon(polys[r], plat[i], plon[i]);
+    }
+    t_double += Bench::nowSeconds() - t0;
+
+    uint32_t ring_mismatches = 0;
+    t0 = Bench::nowSeconds();
+    for (uint32_t i = 0; i < points; i++) {
+      for (int r = 0; r < kRings; r++) {
+        const Bench::Arena &a = arenas[r];
+        const bool in = GeoMath::pointInRing(a.lat.data(), a.lon.data(), a.dlat.data(), a.dlon.data(),
+                                             a.count(), elat[i], elon[i]);
+        ring_mismatches += in != (bool)ref[i * kRings + r];
+      }
+    }
+    t_kernel += Bench::nowSeconds() - t0;
+    ring_tests += (uint64_t)points * kRings;
+
+    uint32_t engine_mismatches = 0;
+    t0 = Bench::nowSeconds();
+    for (uint32_t i = 0; i < points; i++) {
+      bool any = false;
+      for (int r = 0; r < kRings && !any; r++) any = ref[i * kRings + r];
+      engine_mismatches += GeoFence::containedAt(plat[i], plon[i], nullptr) != any;
+    }
+    t_engine += Bench::nowSeconds() - t0;
+    engine_tests += points;
+
+    ok &= Bench::expect(ring_mismatches == 0 && engine_mismatches == 0,
+                        "seed %d: %d rings, %u vertices, %u points: %u ring / %u containedAt mismatches",
+                        s, kRings, vertices, points, ring_mismatches, engine_mismatches);
+  }
+
+  // Line steps: values and both ends on the grid, a quarter of the ends
+  // exactly on the line.
+  Bench::Rng rng(options.seed ^ 0x5A5A5A5AULL);
+  const uint32_t steps = (uint32_t)(kLineSteps * options.scale);
+  uint32_t line_mismatches = 0;
+  uint32_t line_hits = 0;
+  for (uint32_t i = 0; i < steps; i++) {
+    const LineAxis axis = rng.chance(0.5) ? LineAxis::NorthSouth : LineAxis::EastWest;
+    const double value = Bench::quantize((axis == LineAxis::NorthSouth ? kLon0 : kLat0) + rng.uniform(0.0, kSpan));
+    double c[4];
+    for (double &v : c) v = Bench::quantize((axis == LineAxis::NorthSouth ? kLon0 : kLat0) + rng.uniform(0.0, kSpan));
+    double &prev = (axis == LineAxis::NorthSouth) ? c[1] : c[0];
+    double &cur = (axis == LineAxis::NorthSouth) ? c[3] : c[2];
+    if (rng.chance(0.25)) prev = value;
+    if (rng.chance(0.25)) cur = value;
+    const bool want = crossedLine(axis, value, c[0], c[1], c[2], c[3]);
+    const bool got = GeoMath::crossesAxis(GeoMath::toE6(value), GeoMath::toE6(prev), GeoMath::toE6(cur));
+    line_mismatches += want != got;
+    line_hits += want;
+  }
+  ok &= Bench::expect(line_mismatches == 0, "lines: %u steps (%u crossings): %u mismatches",
+                      steps, line_hits, line_mismatches);
+
+  printf("       ring tests/s: double %.2fM, int32 pointInRing %.2fM; containedAt (7 rings) %.2fM/s\n",
+         ring_tests / t_double / 1e6, ring_tests / t_kernel / 1e6, engine_tests / t_engine / 1e6);
+  return ok;
+}
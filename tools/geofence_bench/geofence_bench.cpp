@@ -0,0 +1,176 @@
+// tools/geofence_bench/geofence_bench.cpp
+// Runs the host checks for src/geofence. See run.sh.
+#include "geofence_bench.h"
+
+#include <LittleFS.h>
+#include <math.h>
+#include <time.h>
+
+bool checkFixedPoint(const Bench::Options &options);
+bool checkSwept(const Bench::Options &options);
+bool checkSimplify(const Bench::Options &options);
+bool checkGrid(const Bench::Options &options);
+bool checkMargin(const Bench::Options &options);
+bool checkHoles(const Bench::Options &options);
+bool checkBatch(const Bench::Options &options);
+bool checkTrack(const Bench::Options &options);
+bool checkTypes(const Bench::Options &options);
+bool checkCatalog(const Bench::Options &options);
+bool checkNames(const Bench::Options &options);
+bool checkSia2(const Bench::Options &options);
+
+namespace {
+  struct Check {
+    const char *name;
+    const char *what;
+    CheckFn run;
+  };
+
+  const Check kChecks[] = {
+    {"fixed", "int32 engine against the double ray cast and line test it replaced", checkFixedPoint},
+    {"swept", "swept keep-out hits and line crossings latch only once later fixes confirm them", checkSwept},
+    {"simplify", "one-sided ring simplification: containment side, simplicity, Hausdorff distance", checkSimplify},
+    {"grid", "cell grid against exact-only containment, incremental rebuild and blob boot", checkGrid},
+    {"margin", "per-fix margin from widening index queries against every rule, with many rules", checkMargin},
+    {"holes", "polygon rules with holes and islands: containment, margins, blob, arcs, simplification", checkHoles},
+    {"batch", "batch point-in-ring kernel against the single-point test, and throughput", checkBatch},
+    {"track", "pre-flight route check against hand cases and sampled SUA catalog entries", checkTrack},
+    {"types", "sua_type keep-outs: every area of the category loaded, or the load fails", checkTypes},
+    {"catalog", "SUA catalog from LittleFS against the mapped partition image", checkCatalog},
+    {"names", "SUA name lookup through the index hash section against a linear scan", checkNames},
+    {"sia2", "SIA2 geometry decode against the SIA1 catalog it was compacted from", checkSia2},
+  };
+
+  void usage(const char *argv0)
+  {
+    fprintf(stderr,
+            "usage: %s [--seed N] [--quick] [--fs DIR] [--catalog IDX BIN] [--partition IMAGE]\n"
+            "          [--sia1 IDX BIN] [--verbose] [CHECK...]\nchecks:\n",
+            argv0);
+    for (const Check &c : kChecks) fprintf(stderr, "  %-10s %s\n", c.name, c.what);
+    exit(2);
+  }
+}
+
+namespace Bench {
+
+double quantize(double deg)
+{
+  return (double)lround(deg * 1e6) / 1e6;
+}
+
+Ring randomRing(Rng &rng, double lat, double lon, double radiusDeg, size_t n, bool cw)
+{
+  std::vector<double> angles(n);
+  for (double &a : angles) a = rng.uniform(0.0, 2.0 * M_PI);
+  std::sort(angles.begin(), angles.end());
+  if (cw) std::reverse(angles.begin(), angles.end());
+  const double lon_stretch = 1.0 / cos(lat * M_PI / 180.0);
+  Ring ring;
+  for (double a : angles) {
+    const double r = radiusDeg * rng.uniform(0.3, 1.0);
+    ring.lat.push_back(quantize(lat + r * sin(a)));
+    ring.lon.push_back(quantize(lon + r * cos(a) * lon_stretch));
+  }
+  return ring;
+}
+
+void Arena::add(const Ring &ring)
+{
+  const size_t first = lat.size();
+  for (size_t i = 0; i <= ring.size(); i++) {
+    lat.push_back((int32_t)lround(ring.lat[i % ring.size()] * 1e6));
+    lon.push_back((int32_t)lround(ring.lon[i % ring.size()] * 1e6));
+  }
+  dlat.resize(lat.size());
+  dlon.resize(lon.size());
+  for (size_t i = first; i + 1 < lat.size(); i++) {
+    dlat[i] = lat[i + 1] - lat[i];
+    dlon[i] = lon[i + 1] - lon[i];
+  }
+  dlat.back() = 0;
+  dlon.back() = 0;
+}
+
+std::string ringJson(const Ring &ring)
+{
+  std::string out = "[";
+  char buf[64];
+  for (size_t i = 0; i < ring.size(); i++) {
+    snprintf(buf, sizeof(buf), "%s[%.6f,%.6f]", i ? "," : "", ring.lat[i], ring.lon[i]);
+    out += buf;
+  }
+  return out + "]";
+}
+
+bool writeFile(const char *path, const std::string &text)
+{
+  FILE *f = fopen((hostFsRoot + path).c_str(), "wb");
+  if (!f) return false;
+  const bool ok = fwrite(text.data(), 1, text.size(), f) == text.size();
+  return fclose(f) == 0 && ok;
+}
+
+double nowSeconds()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+bool expect(bool ok, const char *fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  printf("  %-4s ", ok ? "ok" : "FAIL");
+  vprintf(fmt, ap);
+  printf("\n");
+  va_end(ap);
+  fflush(stdout);
+  return ok;
+}
+
+}  // namespace Bench
+
+int main(int argc, char **argv)
+{
+  Bench::Options options;
+  std::vector<const Check *> selected;
+  hostFsRoot = ".";
+  for (int i = 1; i < argc; i++) {
+    const char *a = argv[i];
+    if (!strcmp(a, "--seed") && i + 1 < argc) options.seed = strtoul(argv[++i], nullptr, 0);
+    else if (!strcmp(a, "--quick")) options.scale = 0.1;
+    else if (!strcmp(a, "--verbose")) hostVerbose = true;
+    else if (!strcmp(a, "--fs") && i + 1 < argc) hostFsRoot = argv[++i];
+    else if (!strcmp(a, "--partition") && i + 1 < argc) options.partition = argv[++i];
+    else if (!strcmp(a, "--catalog") && i + 2 < argc) {
+      options.catalogIdx = argv[++i];
+      options.catalogBin = argv[++i];
+    } else if (!strcmp(a, "--sia1") && i + 2 < argc) {
+      options.sia1Idx = argv[++i];
+      options.sia1Bin = argv[++i];
+    } else {
+      const Check *found = nullptr;
+      for (const Check &c : kChecks) {
+        if (!strcmp(a, c.name)) found = &c;
+      }
+      if (!found) usage(argv[0]);
+      selected.push_back(found);
+    }
+  }
+  if (selected.empty()) {
+    for (const Check &c : kChecks) selected.push_back(&c);
+  }
+
+  int failed = 0;
+  for (const Check *c : selected) {
+    printf("[%s] %s\n", c->name, c->what);
+    const double start = Bench::nowSeconds();
+    const bool ok = c->run(options);
+    printf("[%s] %s in %.1f s\n", c->name, ok ? "passed" : "FAILED", Bench::nowSeconds() - start);
+    if (!ok) failed++;
+  }
+  printf("%d of %zu checks failed\n", failed, selected.size());
+  return failed ? 1 : 0;
+}
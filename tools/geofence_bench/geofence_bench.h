@@ -0,0 +1,77 @@
+// tools/geofence_bench/geofence_bench.h
+#pragma once
+// Host checks for src/geofence: each check builds its own inputs from a
+// seed, runs the firmware code against a reference and prints what it
+// measured. A check returns false when any comparison fails.
+#include <Arduino.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Bench {
+  struct Options {
+    uint32_t seed = 1;
+    double scale = 1.0;         // multiplies sample counts (--quick: 0.1)
+    std::string catalogIdx;     // LittleFS path of the SUA catalog index
+    std::string catalogBin;
+    std::string partition;      // catalog partition image (host file)
+    std::string sia1Idx;        // the same catalog with SIA1 geometry (LittleFS)
+    std::string sia1Bin;
+  };
+
+  // splitmix64: small, fast and the same on every host.
+  class Rng {
+  public:
+    explicit Rng(uint64_t seed) : _s(seed) {}
+    uint64_t next()
+    {
+      uint64_t z = (_s += 0x9E3779B97F4A7C15ULL);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      return z ^ (z >> 31);
+    }
+    uint32_t below(uint32_t n) { return (uint32_t)(next() % n); }
+    double uniform(double lo, double hi) { return lo + (hi - lo) * (double)(next() >> 11) / 9007199254740992.0; }
+    bool chance(double p) { return uniform(0.0, 1.0) < p; }
+  private:
+    uint64_t _s;
+  };
+
+  // Open ring (no repeated closing vertex) in degrees, every vertex on the
+  // micro-degree grid the engine stores.
+  struct Ring {
+    std::vector<double> lat;
+    std::vector<double> lon;
+    size_t size() const { return lat.size(); }
+  };
+
+  double quantize(double deg);
+
+  // Simple star-shaped ring of n vertices around a centre: sorted random
+  // angles, random radii between 0.3 and 1 times radiusDeg (longitude
+  // stretched by 1/cos(lat)). Reversed when cw is set.
+  Ring randomRing(Rng &rng, double lat, double lon, double radiusDeg, size_t n, bool cw = false);
+
+  // Rings laid out like the engine's vertex arena: closed, back to back,
+  // per-edge deltas, zero delta on each closing vertex.
+  struct Arena {
+    std::vector<int32_t> lat;
+    std::vector<int32_t> lon;
+    std::vector<int32_t> dlat;
+    std::vector<int32_t> dlon;
+    void add(const Ring &ring);
+    uint32_t count() const { return (uint32_t)lat.size(); }
+  };
+
+  // "[[lat, lon], ...]" with 6 decimals.
+  std::string ringJson(const Ring &ring);
+  // Writes a file under the LittleFS root (hostFsRoot).
+  bool writeFile(const char *path, const std::string &text);
+
+  double nowSeconds();
+
+  // Prints one result line, "ok" or "FAIL", and returns ok.
+  bool expect(bool ok, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+}
+
+typedef bool (*CheckFn)(const Bench::Options &options);
@@ -0,0 +1,258 @@
+// tools/geofence_bench/grid.cpp
+// The cell grid must never change an answer, only skip work. CellGrid is
+// checked on its own (every non-exact cell's set equals the rings holding
+// each point in it, and an incremental rebuild equals a fresh one), then
+// the engine's per-fix margin, which is signed by the containment result
+// the grid short-cuts, is checked against an exact-only reference after
+// a JSON load, a reload that adds a keep-out and a blob boot.
+#include "geofence_bench.h"
+
+#include <math.h>
+
+#include "geofence/CellGrid.h"
+#include "geofence/GeoFence.h"
+#include "geofence/GeoMath.h"
+
+namespace {
+  constexpr uint32_t kPoints = 200000;
+  constexpr uint32_t kFixes = 50000;
+  constexpr int kKeepOuts = 8;
+  constexpr double kLat0 = 35.0;
+  constexpr double kLon0 = -117.0;
+  constexpr double kRadius = 0.4;
+
+  struct Area {
+    Bench::Ring ring;
+    Bench::Arena arena;
+    CellGrid::Box box;
+    bool keepOut;
+  };
+
+  Area makeArea(const Bench::Ring &ring, bool keepOut)
+  {
+    Area a{ring, Bench::Arena(), CellGrid::Box{INT32_MAX, INT32_MAX, INT32_MIN, INT32_MIN}, keepOut};
+    a.arena.add(ring);
+    for (uint32_t i = 0; i < a.arena.count(); i++) {
+      a.box.min_lat = std::min(a.box.min_lat, a.arena.lat[i]);
+      a.box.max_lat = std::max(a.box.max_lat, a.arena.lat[i]);
+      a.box.min_lon = std::min(a.box.min_lon, a.arena.lon[i]);
+      a.box.max_lon = std::max(a.box.max_lon, a.arena.lon[i]);
+    }
+    return a;
+  }
+
+  bool inside(const Area &a, int32_t lat, int32_t lon)
+  {
+    const Bench::Arena &r = a.arena;
+    return GeoMath::pointInRing(r.lat.data(), r.lon.data(), r.dlat.data(), r.dlon.data(), r.count(), lat, lon);
+  }
+
+  float distance(const Area &a, int32_t lat, int32_t lon)
+  {
+    const Bench::Arena &r = a.arena;
+    float best = INFINITY;
+    for (uint32_t i = 0; i + 1 < r.count(); i++) {
+      best = fminf(best, GeoMath::segmentDistanceM(r.lat[i], r.lon[i], r.lat[i + 1], r.lon[i + 1], lat, lon));
+    }
+    return best;
+  }
+
+  // Exact classification of a box against a ring: any edge touching the
+  // box makes it Edge, otherwise its centre decides.
+  CellGrid::Side classify(const Area &a, const CellGrid::Box &b)
+  {
+    const Bench::Arena &r = a.arena;
+    for (uint32_t i = 0; i + 1 < r.count(); i++) {
+      const int32_t lat0 = r.lat[i], lon0 = r.lon[i], lat1 = r.lat[i + 1], lon1 = r.lon[i + 1];
+      if (std::max(lat0, lat1) < b.min_lat || std::min(lat0, lat1) > b.max_lat ||
+          std::max(lon0, lon1) < b.min_lon || std::min(lon0, lon1) > b.max_lon) {
+        continue;
+      }
+      if (lat0 >= b.min_lat && lat0 <= b.max_lat && lon0 >= b.min_lon && lon0 <= b.max_lon) {
+        return CellGrid::Side::Edge;
+      }
+      const int32_t cl[5] = {b.min_lat, b.min_lat, b.max_lat, b.max_lat, b.min_lat};
+      const int32_t co[5] = {b.min_lon, b.max_lon, b.max_lon, b.min_lon, b.min_lon};
+      for (int k = 0; k < 4; k++) {
+        if (GeoMath::segmentsIntersect(lat0, lon0, lat1, lon1, cl[k], co[k], cl[k + 1], co[k + 1])) {
+          return CellGrid::Side::Edge;
+        }
+      }
+    }
+    const int32_t lat = (int32_t)(((int64_t)b.min_lat + b.max_lat) / 2);
+    const int32_t lon = (int32_t)(((int64_t)b.min_lon + b.max_lon) / 2);
+    return inside(a, lat, lon) ? CellGrid::Side::Inside : CellGrid::Side::Outside;
+  }
+
+  uint32_t build(CellGrid &grid, const std::vector<const Area *> &areas, const CellGrid &prev)
+  {
+    std::vector<CellGrid::Box> boxes;
+    std::vector<uint32_t> keys;
+    CellGrid::Box extent = areas[0]->box;
+    for (const Area *a : areas) {
+      boxes.push_back(a->box);
+      keys.push_back((uint32_t)(uintptr_t)a);
+    }
+    return grid.build(CellGrid::extentFor(extent), std::move(boxes), std::move(keys), prev,
+                      [&](uint32_t item, const CellGrid::Box &b) { return classify(*areas[item], b); });
+  }
+
+  bool sameGrid(const CellGrid &a, const CellGrid &b)
+  {
+    if (a.cells().size() != b.cells().size()) return false;
+    for (size_t i = 0; i < a.cells().size(); i++) {
+      const uint8_t va = a.cells()[i];
+      const uint8_t vb = b.cells()[i];
+      if ((va == CellGrid::kClear) != (vb == CellGrid::kClear)) return false;
+      if ((va == CellGrid::kExact) != (vb == CellGrid::kExact)) return false;
+      if (va == CellGrid::kClear || va == CellGrid::kExact) continue;
+      if (!std::equal(a.setBegin(va), a.setEnd(va), b.setBegin(vb), b.setEnd(vb))) return false;
+    }
+    return true;
+  }
+
+  // Non-exact cells against the rings, on random points over the grid.
+  uint32_t gridMismatches(const CellGrid &grid, const std::vector<const Area *> &areas, Bench::Rng &rng,
+                          uint32_t points, uint32_t &settled)
+  {
+    const CellGrid::Box &e = grid.extent().box;
+    uint32_t bad = 0;
+    for (uint32_t i = 0; i < points; i++) {
+      const int32_t lat = e.min_lat + (int32_t)rng.below((uint32_t)(e.max_lat - e.min_lat + 1));
+      const int32_t lon = e.min_lon + (int32_t)rng.below((uint32_t)(e.max_lon - e.min_lon + 1));
+      const uint8_t cell = grid.at(lat, lon);
+      if (cell == CellGrid::kExact) continue;
+      settled++;
+      std::vector<uint16_t> want;
+      for (size_t k = 0; k < areas.size(); k++) {
+        if (inside(*areas[k], lat, lon)) want.push_back((uint16_t)k);
+      }
+      if (!std::equal(want.begin(), want.end(), grid.setBegin(cell), grid.setEnd(cell)) ||
+          (size_t)(grid.setEnd(cell) - grid.setBegin(cell)) != want.size()) {
+        bad++;
+      }
+    }
+    return bad;
+  }
+
+  std::string configJson(const std::vector<Area> &areas)
+  {
+    std::string json = "{\"lines\":[],\"stay_in\":[{\"id\":\"mission\",\"polygon\":" + Bench::ringJson(areas[0].ring) +
+                       "}],\"keep_out\":[";
+    for (size_t i = 1; i < areas.size(); i++) {
+      char head[48];
+      snprintf(head, sizeof(head), "%s{\"id\":\"k%zu\",\"polygon\":", i > 1 ? "," : "", i);
+      json += head + Bench::ringJson(areas[i].ring) + "}";
+    }
+    return json + "]}";
+  }
+
+  // Engine margin per fix against the same formula over exact containment
+  // (no altitude, so no bands). Fixes are far apart: every hop is a glitch
+  // and no swept check runs.
+  bool compareMargins(const char *what, const std::vector<Area> &areas, Bench::Rng &rng, uint32_t fixes)
+  {
+    GeoFence::resetStats();
+    GeoFence::update(kLat0, kLon0);  // arms the stay-in
+    uint32_t bad = 0;
+    uint32_t violating = 0;
+    double t_engine = 0.0;
+    for (uint32_t i = 0; i < fixes; i++) {
+      const double lat = Bench::quantize(kLat0 + rng.uniform(-1.2, 1.2) * kRadius);
+      const double lon = Bench::quantize(kLon0 + rng.uniform(-1.2, 1.2) * kRadius * 1.25);
+      const double e0 = Bench::nowSeconds();
+      GeoFence::update(lat, lon);
+      t_engine += Bench::nowSeconds() - e0;
+      float got = NAN, closing;
+      GeoFence::margin(got, closing);
+      const int32_t elat = GeoMath::toE6(lat);
+      const int32_t elon = GeoMath::toE6(lon);
+      float want = INFINITY;
+      for (const Area &a : areas) {
+        const bool in = inside(a, elat, elon);
+        const float d = distance(a, elat, elon);
+        want = fminf(want, (a.keepOut ? in : !in) ? -d : d);
+      }
+      if (want < 0) violating++;
+      if ((got < 0) != (want < 0) || fabsf(got - want) > 0.01f) bad++;
+    }
+    const GeoFence::Stats st = GeoFence::stats();
+    const GeoFence::LoadInfo li = GeoFence::loadInfo();
+    return Bench::expect(bad == 0,
+                         "%-14s %u fixes (%u violating): %u margin mismatches; grid %u cells, %u exact, "
+                         "%u classified, %u%% of fixes settled by it, %.2f us per update",
+                         what, (unsigned)fixes, (unsigned)violating, (unsigned)bad, (unsigned)li.gridCells,
+                         (unsigned)li.gridExactCells, (unsigned)li.gridClassified,
+                         (unsigned)(100ULL * st.cellHits / (fixes + 1)), t_engine * 1e6 / fixes);
+  }
+}
+
+bool checkGrid(const Bench::Options &options)
+{
+  bool ok = true;
+  Bench::Rng rng(options.seed * 104729ULL + 3);
+  const uint32_t points = (uint32_t)(kPoints * options.scale);
+  const uint32_t fixes = (uint32_t)(kFixes * options.scale);
+
+  // A dense mission outline with keep-outs inside it and across its edge.
+  std::vector<Area> areas;
+  Bench::Ring outline;
+  const size_t n = 2600;
+  for (size_t i = 0; i < n; i++) {
+    const double a = 2.0 * M_PI * (double)i / (double)n;
+    const double r = kRadius * (1.0 + 0.05 * sin(7.0 * a)) + rng.uniform(-0.0005, 0.0005);
+    outline.lat.push_back(Bench::quantize(kLat0 + r * sin(a)));
+    outline.lon.push_back(Bench::quantize(kLon0 + r * cos(a) * 1.22));
+  }
+  areas.push_back(makeArea(outline, false));
+  for (int k = 0; k < kKeepOuts; k++) {
+    const double a = rng.uniform(0.0, 2.0 * M_PI);
+    const double r = rng.uniform(0.1, 1.0) * kRadius;
+    areas.push_back(makeArea(Bench::randomRing(rng, kLat0 + r * sin(a), kLon0 + r * cos(a) * 1.22,
+                                               rng.uniform(0.02, 0.08), 8 + rng.below(40), rng.chance(0.5)),
+                             true));
+  }
+
+  // CellGrid alone: fresh build, then one keep-out removed incrementally.
+  std::vector<const Area *> all;
+  for (const Area &a : areas) all.push_back(&a);
+  CellGrid grid;
+  double t0 = Bench::nowSeconds();
+  const uint32_t full = build(grid, all, CellGrid());
+  const double full_ms = (Bench::nowSeconds() - t0) * 1e3;
+  uint32_t settled = 0;
+  const uint32_t bad = gridMismatches(grid, all, rng, points, settled);
+  ok &= Bench::expect(bad == 0, "CellGrid build: %zu cells, %zu exact, %zu sets, %u classified in %.1f ms; "
+                      "%u of %u points settled, %u wrong",
+                      grid.cellCount(), grid.countCells(CellGrid::kExact), grid.setCount(), (unsigned)full, full_ms,
+                      (unsigned)settled, (unsigned)points, (unsigned)bad);
+
+  std::vector<const Area *> fewer(all.begin(), all.end() - 1);
+  CellGrid incremental;
+  CellGrid fresh;
+  const uint32_t partial = build(incremental, fewer, grid);
+  build(fresh, fewer, CellGrid());
+  settled = 0;
+  const uint32_t bad_incr = gridMismatches(incremental, fewer, rng, points, settled);
+  ok &= Bench::expect(bad_incr == 0 && sameGrid(incremental, fresh) && partial < full,
+                      "CellGrid rebuild without one keep-out: %u cells classified (fresh build %u), "
+                      "same as a fresh build, %u wrong",
+                      (unsigned)partial, (unsigned)full, (unsigned)bad_incr);
+
+  // The engine: JSON load without the last keep-out, reload with it, then
+  // a boot from the blob that reload compiled.
+  std::vector<Area> first(areas.begin(), areas.end() - 1);
+  if (!Bench::writeFile("/bench_grid.json", configJson(first)) || !GeoFence::reload("/bench_grid.json")) {
+    return Bench::expect(false, "rule set did not load");
+  }
+  ok &= compareMargins("json load", first, rng, fixes);
+  if (!Bench::writeFile("/bench_grid.json", configJson(areas)) || !GeoFence::reload("/bench_grid.json")) {
+    return Bench::expect(false, "rule set did not reload");
+  }
+  ok &= compareMargins("reload +1", areas, rng, fixes);
+  if (!GeoFence::begin("/bench_grid.json") || !GeoFence::loadInfo().fromBlob) {
+    return Bench::expect(false, "blob did not load");
+  }
+  ok &= compareMargins("blob boot", areas, rng, fixes);
+  return ok;
+}
@@ -0,0 +1,246 @@
+// tools/geofence_bench/holes.cpp
+// Polygon rules with holes: an outline, a hole in it and an island in the
+// hole combine even-odd. Containment (stay-in, through containedAt) and
+// the signed margin (keep-out, through update) are checked against each
+// ring tested on its own, after a JSON load and a blob boot; then a
+// full-circle arc outline with a triangular hole, and one-sided
+// simplification of random outline/hole/island sets.
+#include "geofence_bench.h"
+
+#include <math.h>
+
+#include "geofence/GeoFence.h"
+#include "geofence/GeoMath.h"
+
+namespace {
+  constexpr uint32_t kPoints = 100000;
+  constexpr uint32_t kSimplifySets = 20;
+  constexpr uint32_t kSimplifyPoints = 20000;
+  constexpr float kSimplifyM = 300.0f;
+  constexpr double kLonStretch = 1.22;  // 1 / cos(35 deg), near enough for test shapes
+
+  // Noisy circle: n vertices, radius r (deg of latitude) +- noise.
+  Bench::Ring circle(Bench::Rng &rng, double lat, double lon, double r, size_t n, double noise)
+  {
+    Bench::Ring ring;
+    for (size_t i = 0; i < n; i++) {
+      const double a = 2.0 * M_PI * (double)i / (double)n;
+      const double d = r + rng.uniform(-noise, noise);
+      ring.lat.push_back(Bench::quantize(lat + d * sin(a)));
+      ring.lon.push_back(Bench::quantize(lon + d * cos(a) * kLonStretch));
+    }
+    return ring;
+  }
+
+  // Outline, hole and island around one centre, each ring tested alone.
+  struct Nest {
+    Bench::Ring rings[3];
+    Bench::Arena arenas[3];
+    double lat;
+    double lon;
+    double radius;
+
+    Nest(Bench::Rng &rng, double lat_, double lon_, double radius_, double noise) : lat(lat_), lon(lon_), radius(radius_)
+    {
+      const double scale[3] = {1.0, 0.5, 0.2};
+      const size_t n[3] = {400, 200, 60};
+      for (int k = 0; k < 3; k++) {
+        rings[k] = circle(rng, lat, lon, radius * scale[k], n[k], noise * scale[k]);
+        arenas[k].add(rings[k]);
+      }
+    }
+
+    // Even-odd over the three rings, each tested on its own.
+    bool inside(int32_t p_lat, int32_t p_lon) const
+    {
+      bool in = false;
+      for (const Bench::Arena &a : arenas) {
+        in ^= GeoMath::pointInRing(a.lat.data(), a.lon.data(), a.dlat.data(), a.dlon.data(), a.count(), p_lat, p_lon);
+      }
+      return in;
+    }
+
+    float distance(int32_t p_lat, int32_t p_lon) const
+    {
+      float best = INFINITY;
+      for (const Bench::Arena &a : arenas) {
+        for (uint32_t i = 0; i + 1 < a.count(); i++) {
+          best = fminf(best, GeoMath::segmentDistanceM(a.lat[i], a.lon[i], a.lat[i + 1], a.lon[i + 1], p_lat, p_lon));
+        }
+      }
+      return best;
+    }
+
+    std::string json(const char *id) const
+    {
+      return std::string("{\"id\":\"") + id + "\",\"polygon\":" + Bench::ringJson(rings[0]) + ",\"holes\":[" +
+             Bench::ringJson(rings[1]) + "," + Bench::ringJson(rings[2]) + "]}";
+    }
+
+    void sample(Bench::Rng &rng, int32_t &p_lat, int32_t &p_lon) const
+    {
+      p_lat = GeoMath::toE6(lat + rng.uniform(-1.1, 1.1) * radius);
+      p_lon = GeoMath::toE6(lon + rng.uniform(-1.1, 1.1) * radius * kLonStretch);
+    }
+  };
+
+  bool load(const std::string &json)
+  {
+    return Bench::writeFile("/bench_holes.json", json) && GeoFence::reload("/bench_holes.json");
+  }
+
+  // Stay-in containment against the nest, through containedAt().
+  uint32_t stayInMismatches(const Nest &nest, Bench::Rng &rng, uint32_t points, uint32_t &in)
+  {
+    uint32_t bad = 0;
+    for (uint32_t i = 0; i < points; i++) {
+      int32_t lat, lon;
+      nest.sample(rng, lat, lon);
+      const bool want = nest.inside(lat, lon);
+      in += want;
+      bad += GeoFence::containedAt(GeoMath::fromE6(lat), GeoMath::fromE6(lon), nullptr) != want;
+    }
+    return bad;
+  }
+
+  // Keep-out margin against the nest: sign from even-odd containment,
+  // magnitude from the nearest of the three rings.
+  uint32_t keepOutMismatches(const Nest &nest, Bench::Rng &rng, uint32_t points, uint32_t &in)
+  {
+    uint32_t bad = 0;
+    for (uint32_t i = 0; i < points; i++) {
+      int32_t lat, lon;
+      nest.sample(rng, lat, lon);
+      GeoFence::update(GeoMath::fromE6(lat), GeoMath::fromE6(lon));
+      float got = NAN, closing;
+      GeoFence::margin(got, closing);
+      const bool inside = nest.inside(lat, lon);
+      in += inside;
+      const float d = nest.distance(lat, lon);
+      bad += (got < 0) != inside || fabsf(fabsf(got) - d) > 0.01f;
+    }
+    return bad;
+  }
+
+  bool checkNests(Bench::Rng &rng, uint32_t points)
+  {
+    bool ok = true;
+    const Nest stay(rng, 35.0, -117.0, 0.4, 0.002);
+    const Nest keep(rng, 36.0, -117.0, 0.4, 0.002);
+    const std::string json = "{\"lines\":[],\"stay_in\":[" + stay.json("mission") + "],\"keep_out\":[" +
+                             keep.json("range") + "]}";
+    if (!load(json)) return Bench::expect(false, "outline/hole/island rule set did not load");
+
+    GeoFence::RuleInfo info;
+    uint32_t rings = 0;
+    for (size_t i = 0; GeoFence::ruleInfo(i, info); i++) rings += info.rings;
+    ok &= Bench::expect(rings == 6, "2 rules, %u rings stored (want 6)", (unsigned)rings);
+
+    for (int pass = 0; pass < 2; pass++) {
+      const char *what = pass ? "blob boot" : "json load";
+      if (pass && (!GeoFence::begin("/bench_holes.json") || !GeoFence::loadInfo().fromBlob)) {
+        return Bench::expect(false, "blob did not load");
+      }
+      // containedAt() first: update() inside the stay-in would arm it and
+      // bring it into the keep-out margins below.
+      uint32_t in = 0;
+      uint32_t bad = stayInMismatches(stay, rng, points, in);
+      ok &= Bench::expect(bad == 0, "%s stay-in:  %u points (%u inside), %u containment mismatches", what,
+                          (unsigned)points, (unsigned)in, (unsigned)bad);
+      in = 0;
+      bad = keepOutMismatches(keep, rng, points, in);
+      ok &= Bench::expect(bad == 0, "%s keep-out: %u points (%u inside), %u margin mismatches", what,
+                          (unsigned)points, (unsigned)in, (unsigned)bad);
+    }
+    return ok;
+  }
+
+  // Full circle (one vertex plus an arc on edge 0) with a triangle cut out.
+  bool checkArcOutline(Bench::Rng &rng, uint32_t points)
+  {
+    const double lat0 = 37.0, lon0 = -117.0, r = 0.1;
+    const Bench::Ring tri{{lat0 - 0.03, lat0 - 0.03, lat0 + 0.04}, {lon0 - 0.04, lon0 + 0.04, lon0}};
+    char head[160];
+    snprintf(head, sizeof(head),
+             "{\"lines\":[],\"keep_out\":[],\"stay_in\":[{\"id\":\"disk\",\"polygon\":[[%.6f,%.6f]],"
+             "\"arcs\":[{\"edge\":0,\"center\":[%.6f,%.6f]}],\"holes\":[",
+             lat0 + r, lon0, lat0, lon0);
+    if (!load(head + Bench::ringJson(tri) + "]}]}")) return Bench::expect(false, "arc rule set did not load");
+
+    Bench::Arena hole;
+    hole.add(tri);
+    const int32_t c_lat = GeoMath::toE6(lat0);
+    const int32_t c_lon = GeoMath::toE6(lon0);
+    const float radius = (float)(r * GeoMath::kMetersPerDegLat);
+    uint32_t bad = 0, in = 0, tested = 0;
+    for (uint32_t i = 0; i < points; i++) {
+      const int32_t lat = GeoMath::toE6(lat0 + rng.uniform(-1.2, 1.2) * r);
+      const int32_t lon = GeoMath::toE6(lon0 + rng.uniform(-1.2, 1.2) * r * kLonStretch);
+      const float x = (float)(lon - c_lon) * GeoMath::metersPerLonE6(c_lat);
+      const float y = (float)(lat - c_lat) * (GeoMath::kMetersPerDegLat / 1e6f);
+      const float d = sqrtf(x * x + y * y);
+      if (fabsf(d - radius) < 5.0f) continue;  // float rounding on the arc itself
+      const bool want = d < radius && !GeoMath::pointInRing(hole.lat.data(), hole.lon.data(), hole.dlat.data(),
+                                                            hole.dlon.data(), hole.count(), lat, lon);
+      tested++;
+      in += want;
+      bad += GeoFence::containedAt(GeoMath::fromE6(lat), GeoMath::fromE6(lon), nullptr) != want;
+    }
+    return Bench::expect(bad == 0, "full-circle arc outline with a triangular hole: %u points (%u inside), "
+                         "%u mismatches", (unsigned)tested, (unsigned)in, (unsigned)bad);
+  }
+
+  // Simplified at kSimplifyM, a stay-in may only lose area and a keep-out
+  // only gain it, holes included.
+  bool checkSimplified(Bench::Rng &rng, uint32_t sets, uint32_t points)
+  {
+    uint32_t off_side = 0, kept = 0, before = 0, after = 0;
+    char head[64];
+    for (uint32_t s = 0; s < sets; s++) {
+      const Nest nest(rng, 35.0 + rng.uniform(-5.0, 5.0), -117.0 + rng.uniform(-5.0, 5.0), rng.uniform(0.2, 0.6),
+                      0.004);
+      for (int keep_out = 0; keep_out < 2; keep_out++) {
+        snprintf(head, sizeof(head), "{\"simplify_m\":%.0f,\"lines\":[],", kSimplifyM);
+        const std::string rules = "[" + nest.json("nest") + "]";
+        if (!load(std::string(head) + (keep_out ? "\"stay_in\":[],\"keep_out\":" + rules
+                                                : "\"keep_out\":[],\"stay_in\":" + rules) + "}")) {
+          return Bench::expect(false, "set %u did not load", (unsigned)s);
+        }
+        GeoFence::RuleInfo info;
+        GeoFence::ruleInfo(0, info);
+        before += info.verticesIn;
+        after += info.vertices;
+        kept += info.vertices == info.verticesIn;
+        for (uint32_t i = 0; i < points; i++) {
+          int32_t lat, lon;
+          nest.sample(rng, lat, lon);
+          const bool exact = nest.inside(lat, lon);
+          if (keep_out) {
+            GeoFence::update(GeoMath::fromE6(lat), GeoMath::fromE6(lon));
+            float m = NAN, closing;
+            GeoFence::margin(m, closing);
+            off_side += exact && !(m < 0);
+          } else {
+            off_side += GeoFence::containedAt(GeoMath::fromE6(lat), GeoMath::fromE6(lon), nullptr) && !exact;
+          }
+        }
+      }
+    }
+    return Bench::expect(off_side == 0, "%u random outline/hole/island sets at %.0f m, stay-in and keep-out: "
+                         "%u points off-side, vertices %u -> %u, %u rules kept as loaded",
+                         (unsigned)sets, kSimplifyM, (unsigned)off_side, (unsigned)before, (unsigned)after,
+                         (unsigned)kept);
+  }
+}
+
+bool checkHoles(const Bench::Options &options)
+{
+  bool ok = true;
+  Bench::Rng rng(options.seed * 15485863ULL + 5);
+  const uint32_t points = std::max<uint32_t>(5000, (uint32_t)(kPoints * options.scale));
+  ok &= checkNests(rng, points);
+  ok &= checkArcOutline(rng, points);
+  ok &= checkSimplified(rng, std::max<uint32_t>(2, (uint32_t)(kSimplifySets * options.scale)),
+                        std::max<uint32_t>(2000, (uint32_t)(kSimplifyPoints * options.scale)));
+  return ok;
+}
@@ -0,0 +1,166 @@
+// tools/geofence_bench/margin.cpp
+// The per-fix margin with many rules: hundreds of small keep-outs
+// scattered inside a stay-in, fixes inside it, outside it and far away.
+// The engine takes its margin candidates from widening index queries;
+// the reference is the signed distance to every rule. Also reports how
+// many rules each fix actually measured. Last, reload() and update() in
+// one thread while another validates tracks and reads stats, as loop()
+// and the portal's AsyncTCP task do, expecting single-threaded answers.
+#include "geofence_bench.h"
+
+#include <math.h>
+#include <thread>
+
+#include "geofence/GeoFence.h"
+#include "geofence/GeoMath.h"
+
+namespace {
+  constexpr uint32_t kFixes = 20000;
+  constexpr uint32_t kKeepOuts[] = {50, 400, 1500};
+  constexpr double kLat0 = 35.0;
+  constexpr double kLon0 = -110.0;
+  constexpr double kHalf = 3.0;  // stay-in half side, deg
+  constexpr int kConcurrentPasses = 4;
+
+  struct Area {
+    Bench::Ring ring;
+    Bench::Arena arena;
+    bool keepOut;
+  };
+
+  float signedDistance(const Area &a, int32_t lat, int32_t lon)
+  {
+    const Bench::Arena &r = a.arena;
+    float d = INFINITY;
+    for (uint32_t i = 0; i + 1 < r.count(); i++) {
+      d = fminf(d, GeoMath::segmentDistanceM(r.lat[i], r.lon[i], r.lat[i + 1], r.lon[i + 1], lat, lon));
+    }
+    const bool in =
+        GeoMath::pointInRing(r.lat.data(), r.lon.data(), r.dlat.data(), r.dlon.data(), r.count(), lat, lon);
+    return (a.keepOut ? in : !in) ? -d : d;
+  }
+
+  bool run(Bench::Rng &rng, uint32_t keep_outs, uint32_t fixes)
+  {
+    std::vector<Area> areas;
+    const Bench::Ring square{{kLat0 - kHalf, kLat0 - kHalf, kLat0 + kHalf, kLat0 + kHalf},
+                             {kLon0 - kHalf, kLon0 + kHalf, kLon0 + kHalf, kLon0 - kHalf}};
+    areas.push_back({square, Bench::Arena(), false});
+    for (uint32_t k = 0; k < keep_outs; k++) {
+      areas.push_back({Bench::randomRing(rng, kLat0 + rng.uniform(-kHalf, kHalf) * 0.95,
+                                         kLon0 + rng.uniform(-kHalf, kHalf) * 0.95, rng.uniform(0.005, 0.05),
+                                         6 + rng.below(20), rng.chance(0.5)),
+                       Bench::Arena(), true});
+    }
+    std::string json = "{\"lines\":[],\"stay_in\":[{\"id\":\"mission\",\"polygon\":" + Bench::ringJson(square) +
+                       "}],\"keep_out\":[";
+    for (size_t i = 1; i < areas.size(); i++) {
+      areas[i].arena.add(areas[i].ring);
+      char head[48];
+      snprintf(head, sizeof(head), "%s{\"id\":\"k%zu\",\"polygon\":", i > 1 ? "," : "", i);
+      json += head + Bench::ringJson(areas[i].ring) + "}";
+    }
+    areas[0].arena.add(square);
+    if (!Bench::writeFile("/bench_margin.json", json + "]}") || !GeoFence::reload("/bench_margin.json")) {
+      return Bench::expect(false, "%u keep-outs did not load", (unsigned)keep_outs);
+    }
+
+    GeoFence::update(kLat0, kLon0);  // arms the stay-in
+    uint32_t bad = 0, outside = 0;
+    uint64_t measured = 0;
+    double t_engine = 0.0;
+    for (uint32_t i = 0; i < fixes; i++) {
+      // Mostly inside, some just outside the stay-in, a few far off.
+      const double spread = rng.chance(0.8) ? kHalf : rng.chance(0.8) ? kHalf * 1.3 : kHalf * 6.0;
+      const double lat = Bench::quantize(kLat0 + rng.uniform(-spread, spread));
+      const double lon = Bench::quantize(kLon0 + rng.uniform(-spread, spread));
+      // Long hops: every one is a glitch, so no swept check runs.
+      hostClockOffsetMs += 1000;
+      const double t0 = Bench::nowSeconds();
+      GeoFence::update(lat, lon);
+      t_engine += Bench::nowSeconds() - t0;
+      measured += GeoFence::stats().lastMarginRules;
+      float got = NAN, closing;
+      GeoFence::margin(got, closing);
+      const int32_t elat = GeoMath::toE6(lat), elon = GeoMath::toE6(lon);
+      float want = INFINITY;
+      for (const Area &a : areas) want = fminf(want, signedDistance(a, elat, elon));
+      outside += !GeoFence::containedAt(lat, lon, nullptr);
+      if ((got < 0) != (want < 0) || fabsf(got - want) > 0.01f) {
+        if (++bad <= 5) printf("       %.6f,%.6f: margin %.2f, want %.2f\n", lat, lon, got, want);
+      }
+    }
+    return Bench::expect(bad == 0,
+                         "%4u keep-outs, %u fixes (%u outside the stay-in): %u mismatches, %.1f rules measured "
+                         "per fix, %.2f us per update",
+                         (unsigned)keep_outs, (unsigned)fixes, (unsigned)outside, (unsigned)bad,
+                         (double)measured / fixes, t_engine * 1e6 / fixes);
+  }
+
+  std::vector<float> updatePass(const std::vector<std::pair<double, double>> &fixes)
+  {
+    std::vector<float> out;
+    GeoFence::update(kLat0, kLon0);
+    for (const auto &f : fixes) {
+      hostClockOffsetMs += 1000;
+      GeoFence::update(f.first, f.second);
+      float m = NAN, closing;
+      GeoFence::margin(m, closing);
+      out.push_back(m);
+    }
+    return out;
+  }
+
+  std::vector<std::pair<std::string, uint32_t>> trackPass(const std::vector<GeoFence::TrackPoint> &tk)
+  {
+    std::vector<std::pair<std::string, uint32_t>> out;
+    GeoFence::TrackReport rep;
+    GeoFence::validateTrack(tk.data(), tk.size(), false, rep);
+    for (const GeoFence::TrackHit &h : rep.hits) out.push_back({h.id.c_str(), h.leg});
+    return out;
+  }
+
+  // Rules from the last run() stay loaded.
+  bool runConcurrent(Bench::Rng &rng, uint32_t fixes)
+  {
+    std::vector<std::pair<double, double>> pos;
+    for (uint32_t i = 0; i < fixes; i++) {
+      pos.push_back({Bench::quantize(kLat0 + rng.uniform(-kHalf, kHalf) * 1.2),
+                     Bench::quantize(kLon0 + rng.uniform(-kHalf, kHalf) * 1.2)});
+    }
+    std::vector<GeoFence::TrackPoint> tk;
+    for (int i = 0; i < 200; i++) {
+      tk.push_back({kLat0 + rng.uniform(-kHalf, kHalf) * 1.1, kLon0 + rng.uniform(-kHalf, kHalf) * 1.1, NAN});
+    }
+    const std::vector<float> want_margin = updatePass(pos);
+    const auto want_hits = trackPass(tk);
+
+    uint32_t wrong_margin = 0, wrong_track = 0, evaluations = 0;
+    std::thread portal([&] {
+      for (int k = 0; k < kConcurrentPasses; k++) {
+        wrong_track += trackPass(tk) != want_hits;
+        evaluations = std::max(evaluations, GeoFence::stats().evaluations);
+      }
+    });
+    // Reloads too, as loop() does when the portal uploads rules.
+    for (int k = 0; k < kConcurrentPasses; k++) {
+      wrong_margin += !GeoFence::reload("/bench_margin.json") || updatePass(pos) != want_margin;
+    }
+    portal.join();
+    return Bench::expect(wrong_margin == 0 && wrong_track == 0 && evaluations > 0,
+                         "two threads, %d passes of a reload and %u updates and of a %zu-point track (%zu hits): %u margin and "
+                         "%u track passes differ from single-threaded",
+                         kConcurrentPasses, (unsigned)fixes, tk.size(), want_hits.size(), (unsigned)wrong_margin,
+                         (unsigned)wrong_track);
+  }
+}
+
+bool checkMargin(const Bench::Options &options)
+{
+  bool ok = true;
+  Bench::Rng rng(options.seed * 1000003ULL + 11);
+  const uint32_t fixes = std::max<uint32_t>(1000, (uint32_t)(kFixes * options.scale));
+  for (uint32_t n : kKeepOuts) ok &= run(rng, n, fixes);
+  ok &= runConcurrent(rng, fixes / 4);
+  return ok;
+}
@@ -0,0 +1,107 @@
+// tools/geofence_bench/names.cpp
+// SuaCatalog::findByName() through the index's hash section against a
+// linear scan of every entry name: each name as stored, upper-cased and
+// lower-cased, plus names that are not in the catalog. Times both on the
+// LittleFS and the partition source.
+#include "geofence_bench.h"
+
+#include <ctype.h>
+#include <map>
+#include <string.h>
+#include <strings.h>
+
+#include "geofence/SuaCatalog.h"
+
+namespace {
+  constexpr uint32_t kMisses = 2000;
+
+  std::string mapCase(const std::string &s, int (*fn)(int))
+  {
+    std::string out = s;
+    for (char &c : out) c = (char)fn((unsigned char)c);
+    return out;
+  }
+
+  // What the index section must reproduce: first entry with the name, any case.
+  int32_t linearFind(const std::vector<std::string> &names, const char *name)
+  {
+    for (size_t i = 0; i < names.size(); i++) {
+      if (!names[i].empty() && strcasecmp(names[i].c_str(), name) == 0) return (int32_t)i;
+    }
+    return -1;
+  }
+
+  bool checkSource(const char *what, Bench::Rng &rng, double scale)
+  {
+    std::vector<std::string> names;
+    std::map<std::string, uint32_t> seen;  // upper-cased name -> entries carrying it
+    char buf[64];
+    for (uint32_t i = 0; i < SuaCatalog::count(); i++) {
+      SuaCatalog::Entry e;
+      names.push_back(SuaCatalog::entry(i, e) && SuaCatalog::name(e, buf, sizeof(buf)) ? buf : "");
+      seen[mapCase(names.back(), toupper)]++;
+    }
+
+    std::vector<std::string> queries;
+    for (const std::string &n : names) {
+      if (n.empty()) continue;
+      queries.push_back(n);
+      queries.push_back(mapCase(n, toupper));
+      queries.push_back(mapCase(n, tolower));
+    }
+    const uint32_t found = (uint32_t)queries.size();
+    // Misses: real names with a character changed or appended, and noise.
+    const uint32_t misses = std::max<uint32_t>(200, (uint32_t)(kMisses * scale));
+    for (uint32_t k = 0; k < misses; k++) {
+      std::string q = names[rng.below((uint32_t)names.size())];
+      if (k % 3 == 0) q += (char)('0' + rng.below(10));
+      else if (k % 3 == 1 && !q.empty()) q[rng.below((uint32_t)q.size())] = '~';
+      else q = "NO SUCH AREA " + std::to_string(rng.below(100000));
+      if (seen.count(mapCase(q, toupper))) continue;
+      queries.push_back(q);
+    }
+
+    uint32_t wrong = 0, dup = 0;
+    std::vector<int32_t> want(queries.size());
+    const double t0 = Bench::nowSeconds();
+    for (size_t i = 0; i < queries.size(); i++) want[i] = linearFind(names, queries[i].c_str());
+    const double t_linear = Bench::nowSeconds() - t0;
+    std::vector<int32_t> got(queries.size());
+    const double t1 = Bench::nowSeconds();
+    for (size_t i = 0; i < queries.size(); i++) got[i] = SuaCatalog::findByName(queries[i].c_str());
+    const double t_hash = Bench::nowSeconds() - t1;
+    for (size_t i = 0; i < queries.size(); i++) {
+      if (got[i] == want[i]) continue;
+      // A name several areas share may resolve to any of them.
+      if (got[i] >= 0 && want[i] >= 0 && strcasecmp(names[got[i]].c_str(), names[want[i]].c_str()) == 0) {
+        dup++;
+        continue;
+      }
+      wrong++;
+      if (wrong <= 5) printf("       \"%s\": %d, scan %d\n", queries[i].c_str(), (int)got[i], (int)want[i]);
+    }
+    const bool empty_ok = SuaCatalog::findByName("") < 0 && SuaCatalog::findByName(nullptr) < 0;
+    return Bench::expect(SuaCatalog::hashIndexed() && wrong == 0 && empty_ok,
+                         "%-9s %u names found three ways and %zu misses: %u wrong (%u shared names), "
+                         "%.2f us per lookup, linear scan %.1f us",
+                         what, found / 3, queries.size() - found, (unsigned)wrong, (unsigned)dup,
+                         t_hash * 1e6 / queries.size(), t_linear * 1e6 / queries.size());
+  }
+}
+
+bool checkNames(const Bench::Options &options)
+{
+  bool ok = true;
+  Bench::Rng rng(options.seed * 998244353ULL + 7);
+  SuaCatalog::end();
+  if (!SuaCatalog::begin(options.catalogIdx.c_str(), options.catalogBin.c_str())) {
+    return Bench::expect(false, "LittleFS catalog did not open");
+  }
+  ok &= checkSource("LittleFS", rng, options.scale);
+  if (!SuaCatalog::beginPartition(options.partition.c_str())) {
+    return Bench::expect(false, "catalog partition image %s did not map", options.partition.c_str());
+  }
+  ok &= checkSource("partition", rng, options.scale);
+  SuaCatalog::end();
+  return ok;
+}
@@ -0,0 +1,31 @@
+#!/usr/bin/env bash
+# Builds geofence_bench against src/geofence and runs its checks on the
+# host. The SUA catalog checks use data/Portal/sua_catalog.{idx,bin}, from
+# LittleFS (copied into a scratch root) and as a partition image built
+# by build_sua_catalog.py, and expanded back to SIA1 geometry for the
+# sia2 check. Arguments go to the bench:
+#
+#   tools/geofence_bench/run.sh               # every check
+#   tools/geofence_bench/run.sh --quick fixed
+set -euo pipefail
+
+here=$(cd "$(dirname "$0")" && pwd)
+repo=$(cd "$here/../.." && pwd)
+out=${GEOFENCE_BENCH_OUT:-/tmp/geofence_bench}
+
+rm -rf "$out"
+mkdir -p "$out/fs/portal"
+cp "$repo/data/Portal/sua_catalog.idx" "$repo/data/Portal/sua_catalog.bin" "$out/fs/portal/"
+cp "$repo/data/Portal/sua_catalog.idx" "$out/fs/portal/sua_catalog_sia1.idx"
+cp "$repo/data/Portal/sua_catalog.bin" "$out/fs/portal/sua_catalog_sia1.bin"
+(cd "$repo" && python3 special_use_airspace/build_sua_catalog.py --partition "$out/sua_catalog.part" \
+  --idx data/Portal/sua_catalog.idx --bin data/Portal/sua_catalog.bin > /dev/null)
+python3 "$repo/special_use_airspace/build_sua_catalog.py" --expand \
+  --idx "$out/fs/portal/sua_catalog_sia1.idx" --bin "$out/fs/portal/sua_catalog_sia1.bin" > /dev/null
+
+"${CXX:-g++}" -std=gnu++17 -O2 -Wall -I"$here/../host" -I"$repo/src" -I"$repo/include" -o "$out/geofence_bench" \
+  "$here"/*.cpp "$here/../host/host.cpp" "$repo"/src/geofence/*.cpp
+
+"$out/geofence_bench" --fs "$out/fs" --catalog /portal/sua_catalog.idx /portal/sua_catalog.bin \
+  --partition "$out/sua_catalog.part" --sia1 /portal/sua_catalog_sia1.idx /portal/sua_catalog_sia1.bin \
+  "$@"
@@ -0,0 +1,146 @@
+// tools/geofence_bench/sia2.cpp
+// SuaCatalog::GeometryReader on the SIA2 catalog (LittleFS and partition)
+// against the same catalog expanded back to fixed-width SIA1: ring and
+// segment counts and every segment field must match for every area. Then
+// full-catalog decode throughput and block-cache traffic for each source.
+#include "geofence_bench.h"
+
+#include <LittleFS.h>
+#include <sys/stat.h>
+
+#include "geofence/SuaCatalog.h"
+
+namespace {
+  constexpr int kPasses = 20;
+
+  // Every area's segments in order, ring ends marked by a segment count.
+  struct Decoded {
+    std::vector<uint32_t> ringSegments;
+    std::vector<SuaCatalog::Segment> segments;
+    uint32_t badAreas = 0;
+  };
+
+  void decodeAll(Decoded &out)
+  {
+    SuaCatalog::Entry e;
+    SuaCatalog::GeometryReader reader;
+    for (uint32_t idx = 0; idx < SuaCatalog::count(); idx++) {
+      if (!SuaCatalog::entry(idx, e) || !reader.open(e)) {
+        out.badAreas++;
+        continue;
+      }
+      uint16_t n;
+      while (reader.nextRing(n)) {
+        uint32_t got = 0;
+        SuaCatalog::Segment seg;
+        while (reader.nextSegment(seg)) {
+          out.segments.push_back(seg);
+          got++;
+        }
+        out.badAreas += got != n;
+        out.ringSegments.push_back(got);
+      }
+    }
+  }
+
+  bool sameSegment(const SuaCatalog::Segment &a, const SuaCatalog::Segment &b)
+  {
+    if (a.type != b.type || a.start_lat != b.start_lat || a.start_lon != b.start_lon || a.end_lat != b.end_lat ||
+        a.end_lon != b.end_lon) {
+      return false;
+    }
+    if (a.type == SuaCatalog::SEG_LINE) return true;
+    return a.center_lat == b.center_lat && a.center_lon == b.center_lon && a.radius_m == b.radius_m &&
+           a.start_cd == b.start_cd && a.end_cd == b.end_cd && a.direction == b.direction;
+  }
+
+  // Decodes the open catalog once for the comparison, then kPasses more
+  // times for the timing; cache figures are per pass.
+  double timedDecode(Decoded &d, SuaCatalog::CacheStats &cache)
+  {
+    decodeAll(d);
+    const SuaCatalog::CacheStats before = SuaCatalog::cacheStats();
+    const double t0 = Bench::nowSeconds();
+    for (int k = 0; k < kPasses; k++) {
+      Decoded again;
+      decodeAll(again);
+    }
+    const double seconds = (Bench::nowSeconds() - t0) / kPasses;
+    const SuaCatalog::CacheStats &after = SuaCatalog::cacheStats();
+    cache.hits = (after.hits - before.hits) / kPasses;
+    cache.misses = (after.misses - before.misses) / kPasses;
+    cache.bytesRead = (after.bytesRead - before.bytesRead) / kPasses;
+    return seconds;
+  }
+
+  long fileSize(const std::string &path)
+  {
+    struct stat st;
+    return stat((hostFsRoot + path).c_str(), &st) == 0 ? (long)st.st_size : -1;
+  }
+
+  bool compare(const char *what, const Decoded &v1, const Decoded &v2)
+  {
+    uint32_t diff = 0;
+    const size_t n = std::min(v1.segments.size(), v2.segments.size());
+    for (size_t i = 0; i < n; i++) {
+      if (sameSegment(v1.segments[i], v2.segments[i])) continue;
+      if (++diff <= 5) {
+        const SuaCatalog::Segment &a = v1.segments[i], &b = v2.segments[i];
+        printf("       segment %zu: SIA1 %d %d,%d -> %d,%d, %s %d %d,%d -> %d,%d\n", i, a.type, (int)a.start_lat,
+               (int)a.start_lon, (int)a.end_lat, (int)a.end_lon, what, b.type, (int)b.start_lat, (int)b.start_lon,
+               (int)b.end_lat, (int)b.end_lon);
+      }
+    }
+    return Bench::expect(v2.badAreas == 0 && v1.ringSegments == v2.ringSegments &&
+                         v1.segments.size() == v2.segments.size() && diff == 0,
+                         "%-15s %zu rings, %zu segments (SIA1 %zu / %zu): %u differ, %u areas short or unreadable",
+                         what, v2.ringSegments.size(), v2.segments.size(), v1.ringSegments.size(),
+                         v1.segments.size(), (unsigned)diff, (unsigned)v2.badAreas);
+  }
+
+  void report(const char *what, size_t segments, double seconds, const SuaCatalog::CacheStats *cache)
+  {
+    printf("       %-15s %6.1f ms per catalog, %5.2f Mseg/s", what, seconds * 1e3, segments / seconds / 1e6);
+    if (cache) {
+      printf(", block cache %u misses / %u hits, %u KB read", (unsigned)cache->misses, (unsigned)cache->hits,
+             (unsigned)(cache->bytesRead / 1024));
+    }
+    printf("\n");
+  }
+}
+
+bool checkSia2(const Bench::Options &options)
+{
+  bool ok = true;
+  Decoded v1, v2, part;
+  SuaCatalog::CacheStats c1, c2, cp;
+
+  SuaCatalog::end();
+  if (!SuaCatalog::begin(options.sia1Idx.c_str(), options.sia1Bin.c_str()) || SuaCatalog::mapped()) {
+    return Bench::expect(false, "SIA1 catalog %s did not open", options.sia1Bin.c_str());
+  }
+  const double t1 = timedDecode(v1, c1);
+  if (!SuaCatalog::begin(options.catalogIdx.c_str(), options.catalogBin.c_str()) || SuaCatalog::mapped()) {
+    return Bench::expect(false, "LittleFS catalog did not open");
+  }
+  const double t2 = timedDecode(v2, c2);
+  if (!SuaCatalog::beginPartition(options.partition.c_str())) {
+    return Bench::expect(false, "catalog partition image %s did not map", options.partition.c_str());
+  }
+  const double tp = timedDecode(part, cp);
+  SuaCatalog::end();
+
+  ok &= Bench::expect(v1.badAreas == 0 && !v1.segments.empty(), "SIA1 %zu segments, %u areas unreadable",
+                      v1.segments.size(), (unsigned)v1.badAreas);
+  ok &= compare("SIA2 LittleFS", v1, v2);
+  ok &= compare("SIA2 partition", v1, part);
+
+  const long bin1 = fileSize(options.sia1Bin), bin2 = fileSize(options.catalogBin);
+  printf("       .bin %ld -> %ld bytes (%.0f%%)\n", bin1, bin2, bin1 > 0 ? 100.0 * bin2 / bin1 : 0.0);
+  report("SIA1 LittleFS", v1.segments.size(), t1, &c1);
+  report("SIA2 LittleFS", v2.segments.size(), t2, &c2);
+  report("SIA2 partition", part.segments.size(), tp, nullptr);
+  fflush(stdout);
+  return ok;
+}
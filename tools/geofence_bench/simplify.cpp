@@ -0,0 +1,219 @@
+// tools/geofence_bench/simplify.cpp
+// GeoSimplify::conservative() on random rings: the result may only gain
+// area for keep-outs (grow) and only lose it for stay-ins, stays simple,
+// and stays within tolerance_m of the original in both directions. Also
+// reports the vertices and containment-test time it saves.
+#include "geofence_bench.h"
+
+#include <math.h>
+
+#include "geofence/GeoMath.h"
+#include "geofence/GeoSimplify.h"
+
+namespace {
+  constexpr uint32_t kRings = 100;
+  constexpr uint32_t kSamplesPerRing = 4000;
+  constexpr float kTolerances[] = {25.0f, 100.0f, 400.0f};
+  // The simplifier rounds new vertices to the micro-degree grid.
+  constexpr float kRoundingM = 0.2f;
+
+  struct IntRing {
+    std::vector<int32_t> lat;
+    std::vector<int32_t> lon;
+    size_t size() const { return lat.size(); }
+  };
+
+  IntRing toInt(const Bench::Ring &ring)
+  {
+    IntRing out;
+    for (size_t i = 0; i < ring.size(); i++) {
+      out.lat.push_back(GeoMath::toE6(ring.lat[i]));
+      out.lon.push_back(GeoMath::toE6(ring.lon[i]));
+    }
+    return out;
+  }
+
+  Bench::Ring toDeg(const IntRing &ring)
+  {
+    Bench::Ring out;
+    for (size_t i = 0; i < ring.size(); i++) {
+      out.lat.push_back(GeoMath::fromE6(ring.lat[i]));
+      out.lon.push_back(GeoMath::fromE6(ring.lon[i]));
+    }
+    return out;
+  }
+
+  // Densely sampled circle with radial noise, like a digitised airspace
+  // outline: most vertices sit well inside any useful tolerance.
+  Bench::Ring noisyCircle(Bench::Rng &rng, double lat, double lon, double radiusDeg, size_t n, double noiseDeg,
+                          bool cw)
+  {
+    const double lon_stretch = 1.0 / cos(lat * M_PI / 180.0);
+    Bench::Ring ring;
+    for (size_t i = 0; i < n; i++) {
+      const double a = (cw ? -2.0 : 2.0) * M_PI * (double)i / (double)n;
+      const double r = radiusDeg + rng.uniform(-noiseDeg, noiseDeg);
+      ring.lat.push_back(Bench::quantize(lat + r * sin(a)));
+      ring.lon.push_back(Bench::quantize(lon + r * cos(a) * lon_stretch));
+    }
+    return ring;
+  }
+
+  bool simple(const IntRing &r)
+  {
+    const size_t n = r.size();
+    for (size_t i = 0; i < n; i++) {
+      const size_t i1 = (i + 1) % n;
+      for (size_t j = i + 2; j < n; j++) {
+        const size_t j1 = (j + 1) % n;
+        if (j1 == i) continue;  // adjacent through the closing edge
+        if (GeoMath::segmentsIntersect(r.lat[i], r.lon[i], r.lat[i1], r.lon[i1],
+                                       r.lat[j], r.lon[j], r.lat[j1], r.lon[j1])) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  float distanceToRing(const IntRing &r, int32_t lat, int32_t lon)
+  {
+    float best = INFINITY;
+    for (size_t i = 0; i < r.size(); i++) {
+      const size_t i1 = (i + 1) % r.size();
+      best = fminf(best, GeoMath::segmentDistanceM(r.lat[i], r.lon[i], r.lat[i1], r.lon[i1], lat, lon));
+    }
+    return best;
+  }
+
+  // Directed Hausdorff distance from a's boundary to b's, sampled at a's
+  // vertices and edge quarter points.
+  float directedHausdorff(const IntRing &a, const IntRing &b)
+  {
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size(); i++) {
+      const size_t i1 = (i + 1) % a.size();
+      for (int q = 0; q < 4; q++) {
+        const int32_t lat = a.lat[i] + (int32_t)lround((double)(a.lat[i1] - a.lat[i]) * q / 4.0);
+        const int32_t lon = a.lon[i] + (int32_t)lround((double)(a.lon[i1] - a.lon[i]) * q / 4.0);
+        worst = fmaxf(worst, distanceToRing(b, lat, lon));
+      }
+    }
+    return worst;
+  }
+
+  struct Result {
+    uint32_t rings = 0;
+    uint32_t sideErrors = 0;  // samples that moved to the protected side
+    uint32_t notSimple = 0;
+    float worstRatio = 0.0f;  // Hausdorff / tolerance
+    uint64_t before = 0;
+    uint64_t after = 0;
+  };
+
+  void checkOne(const Bench::Ring &ring, float tol, bool grow, Bench::Rng &rng, uint32_t samples, Result &res)
+  {
+    const IntRing orig = toInt(ring);
+    IntRing out = orig;
+    const size_t n = GeoSimplify::conservative(out.lat.data(), out.lon.data(), out.size(), tol, grow);
+    out.lat.resize(n);
+    out.lon.resize(n);
+    res.rings++;
+    res.before += orig.size();
+    res.after += n;
+
+    Bench::Arena a_orig;
+    Bench::Arena a_out;
+    a_orig.add(ring);
+    a_out.add(toDeg(out));
+    int32_t min_lat = INT32_MAX, min_lon = INT32_MAX, max_lat = INT32_MIN, max_lon = INT32_MIN;
+    for (size_t i = 0; i < orig.size(); i++) {
+      min_lat = std::min(min_lat, orig.lat[i]);
+      max_lat = std::max(max_lat, orig.lat[i]);
+      min_lon = std::min(min_lon, orig.lon[i]);
+      max_lon = std::max(max_lon, orig.lon[i]);
+    }
+    const int32_t pad = (int32_t)(tol / GeoMath::kMetersPerDegLat * 2e6f);
+    for (uint32_t s = 0; s < samples; s++) {
+      const int32_t lat = min_lat - pad + (int32_t)rng.below((uint32_t)(max_lat - min_lat + 2 * pad));
+      const int32_t lon = min_lon - pad + (int32_t)rng.below((uint32_t)(max_lon - min_lon + 2 * pad));
+      const bool in_orig = GeoMath::pointInRing(a_orig.lat.data(), a_orig.lon.data(), a_orig.dlat.data(),
+                                                a_orig.dlon.data(), a_orig.count(), lat, lon);
+      const bool in_out = GeoMath::pointInRing(a_out.lat.data(), a_out.lon.data(), a_out.dlat.data(),
+                                               a_out.dlon.data(), a_out.count(), lat, lon);
+      if (grow ? (in_orig && !in_out) : (in_out && !in_orig)) res.sideErrors++;
+    }
+
+    if (!simple(out)) res.notSimple++;
+    const float h = fmaxf(directedHausdorff(orig, out), directedHausdorff(out, orig));
+    res.worstRatio = fmaxf(res.worstRatio, (h - kRoundingM) / tol);
+  }
+
+  // Nanoseconds per containment test on a ring, for the before/after timing.
+  double nsPerTest(const Bench::Ring &ring, Bench::Rng &rng, uint32_t points)
+  {
+    Bench::Arena a;
+    a.add(ring);
+    std::vector<int32_t> lat(points);
+    std::vector<int32_t> lon(points);
+    for (uint32_t i = 0; i < points; i++) {
+      const size_t v = rng.below((uint32_t)ring.size());
+      lat[i] = GeoMath::toE6(ring.lat[v]) + (int32_t)rng.below(2001) - 1000;
+      lon[i] = GeoMath::toE6(ring.lon[v]) + (int32_t)rng.below(2001) - 1000;
+    }
+    volatile uint32_t inside = 0;
+    const double t0 = Bench::nowSeconds();
+    for (uint32_t i = 0; i < points; i++) {
+      inside += GeoMath::pointInRing(a.lat.data(), a.lon.data(), a.dlat.data(), a.dlon.data(), a.count(),
+                                     lat[i], lon[i]);
+    }
+    const double dt = Bench::nowSeconds() - t0;
+    return dt * 1e9 / points;
+  }
+}
+
+bool checkSimplify(const Bench::Options &options)
+{
+  bool ok = true;
+  Bench::Rng rng(options.seed * 7919ULL + 11);
+  const uint32_t rings = std::max<uint32_t>(6, (uint32_t)(kRings * options.scale));
+  const uint32_t samples = std::max<uint32_t>(400, (uint32_t)(kSamplesPerRing * options.scale));
+
+  for (float tol : kTolerances) {
+    for (int grow = 1; grow >= 0; grow--) {
+      Result res;
+      for (uint32_t i = 0; i < rings; i++) {
+        const double lat = rng.uniform(-60.0, 60.0);
+        const double lon = rng.uniform(-170.0, 170.0);
+        const size_t n = 20 + rng.below(381);
+        const bool cw = rng.chance(0.5);
+        const Bench::Ring ring = rng.chance(0.5)
+                                     ? noisyCircle(rng, lat, lon, rng.uniform(0.05, 0.5), n,
+                                                   rng.uniform(0.0, 3.0 * tol / 111320.0), cw)
+                                     : Bench::randomRing(rng, lat, lon, rng.uniform(0.05, 0.5), n, cw);
+        checkOne(ring, tol, grow != 0, rng, samples, res);
+      }
+      ok &= Bench::expect(res.sideErrors == 0 && res.notSimple == 0 && res.worstRatio <= 1.0f,
+                          "%s %3.0f m: %u rings, %u samples off-side, %u not simple, Hausdorff/tol %.3f, "
+                          "vertices %llu -> %llu",
+                          grow ? "grow  " : "shrink", tol, (unsigned)res.rings, (unsigned)res.sideErrors,
+                          (unsigned)res.notSimple, res.worstRatio, (unsigned long long)res.before,
+                          (unsigned long long)res.after);
+    }
+  }
+
+  // What it buys on dense outlines at the portal's default 25 m.
+  const uint32_t points = std::max<uint32_t>(20000, (uint32_t)(200000 * options.scale));
+  for (size_t n : {600, 2000}) {
+    const Bench::Ring ring = noisyCircle(rng, 35.0, -117.0, 0.3, n, 0.0001, false);
+    IntRing out = toInt(ring);
+    const double t0 = Bench::nowSeconds();
+    const size_t kept = GeoSimplify::conservative(out.lat.data(), out.lon.data(), out.size(), 25.0f, true);
+    const double simplify_ms = (Bench::nowSeconds() - t0) * 1e3;
+    out.lat.resize(kept);
+    out.lon.resize(kept);
+    printf("       %4zu-vertex outline at 25 m: %zu vertices, %.0f -> %.0f ns per test, simplified in %.1f ms\n",
+           n, kept, nsPerTest(ring, rng, points), nsPerTest(toDeg(out), rng, points), simplify_ms);
+  }
+  return ok;
+}
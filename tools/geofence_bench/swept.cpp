@@ -0,0 +1,102 @@
+// tools/geofence_bench/swept.cpp
+// Swept keep-out hits and line crossings are only latched once later fixes
+// confirm them: a real transit has to terminate after the usual debounce,
+// and a single bad fix that clips a rule and comes back has to be dropped.
+#include "geofence_bench.h"
+
+#include "geofence/GeoFence.h"
+
+namespace {
+  constexpr uint32_t kFixMs = 3000;     // fix spacing; 150 m/s allows 450 m
+  constexpr double kHalf = 0.001;       // keep-out half width, ~110 m
+  constexpr double kStep = 0.002;       // ~180 m of longitude per fix at 35 N
+
+  struct Fix {
+    double lat;
+    double lon;
+  };
+
+  // Feeds the fixes kFixMs apart and returns the index of the first one
+  // update() reported a violation for, or -1. pending is the first fix
+  // violationPending() was set after, or -1.
+  int fly(const std::vector<Fix> &fixes, int &pending)
+  {
+    int first = -1;
+    pending = -1;
+    for (size_t i = 0; i < fixes.size(); i++) {
+      if (i) hostClockOffsetMs += kFixMs;
+      if (GeoFence::update(fixes[i].lat, fixes[i].lon) && first < 0) first = (int)i;
+      if (GeoFence::violationPending() && pending < 0) pending = (int)i;
+    }
+    return first;
+  }
+
+  bool load(double lat, double lon)
+  {
+    char json[512];
+    snprintf(json, sizeof(json),
+             "{\"keep_out\":[{\"id\":\"box\",\"polygon\":[[%.6f,%.6f],[%.6f,%.6f],[%.6f,%.6f],[%.6f,%.6f]]}],"
+             "\"stay_in\":[],\"lines\":[{\"id\":\"fence\",\"axis\":\"N/S\",\"value\":%.6f}]}",
+             lat - kHalf, lon - kHalf, lat - kHalf, lon + kHalf, lat + kHalf, lon + kHalf, lat + kHalf, lon - kHalf,
+             lon + 0.5);
+    return Bench::writeFile("/bench_swept.json", json) && GeoFence::reload("/bench_swept.json");
+  }
+
+  // Each case gets its own area, far enough from the last one that the
+  // first fix is an implausible hop and starts a fresh track.
+  bool run(const char *name, double lat, double lon, const std::vector<Fix> &offsets, int expectFirst,
+           uint32_t expectDropped)
+  {
+    if (!load(lat, lon)) return Bench::expect(false, "%s: rule set did not load", name);
+    GeoFence::resetStats();
+    std::vector<Fix> fixes;
+    for (const Fix &f : offsets) fixes.push_back({lat + f.lat, lon + f.lon});
+    int pending;
+    const int first = fly(fixes, pending);
+    const uint32_t dropped = GeoFence::stats().transitsDropped;
+    // A violation is always announced as pending first.
+    const bool pending_ok = first < 0 || (pending >= 0 && pending < first);
+    return Bench::expect(first == expectFirst && dropped == expectDropped && pending_ok,
+                         "%-28s first violation at fix %d (want %d, pending from %d), transits dropped %u (want %u)",
+                         name, first, expectFirst, pending, (unsigned)dropped, (unsigned)expectDropped);
+  }
+}
+
+bool checkSwept(const Bench::Options &options)
+{
+  (void)options;
+  bool ok = true;
+  const double y = 0.0002;  // keep the track off the box corners
+
+  // Straight through the box between two fixes and on east: the hit is
+  // confirmed by the next two fixes, the debounce runs its 3 fixes / 5 s.
+  ok &= run("keep-out transit", 35.0, -117.0,
+            {{y, -2 * kStep}, {y, -kStep}, {y, kStep}, {y, 2 * kStep}, {y, 3 * kStep}, {y, 4 * kStep}}, 4, 0);
+  // One fix lands past the box and the next is back where the track was.
+  ok &= run("keep-out glitch", 35.5, -117.0,
+            {{y, -2 * kStep}, {y, -kStep}, {y, kStep}, {y, -kStep}, {y, -kStep}, {y, -kStep}}, -1, 1);
+  // The glitch fix is far enough out to be implausible on its own: it is
+  // not evaluated as a path, so nothing is latched or dropped.
+  ok &= run("keep-out implausible", 36.0, -117.0,
+            {{y, -2 * kStep}, {y, -kStep}, {y, 20 * kStep}, {y, -kStep}, {y, -kStep}}, -1, 0);
+
+  // The same for the line half a degree east of the box.
+  ok &= run("line transit", 36.5, -117.0,
+            {{0, 0.5 - kStep}, {0, 0.5 + kStep}, {0, 0.5 + 2 * kStep}, {0, 0.5 + 3 * kStep}, {0, 0.5 + 4 * kStep}},
+            3, 0);
+  // Once confirmed the crossing stays latched, however long the track
+  // then sits past the line, until clearViolations().
+  bool held = true;
+  for (int i = 0; i < 5; i++) {
+    hostClockOffsetMs += kFixMs;
+    held &= GeoFence::update(36.5, -117.0 + 0.5 + 4 * kStep);
+  }
+  GeoFence::clearViolations();
+  hostClockOffsetMs += kFixMs;
+  const bool cleared = !GeoFence::update(36.5, -117.0 + 0.5 + 4 * kStep) && GeoFence::violationCount() == 0;
+  ok &= Bench::expect(held && cleared, "%-28s held over 5 fixes %s, cleared by clearViolations() %s", "line latched",
+                      held ? "yes" : "no", cleared ? "yes" : "no");
+  ok &= run("line glitch", 37.0, -117.0,
+            {{0, 0.5 - 2 * kStep}, {0, 0.5 - kStep}, {0, 0.5 + kStep}, {0, 0.5 - kStep}, {0, 0.5 - kStep}}, -1, 1);
+  return ok;
+}
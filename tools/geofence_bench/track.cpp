@@ -0,0 +1,168 @@
+// tools/geofence_bench/track.cpp
+// GeoFence::validateTrack() (the portal's pre-flight route check): a few
+// hand-computed entries and crossings, then random climbing and descending
+// zigzags across the R-2508 complex against brute-force sampling of every
+// catalog area through SuaCatalog::contains() and its altitude band.
+#include "geofence_bench.h"
+
+#include <math.h>
+#include <set>
+#include <string>
+
+#include "geofence/GeoFence.h"
+#include "geofence/GeoMath.h"
+#include "geofence/SuaCatalog.h"
+
+namespace {
+  constexpr size_t kTrackSizes[] = {100, 400, 1000};
+  constexpr int kSamplesPerLeg = 2000;
+
+  typedef std::set<std::pair<std::string, uint32_t>> Entries;  // area name, leg
+
+  bool load(const char *json)
+  {
+    return Bench::writeFile("/bench_track.json", json) && GeoFence::reload("/bench_track.json");
+  }
+
+  const GeoFence::TrackHit *findHit(const GeoFence::TrackReport &rep, const char *id)
+  {
+    for (const GeoFence::TrackHit &h : rep.hits) {
+      if (h.id == id) return &h;
+    }
+    return nullptr;
+  }
+
+  // A 0.1 deg keep-out box, the same box banded from 1000 m up, and a N/S
+  // line, crossed by straight tracks whose answers follow from the layout.
+  bool checkHandCases()
+  {
+    bool ok = true;
+    if (!load("{\"stay_in\":[],"
+              "\"keep_out\":[{\"id\":\"box\",\"polygon\":[[35.0,-117.0],[35.0,-116.9],[35.1,-116.9],[35.1,-117.0]]},"
+              "{\"id\":\"banded\",\"floor_m\":1000,\"polygon\":[[36.0,-117.0],[36.0,-116.9],[36.1,-116.9],"
+              "[36.1,-117.0]]}],"
+              "\"lines\":[{\"id\":\"fence\",\"axis\":\"N/S\",\"value\":-116.8}]}")) {
+      return Bench::expect(false, "hand-case rule set did not load");
+    }
+    const float m_per_lon = GeoMath::metersPerLonE6(GeoMath::toE6(35.05)) * 1e6f;
+
+    // East along 35.05 from -117.1: into the box after 0.1 deg, over the
+    // line after 0.3 deg.
+    const GeoFence::TrackPoint east[] = {{35.05, -117.1, NAN}, {35.05, -116.7, NAN}};
+    GeoFence::TrackReport rep;
+    GeoFence::validateTrack(east, 2, false, rep);
+    const GeoFence::TrackHit *box = findHit(rep, "box");
+    const GeoFence::TrackHit *line = findHit(rep, "fence");
+    ok &= Bench::expect(box && fabsf(box->alongM - 0.1f * m_per_lon) < 2.0f && fabsf((float)box->lon + 117.0f) < 1e-5f,
+                        "box entry at %.1f m (want %.1f), lon %.6f", box ? box->alongM : NAN, 0.1f * m_per_lon,
+                        box ? box->lon : NAN);
+    ok &= Bench::expect(line && line->type == "line" && fabsf(line->alongM - 0.3f * m_per_lon) < 2.0f,
+                        "line crossing at %.1f m (want %.1f)", line ? line->alongM : NAN, 0.3f * m_per_lon);
+    ok &= Bench::expect(rep.hits.size() == 2, "%zu hits on the eastbound track (want 2)", rep.hits.size());
+
+    // Straight up through the banded box's middle: entered where the climb
+    // from 0 to 2000 m passes its floor, halfway along.
+    const GeoFence::TrackPoint climb[] = {{36.02, -116.95, 0.0f}, {36.08, -116.95, 2000.0f}};
+    GeoFence::validateTrack(climb, 2, false, rep);
+    const GeoFence::TrackHit *banded = findHit(rep, "banded");
+    const float half = 0.03f * GeoMath::kMetersPerDegLat;
+    ok &= Bench::expect(banded && fabsf(banded->alongM - half) < 2.0f && fabsf(banded->altM - 1000.0f) < 1.0f,
+                        "climb into the banded box at %.1f m, %.1f m MSL (want %.1f m, 1000 m MSL)",
+                        banded ? banded->alongM : NAN, banded ? banded->altM : NAN, half);
+    return ok;
+  }
+
+  // Zigzag across the R-2508 complex, climbing and descending.
+  std::vector<GeoFence::TrackPoint> zigzag(Bench::Rng &rng, size_t n)
+  {
+    std::vector<GeoFence::TrackPoint> tk;
+    double lat = 34.6, lon = -118.4;
+    for (size_t i = 0; i < n; i++) {
+      lat += rng.uniform(-0.004, 0.016) * (400.0 / n) * 1.3;
+      lon += rng.uniform(-0.002, 0.018) * (400.0 / n) * 2.5;
+      tk.push_back({lat, lon, 3000.0f + 2800.0f * sinf((float)i * 6.2832f / (float)n * 3.0f)});
+    }
+    return tk;
+  }
+
+  // Every leg on which the track goes from outside an area (or its band)
+  // to inside, plus leg 0 when it starts inside, by dense sampling.
+  Entries sampledEntries(const std::vector<GeoFence::TrackPoint> &tk)
+  {
+    Entries ref;
+    SuaCatalog::Entry e;
+    char name[64];
+    for (uint32_t idx = 0; idx < SuaCatalog::count(); idx++) {
+      if (!SuaCatalog::entry(idx, e) || !SuaCatalog::name(e, name, sizeof(name))) continue;
+      auto inside = [&](size_t i, double t) {
+        const double lat = tk[i].lat + t * (tk[i + 1].lat - tk[i].lat);
+        const double lon = tk[i].lon + t * (tk[i + 1].lon - tk[i].lon);
+        const int32_t alt = (int32_t)lroundf(tk[i].altM + (float)t * (tk[i + 1].altM - tk[i].altM));
+        if (alt < e.floor_m || alt > e.ceil_m) return false;
+        return SuaCatalog::contains(e, GeoMath::toE6(lat), GeoMath::toE6(lon));
+      };
+      if (inside(0, 0.0)) ref.insert({name, 0});
+      for (size_t i = 0; i + 1 < tk.size(); i++) {
+        const double min_lat = std::min(tk[i].lat, tk[i + 1].lat) * 1e6, max_lat = std::max(tk[i].lat, tk[i + 1].lat) * 1e6;
+        const double min_lon = std::min(tk[i].lon, tk[i + 1].lon) * 1e6, max_lon = std::max(tk[i].lon, tk[i + 1].lon) * 1e6;
+        if (max_lat < e.min_lat || min_lat > e.max_lat || max_lon < e.min_lon || min_lon > e.max_lon) continue;
+        const bool start = inside(i, 0.0);
+        bool prev = start;
+        for (int k = 1; k <= kSamplesPerLeg && !start; k++) {
+          const bool cur = inside(i, (double)k / kSamplesPerLeg);
+          if (cur && !prev) ref.insert({name, (uint32_t)i});
+          prev = cur;
+        }
+      }
+    }
+    return ref;
+  }
+
+  bool checkCatalogTracks(Bench::Rng &rng, const Bench::Options &options)
+  {
+    bool ok = true;
+    if (!load("{\"stay_in\":[],\"keep_out\":[],\"lines\":[]}")) return Bench::expect(false, "empty rule set did not load");
+    SuaCatalog::end();
+    if (!SuaCatalog::begin(options.catalogIdx.c_str(), options.catalogBin.c_str())) {
+      return Bench::expect(false, "SUA catalog did not open");
+    }
+    for (size_t n : kTrackSizes) {
+      const std::vector<GeoFence::TrackPoint> tk = zigzag(rng, n);
+      GeoFence::TrackReport rep;
+      if (!GeoFence::validateTrack(tk.data(), tk.size(), true, rep)) {
+        ok &= Bench::expect(false, "%zu-point track rejected", n);
+        continue;
+      }
+      Entries got;
+      for (const GeoFence::TrackHit &h : rep.hits) {
+        if (h.type == "sua") got.insert({h.id.c_str(), h.leg});
+      }
+      const Entries ref = sampledEntries(tk);
+      uint32_t missing = 0, extra = 0;
+      for (const auto &r : ref) {
+        if (got.count(r)) continue;
+        missing++;
+        printf("       missing %s on leg %u\n", r.first.c_str(), (unsigned)r.second);
+      }
+      for (const auto &g : got) {
+        if (ref.count(g)) continue;
+        extra++;
+        printf("       extra %s on leg %u\n", g.first.c_str(), (unsigned)g.second);
+      }
+      ok &= Bench::expect(missing == 0 && extra == 0 && !rep.truncated,
+                          "%4zu points, %.0f km, %u areas checked: %zu entries (sampled %zu), %u missing, %u extra, "
+                          "%u us",
+                          n, rep.lengthM / 1000.0f, (unsigned)rep.areasChecked, got.size(), ref.size(),
+                          (unsigned)missing, (unsigned)extra, (unsigned)rep.elapsedUs);
+    }
+    return ok;
+  }
+}
+
+bool checkTrack(const Bench::Options &options)
+{
+  Bench::Rng rng(options.seed * 40503ULL + 29);
+  bool ok = checkHandCases();
+  ok &= checkCatalogTracks(rng, options);
+  return ok;
+}
@@ -0,0 +1,105 @@
+// tools/geofence_bench/types.cpp
+// "sua_type" category keep-outs with no stay-in to narrow them: every
+// area of the type is loaded, however many, and each answers through the
+// index like any keep-out (a short track starting inside it reports it),
+// after the JSON load and a blob boot alike. With too little heap for a
+// category the load fails instead and reports the areas it refused.
+#include "geofence_bench.h"
+
+#include "geofence/GeoFence.h"
+#include "geofence/SuaCatalog.h"
+
+namespace {
+  const char *const kTypes[] = {"MOA", "R"};
+  constexpr uint32_t kTries = 200;  // random bbox points per area to find one inside
+  // Where the count cap on one category used to cut it off.
+  constexpr uint32_t kOldCap = 256;
+
+  const char *kJson = "{\"stay_in\":[],\"lines\":[],\"keep_out\":[{\"id\":\"no MOA\",\"sua_type\":\"MOA\"},"
+                      "{\"id\":\"no R\",\"sua_type\":\"R\"}]}";
+
+  // Areas of the category with no track hit starting inside them.
+  uint32_t missedAreas(Bench::Rng &rng, const std::vector<uint32_t> &areas, uint32_t &tested)
+  {
+    uint32_t missed = 0;
+    tested = 0;
+    char name[64];
+    for (uint32_t idx : areas) {
+      SuaCatalog::Entry e;
+      if (!SuaCatalog::entry(idx, e) || !SuaCatalog::name(e, name, sizeof(name))) {
+        missed++;
+        continue;
+      }
+      int32_t lat = 0, lon = 0;
+      bool found = false;
+      for (uint32_t k = 0; k < kTries && !found; k++) {
+        lat = e.min_lat + (int32_t)rng.below((uint32_t)(e.max_lat - e.min_lat) + 1);
+        lon = e.min_lon + (int32_t)rng.below((uint32_t)(e.max_lon - e.min_lon) + 1);
+        found = SuaCatalog::contains(e, lat, lon);
+      }
+      if (!found) continue;  // a sliver the random points never hit
+      tested++;
+      const GeoFence::TrackPoint tk[] = {{lat / 1e6, lon / 1e6, NAN}, {lat / 1e6 + 1e-6, lon / 1e6, NAN}};
+      GeoFence::TrackReport rep;
+      bool hit = false;
+      if (GeoFence::validateTrack(tk, 2, false, rep)) {
+        for (const GeoFence::TrackHit &h : rep.hits) hit |= h.leg == 0 && h.id == name;
+      }
+      if (!hit && ++missed <= 5) printf("       %s (area %u) not reported at %d,%d\n", name, (unsigned)idx, (int)lat, (int)lon);
+    }
+    return missed;
+  }
+}
+
+bool checkTypes(const Bench::Options &options)
+{
+  bool ok = true;
+  Bench::Rng rng(options.seed * 69069ULL + 5);
+  SuaCatalog::end();
+  if (!SuaCatalog::begin(options.catalogIdx.c_str(), options.catalogBin.c_str())) {
+    return Bench::expect(false, "LittleFS catalog did not open");
+  }
+  std::vector<uint32_t> areas;
+  uint32_t past_cap = 0;
+  for (const char *code : kTypes) {
+    const int32_t t = SuaCatalog::findType(code);
+    if (t < 0) return Bench::expect(false, "catalog has no type %s", code);
+    std::vector<uint32_t> of_type;
+    SuaCatalog::queryType((size_t)t, INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX, of_type);
+    past_cap += of_type.size() > kOldCap ? (uint32_t)of_type.size() - kOldCap : 0;
+    areas.insert(areas.end(), of_type.begin(), of_type.end());
+  }
+
+  if (!Bench::writeFile("/bench_types.json", kJson)) return Bench::expect(false, "could not write the rule set");
+  const double t0 = Bench::nowSeconds();
+  const bool loaded = GeoFence::reload("/bench_types.json");
+  const double t_load = Bench::nowSeconds() - t0;
+  GeoFence::LoadInfo li = GeoFence::loadInfo();
+  uint32_t tested = 0;
+  uint32_t missed = loaded ? missedAreas(rng, areas, tested) : (uint32_t)areas.size();
+  ok &= Bench::expect(loaded && li.ok && li.suaTypeAreas == areas.size() && li.suaTypeRefused == 0 &&
+                      GeoFence::suaRuleCount() == areas.size() && missed == 0,
+                      "MOA + R: %u of %zu areas loaded (%u past the old %u-area cap) in %.0f ms, "
+                      "%u refused; %u tested from inside, %u not reported",
+                      (unsigned)li.suaTypeAreas, areas.size(), (unsigned)past_cap, (unsigned)kOldCap, t_load * 1e3,
+                      (unsigned)li.suaTypeRefused, (unsigned)tested, (unsigned)missed);
+
+  const bool booted = GeoFence::begin("/bench_types.json");
+  li = GeoFence::loadInfo();
+  missed = booted ? missedAreas(rng, areas, tested) : (uint32_t)areas.size();
+  ok &= Bench::expect(booted && li.fromBlob && li.suaTypeAreas == areas.size() && missed == 0,
+                      "blob boot: %u areas, %u tested from inside, %u not reported", (unsigned)li.suaTypeAreas,
+                      (unsigned)tested, (unsigned)missed);
+
+  // Room for the index and the grid but not for the MOA areas.
+  const uint32_t heap = hostFreeHeap;
+  hostFreeHeap = 100 * 1024;
+  const bool short_ok = GeoFence::reload("/bench_types.json");
+  hostFreeHeap = heap;
+  li = GeoFence::loadInfo();
+  ok &= Bench::expect(!short_ok && !li.ok && li.suaTypeRefused > 0 && GeoFence::ruleCount() == 0,
+                      "100 KB free: load %s, %u areas refused, %zu rules left in force",
+                      short_ok ? "succeeded" : "failed", (unsigned)li.suaTypeRefused, GeoFence::ruleCount());
+  SuaCatalog::end();
+  return ok;
+}
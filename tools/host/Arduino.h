@@ -0,0 +1,84 @@
+// tools/host/Arduino.h
+#pragma once
+// Just enough of the Arduino core to build src/satcom, src/message and
+// src/geofence on a Linux host. Time is CLOCK_MONOTONIC from process start
+// plus hostClockOffsetMs, which a bench may advance to skip a wait; Serial
+// is stdout and stays quiet unless hostVerbose is set.
+#include <ctype.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+using std::min;
+using std::max;
+
+#define OUTPUT 0x03
+#define INPUT 0x01
+#define LOW 0x0
+#define HIGH 0x1
+#define SERIAL_8N1 0x800001c
+
+extern bool hostVerbose;
+extern uint32_t hostClockOffsetMs;
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+inline void yield() {}
+
+// The handshake line has no pty equivalent; transitions are only counted.
+extern uint32_t hostPinWrites;
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) { hostPinWrites++; }
+
+class String {
+public:
+  String() {}
+  String(const char *s) : _s(s ? s : "") {}
+  String(const std::string &s) : _s(s) {}
+  String operator+(const char *s) const { return String(_s + s); }
+  String operator+(const String &s) const { return String(_s + s._s); }
+  String &operator+=(const char *s) { _s += s; return *this; }
+  String &operator+=(const String &s) { _s += s._s; return *this; }
+  bool operator==(const char *s) const { return _s == s; }
+  bool operator==(const String &s) const { return _s == s._s; }
+  bool operator!=(const char *s) const { return _s != s; }
+  bool operator!=(const String &s) const { return _s != s._s; }
+  void toUpperCase() { for (char &c : _s) c = (char)toupper((unsigned char)c); }
+  size_t length() const { return _s.size(); }
+  const char *c_str() const { return _s.c_str(); }
+private:
+  std::string _s;
+};
+inline String operator+(const char *a, const String &b) { return String(a) + b; }
+
+struct HostConsole {
+  void begin(unsigned long) {}
+  int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)))
+  {
+    if (!hostVerbose) return 0;
+    va_list ap;
+    va_start(ap, fmt);
+    const int n = vprintf(fmt, ap);
+    va_end(ap);
+    return n;
+  }
+  void print(const char *s) { if (hostVerbose) fputs(s, stdout); }
+  void println(const char *s = "") { if (hostVerbose) puts(s); }
+};
+extern HostConsole Serial;
+
+// Heap figures are meaningless on the host; both report hostFreeHeap
+// (320 KB unless a bench lowers it to reach an out-of-memory path).
+extern uint32_t hostFreeHeap;
+struct HostEsp {
+  uint32_t getFreeHeap() { return hostFreeHeap; }
+  uint32_t getMinFreeHeap() { return hostFreeHeap; }
+};
+extern HostEsp ESP;
@@ -0,0 +1,306 @@
+// tools/host/ArduinoJson.h
+#pragma once
+// Read-only stand-in for the slice of ArduinoJson 6 that src/geofence uses
+// to load geofence.json: parse a document, index it, iterate arrays and
+// read values with as<T>() or "| default". Documents are trees of shared
+// nodes, so views stay valid as long as the document does. Capacity is
+// enforced the way ArduinoJson 6 spends it on the ESP32: a 16-byte slot
+// per value below the root plus every distinct string copied, so a
+// document sized too small fails with NoMemory here as on the device.
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace hostjson {
+  constexpr size_t kSlotSize = 16;  // sizeof(VariantSlot) on a 32-bit target
+}
+
+#define JSON_ARRAY_SIZE(n) ((n) * hostjson::kSlotSize)
+#define JSON_OBJECT_SIZE(n) ((n) * hostjson::kSlotSize)
+
+namespace hostjson {
+  struct Node {
+    enum Type { Null, Bool, Number, Text, Array, Object } type = Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string text;
+    std::vector<std::shared_ptr<Node>> items;
+    std::vector<std::pair<std::string, std::shared_ptr<Node>>> members;
+  };
+  typedef std::shared_ptr<Node> NodePtr;
+}
+
+class JsonArray;
+class JsonObject;
+
+class JsonVariant {
+public:
+  JsonVariant(hostjson::NodePtr node = nullptr) : _node(std::move(node)) {}
+
+  bool isNull() const { return !_node || _node->type == hostjson::Node::Null; }
+  size_t size() const
+  {
+    if (is(hostjson::Node::Array)) return _node->items.size();
+    if (is(hostjson::Node::Object)) return _node->members.size();
+    return 0;
+  }
+
+  JsonVariant operator[](size_t i) const
+  {
+    return is(hostjson::Node::Array) && i < _node->items.size() ? JsonVariant(_node->items[i]) : JsonVariant();
+  }
+  JsonVariant operator[](int i) const { return (*this)[(size_t)i]; }
+  JsonVariant operator[](const char *key) const
+  {
+    if (!is(hostjson::Node::Object)) return JsonVariant();
+    for (const auto &m : _node->members) {
+      if (m.first == key) return JsonVariant(m.second);
+    }
+    return JsonVariant();
+  }
+  bool containsKey(const char *key) const { return !(*this)[key].isNull(); }
+
+  template <typename T> T as() const;
+  template <typename T> bool is() const;
+  operator JsonArray() const;
+  operator JsonObject() const;
+
+  const char *operator|(const char *d) const { return is(hostjson::Node::Text) ? _node->text.c_str() : d; }
+  String operator|(const String &d) const { return is(hostjson::Node::Text) ? String(_node->text) : d; }
+  bool operator|(bool d) const { return is(hostjson::Node::Bool) ? _node->boolean : d; }
+  template <typename T>
+  typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, T>::type
+  operator|(T d) const { return is(hostjson::Node::Number) ? (T)_node->number : d; }
+
+  const hostjson::NodePtr &node() const { return _node; }
+
+protected:
+  bool is(hostjson::Node::Type type) const { return _node && _node->type == type; }
+  hostjson::NodePtr _node;
+};
+
+class JsonArray : public JsonVariant {
+public:
+  class iterator {
+  public:
+    iterator(const hostjson::NodePtr &array, size_t i) : _array(array), _i(i) {}
+    JsonVariant operator*() const { return JsonVariant(_array->items[_i]); }
+    iterator &operator++() { _i++; return *this; }
+    bool operator!=(const iterator &o) const { return _i != o._i; }
+  private:
+    hostjson::NodePtr _array;
+    size_t _i;
+  };
+
+  JsonArray(hostjson::NodePtr node = nullptr)
+    : JsonVariant(node && node->type == hostjson::Node::Array ? node : nullptr) {}
+  iterator begin() const { return iterator(_node, 0); }
+  iterator end() const { return iterator(_node, _node ? _node->items.size() : 0); }
+};
+
+class JsonObject : public JsonVariant {
+public:
+  JsonObject(hostjson::NodePtr node = nullptr)
+    : JsonVariant(node && node->type == hostjson::Node::Object ? node : nullptr) {}
+};
+
+inline JsonVariant::operator JsonArray() const { return JsonArray(_node); }
+inline JsonVariant::operator JsonObject() const { return JsonObject(_node); }
+
+template <> inline JsonArray JsonVariant::as<JsonArray>() const { return JsonArray(_node); }
+template <> inline JsonObject JsonVariant::as<JsonObject>() const { return JsonObject(_node); }
+template <> inline double JsonVariant::as<double>() const { return is(hostjson::Node::Number) ? _node->number : 0.0; }
+template <> inline float JsonVariant::as<float>() const { return (float)as<double>(); }
+template <> inline int JsonVariant::as<int>() const { return (int)as<double>(); }
+template <> inline uint32_t JsonVariant::as<uint32_t>() const { return (uint32_t)as<double>(); }
+template <> inline bool JsonVariant::as<bool>() const { return is(hostjson::Node::Bool) && _node->boolean; }
+template <> inline const char *JsonVariant::as<const char *>() const
+{
+  return is(hostjson::Node::Text) ? _node->text.c_str() : nullptr;
+}
+template <> inline bool JsonVariant::is<JsonArray>() const { return is(hostjson::Node::Array); }
+template <> inline bool JsonVariant::is<JsonObject>() const { return is(hostjson::Node::Object); }
+template <> inline bool JsonVariant::is<const char *>() const { return is(hostjson::Node::Text); }
+template <> inline bool JsonVariant::is<double>() const { return is(hostjson::Node::Number); }
+template <> inline bool JsonVariant::is<float>() const { return is(hostjson::Node::Number); }
+
+class DynamicJsonDocument : public JsonVariant {
+public:
+  explicit DynamicJsonDocument(size_t capacity) : _capacity(capacity) {}
+  size_t capacity() const { return _capacity; }
+  size_t memoryUsage() const { return _usage; }
+  // Only deserializeJson() fills a host document; it fails rather than
+  // truncating, so nothing is ever left half-stored.
+  bool overflowed() const { return false; }
+  void set(hostjson::NodePtr node, size_t usage)
+  {
+    _node = std::move(node);
+    _usage = usage;
+  }
+
+private:
+  size_t _capacity;
+  size_t _usage = 0;
+};
+
+class DeserializationError {
+public:
+  explicit DeserializationError(const char *what = nullptr) : _what(what) {}
+  explicit operator bool() const { return _what != nullptr; }
+  const char *c_str() const { return _what ? _what : "Ok"; }
+private:
+  const char *_what;
+};
+
+namespace hostjson {
+  // Recursive descent over the whole text. Numbers go through strtod;
+  // string escapes other than \n are taken literally.
+  class Parser {
+  public:
+    Parser(const char *begin, const char *end) : _p(begin), _end(end) {}
+
+    NodePtr value()
+    {
+      skipSpace();
+      if (_p >= _end) return nullptr;
+      if (*_p == '{') return object();
+      if (*_p == '[') return array();
+      if (*_p == '"') return text();
+      NodePtr n = std::make_shared<Node>();
+      if (literal("true")) {
+        n->type = Node::Bool;
+        n->boolean = true;
+      } else if (literal("false")) {
+        n->type = Node::Bool;
+      } else if (!literal("null")) {
+        char *stop = nullptr;
+        n->number = strtod(_p, &stop);
+        if (stop == _p) return nullptr;
+        n->type = Node::Number;
+        _p = stop;
+      }
+      return n;
+    }
+
+  private:
+    void skipSpace()
+    {
+      while (_p < _end && isspace((unsigned char)*_p)) _p++;
+    }
+
+    bool consume(char c)
+    {
+      skipSpace();
+      if (_p >= _end || *_p != c) return false;
+      _p++;
+      return true;
+    }
+
+    bool literal(const char *word)
+    {
+      const size_t n = strlen(word);
+      if ((size_t)(_end - _p) < n || strncmp(_p, word, n) != 0) return false;
+      _p += n;
+      return true;
+    }
+
+    NodePtr text()
+    {
+      NodePtr n = std::make_shared<Node>();
+      n->type = Node::Text;
+      _p++;  // opening quote
+      while (_p < _end && *_p != '"') {
+        if (*_p == '\\' && _p + 1 < _end) {
+          _p++;
+          n->text += (*_p == 'n') ? '\n' : *_p;
+        } else {
+          n->text += *_p;
+        }
+        _p++;
+      }
+      if (_p >= _end) return nullptr;
+      _p++;  // closing quote
+      return n;
+    }
+
+    NodePtr array()
+    {
+      NodePtr n = std::make_shared<Node>();
+      n->type = Node::Array;
+      _p++;
+      if (consume(']')) return n;
+      do {
+        NodePtr item = value();
+        if (!item) return nullptr;
+        n->items.push_back(item);
+      } while (consume(','));
+      return consume(']') ? n : nullptr;
+    }
+
+    NodePtr object()
+    {
+      NodePtr n = std::make_shared<Node>();
+      n->type = Node::Object;
+      _p++;
+      if (consume('}')) return n;
+      do {
+        skipSpace();
+        if (_p >= _end || *_p != '"') return nullptr;
+        NodePtr key = text();
+        if (!key || !consume(':')) return nullptr;
+        NodePtr item = value();
+        if (!item) return nullptr;
+        n->members.emplace_back(key->text, item);
+      } while (consume(','));
+      return consume('}') ? n : nullptr;
+    }
+
+    const char *_p;
+    const char *_end;
+  };
+
+  // Pool bytes ArduinoJson would spend on the tree below node.
+  inline size_t usage(const NodePtr &node, std::set<std::string> &strings)
+  {
+    size_t bytes = 0;
+    if (node->type == Node::Text && strings.insert(node->text).second) bytes += node->text.size() + 1;
+    for (const NodePtr &item : node->items) bytes += kSlotSize + usage(item, strings);
+    for (const auto &m : node->members) {
+      if (strings.insert(m.first).second) bytes += m.first.size() + 1;
+      bytes += kSlotSize + usage(m.second, strings);
+    }
+    return bytes;
+  }
+
+  inline DeserializationError parse(DynamicJsonDocument &doc, const std::string &text)
+  {
+    Parser parser(text.data(), text.data() + text.size());
+    NodePtr root = parser.value();
+    if (!root) return DeserializationError("InvalidInput");
+    std::set<std::string> strings;
+    const size_t bytes = usage(root, strings);
+    if (bytes > doc.capacity()) {
+      doc.set(nullptr, 0);
+      return DeserializationError("NoMemory");
+    }
+    doc.set(root, bytes);
+    return DeserializationError();
+  }
+}
+
+inline DeserializationError deserializeJson(DynamicJsonDocument &doc, File &f)
+{
+  std::string text;
+  uint8_t buf[512];
+  size_t n;
+  while ((n = f.read(buf, sizeof(buf))) > 0) text.append((const char *)buf, n);
+  return hostjson::parse(doc, text);
+}
+
+inline DeserializationError deserializeJson(DynamicJsonDocument &doc, const char *text)
+{
+  return hostjson::parse(doc, text);
+}
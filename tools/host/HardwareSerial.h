@@ -0,0 +1,43 @@
+// tools/host/HardwareSerial.h
+#pragma once
+// Serial2 backed by a tty (normally the pty the SmartOne emulator prints).
+// begin() opens hostUartPath in raw, non-blocking mode; reads go through a
+// small buffer so available() can report what the kernel already holds.
+#include <Arduino.h>
+
+enum hardwareSerial_error_t {
+  UART_NO_ERROR,
+  UART_BREAK_ERROR,
+  UART_BUFFER_FULL_ERROR,
+  UART_FIFO_OVF_ERROR,
+  UART_FRAME_ERROR,
+  UART_PARITY_ERROR,
+};
+
+extern const char *hostUartPath;
+
+class HostUart {
+public:
+  void begin(unsigned long baud, uint32_t config, int rxPin, int txPin);
+  void end();
+  void setRxBufferSize(size_t) {}
+  // A pty never overruns; the callback is kept but never fires.
+  void onReceiveError(void (*cb)(hardwareSerial_error_t)) { _onError = cb; }
+  int available();
+  int read();
+  int availableForWrite() { return _fd < 0 ? 0 : 128; }
+  size_t write(const uint8_t *data, size_t len);
+
+  uint32_t rxBytes = 0;
+  uint32_t txBytes = 0;
+
+private:
+  void fill();
+
+  int _fd = -1;
+  uint8_t _buf[256];
+  size_t _head = 0;
+  size_t _tail = 0;
+  void (*_onError)(hardwareSerial_error_t) = nullptr;
+};
+extern HostUart Serial2;
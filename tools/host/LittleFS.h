@@ -0,0 +1,43 @@
+// tools/host/LittleFS.h
+#pragma once
+// LittleFS mapped onto a host directory (hostFsRoot).
+#include <Arduino.h>
+
+extern std::string hostFsRoot;
+
+class File {
+public:
+  File() {}
+  explicit File(FILE *f) : _f(f) {}
+  File(const File &) = delete;
+  File &operator=(const File &) = delete;
+  File(File &&o) : _f(o._f) { o._f = nullptr; }
+  File &operator=(File &&o)
+  {
+    if (this != &o) {
+      close();
+      _f = o._f;
+      o._f = nullptr;
+    }
+    return *this;
+  }
+  ~File() { close(); }
+  explicit operator bool() const { return _f != nullptr; }
+  size_t read(uint8_t *buf, size_t len) { return _f ? fread(buf, 1, len, _f) : 0; }
+  size_t write(const uint8_t *buf, size_t len) { return _f ? fwrite(buf, 1, len, _f) : 0; }
+  bool seek(uint32_t pos) { return _f && fseek(_f, (long)pos, SEEK_SET) == 0; }
+  size_t size();
+  void close() { if (_f) fclose(_f); _f = nullptr; }
+private:
+  FILE *_f = nullptr;
+};
+
+class HostFS {
+public:
+  bool begin(bool formatOnFail = false);
+  bool exists(const char *path);
+  File open(const char *path, const char *mode = "r");
+  bool remove(const char *path);
+  bool rename(const char *from, const char *to);
+};
+extern HostFS LittleFS;
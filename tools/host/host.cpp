@@ -0,0 +1,138 @@
+// tools/host/host.cpp
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <LittleFS.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+bool hostVerbose = false;
+uint32_t hostClockOffsetMs = 0;
+uint32_t hostFreeHeap = 320 * 1024;
+uint32_t hostPinWrites = 0;
+const char *hostUartPath = nullptr;
+std::string hostFsRoot = ".";
+
+HostConsole Serial;
+HostEsp ESP;
+HostUart Serial2;
+HostFS LittleFS;
+
+namespace {
+  uint64_t monotonicUs()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+  }
+
+  const uint64_t s_startUs = monotonicUs();
+
+  std::string fullPath(const char *path) { return hostFsRoot + path; }
+}
+
+uint32_t millis() { return (uint32_t)((monotonicUs() - s_startUs) / 1000ULL) + hostClockOffsetMs; }
+uint32_t micros() { return (uint32_t)(monotonicUs() - s_startUs) + hostClockOffsetMs * 1000U; }
+void delay(uint32_t ms) { usleep((useconds_t)ms * 1000); }
+
+// ---------------------------------------------------------------------------
+// Serial2
+
+void HostUart::begin(unsigned long, uint32_t, int, int)
+{
+  end();
+  if (!hostUartPath) return;
+  _fd = ::open(hostUartPath, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (_fd < 0) {
+    fprintf(stderr, "[HOST] cannot open %s: %s\n", hostUartPath, strerror(errno));
+    return;
+  }
+  termios tio;
+  if (tcgetattr(_fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tcsetattr(_fd, TCSANOW, &tio);
+  }
+}
+
+void HostUart::end()
+{
+  if (_fd >= 0) ::close(_fd);
+  _fd = -1;
+  _head = _tail = 0;
+}
+
+void HostUart::fill()
+{
+  if (_fd < 0) return;
+  if (_head == _tail) _head = _tail = 0;
+  if (_tail == sizeof(_buf)) return;
+  const ssize_t n = ::read(_fd, _buf + _tail, sizeof(_buf) - _tail);
+  if (n > 0) {
+    _tail += (size_t)n;
+    rxBytes += (uint32_t)n;
+  }
+}
+
+int HostUart::available()
+{
+  fill();
+  return (int)(_tail - _head);
+}
+
+int HostUart::read()
+{
+  if (_head == _tail) fill();
+  if (_head == _tail) return -1;
+  return _buf[_head++];
+}
+
+size_t HostUart::write(const uint8_t *data, size_t len)
+{
+  size_t done = 0;
+  while (_fd >= 0 && done < len) {
+    const ssize_t n = ::write(_fd, data + done, len - done);
+    if (n > 0) done += (size_t)n;
+    else if (n < 0 && errno != EAGAIN && errno != EINTR) break;
+  }
+  txBytes += (uint32_t)done;
+  return done;
+}
+
+// ---------------------------------------------------------------------------
+// LittleFS
+
+size_t File::size()
+{
+  if (!_f) return 0;
+  struct stat st;
+  return fstat(fileno(_f), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+bool HostFS::begin(bool)
+{
+  struct stat st;
+  return stat(hostFsRoot.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+bool HostFS::exists(const char *path)
+{
+  struct stat st;
+  return stat(fullPath(path).c_str(), &st) == 0;
+}
+
+File HostFS::open(const char *path, const char *mode)
+{
+  const char *m = mode[0] == 'w' ? "wb" : mode[0] == 'a' ? "ab" : "rb";
+  return File(fopen(fullPath(path).c_str(), m));
+}
+
+bool HostFS::remove(const char *path) { return ::remove(fullPath(path).c_str()) == 0; }
+
+bool HostFS::rename(const char *from, const char *to)
+{
+  return ::rename(fullPath(from).c_str(), fullPath(to).c_str()) == 0;
+}
@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+# Builds satcom_bench against the firmware sources and runs it against
+# smartone_emulator.py on a fresh pty. Options before "--" go to the
+# emulator, the rest to the bench:
+#
+#   tools/satcom_bench/run.sh --nak-rate 0.1 --drop-rate 0.002 -- --seconds 300
+set -euo pipefail
+
+here=$(cd "$(dirname "$0")" && pwd)
+repo=$(cd "$here/../.." && pwd)
+out=${SATCOM_BENCH_OUT:-/tmp/satcom_bench}
+
+emu_args=()
+while [ $# -gt 0 ] && [ "$1" != "--" ]; do
+  emu_args+=("$1")
+  shift
+done
+[ $# -gt 0 ] && shift
+
+rm -rf "$out"
+mkdir -p "$out/fs"
+"${CXX:-g++}" -std=gnu++17 -O2 -Wall -I"$here/../host" -I"$repo/src" -o "$out/satcom_bench" \
+  "$here/satcom_bench.cpp" "$here/../host/host.cpp" \
+  "$repo"/src/satcom/*.cpp "$repo/src/message/MessageCodec.cpp"
+
+python3 "$here/smartone_emulator.py" --link "$out/modem.pty" "${emu_args[@]}" &
+emu=$!
+trap 'kill "$emu" 2>/dev/null || true' EXIT
+for _ in $(seq 50); do
+  [ -e "$out/modem.pty" ] && break
+  sleep 0.1
+done
+
+"$out/satcom_bench" --fs "$out/fs" "$@" "$out/modem.pty"
+kill -INT "$emu"
+wait "$emu"
@@ -0,0 +1,219 @@
+// tools/satcom_bench/satcom_bench.cpp
+// Runs the firmware's SatCom driver, TxQueue and MessageCodec, unchanged,
+// against a SmartOne on a tty (normally smartone_emulator.py's pty) and
+// reports end-to-end send latency and retry statistics. See run.sh.
+#include <Arduino.h>
+#include <HardwareSerial.h>
+#include <LittleFS.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include "message/MessageCodec.h"
+#include "satcom/SatCom.h"
+#include "satcom/TxQueue.h"
+
+namespace {
+  constexpr uint32_t kLoopSleepUs = 1000;  // the firmware loop() runs about this often
+
+  struct Options {
+    const char *tty = nullptr;
+    const char *fs = ".";
+    uint32_t seconds = 120;
+    uint32_t positionMs = 10000;  // routine position cadence
+    uint32_t geofenceEvery = 0;   // every Nth position is a geofence event instead; 0 = never
+    uint32_t terminationAtS = 0;  // one termination alert this far in; 0 = never
+    uint32_t queryMs = 5000;      // QUERY_FIRMWARE cadence, for request round trips
+    uint32_t drainS = 120;        // then wait up to this long for the queue to empty
+  };
+
+  struct QueryStats {
+    uint32_t sent = 0;
+    uint32_t ok = 0;
+    uint32_t nak = 0;
+    uint32_t timeout = 0;
+    std::vector<uint32_t> latencyMs;
+  };
+
+  volatile sig_atomic_t s_stop = 0;
+  QueryStats s_queries;
+  bool s_queryOutstanding = false;
+  uint32_t s_queryStartMs = 0;
+  std::vector<uint32_t> s_sendLatencyMs;
+  uint32_t s_pushed[3] = {};
+
+  void usage(const char *argv0)
+  {
+    fprintf(stderr,
+            "usage: %s [--seconds N] [--position-ms N] [--geofence-every N] [--termination-at S]\n"
+            "          [--query-ms N] [--drain S] [--fs DIR] [--verbose] TTY\n",
+            argv0);
+    exit(2);
+  }
+
+  bool parseArgs(int argc, char **argv, Options &o)
+  {
+    for (int i = 1; i < argc; i++) {
+      const char *a = argv[i];
+      const bool hasValue = i + 1 < argc;
+      if (!strcmp(a, "--verbose")) hostVerbose = true;
+      else if (!strcmp(a, "--seconds") && hasValue) o.seconds = strtoul(argv[++i], nullptr, 0);
+      else if (!strcmp(a, "--position-ms") && hasValue) o.positionMs = strtoul(argv[++i], nullptr, 0);
+      else if (!strcmp(a, "--geofence-every") && hasValue) o.geofenceEvery = strtoul(argv[++i], nullptr, 0);
+      else if (!strcmp(a, "--termination-at") && hasValue) o.terminationAtS = strtoul(argv[++i], nullptr, 0);
+      else if (!strcmp(a, "--query-ms") && hasValue) o.queryMs = strtoul(argv[++i], nullptr, 0);
+      else if (!strcmp(a, "--drain") && hasValue) o.drainS = strtoul(argv[++i], nullptr, 0);
+      else if (!strcmp(a, "--fs") && hasValue) o.fs = argv[++i];
+      else if (a[0] != '-' && !o.tty) o.tty = a;
+      else return false;
+    }
+    return o.tty != nullptr;
+  }
+
+  uint32_t monotonicMs()
+  {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL);
+  }
+
+  // A MessageCodec frame tagged for the emulator: the time field carries the
+  // enqueue time (CLOCK_MONOTONIC ms) and the altitude field the priority.
+  bool pushTagged(TxQueue::Priority priority)
+  {
+    MessageCodec::Fields fields;
+    fields.time_value = monotonicMs();
+    fields.latitude = 35.0f;
+    fields.longitude = -117.0f;
+    fields.altitude_m = (float)(uint8_t)priority;
+    fields.temp_k = 288.15f;
+    fields.pressure_hpa = 1013.25f;
+
+    MessageCodec::EncodedMessage msg;
+    if (!MessageCodec::encodeRaw27(fields, msg)) return false;
+    if (!TxQueue::push(priority, msg.bytes, msg.len)) return false;
+    s_pushed[(uint8_t)priority]++;
+    return true;
+  }
+
+  void onQueryDone(SatCom::Result result, const uint8_t *frame, size_t len)
+  {
+    s_queryOutstanding = false;
+    switch (result) {
+      case SatCom::Result::OK: {
+        SmartOne::FirmwareResponse fw;
+        if (fw.decode(frame, len)) s_queries.ok++;
+        s_queries.latencyMs.push_back(millis() - s_queryStartMs);
+        break;
+      }
+      case SatCom::Result::NAK: s_queries.nak++; break;
+      case SatCom::Result::TIMEOUT: s_queries.timeout++; break;
+    }
+  }
+
+  const char *percentiles(std::vector<uint32_t> v)
+  {
+    static char buf[96];
+    if (v.empty()) return "n=0";
+    std::sort(v.begin(), v.end());
+    snprintf(buf, sizeof(buf), "n=%u p50=%u p95=%u max=%u", (unsigned)v.size(),
+             (unsigned)v[v.size() / 2], (unsigned)v[std::min(v.size() - 1, v.size() * 95 / 100)],
+             (unsigned)v.back());
+    return buf;
+  }
+
+  void step(uint32_t &lastSent)
+  {
+    const uint32_t now = millis();
+    SatCom::poll();
+    TxQueue::update(now);
+    const TxQueue::Stats &q = TxQueue::stats();
+    if (q.sent != lastSent) {
+      lastSent = q.sent;
+      s_sendLatencyMs.push_back(q.lastLatencyMs);
+    }
+  }
+
+  void report(const Options &o, uint32_t elapsedMs)
+  {
+    const TxQueue::Stats &q = TxQueue::stats();
+    const SatCom::Stats &s = SatCom::stats();
+    const SatCom::RxStats rx = SatCom::rxStats();
+    const SatCom::ModemQueue &m = SatCom::modemQueue();
+
+    printf("[BENCH] %.1f s against %s\n", elapsedMs / 1000.0, o.tty);
+    printf("[BENCH] pushed: routine=%u geofence=%u termination=%u\n",
+           (unsigned)s_pushed[0], (unsigned)s_pushed[1], (unsigned)s_pushed[2]);
+    printf("[BENCH] queue: enqueued=%u sent=%u coalesced=%u dropped=%u depth=%u throttled=%u aborts=%u\n",
+           (unsigned)q.enqueued, (unsigned)q.sent, (unsigned)q.coalesced, (unsigned)q.dropped,
+           (unsigned)q.depth, (unsigned)q.throttled, (unsigned)q.aborts);
+    printf("[BENCH] enqueue->on the wire ms: %s\n", percentiles(s_sendLatencyMs));
+    printf("[BENCH] firmware queries: sent=%u ok=%u nak=%u timeout=%u round trip ms: %s\n",
+           (unsigned)s_queries.sent, (unsigned)s_queries.ok, (unsigned)s_queries.nak,
+           (unsigned)s_queries.timeout, percentiles(s_queries.latencyMs));
+    printf("[BENCH] driver: requests=%u completed=%u naks=%u timeouts=%u retries=%u rejected=%u worstPollUs=%u\n",
+           (unsigned)s.requests, (unsigned)s.completed, (unsigned)s.naks, (unsigned)s.timeouts,
+           (unsigned)s.retries, (unsigned)s.rejected, (unsigned)s.worstPollUs);
+    printf("[BENCH] rx: frames=%u crcErrors=%u resyncs=%u discarded=%u unclaimed=%u bytes=%u tx bytes=%u\n",
+           (unsigned)rx.frames, (unsigned)rx.crcErrors, (unsigned)rx.resyncs, (unsigned)rx.discarded,
+           (unsigned)rx.unclaimed, (unsigned)Serial2.rxBytes, (unsigned)Serial2.txBytes);
+    printf("[BENCH] modem: known=%d bursts=%u failures=%u\n",
+           m.known ? 1 : 0, (unsigned)m.burstsRemaining, (unsigned)m.failures);
+    fflush(stdout);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  Options o;
+  if (!parseArgs(argc, argv, o)) usage(argv[0]);
+  hostUartPath = o.tty;
+  hostFsRoot = o.fs;
+  signal(SIGINT, [](int) { s_stop = 1; });
+  signal(SIGTERM, [](int) { s_stop = 1; });
+
+  SatCom::begin();
+  TxQueue::begin();
+
+  const uint32_t startMs = millis();
+  const uint32_t endMs = startMs + o.seconds * 1000UL;
+  uint32_t nextPositionMs = startMs;
+  uint32_t nextQueryMs = startMs;
+  uint32_t positions = 0;
+  bool terminated = false;
+  uint32_t lastSent = 0;
+
+  while (!s_stop && (int32_t)(millis() - endMs) < 0) {
+    const uint32_t now = millis();
+    if ((int32_t)(now - nextPositionMs) >= 0) {
+      nextPositionMs += o.positionMs;
+      positions++;
+      const bool geofence = o.geofenceEvery && positions % o.geofenceEvery == 0;
+      pushTagged(geofence ? TxQueue::Priority::GEOFENCE : TxQueue::Priority::ROUTINE);
+    }
+    if (o.terminationAtS && !terminated && now - startMs >= o.terminationAtS * 1000UL) {
+      terminated = true;
+      pushTagged(TxQueue::Priority::TERMINATION);
+    }
+    if (o.queryMs && !s_queryOutstanding && (int32_t)(now - nextQueryMs) >= 0) {
+      nextQueryMs = now + o.queryMs;
+      if (SatCom::queryFirmware(onQueryDone)) {
+        s_queryOutstanding = true;
+        s_queryStartMs = now;
+        s_queries.sent++;
+      }
+    }
+    step(lastSent);
+    usleep(kLoopSleepUs);
+  }
+
+  // Let everything already queued reach the modem.
+  const uint32_t drainEndMs = millis() + o.drainS * 1000UL;
+  while (!s_stop && (TxQueue::stats().depth || SatCom::busy()) && (int32_t)(millis() - drainEndMs) < 0) {
+    step(lastSent);
+    usleep(kLoopSleepUs);
+  }
+
+  report(o, millis() - startMs);
+  return 0;
+}
@@ -0,0 +1,317 @@
+import argparse
+import os
+import random
+import select
+import signal
+import struct
+import sys
+import time
+import tty
+
+# SmartOne C serial framing: AA LEN CMD payload CRC(lo, hi), LEN counting
+# the whole frame.
+SYNC = 0xAA
+MIN_FRAME = 5
+
+CMD_QUERY_ESN = 0x01
+CMD_ABORT = 0x03
+CMD_QUERY_BURSTS = 0x04
+CMD_QUERY_FIRMWARE = 0x05
+CMD_SETUP = 0x06
+CMD_QUERY_SETUP = 0x07
+CMD_QUERY_HARDWARE = 0x09
+CMD_SEND_RAW = 0x27
+CMD_NAK = 0xFF
+
+SETUP_LEN = 9
+SETUP_DEFAULT = bytes([0, 0, 0, 0, 0, 3, 1, 2, 0])  # channel 0, 3 bursts, 5-10 s apart
+BURST_UNIT_S = 5.0
+FIRMWARE = bytes([1, 4])
+HARDWARE = bytes([0x00, 0x31, 2, 5])
+
+# A partial frame idle this long is given up, one byte at a time, like the
+# driver's SAT_RX_GAP_MS.
+RX_GAP_S = 0.05
+
+# satcom_bench tags its 0x27 frames: burn byte, then time (enqueue time,
+# CLOCK_MONOTONIC ms), lat, lon, altitude (= priority class) and so on.
+TAGGED_RAW_LEN = 25
+PRIORITY_NAMES = {0: "routine", 1: "geofence", 2: "termination"}
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x8408 if crc & 1 else crc >> 1
+    return ~crc & 0xFFFF
+
+
+def build_frame(cmd, payload=b""):
+    body = bytes([SYNC, len(payload) + MIN_FRAME, cmd]) + bytes(payload)
+    return body + struct.pack("<H", crc16(body))
+
+
+def monotonic_ms():
+    return int(time.monotonic() * 1000) & 0xFFFFFFFF
+
+
+def percentiles(values):
+    if not values:
+        return "n=0"
+    v = sorted(values)
+    return "n=%d p50=%d p95=%d max=%d" % (len(v), v[len(v) // 2], v[min(len(v) - 1, len(v) * 95 // 100)], v[-1])
+
+
+class Modem:
+    def __init__(self, args, rng):
+        self.args = args
+        self.rng = rng
+        self.setup = bytearray(SETUP_DEFAULT)
+        self.queue = []  # [stamp or None, priority or None, bursts left]
+        self.next_burst = None
+        self.stats = dict(commands=0, crc_errors=0, resyncs=0, naks_injected=0, naks_unknown=0,
+                          dropped_in=0, dropped_out=0, accepted=0, rejected_full=0, lost_full=0,
+                          delivered=0, aborted=0, duplicates=0, bursts=0, queries=0)
+        self.seen = set()
+        self.accept_ms = {}
+        self.deliver_ms = {}
+
+    # -- transmission --------------------------------------------------------
+
+    def burst_gap(self):
+        lo, hi = self.setup[6], max(self.setup[6], self.setup[7])
+        return self.rng.uniform(lo, hi) * BURST_UNIT_S * self.args.time_scale
+
+    def bursts_remaining(self):
+        return min(255, sum(m[2] for m in self.queue))
+
+    def tick(self, now):
+        if not self.queue or self.next_burst is None or now < self.next_burst:
+            return
+        msg = self.queue[0]
+        msg[2] -= 1
+        self.stats["bursts"] += 1
+        if msg[2] <= 0:
+            self.queue.pop(0)
+            self.stats["delivered"] += 1
+            if msg[0] is not None:
+                lat = (monotonic_ms() - msg[0]) & 0xFFFFFFFF
+                self.deliver_ms.setdefault(msg[1], []).append(lat)
+        self.next_burst = now + self.burst_gap() if self.queue else None
+
+    # -- commands ------------------------------------------------------------
+
+    def handle(self, cmd, payload, now):
+        """Returns the reply frame, or None when the command has none."""
+        self.stats["commands"] += 1
+        if cmd == CMD_SEND_RAW:
+            return self.send_raw(payload, now)
+        if cmd == CMD_QUERY_ESN:
+            return build_frame(cmd, struct.pack(">I", self.args.esn))
+        if cmd == CMD_ABORT:
+            self.stats["aborted"] += len(self.queue)
+            self.queue = []
+            self.next_burst = None
+            return build_frame(cmd)
+        if cmd == CMD_QUERY_BURSTS:
+            self.stats["queries"] += 1
+            return build_frame(cmd, bytes([self.bursts_remaining()]))
+        if cmd == CMD_QUERY_FIRMWARE:
+            return build_frame(cmd, FIRMWARE)
+        if cmd == CMD_SETUP and len(payload) >= SETUP_LEN:
+            self.setup = bytearray(payload[:SETUP_LEN])
+            return build_frame(cmd)
+        if cmd == CMD_QUERY_SETUP:
+            return build_frame(cmd, bytes(self.setup))
+        if cmd == CMD_QUERY_HARDWARE:
+            return build_frame(cmd, HARDWARE)
+        self.stats["naks_unknown"] += 1
+        return build_frame(CMD_NAK)
+
+    def send_raw(self, payload, now):
+        stamp = priority = None
+        if len(payload) == TAGGED_RAW_LEN:
+            stamp = struct.unpack(">I", payload[1:5])[0]
+            priority = round(struct.unpack(">I", payload[13:17])[0] / 100.0 - 200.0)
+            if stamp in self.seen:
+                self.stats["duplicates"] += 1
+            self.seen.add(stamp)
+        if len(self.queue) >= self.args.queue_depth:
+            # Queue full: refuse it with a NAK, or (--full drop) swallow it.
+            if self.args.full == "drop":
+                self.stats["lost_full"] += 1
+                return None
+            self.stats["rejected_full"] += 1
+            return build_frame(CMD_NAK)
+        bursts = max(1, self.setup[5])
+        self.queue.append([stamp, priority, bursts])
+        self.stats["accepted"] += 1
+        if stamp is not None:
+            self.accept_ms.setdefault(priority, []).append((monotonic_ms() - stamp) & 0xFFFFFFFF)
+        if self.next_burst is None:
+            self.next_burst = now + self.burst_gap()
+        return None
+
+    def report(self, elapsed):
+        out = sys.stdout
+        s = self.stats
+        out.write("[EMU] %.0f s: commands=%d queries=%d accepted=%d delivered=%d bursts=%d aborted=%d\n"
+                  % (elapsed, s["commands"], s["queries"], s["accepted"], s["delivered"], s["bursts"], s["aborted"]))
+        out.write("[EMU] queue full: nak=%d lost=%d  duplicates=%d  left in queue=%d\n"
+                  % (s["rejected_full"], s["lost_full"], s["duplicates"], len(self.queue)))
+        out.write("[EMU] line: crc_errors=%d resyncs=%d dropped_in=%d dropped_out=%d naks_injected=%d naks_unknown=%d\n"
+                  % (s["crc_errors"], s["resyncs"], s["dropped_in"], s["dropped_out"], s["naks_injected"],
+                     s["naks_unknown"]))
+        for p in sorted(set(self.accept_ms) | set(self.deliver_ms)):
+            name = PRIORITY_NAMES.get(p, str(p))
+            out.write("[EMU] %s enqueue->accepted ms: %s\n" % (name, percentiles(self.accept_ms.get(p, []))))
+            out.write("[EMU] %s enqueue->delivered ms: %s\n" % (name, percentiles(self.deliver_ms.get(p, []))))
+        out.flush()
+
+
+class Line:
+    """The modem's UART: parses requests off the pty and writes replies
+    back after the configured latency, dropping bytes both ways."""
+
+    def __init__(self, fd, modem, args, rng):
+        self.fd = fd
+        self.modem = modem
+        self.args = args
+        self.rng = rng
+        self.rx = bytearray()
+        self.last_rx = 0.0
+        self.pending = []  # (due, frame), in due order
+        self.line_free = 0.0
+
+    def receive(self, data, now):
+        stats = self.modem.stats
+        for b in data:
+            if self.args.drop_rate and self.rng.random() < self.args.drop_rate:
+                stats["dropped_in"] += 1
+                continue
+            self.rx.append(b)
+        if data:
+            self.last_rx = now
+        self.parse(now)
+
+    def resync(self):
+        self.modem.stats["resyncs"] += 1
+        del self.rx[0]
+        while self.rx and self.rx[0] != SYNC:
+            del self.rx[0]
+
+    def parse(self, now):
+        while self.rx:
+            if self.rx[0] != SYNC:
+                self.resync()
+                continue
+            if len(self.rx) < 2:
+                break
+            n = self.rx[1]
+            if n < MIN_FRAME:
+                self.resync()
+                continue
+            if len(self.rx) < n:
+                if now - self.last_rx >= RX_GAP_S:
+                    self.resync()
+                    continue
+                break
+            frame = bytes(self.rx[:n])
+            if struct.unpack("<H", frame[-2:])[0] != crc16(frame[:-2]):
+                self.modem.stats["crc_errors"] += 1
+                self.resync()
+                continue
+            del self.rx[:n]
+            reply = self.modem.handle(frame[2], frame[3:-2], now)
+            if reply is not None:
+                self.queue_reply(reply, now)
+
+    def queue_reply(self, reply, now):
+        if reply[2] != CMD_NAK and self.args.nak_rate and self.rng.random() < self.args.nak_rate:
+            self.modem.stats["naks_injected"] += 1
+            reply = build_frame(CMD_NAK)
+        latency = (self.args.latency_ms + self.rng.uniform(0, self.args.jitter_ms)) / 1000.0
+        wire = len(reply) * 10.0 / self.args.baud
+        due = max(now + latency, self.line_free) + wire
+        self.line_free = due
+        self.pending.append((due, reply))
+
+    def flush(self, now):
+        while self.pending and self.pending[0][0] <= now:
+            _, reply = self.pending.pop(0)
+            out = bytearray()
+            for b in reply:
+                if self.args.drop_rate and self.rng.random() < self.args.drop_rate:
+                    self.modem.stats["dropped_out"] += 1
+                    continue
+                out.append(b)
+            os.write(self.fd, bytes(out))
+
+    def next_deadline(self, now):
+        deadlines = [now + 0.1]
+        if self.pending:
+            deadlines.append(self.pending[0][0])
+        if self.rx:
+            deadlines.append(self.last_rx + RX_GAP_S)
+        if self.modem.next_burst is not None:
+            deadlines.append(self.modem.next_burst)
+        return max(0.0, min(deadlines) - now)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SmartOne C modem emulator on a pseudo-terminal")
+    parser.add_argument("--link", help="symlink to create for the pty's slave side")
+    parser.add_argument("--seconds", type=float, default=0, help="stop after this long (default: until SIGINT/SIGTERM)")
+    parser.add_argument("--latency-ms", type=float, default=20, help="delay before a reply starts")
+    parser.add_argument("--jitter-ms", type=float, default=10, help="uniform extra delay added to --latency-ms")
+    parser.add_argument("--nak-rate", type=float, default=0.0, help="chance a reply is replaced with a NAK (0xFF)")
+    parser.add_argument("--drop-rate", type=float, default=0.0, help="chance each byte is lost, either direction")
+    parser.add_argument("--queue-depth", type=int, default=1, help="messages the modem holds before it is full")
+    parser.add_argument("--full", choices=("nak", "drop"), default="nak",
+                        help="a 0x27 to a full queue is NAKed, or silently lost")
+    parser.add_argument("--time-scale", type=float, default=1.0, help="multiplies the gaps between bursts")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--esn", type=lambda s: int(s, 0), default=0x00A1B2C3)
+    parser.add_argument("--seed", type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(args.seed)
+    master, slave = os.openpty()
+    tty.setraw(slave)
+    path = os.ttyname(slave)
+    if args.link:
+        if os.path.lexists(args.link):
+            os.remove(args.link)
+        os.symlink(path, args.link)
+    # The slave stays open here so the driver can reopen it without the
+    # master seeing a hangup.
+
+    stop = []
+    signal.signal(signal.SIGINT, lambda *_: stop.append(1))
+    signal.signal(signal.SIGTERM, lambda *_: stop.append(1))
+
+    modem = Modem(args, rng)
+    line = Line(master, modem, args, rng)
+    start = time.monotonic()
+    print("[EMU] SmartOne on %s" % path, flush=True)
+
+    while not stop and (not args.seconds or time.monotonic() - start < args.seconds):
+        now = time.monotonic()
+        try:
+            ready, _, _ = select.select([master], [], [], line.next_deadline(now))
+        except InterruptedError:
+            continue
+        now = time.monotonic()
+        line.receive(os.read(master, 4096) if ready else b"", now)
+        modem.tick(now)
+        line.flush(now)
+
+    modem.report(time.monotonic() - start)
+    if args.link and os.path.islink(args.link):
+        os.remove(args.link)
+
+
+if __name__ == "__main__":
+    main()